@@ -1,21 +1,236 @@
 #include "readfile.h"
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <limits.h>
 
-// Static file pointer for file handling operations
-static FILE* file = NULL;
+// Reader used by the legacy open_file/read_*/close_file interface
+static struct reader* file_reader = NULL;
+
+/**
+ * @brief Opens a file for reading with its own buffer.
+ *
+ * Each reader owns its file and buffer, so several readers can be open at once and used from
+ * different threads (one thread per reader).
+ *
+ * @param filename The name of the file to open.
+ * @return The new reader, or NULL if the file cannot be opened or memory cannot be allocated.
+ */
+struct reader* reader_open(const char* filename) {
+    struct reader* reader = (struct reader*)malloc(sizeof(struct reader));
+    if (reader == NULL) {
+        return NULL;
+    }
+    reader->capacity = READER_BUFFER_SIZE;
+    reader->buffer = (char*)malloc(reader->capacity + 1); // One more byte to terminate the last token
+    reader->file = fopen(filename, "r");
+    if (reader->buffer == NULL || reader->file == NULL) {
+        int error = errno;
+        if (reader->file != NULL) {
+            fclose(reader->file);
+        }
+        free(reader->buffer);
+        free(reader);
+        errno = error;
+        return NULL;
+    }
+    reader->start = 0;
+    reader->end = 0;
+    reader->at_eof = 0;
+    return reader;
+}
+
+/**
+ * @brief Appends the next bytes of the file to the buffered bytes.
+ *
+ * @param reader The reader.
+ * @return The number of bytes read, 0 at the end of the file, -1 on a read error.
+ */
+static int fill_buffer(struct reader* reader) {
+    size_t count = fread(reader->buffer + reader->end, 1, reader->capacity - reader->end, reader->file);
+    if (count == 0) {
+        if (ferror(reader->file)) {
+            return -1;
+        }
+        reader->at_eof = 1;
+        return 0;
+    }
+    reader->end += count;
+    return (int)count;
+}
+
+/**
+ * @brief Finds the next whitespace-delimited token without copying it.
+ *
+ * The token is returned as a view into the buffer of the reader and is NUL-terminated in place, so
+ * it can be passed to strtol, strcmp and the like directly. A token that does not fit in the rest of
+ * the buffer is moved to its front, and the buffer grows if the token is longer than the buffer.
+ *
+ * @param reader The reader.
+ * @param token Receives the token; valid until the next read from the same reader.
+ * @return 1 if a token was found, 0 at the end of the file, -1 on an error or if reader is NULL.
+ */
+int reader_next_token(struct reader* reader, struct token_view* token) {
+    if (reader == NULL) {
+        return -1;
+    }
+
+    // Skip whitespace, refilling the buffer as needed
+    while (1) {
+        while (reader->start < reader->end && isspace((unsigned char)reader->buffer[reader->start])) {
+            reader->start++;
+        }
+        if (reader->start < reader->end) {
+            break;
+        }
+        reader->start = 0;
+        reader->end = 0;
+        if (reader->at_eof) {
+            return 0;
+        }
+        int status = fill_buffer(reader);
+        if (status <= 0) {
+            return status;
+        }
+    }
+
+    // Find the end of the token; it may continue beyond the buffered bytes
+    size_t pos = reader->start;
+    while (1) {
+        while (pos < reader->end && !isspace((unsigned char)reader->buffer[pos])) {
+            pos++;
+        }
+        if (pos < reader->end || reader->at_eof) {
+            break;
+        }
+        // Move the partial token to the front and read more, growing the buffer if it is full
+        size_t length = reader->end - reader->start;
+        memmove(reader->buffer, reader->buffer + reader->start, length);
+        reader->start = 0;
+        reader->end = length;
+        pos = length;
+        if (reader->end == reader->capacity) {
+            char* grown = (char*)realloc(reader->buffer, 2 * reader->capacity + 1);
+            if (grown == NULL) {
+                return -1;
+            }
+            reader->buffer = grown;
+            reader->capacity *= 2;
+        }
+        if (fill_buffer(reader) < 0) {
+            return -1;
+        }
+    }
+
+    // Terminate the token in place; the delimiter it replaces has been consumed
+    token->data = reader->buffer + reader->start;
+    token->length = (int)(pos - reader->start);
+    reader->buffer[pos] = '\0';
+    reader->start = (pos < reader->end) ? pos + 1 : pos;
+    return 1;
+}
+
+/**
+ * @brief Reads an integer token.
+ *
+ * @param reader The reader.
+ * @param value Pointer to the variable where the read integer will be stored.
+ * @return 1 if an integer is read, 0 if the next token is not an integer (the token is consumed),
+ *         -1 at the end of the file or on an error.
+ */
+int reader_read_int(struct reader* reader, int* value) {
+    struct token_view token;
+    int status = reader_next_token(reader, &token);
+    if (status != 1) {
+        return (status == 0) ? EOF : -1;
+    }
+    char* end;
+    errno = 0;
+    long number = strtol(token.data, &end, 10);
+    if (end != token.data + token.length || errno == ERANGE || number < INT_MIN || number > INT_MAX) {
+        return 0;
+    }
+    *value = (int)number;
+    return 1;
+}
+
+/**
+ * @brief Reads a string token into a buffer of bounded size.
+ *
+ * At most max_length - 1 characters are copied and the string is always NUL-terminated; a longer
+ * token is truncated (and consumed entirely, so the next read starts at the next token).
+ *
+ * @param reader The reader.
+ * @param str Pointer to the buffer where the read string will be stored.
+ * @param max_length Size of the buffer, including the terminating NUL.
+ * @return 1 if a string is read, -1 at the end of the file, on an error or if max_length < 1.
+ */
+int reader_read_string(struct reader* reader, char* str, int max_length) {
+    if (max_length < 1) {
+        return -1;
+    }
+    struct token_view token;
+    int status = reader_next_token(reader, &token);
+    if (status != 1) {
+        return (status == 0) ? EOF : -1;
+    }
+    int length = (token.length < max_length - 1) ? token.length : max_length - 1;
+    memcpy(str, token.data, length);
+    str[length] = '\0';
+    return 1;
+}
+
+/**
+ * @brief Reads a float token.
+ *
+ * @param reader The reader.
+ * @param value Pointer to the variable where the read float will be stored.
+ * @return 1 if a float is read, 0 if the next token is not a number (the token is consumed),
+ *         -1 at the end of the file or on an error.
+ */
+int reader_read_float(struct reader* reader, float* value) {
+    struct token_view token;
+    int status = reader_next_token(reader, &token);
+    if (status != 1) {
+        return (status == 0) ? EOF : -1;
+    }
+    char* end;
+    float number = strtof(token.data, &end);
+    if (end != token.data + token.length) {
+        return 0;
+    }
+    *value = number;
+    return 1;
+}
+
+/**
+ * @brief Closes the file of a reader and releases its buffer.
+ *
+ * @param reader The reader (may be NULL).
+ */
+void reader_close(struct reader* reader) {
+    if (reader != NULL) {
+        fclose(reader->file);
+        free(reader->buffer);
+        free(reader);
+    }
+}
 
 /**
  * @brief Opens a file for reading.
  *
- * This function opens a file with the given filename for reading.
+ * This function opens a file with the given filename for reading. It replaces (and closes) the file
+ * opened by a previous call.
  *
  * @param filename The name of the file to open.
  * @return 0 if the file is opened successfully, -1 otherwise.
  */
 int open_file(const char* filename) {
-    file = fopen(filename, "r");
-    if (file == NULL) {
+    close_file();
+    file_reader = reader_open(filename);
+    if (file_reader == NULL) {
         return -1;
     }
     return 0;
@@ -30,26 +245,20 @@ int open_file(const char* filename) {
  * @return 1 if an integer is successfully read, -1 if an error occurs or the file is not open.
  */
 int read_int(int* value) {
-    if (file == NULL) {
-        return -1;
-    }
-    return fscanf(file, "%d", value);
+    return reader_read_int(file_reader, value);
 }
 
 /**
  * @brief Reads a string from the file.
  *
- * This function reads a string from the currently open file.
+ * This function reads a string of at most max_length - 1 characters from the currently open file.
  *
  * @param str Pointer to the buffer where the read string will be stored.
- * @param max_length Maximum length of the string to read.
+ * @param max_length Size of the buffer, including the terminating NUL.
  * @return 1 if a string is successfully read, -1 if an error occurs or the file is not open.
  */
 int read_string(char* str, int max_length) {
-    if (file == NULL) {
-        return -1;
-    }
-    return fscanf(file, "%s", str);
+    return reader_read_string(file_reader, str, max_length);
 }
 
 /**
@@ -61,10 +270,7 @@ int read_string(char* str, int max_length) {
  * @return 1 if a float is successfully read, -1 if an error occurs or the file is not open.
  */
 int read_float(float* value) {
-    if (file == NULL) {
-        return -1;
-    }
-    return fscanf(file, "%f", value);
+    return reader_read_float(file_reader, value);
 }
 
 /**
@@ -73,8 +279,6 @@ int read_float(float* value) {
  * This function closes the currently open file.
  */
 void close_file() {
-    if (file != NULL) {
-        fclose(file);
-        file = NULL;
-    }
+    reader_close(file_reader);
+    file_reader = NULL;
 }
@@ -1,10 +1,42 @@
 #ifndef READFILE_H
 #define READFILE_H
 
+#include <stdio.h>
+#include <stddef.h>
+
+// Initial size of the buffer of a reader; it grows for longer tokens
+#define READER_BUFFER_SIZE 65536
+
+// A whitespace-delimited token inside the buffer of a reader (NUL-terminated in place).
+// It stays valid until the next read from the same reader.
+struct token_view {
+    const char* data;
+    int length;
+};
+
+// An open input file with its own buffer. Readers share no state, so several files can be
+// read at the same time, one thread per reader.
+struct reader {
+    FILE* file;
+    char* buffer;
+    size_t capacity;    // Size of buffer, without the byte reserved for a terminating NUL
+    size_t start;       // First unread byte
+    size_t end;         // End of the buffered bytes
+    int at_eof;         // The file has been read to its end
+};
+
+struct reader* reader_open(const char* filename);
+int reader_next_token(struct reader* reader, struct token_view* token);
+int reader_read_int(struct reader* reader, int* value);
+int reader_read_string(struct reader* reader, char* str, int max_length);
+int reader_read_float(struct reader* reader, float* value);
+void reader_close(struct reader* reader);
+
+// Legacy interface over one shared reader (not reentrant)
 int open_file(const char* filename);
 int read_int(int* value);
 int read_string(char* str, int max_length);
 int read_float(float* value);
 void close_file();
 
-#endif // READFILE_H
\ No newline at end of file
+#endif // READFILE_H
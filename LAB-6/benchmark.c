@@ -0,0 +1,1315 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <unistd.h>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+#include "employee.h"
+#include "bptree.h"
+#include "database.h"
+#include "nameIndex.h"
+#include "ingest.h"
+#include "columnar.h"
+#include "pool.h"
+
+// Default sizes of the storage benchmark. The sorted array moves half of the table on every insert and
+// removal, so much larger tables make its run take minutes.
+#define DEFAULT_STORAGE_RECORDS 20000
+#define DEFAULT_STORAGE_OPERATIONS 200000
+#define DEFAULT_LOOKUP_PERCENT 50
+#define DEFAULT_INGEST_REPETITIONS 5
+// Largest name of the snapshot file written by the columnar benchmark
+#define MAX_FILENAME_LENGTH 256
+#define DEFAULT_SNAPSHOT_RECORDS 200000
+#define DEFAULT_SNAPSHOT_OPERATIONS 500000
+#define DEFAULT_SNAPSHOT_READERS 4
+#define DEFAULT_LOOKUP_RECORDS 500000
+#define DEFAULT_LOOKUP_THREADS 64
+#define DEFAULT_LOOKUP_MILLISECONDS 300
+#define DEFAULT_TRANSACTION_RECORDS 500000
+#define DEFAULT_TRANSACTION_BATCH 10000
+#define DEFAULT_ALLOC_OBJECTS 200000
+#define DEFAULT_ALLOC_OPERATIONS 4000000
+#define DEFAULT_ALLOC_THREADS 8
+#define DEFAULT_FUZZY_RECORDS 1000000
+#define DEFAULT_FUZZY_QUERIES 1000
+// Edits allowed by the fuzzy searches, and number of them also answered by scanning every row
+#define FUZZY_EDITS 2
+#define FUZZY_SCAN_QUERIES 20
+// One object in this many of the allocation benchmark is the size of an internal node, the others of a leaf
+#define ALLOC_INTERNAL_RATIO 8
+
+// Kinds of operations of a mixed workload
+enum Operation {
+    OP_LOOKUP,
+    OP_INSERT,
+    OP_REMOVE
+};
+
+// Sink for benchmark results so the compiler cannot drop the timed calls
+static volatile long benchmarkSink;
+
+
+/**
+ * @brief Returns the current time of a monotonic clock in seconds.
+ */
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief Allocates memory (the program exits on allocation failure).
+ */
+static void* allocate(size_t size) {
+    void* memory = malloc(size);
+    if (memory == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    return memory;
+}
+
+
+/**
+ * @brief Returns a random employee ID between MIN_ID and MAX_ID.
+ */
+static int randomId(void) {
+    return MIN_ID + rand() % (MAX_ID - MIN_ID + 1);
+}
+
+
+/**
+ * @brief Fills in a generated employee record with the given ID.
+ */
+static void makeEmployee(struct Employee* employee, int id) {
+    employee->id = id;
+    snprintf(employee->first_name, MAX_NAME_LENGTH, "First%d", id % 1000);
+    snprintf(employee->last_name, MAX_NAME_LENGTH, "Last%d", id % 5000);
+    employee->salary = MIN_SALARY + id % (MAX_SALARY - MIN_SALARY + 1);
+}
+
+
+/**
+ * @brief Returns the index of the first record of a sorted array whose ID is >= id.
+ */
+static int arrayLowerBound(const struct Employee* employees, int numEmployees, int id) {
+    int low = 0;
+    int high = numEmployees;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (employees[mid].id < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+
+/**
+ * @brief Runs a workload on an array kept sorted by ID, as the database did before the B+-tree.
+ *
+ * Lookups use binary search; inserts and removals move every record after the position.
+ *
+ * @return Number of successful operations, to compare with the tree.
+ */
+static long runArrayWorkload(const struct Employee* initial, int numRecords, const enum Operation* ops,
+                             const int* ids, int numOps) {
+    struct Employee* employees = (struct Employee*)allocate(sizeof(struct Employee) * (numRecords + numOps));
+    memcpy(employees, initial, sizeof(struct Employee) * numRecords);
+    int numEmployees = numRecords;
+    long hits = 0;
+
+    for (int i = 0; i < numOps; i++) {
+        int pos = arrayLowerBound(employees, numEmployees, ids[i]);
+        int found = pos < numEmployees && employees[pos].id == ids[i];
+        if (ops[i] == OP_LOOKUP) {
+            if (found) {
+                hits += employees[pos].salary > 0;
+            }
+        } else if (ops[i] == OP_INSERT) {
+            if (!found) {
+                memmove(&employees[pos + 1], &employees[pos], sizeof(struct Employee) * (numEmployees - pos));
+                makeEmployee(&employees[pos], ids[i]);
+                numEmployees++;
+                hits++;
+            }
+        } else if (found) {
+            memmove(&employees[pos], &employees[pos + 1], sizeof(struct Employee) * (numEmployees - pos - 1));
+            numEmployees--;
+            hits++;
+        }
+    }
+
+    free(employees);
+    return hits;
+}
+
+
+/**
+ * @brief Runs a workload on the B+-tree.
+ *
+ * @return Number of successful operations, to compare with the array.
+ */
+static long runTreeWorkload(const struct Employee* initial, int numRecords, const enum Operation* ops,
+                            const int* ids, int numOps) {
+    struct BPlusTree tree;
+    bptreeInit(&tree);
+    for (int i = 0; i < numRecords; i++) {
+        bptreeInsert(&tree, &initial[i]);
+    }
+    long hits = 0;
+
+    for (int i = 0; i < numOps; i++) {
+        if (ops[i] == OP_LOOKUP) {
+            const struct Employee* employee = bptreeFind(&tree, ids[i]);
+            if (employee != NULL) {
+                hits += employee->salary > 0;
+            }
+        } else if (ops[i] == OP_INSERT) {
+            struct Employee employee;
+            makeEmployee(&employee, ids[i]);
+            hits += bptreeInsert(&tree, &employee);
+        } else {
+            hits += bptreeRemove(&tree, ids[i], NULL);
+        }
+    }
+
+    // Check that an ordered scan sees every record in ID order
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    int count = 0;
+    int previous = 0;
+    bptreeSeek(&tree, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        if (employee->id <= previous) {
+            fprintf(stderr, "Error: B+-tree scan out of order at ID %d\n", employee->id);
+            exit(1);
+        }
+        previous = employee->id;
+        count++;
+    }
+    if (count != tree.size) {
+        fprintf(stderr, "Error: B+-tree scan found %d of %d records\n", count, tree.size);
+        exit(1);
+    }
+
+    bptreeFree(&tree);
+    return hits;
+}
+
+
+/**
+ * @brief Benchmarks the B+-tree against a sorted array on a mixed insert/remove/lookup workload.
+ *
+ * The table starts with numRecords random employees sorted by ID. The workload has lookupPercent
+ * percent lookups and an even split of inserts and removals of the rest, so the table size stays about
+ * the same. Inserts add new random IDs, removals take out IDs in the table, and half of the lookups
+ * target IDs in the table while the other half target random IDs.
+ *
+ * @param numRecords Initial number of records.
+ * @param numOps Number of operations of the workload.
+ * @param lookupPercent Percentage of lookups.
+ */
+static void benchmarkStorage(int numRecords, int numOps, int lookupPercent) {
+    struct Employee* initial = (struct Employee*)allocate(sizeof(struct Employee) * (numRecords + 1));
+    enum Operation* ops = (enum Operation*)allocate(sizeof(enum Operation) * (numOps + 1));
+    int* ids = (int*)allocate(sizeof(int) * (numOps + 1));
+
+    // Generate a sorted table of distinct IDs by sampling the ID space
+    srand(42);
+    int numIds = MAX_ID - MIN_ID + 1;
+    int count = 0;
+    for (int id = MIN_ID; id <= MAX_ID && count < numRecords; id++) {
+        if (rand() % (numIds - (id - MIN_ID)) < numRecords - count) {
+            makeEmployee(&initial[count++], id);
+        }
+    }
+
+    // Generate the workload, tracking the IDs in the table so removals always hit
+    char* present = (char*)calloc(numIds, 1);
+    int* live = (int*)allocate(sizeof(int) * (count + numOps + 1));
+    if (present == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    int numLive = count;
+    for (int i = 0; i < count; i++) {
+        live[i] = initial[i].id;
+        present[initial[i].id - MIN_ID] = 1;
+    }
+    for (int i = 0; i < numOps; i++) {
+        int roll = rand() % 100;
+        ops[i] = (roll < lookupPercent) ? OP_LOOKUP : ((roll - lookupPercent) % 2 == 0 ? OP_INSERT : OP_REMOVE);
+        if (ops[i] == OP_REMOVE && numLive == 0) {
+            ops[i] = OP_INSERT;
+        }
+        if (ops[i] == OP_LOOKUP) {
+            ids[i] = (numLive > 0 && rand() % 2 == 0) ? live[rand() % numLive] : randomId();
+        } else if (ops[i] == OP_INSERT) {
+            ids[i] = randomId();
+            if (!present[ids[i] - MIN_ID]) {
+                present[ids[i] - MIN_ID] = 1;
+                live[numLive++] = ids[i];
+            }
+        } else {
+            int slot = rand() % numLive;
+            ids[i] = live[slot];
+            live[slot] = live[--numLive];
+            present[ids[i] - MIN_ID] = 0;
+        }
+    }
+    free(present);
+    free(live);
+
+    printf("Storage: %d records, %d operations (%d%% lookups, the rest inserts and removals)\n", count, numOps,
+           lookupPercent);
+    printf("%-14s %12s %14s %12s\n", "structure", "time ms", "ops/s", "successful");
+
+    double start = nowSeconds();
+    long arrayHits = runArrayWorkload(initial, count, ops, ids, numOps);
+    double arrayTime = nowSeconds() - start;
+    printf("%-14s %12.3f %14.0f %12ld\n", "sorted array", arrayTime * 1e3, numOps / arrayTime, arrayHits);
+
+    start = nowSeconds();
+    long treeHits = runTreeWorkload(initial, count, ops, ids, numOps);
+    double treeTime = nowSeconds() - start;
+    printf("%-14s %12.3f %14.0f %12ld\n", "B+-tree", treeTime * 1e3, numOps / treeTime, treeHits);
+
+    if (arrayHits != treeHits) {
+        fprintf(stderr, "Error: the array and the B+-tree disagree (%ld vs %ld successful operations)\n", arrayHits,
+                treeHits);
+        exit(1);
+    }
+    benchmarkSink = treeHits;
+    printf("Speedup of the B+-tree: %.1fx\n", arrayTime / treeTime);
+
+    free(initial);
+    free(ops);
+    free(ids);
+}
+
+
+/**
+ * @brief Writes an input file of random employee records.
+ *
+ * IDs are drawn at random from the ID space, so large files have some duplicate IDs. Invalid records
+ * have an ID or a salary out of range, half each.
+ *
+ * @param numRecords Number of records.
+ * @param filename Name of the file to write.
+ * @param invalidPercent Percentage of records with a value out of range.
+ */
+static void generateEmployeeFile(int numRecords, const char* filename, int invalidPercent) {
+    FILE* file = fopen(filename, "w");
+    if (file == NULL) {
+        perror("Error opening the output file");
+        exit(1);
+    }
+    srand(42);
+    for (int i = 0; i < numRecords; i++) {
+        struct Employee employee;
+        makeEmployee(&employee, randomId());
+        employee.salary = MIN_SALARY + rand() % (MAX_SALARY - MIN_SALARY + 1);
+        if (rand() % 100 < invalidPercent) {
+            if (rand() % 2 == 0) {
+                employee.id = rand() % MIN_ID;
+            } else {
+                employee.salary = rand() % MIN_SALARY;
+            }
+        }
+        fprintf(file, "%d %s %s %d\n", employee.id, employee.first_name, employee.last_name, employee.salary);
+    }
+    fclose(file);
+}
+
+
+/**
+ * @brief Times loading an input file with and without validation.
+ *
+ * Each mode runs once to warm up the page cache, then the fastest of the timed repetitions is reported,
+ * with the number of records loaded and rejected and the cost of validation relative to plain loading.
+ *
+ * @param filename Name of the input file.
+ * @param repetitions Number of timed repetitions per mode.
+ */
+static void benchmarkIngest(const char* filename, int repetitions) {
+    static const char* modeNames[] = {"unvalidated", "validated"};
+    double best[2] = {0.0, 0.0};
+
+    printf("Ingest: %s, best of %d runs\n", filename, repetitions);
+    printf("%-12s %12s %14s %10s %10s\n", "mode", "time ms", "records/s", "loaded", "rejected");
+    for (int validate = 0; validate <= 1; validate++) {
+        struct IngestResult result;
+        for (int rep = -1; rep < repetitions; rep++) {
+            double start = nowSeconds();
+            if (ingestEmployeeFile(filename, validate, &result) != 0) {
+                perror("Error opening the input file");
+                exit(1);
+            }
+            double elapsed = nowSeconds() - start;
+            // Repetition -1 is the warmup run
+            if (rep == 0 || (rep > 0 && elapsed < best[validate])) {
+                best[validate] = elapsed;
+            }
+            if (rep < repetitions - 1) {
+                freeIngestResult(&result);
+            }
+        }
+        int numRecords = result.numEmployees + result.numRejected;
+        printf("%-12s %12.3f %14.0f %10d %10d\n", modeNames[validate], best[validate] * 1e3,
+               numRecords / best[validate], result.numEmployees, result.numRejected);
+        benchmarkSink = result.numEmployees;
+        freeIngestResult(&result);
+    }
+    printf("Validation overhead: %+.1f%%\n", 100.0 * (best[1] - best[0]) / best[0]);
+}
+
+
+/**
+ * @brief Returns the size of a file in bytes, or -1 if it cannot be opened.
+ */
+static long fileSize(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return -1;
+    }
+    fseek(file, 0, SEEK_END);
+    long size = ftell(file);
+    fclose(file);
+    return size;
+}
+
+
+/**
+ * @brief Returns the best time of loading a file with ingestEmployeeFile, keeping the last result.
+ */
+static double timeLoad(const char* filename, int repetitions, struct IngestResult* result) {
+    double best = 0.0;
+    for (int rep = -1; rep < repetitions; rep++) {
+        double start = nowSeconds();
+        if (ingestEmployeeFile(filename, 1, result) != 0) {
+            fprintf(stderr, "Error: Unable to load %s\n", filename);
+            exit(1);
+        }
+        double elapsed = nowSeconds() - start;
+        // Repetition -1 is the warmup run
+        if (rep == 0 || (rep > 0 && elapsed < best)) {
+            best = elapsed;
+        }
+        if (rep < repetitions - 1) {
+            freeIngestResult(result);
+        }
+    }
+    return best;
+}
+
+
+/**
+ * @brief Compares a text input file with the columnar snapshot of the same records.
+ *
+ * Loads the text file, writes its valid records to <file>.col, and compares the sizes of both files
+ * and the time to load each of them (with validation, as the employee manager does). The records
+ * loaded from the snapshot must be those of the text file in ID order.
+ *
+ * @param filename Name of the text input file.
+ * @param repetitions Number of timed loads of each file.
+ */
+static void benchmarkColumnar(const char* filename, int repetitions) {
+    struct IngestResult text;
+    double textSeconds = timeLoad(filename, repetitions, &text);
+    struct BPlusTree records;
+    bptreeInit(&records);
+    for (int i = 0; i < text.numEmployees; i++) {
+        bptreeInsert(&records, &text.employees[i]);
+    }
+
+    char snapshotName[MAX_FILENAME_LENGTH];
+    snprintf(snapshotName, sizeof(snapshotName), "%s.col", filename);
+    double start = nowSeconds();
+    if (writeColumnarSnapshot(&records, snapshotName) != 0) {
+        fprintf(stderr, "Error: Unable to write %s\n", snapshotName);
+        exit(1);
+    }
+    double writeSeconds = nowSeconds() - start;
+
+    struct IngestResult columnar;
+    double columnarSeconds = timeLoad(snapshotName, repetitions, &columnar);
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    int i = 0;
+    bptreeSeek(&records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        const struct Employee* loaded = &columnar.employees[i++];
+        if (i > columnar.numEmployees || loaded->id != employee->id || loaded->salary != employee->salary ||
+            strcmp(loaded->first_name, employee->first_name) != 0 || strcmp(loaded->last_name, employee->last_name) != 0) {
+            fprintf(stderr, "Error: record %d of the snapshot differs from the text file\n", i);
+            exit(1);
+        }
+    }
+
+    long textBytes = fileSize(filename);
+    long columnarBytes = fileSize(snapshotName);
+    printf("Columnar snapshot: %d records of %s, best of %d loads (written in %.1f ms)\n", records.size, filename,
+           repetitions, writeSeconds * 1e3);
+    printf("%-10s %14s %12s %14s\n", "format", "bytes", "load ms", "records/s");
+    printf("%-10s %14ld %12.3f %14.0f\n", "text", textBytes, textSeconds * 1e3, text.numEmployees / textSeconds);
+    printf("%-10s %14ld %12.3f %14.0f\n", "columnar", columnarBytes, columnarSeconds * 1e3,
+           columnar.numEmployees / columnarSeconds);
+    printf("The snapshot is %.1fx smaller and loads %.1fx faster\n", (double)textBytes / columnarBytes,
+           textSeconds / columnarSeconds);
+
+    freeIngestResult(&text);
+    freeIngestResult(&columnar);
+    bptreeFree(&records);
+}
+
+
+/**
+ * @brief Returns the next number of a xorshift generator, for threads that cannot share rand().
+ */
+static unsigned int nextRandom(unsigned int* state) {
+    unsigned int x = *state;
+    x ^= x << 13;
+    x ^= x >> 17;
+    x ^= x << 5;
+    *state = x;
+    return x;
+}
+
+
+/**
+ * @brief Fills in a record whose first name repeats its salary, so a torn record can be detected.
+ */
+static void stampEmployee(struct Employee* employee, int id, int salary) {
+    employee->id = id;
+    employee->salary = salary;
+    snprintf(employee->first_name, MAX_NAME_LENGTH, "S%d", salary);
+    snprintf(employee->last_name, MAX_NAME_LENGTH, "Last%d", id % 5000);
+}
+
+
+// State shared by the writer and the report threads of the snapshot benchmark
+struct SnapshotRun {
+    struct Database* db;
+    int numOps;                     // Changes the writer makes
+    int lockedReports;              // 1 if reports hold the lock for the whole scan instead of pinning
+    atomic_int writerDone;          // Set with release order once the writer has finished
+    double writerSeconds;
+    int peakRetired;                // Most replaced nodes waiting to be freed at once
+};
+
+// Results of one report thread
+struct ReportThread {
+    struct SnapshotRun* run;
+    pthread_t thread;
+    long numReports;
+    long numErrors;
+};
+
+
+/**
+ * @brief Applies the writer's changes: 80% salary updates, 10% inserts and 10% removals.
+ */
+static void* snapshotWriter(void* arg) {
+    struct SnapshotRun* run = (struct SnapshotRun*)arg;
+    struct Database* db = run->db;
+    unsigned int state = 12345;
+    int numIds = MAX_ID - MIN_ID + 1;
+
+    // IDs in the table, to pick the targets of updates and removals
+    int* live = (int*)allocate(sizeof(int) * (db->records.size + run->numOps + 1));
+    int numLive = 0;
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    bptreeSeek(&db->records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        live[numLive++] = employee->id;
+    }
+
+    double start = nowSeconds();
+    for (int i = 0; i < run->numOps; i++) {
+        int roll = nextRandom(&state) % 10;
+        int salary = MIN_SALARY + nextRandom(&state) % (MAX_SALARY - MIN_SALARY + 1);
+        struct Employee record;
+        if (roll == 0 || numLive == 0) {
+            stampEmployee(&record, MIN_ID + nextRandom(&state) % numIds, salary);
+            if (insertEmployee(db, &record)) {
+                live[numLive++] = record.id;
+            }
+        } else if (roll == 1) {
+            int slot = nextRandom(&state) % numLive;
+            deleteEmployee(db, live[slot], NULL);
+            live[slot] = live[--numLive];
+        } else {
+            stampEmployee(&record, live[nextRandom(&state) % numLive], salary);
+            replaceEmployee(db, &record);
+        }
+        if (i % 1024 == 0) {
+            pthread_mutex_lock(&db->lock);
+            if (db->records.numRetired > run->peakRetired) {
+                run->peakRetired = db->records.numRetired;
+            }
+            pthread_mutex_unlock(&db->lock);
+        }
+    }
+    run->writerSeconds = nowSeconds() - start;
+    atomic_store_explicit(&run->writerDone, 1, memory_order_release);
+    free(live);
+    return NULL;
+}
+
+
+/**
+ * @brief Scans a tree as a report would and checks what it sees.
+ *
+ * @return Number of inconsistencies: records out of ID order, records whose fields come from different
+ *         versions, or a count of records different from the size of the tree.
+ */
+static long scanReport(const struct BPlusTree* records, long* checksum) {
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    long errors = 0;
+    int count = 0;
+    int previous = 0;
+    *checksum = 0;
+    bptreeSeek(records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        errors += employee->id <= previous || atoi(employee->first_name + 1) != employee->salary;
+        previous = employee->id;
+        *checksum += (long)employee->id * employee->salary;
+        count++;
+    }
+    return errors + (count != records->size);
+}
+
+
+/**
+ * @brief Runs full-table reports until the writer is done.
+ *
+ * With snapshots, each report pins a snapshot, scans it twice and checks that both scans agree, since
+ * a snapshot must not change while it is pinned. With locked reports, each scan holds the lock.
+ */
+static void* snapshotReporter(void* arg) {
+    struct ReportThread* reporter = (struct ReportThread*)arg;
+    struct SnapshotRun* run = reporter->run;
+    while (!atomic_load_explicit(&run->writerDone, memory_order_acquire)) {
+        long first, second;
+        if (run->lockedReports) {
+            pthread_mutex_lock(&run->db->lock);
+            reporter->numErrors += scanReport(&run->db->records, &first);
+            pthread_mutex_unlock(&run->db->lock);
+        } else {
+            struct Snapshot snapshot;
+            pinSnapshot(run->db, &snapshot);
+            reporter->numErrors += scanReport(&snapshot.records, &first);
+            reporter->numErrors += scanReport(&snapshot.records, &second);
+            reporter->numErrors += first != second;
+            releaseSnapshot(run->db, &snapshot);
+        }
+        reporter->numReports++;
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Measures how fast one writer changes the database while report threads scan all of it.
+ *
+ * For 0, 1, 2, 4, ... report threads up to maxReaders, the writer applies numOps changes while the
+ * reports run, first reading pinned snapshots and then, for comparison, holding the database lock for
+ * each scan as a report without snapshots would have to. The table shows the writer's throughput, the
+ * number of reports and inconsistencies seen, and the most replaced nodes waiting to be reclaimed.
+ *
+ * @param numRecords Number of records in the table.
+ * @param numOps Number of changes the writer makes per run.
+ * @param maxReaders Largest number of report threads.
+ */
+static void benchmarkSnapshots(int numRecords, int numOps, int maxReaders) {
+    if (numRecords > MAX_ID - MIN_ID + 1) {
+        numRecords = MAX_ID - MIN_ID + 1; // One record per possible ID at most
+    }
+    printf("Snapshots: %d records, %d changes by one writer (80%% updates, 10%% inserts, 10%% removals)\n",
+           numRecords, numOps);
+    printf("%-8s %8s %12s %14s %10s %8s %12s\n", "reports", "threads", "writer ms", "changes/s", "reports",
+           "errors", "peak retired");
+
+    for (int locked = 0; locked <= 1; locked++) {
+        for (int numReaders = 0; numReaders <= maxReaders; numReaders = (numReaders == 0) ? 1 : 2 * numReaders) {
+            if (locked && numReaders == 0) {
+                continue; // Same as with snapshots
+            }
+            struct Database db;
+            initDatabase(&db);
+            unsigned int state = 42;
+            while (db.records.size < numRecords) {
+                struct Employee record;
+                stampEmployee(&record, MIN_ID + nextRandom(&state) % (MAX_ID - MIN_ID + 1),
+                              MIN_SALARY + nextRandom(&state) % (MAX_SALARY - MIN_SALARY + 1));
+                insertEmployee(&db, &record);
+            }
+
+            struct SnapshotRun run = {&db, numOps, locked, 0, 0.0, 0};
+            struct ReportThread* reporters = (struct ReportThread*)allocate(sizeof(struct ReportThread) * (numReaders + 1));
+            for (int r = 0; r < numReaders; r++) {
+                reporters[r].run = &run;
+                reporters[r].numReports = 0;
+                reporters[r].numErrors = 0;
+                if (pthread_create(&reporters[r].thread, NULL, snapshotReporter, &reporters[r]) != 0) {
+                    fprintf(stderr, "Error: Unable to start a report thread.\n");
+                    exit(1);
+                }
+            }
+            snapshotWriter(&run);
+            long numReports = 0;
+            long numErrors = 0;
+            for (int r = 0; r < numReaders; r++) {
+                pthread_join(reporters[r].thread, NULL);
+                numReports += reporters[r].numReports;
+                numErrors += reporters[r].numErrors;
+            }
+            printf("%-8s %8d %12.3f %14.0f %10ld %8ld %12d\n", locked ? "locked" : "snapshot", numReaders,
+                   run.writerSeconds * 1e3, numOps / run.writerSeconds, numReports, numErrors, run.peakRetired);
+            free(reporters);
+            freeDatabase(&db);
+            if (numErrors > 0) {
+                fprintf(stderr, "Error: reports saw inconsistent data\n");
+                exit(1);
+            }
+        }
+    }
+}
+
+
+// State shared by the threads of the lookup benchmark
+struct LookupRun {
+    struct Database* db;
+    const int* ids;                 // IDs in the table
+    int numIds;
+    int lockedLookups;              // 1 to look up in the tree under the lock instead of in the ID index
+    atomic_int stop;                // Set with release order when the time is up
+    long numUpdates;
+};
+
+// Results of one lookup thread
+struct LookupThread {
+    struct LookupRun* run;
+    pthread_t thread;
+    unsigned int seed;
+    long numLookups;
+    long numErrors;
+};
+
+
+/**
+ * @brief Looks up random IDs until told to stop, checking that no record is torn.
+ */
+static void* lookupReader(void* arg) {
+    struct LookupThread* reader = (struct LookupThread*)arg;
+    struct LookupRun* run = reader->run;
+    while (!atomic_load_explicit(&run->stop, memory_order_acquire)) {
+        int id = run->ids[nextRandom(&reader->seed) % run->numIds];
+        struct Employee employee;
+        int found;
+        if (run->lockedLookups) {
+            pthread_mutex_lock(&run->db->lock);
+            const struct Employee* record = bptreeFind(&run->db->records, id);
+            found = record != NULL;
+            if (found) {
+                employee = *record;
+            }
+            pthread_mutex_unlock(&run->db->lock);
+        } else {
+            found = findEmployee(run->db, id, &employee);
+        }
+        reader->numErrors += !found || atoi(employee.first_name + 1) != employee.salary;
+        reader->numLookups++;
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Changes the salaries of random employees until told to stop.
+ */
+static void* lookupWriter(void* arg) {
+    struct LookupRun* run = (struct LookupRun*)arg;
+    unsigned int state = 99;
+    while (!atomic_load_explicit(&run->stop, memory_order_acquire)) {
+        struct Employee record;
+        stampEmployee(&record, run->ids[nextRandom(&state) % run->numIds],
+                      MIN_SALARY + nextRandom(&state) % (MAX_SALARY - MIN_SALARY + 1));
+        replaceEmployee(run->db, &record);
+        run->numUpdates++;
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Measures the throughput of ID lookups from 1 to maxThreads threads while one writer updates records.
+ *
+ * Each thread count runs for the given time, first with lookups in the lock-free ID index and then with
+ * lookups in the B+-tree under the database lock, which the writer also takes for each change. Every
+ * lookup must find its record untorn.
+ *
+ * @param numRecords Number of records in the table.
+ * @param maxThreads Largest number of lookup threads.
+ * @param milliseconds Duration of each run.
+ */
+static void benchmarkLookups(int numRecords, int maxThreads, int milliseconds) {
+    if (numRecords > MAX_ID - MIN_ID + 1) {
+        numRecords = MAX_ID - MIN_ID + 1; // One record per possible ID at most
+    }
+    struct Database db;
+    initDatabase(&db);
+    int* ids = (int*)allocate(sizeof(int) * numRecords);
+    unsigned int state = 11;
+    while (db.records.size < numRecords) {
+        struct Employee record;
+        stampEmployee(&record, MIN_ID + nextRandom(&state) % (MAX_ID - MIN_ID + 1),
+                      MIN_SALARY + nextRandom(&state) % (MAX_SALARY - MIN_SALARY + 1));
+        if (insertEmployee(&db, &record)) {
+            ids[db.records.size - 1] = record.id;
+        }
+    }
+
+    printf("Lookups: %d records, one writer updating salaries, %d ms per run\n", numRecords, milliseconds);
+    printf("%-8s %8s %16s %18s %12s %8s\n", "lookups", "threads", "lookups/s", "per thread/s", "updates/s",
+           "errors");
+    struct LookupThread* readers = (struct LookupThread*)allocate(sizeof(struct LookupThread) * maxThreads);
+    struct timespec duration = {milliseconds / 1000, (milliseconds % 1000) * 1000000L};
+    for (int locked = 0; locked <= 1; locked++) {
+        for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+            struct LookupRun run = {&db, ids, numRecords, locked, 0, 0};
+            pthread_t writer;
+            for (int r = 0; r < numThreads; r++) {
+                readers[r].run = &run;
+                readers[r].seed = 1234567u + 7919u * r;
+                readers[r].numLookups = 0;
+                readers[r].numErrors = 0;
+                if (pthread_create(&readers[r].thread, NULL, lookupReader, &readers[r]) != 0) {
+                    fprintf(stderr, "Error: Unable to start a lookup thread.\n");
+                    exit(1);
+                }
+            }
+            if (pthread_create(&writer, NULL, lookupWriter, &run) != 0) {
+                fprintf(stderr, "Error: Unable to start the writer thread.\n");
+                exit(1);
+            }
+            nanosleep(&duration, NULL);
+            atomic_store_explicit(&run.stop, 1, memory_order_release);
+            pthread_join(writer, NULL);
+            long numLookups = 0;
+            long numErrors = 0;
+            for (int r = 0; r < numThreads; r++) {
+                pthread_join(readers[r].thread, NULL);
+                numLookups += readers[r].numLookups;
+                numErrors += readers[r].numErrors;
+            }
+            double seconds = milliseconds / 1e3;
+            printf("%-8s %8d %16.0f %18.0f %12.0f %8ld\n", locked ? "locked" : "index", numThreads,
+                   numLookups / seconds, numLookups / seconds / numThreads, run.numUpdates / seconds, numErrors);
+            if (numErrors > 0) {
+                fprintf(stderr, "Error: lookups found missing or torn records\n");
+                exit(1);
+            }
+        }
+    }
+
+    free(readers);
+    free(ids);
+    freeDatabase(&db);
+}
+
+
+// One thread of the allocation benchmark
+struct ChurnThread {
+    pthread_t thread;
+    int usePool;                    // 1 for the node pools, 0 for malloc
+    int numObjects;                 // Objects the thread keeps allocated
+    long numOperations;             // Frees, each followed by an allocation
+    unsigned int seed;
+};
+
+// Pools of the allocation benchmark, sized like B+-tree leaves and internal nodes
+static struct Pool churnPools[2];
+static const size_t churnSizes[2] = {sizeof(struct BPlusLeaf), sizeof(struct BPlusInternal)};
+
+
+/**
+ * @brief Allocates an object of one of the benchmark sizes, from a pool or from malloc.
+ */
+static void* churnAlloc(int usePool, int kind) {
+    void* object = usePool ? poolAlloc(&churnPools[kind]) : allocate(churnSizes[kind]);
+    memset(object, kind, 64); // Write the header of the node, as a tree would
+    return object;
+}
+
+
+/**
+ * @brief Frees an object of one of the benchmark sizes.
+ */
+static void churnFree(int usePool, int kind, void* object) {
+    if (usePool) {
+        poolFree(&churnPools[kind], object);
+    } else {
+        free(object);
+    }
+}
+
+
+/**
+ * @brief Replaces random objects of a set of live objects, one in ALLOC_INTERNAL_RATIO of them node-sized.
+ */
+static void* churnObjects(void* arg) {
+    struct ChurnThread* churn = (struct ChurnThread*)arg;
+    void** objects = (void**)allocate(sizeof(void*) * churn->numObjects);
+    for (int i = 0; i < churn->numObjects; i++) {
+        objects[i] = churnAlloc(churn->usePool, i % ALLOC_INTERNAL_RATIO == 0);
+    }
+    for (long op = 0; op < churn->numOperations; op++) {
+        int i = nextRandom(&churn->seed) % churn->numObjects;
+        int kind = i % ALLOC_INTERNAL_RATIO == 0;
+        churnFree(churn->usePool, kind, objects[i]);
+        objects[i] = churnAlloc(churn->usePool, kind);
+    }
+    for (int i = 0; i < churn->numObjects; i++) {
+        churnFree(churn->usePool, i % ALLOC_INTERNAL_RATIO == 0, objects[i]);
+    }
+    free(objects);
+    return NULL;
+}
+
+
+/**
+ * @brief Returns the resident set size of the process in megabytes, or -1 if it is unknown.
+ */
+static double residentMegabytes(void) {
+    FILE* file = fopen("/proc/self/statm", "r");
+    long size;
+    long resident;
+    if (file == NULL) {
+        return -1;
+    }
+    int read = fscanf(file, "%ld %ld", &size, &resident);
+    fclose(file);
+    return (read == 2) ? resident * (double)sysconf(_SC_PAGESIZE) / (1024 * 1024) : -1;
+}
+
+
+/**
+ * @brief Runs the churn workload on some threads and prints its allocation rate and memory use.
+ *
+ * Runs in a child process of its own, so that each row starts from a fresh heap.
+ */
+static void runChurn(int usePool, int numThreads, int numObjects, int numOps) {
+    if (usePool) {
+        poolInit(&churnPools[0], churnSizes[0]);
+        poolInit(&churnPools[1], churnSizes[1]);
+    }
+    struct ChurnThread* threads = (struct ChurnThread*)allocate(sizeof(struct ChurnThread) * numThreads);
+    double start = nowSeconds();
+    for (int t = 0; t < numThreads; t++) {
+        threads[t].usePool = usePool;
+        threads[t].numObjects = (numObjects + numThreads - 1) / numThreads;
+        threads[t].numOperations = numOps / numThreads;
+        threads[t].seed = 2463534242u + 7919u * t;
+        if (pthread_create(&threads[t].thread, NULL, churnObjects, &threads[t]) != 0) {
+            fprintf(stderr, "Error: Unable to start a churn thread.\n");
+            exit(1);
+        }
+    }
+    for (int t = 0; t < numThreads; t++) {
+        pthread_join(threads[t].thread, NULL);
+    }
+    double seconds = nowSeconds() - start;
+    long totalOps = threads[0].numOperations * numThreads;
+
+    struct rusage usage;
+    getrusage(RUSAGE_SELF, &usage);
+    printf("%-8s %8d %16.0f %12.1f %12.1f\n", usePool ? "pool" : "malloc", numThreads, totalOps / seconds,
+           residentMegabytes(), usage.ru_maxrss / 1024.0);
+    free(threads);
+}
+
+
+/**
+ * @brief Compares the node pools with malloc on a churn of node-sized objects.
+ *
+ * Each thread keeps its share of numObjects objects allocated, of the sizes of B+-tree leaves and
+ * internal nodes, and replaces random ones. Every row runs in a fresh process and reports the
+ * allocations (and frees) per second, the resident memory once every object is freed and the peak.
+ *
+ * @param numObjects Objects kept allocated, over all threads.
+ * @param numOps Objects replaced, over all threads.
+ * @param maxThreads Largest number of threads.
+ */
+static void benchmarkAllocation(int numObjects, int numOps, int maxThreads) {
+    printf("Allocation: %d live objects (%zu and %zu bytes), %d replacements\n", numObjects, churnSizes[0],
+           churnSizes[1], numOps);
+    printf("%-8s %8s %16s %12s %12s\n", "alloc", "threads", "allocations/s", "RSS (MB)", "peak (MB)");
+    fflush(stdout);
+    for (int usePool = 0; usePool <= 1; usePool++) {
+        for (int numThreads = 1; numThreads <= maxThreads; numThreads *= 2) {
+            pid_t child = fork();
+            if (child < 0) {
+                perror("Error starting a process");
+                exit(1);
+            }
+            if (child == 0) {
+                runChurn(usePool, numThreads, numObjects, numOps);
+                fflush(stdout);
+                _exit(0);
+            }
+            int status;
+            waitpid(child, &status, 0);
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+                fprintf(stderr, "Error: The allocation run failed.\n");
+                exit(1);
+            }
+        }
+    }
+}
+
+
+/**
+ * @brief Returns a checksum of every record of a tree.
+ */
+static unsigned long tableChecksum(const struct BPlusTree* records) {
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    unsigned long checksum = 0;
+    bptreeSeek(records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        checksum = checksum * 31 + (unsigned long)employee->id * employee->salary;
+    }
+    return checksum;
+}
+
+
+/**
+ * @brief Measures batches of salary changes applied directly, in a transaction, and with a copy of the table.
+ *
+ * Each batch changes the salaries of batchSize employees of a table of numRecords. A transaction that
+ * commits or rolls back keeps one undo record per change; the copy is what a backup of the whole table
+ * before the batch would cost. Halfway through each transaction a snapshot is checked to still show the
+ * table as it was, and after the rollback the table must be as it was.
+ *
+ * @param numRecords Number of records in the table.
+ * @param batchSize Number of changes per batch.
+ */
+static void benchmarkTransactions(int numRecords, int batchSize) {
+    static const char* modeNames[] = {"direct", "commit", "rollback", "copy table"};
+    if (numRecords > MAX_ID - MIN_ID + 1) {
+        numRecords = MAX_ID - MIN_ID + 1; // One record per possible ID at most
+    }
+    struct Database db;
+    initDatabase(&db);
+    unsigned int state = 7;
+    while (db.records.size < numRecords) {
+        struct Employee record;
+        stampEmployee(&record, MIN_ID + nextRandom(&state) % (MAX_ID - MIN_ID + 1),
+                      MIN_SALARY + nextRandom(&state) % (MAX_SALARY - MIN_SALARY + 1));
+        insertEmployee(&db, &record);
+    }
+    if (batchSize > numRecords) {
+        batchSize = numRecords;
+    }
+
+    // The batches change the salaries of the same batchSize employees, picked at random
+    struct Employee* batch = (struct Employee*)allocate(sizeof(struct Employee) * batchSize);
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    int numPicked = 0;
+    int seen = 0;
+    bptreeSeek(&db.records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        int slot = (numPicked < batchSize) ? numPicked++ : (int)(nextRandom(&state) % (unsigned int)(seen + 1));
+        if (slot < batchSize) {
+            batch[slot].id = employee->id;
+        }
+        seen++;
+    }
+
+    printf("Transactions: batches of %d salary changes to a table of %d records\n", batchSize, numRecords);
+    printf("%-12s %12s %16s %14s\n", "mode", "batch ms", "us per change", "saved (KB)");
+    // Mode -1 is an untimed warm-up, so the first timed batch does not create most of the names
+    for (int mode = -1; mode < 4; mode++) {
+        for (int i = 0; i < batchSize; i++) {
+            stampEmployee(&batch[i], batch[i].id, MIN_SALARY + nextRandom(&state) % (MAX_SALARY - MIN_SALARY + 1));
+        }
+        unsigned long before = tableChecksum(&db.records);
+        struct Transaction transaction;
+        struct Employee* copy = NULL;
+        size_t savedBytes = 0;
+
+        double start = nowSeconds();
+        if (mode == 3) {
+            copy = (struct Employee*)allocate(sizeof(struct Employee) * db.records.size);
+            int numCopied = 0;
+            bptreeSeek(&db.records, MIN_ID, &cursor);
+            while ((employee = bptreeNext(&cursor)) != NULL) {
+                copy[numCopied++] = *employee;
+            }
+            savedBytes = sizeof(struct Employee) * numCopied;
+        } else if (mode > 0) {
+            beginTransaction(&db, &transaction);
+        }
+        for (int i = 0; i < batchSize; i++) {
+            if (mode == 1 || mode == 2) {
+                transactionReplace(&transaction, &batch[i]);
+            } else {
+                replaceEmployee(&db, &batch[i]);
+            }
+            if (i == batchSize / 2 && (mode == 1 || mode == 2)) {
+                double checkStart = nowSeconds();
+                struct Snapshot snapshot;
+                pinSnapshot(&db, &snapshot);
+                if (tableChecksum(&snapshot.records) != before) {
+                    fprintf(stderr, "Error: a snapshot shows changes of an open transaction\n");
+                    exit(1);
+                }
+                releaseSnapshot(&db, &snapshot);
+                start += nowSeconds() - checkStart; // Not part of the batch time
+            }
+        }
+        if (mode == 1) {
+            savedBytes = sizeof(struct UndoRecord) * transaction.numUndo;
+            commitTransaction(&transaction);
+        } else if (mode == 2) {
+            savedBytes = sizeof(struct UndoRecord) * transaction.numUndo;
+            rollbackTransaction(&transaction);
+        }
+        double seconds = nowSeconds() - start;
+
+        if (mode == 2 && tableChecksum(&db.records) != before) {
+            fprintf(stderr, "Error: the rollback did not restore the table\n");
+            exit(1);
+        }
+        if (mode < 0) {
+            continue;
+        }
+        printf("%-12s %12.3f %16.3f %14zu\n", modeNames[mode], seconds * 1e3, seconds * 1e6 / batchSize,
+               savedBytes / 1024);
+        free(copy);
+    }
+
+    free(batch);
+    freeDatabase(&db);
+}
+
+
+/**
+ * @brief Writes a generated last name of two or three syllables.
+ */
+static void makeSyllableName(char* name, unsigned int* state) {
+    static const char* syllables[] = {
+        "an", "ber", "car", "dal", "den", "el", "fer", "gan", "har", "is", "jo", "kel", "lan", "mar", "mon", "nor",
+        "ol", "par", "quin", "ros", "sal", "sen", "ton", "ur", "van", "wes", "xan", "yor", "zel", "bro", "stan", "vik"
+    };
+    int numSyllables = 2 + nextRandom(state) % 2;
+    name[0] = '\0';
+    for (int s = 0; s < numSyllables; s++) {
+        strcat(name, syllables[nextRandom(state) % 32]);
+    }
+    name[0] = (char)(name[0] - 'a' + 'A');
+}
+
+
+/**
+ * @brief Makes a typo in a name: a letter replaced, removed, inserted, or two letters swapped.
+ */
+static void makeTypo(char* name, unsigned int* state) {
+    int length = (int)strlen(name);
+    int position = nextRandom(state) % length;
+    char letter = (char)('a' + nextRandom(state) % 26);
+    switch (nextRandom(state) % 4) {
+        case 0:
+            name[position] = letter;
+            break;
+        case 1:
+            if (length > 1) {
+                memmove(&name[position], &name[position + 1], length - position);
+            }
+            break;
+        case 2:
+            if (length < MAX_NAME_LENGTH - 1) {
+                memmove(&name[position + 1], &name[position], length - position + 1);
+                name[position] = letter;
+            }
+            break;
+        default:
+            if (position + 1 < length) {
+                char swap = name[position];
+                name[position] = name[position + 1];
+                name[position + 1] = swap;
+            }
+            break;
+    }
+}
+
+
+/**
+ * @brief Compares fuzzy last-name searches through the trigram index with a scan of every row.
+ *
+ * Builds the index of numRecords generated last names, then searches numQueries names with one or two
+ * typos for the rows within FUZZY_EDITS edits, through the index and, for the first queries, by checking
+ * the edit distance of every row. Both must find the same rows.
+ *
+ * @param numRecords Number of rows.
+ * @param numQueries Number of searches.
+ */
+static void benchmarkFuzzy(int numRecords, int numQueries) {
+    char (*lastNames)[MAX_NAME_LENGTH] = allocate(sizeof(*lastNames) * numRecords);
+    char (*queries)[MAX_NAME_LENGTH] = allocate(sizeof(*queries) * numQueries);
+    unsigned int state = 2024;
+    for (int i = 0; i < numRecords; i++) {
+        makeSyllableName(lastNames[i], &state);
+    }
+    for (int q = 0; q < numQueries; q++) {
+        strcpy(queries[q], lastNames[nextRandom(&state) % numRecords]);
+        int numTypos = 1 + nextRandom(&state) % FUZZY_EDITS;
+        for (int t = 0; t < numTypos; t++) {
+            makeTypo(queries[q], &state);
+        }
+    }
+
+    struct NameIndex index;
+    nameIndexInit(&index);
+    double start = nowSeconds();
+    for (int i = 0; i < numRecords; i++) {
+        nameIndexAdd(&index, lastNames[i], MIN_ID + i);
+    }
+    double buildSeconds = nowSeconds() - start;
+
+    long* indexedRows = allocate(sizeof(long) * numQueries);
+    long numMatchedNames = 0;
+    start = nowSeconds();
+    for (int q = 0; q < numQueries; q++) {
+        struct NameMatch* matches;
+        int numMatches = nameIndexSearch(&index, queries[q], FUZZY_EDITS, &matches);
+        indexedRows[q] = 0;
+        for (int m = 0; m < numMatches; m++) {
+            indexedRows[q] += matches[m].name->numIds;
+        }
+        numMatchedNames += numMatches;
+        free(matches);
+    }
+    double indexSeconds = nowSeconds() - start;
+
+    int numScans = (numQueries < FUZZY_SCAN_QUERIES) ? numQueries : FUZZY_SCAN_QUERIES;
+    start = nowSeconds();
+    for (int q = 0; q < numScans; q++) {
+        long scannedRows = 0;
+        for (int i = 0; i < numRecords; i++) {
+            scannedRows += nameEditDistance(queries[q], lastNames[i], FUZZY_EDITS) <= FUZZY_EDITS;
+        }
+        if (scannedRows != indexedRows[q]) {
+            fprintf(stderr, "Error: query %s finds %ld rows through the index and %ld by a scan\n", queries[q],
+                    indexedRows[q], scannedRows);
+            exit(1);
+        }
+    }
+    double scanSeconds = nowSeconds() - start;
+
+    printf("Fuzzy search: %d rows, %d distinct last names, queries with 1 to %d typos, up to %d edits\n",
+           numRecords, index.numNames, FUZZY_EDITS, FUZZY_EDITS);
+    printf("index build: %.1f ms\n", buildSeconds * 1e3);
+    printf("%-8s %10s %14s\n", "search", "queries", "ms per query");
+    printf("%-8s %10d %14.3f\n", "index", numQueries, indexSeconds * 1e3 / numQueries);
+    printf("%-8s %10d %14.3f\n", "scan", numScans, scanSeconds * 1e3 / numScans);
+    printf("Average %.1f names matched per query; the index is %.0fx faster\n",
+           (double)numMatchedNames / numQueries, (scanSeconds / numScans) / (indexSeconds / numQueries));
+
+    nameIndexFree(&index);
+    free(indexedRows);
+    free(queries);
+    free(lastNames);
+}
+
+
+/**
+ * @brief Parses an optional positive integer argument.
+ */
+static int parseCount(int argc, char* argv[], int index, int defaultValue) {
+    if (index >= argc) {
+        return defaultValue;
+    }
+    int value = atoi(argv[index]);
+    if (value <= 0) {
+        fprintf(stderr, "Invalid number: %s\n", argv[index]);
+        exit(1);
+    }
+    return value;
+}
+
+
+/**
+ * @brief Runs the benchmark selected on the command line.
+ */
+int main(int argc, char* argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Usage: %s storage [numRecords] [numOperations] [lookupPercent]\n", argv[0]);
+        fprintf(stderr, "       %s generate <numRecords> <file> [invalidPercent]\n", argv[0]);
+        fprintf(stderr, "       %s ingest <file> [repetitions]\n", argv[0]);
+        fprintf(stderr, "       %s columnar <file> [repetitions]\n", argv[0]);
+        fprintf(stderr, "       %s snapshot [numRecords] [numChanges] [maxReaders]\n", argv[0]);
+        fprintf(stderr, "       %s lookup [numRecords] [maxThreads] [milliseconds]\n", argv[0]);
+        fprintf(stderr, "       %s alloc [numObjects] [numOperations] [maxThreads]\n", argv[0]);
+        fprintf(stderr, "       %s transaction [numRecords] [batchSize]\n", argv[0]);
+        fprintf(stderr, "       %s fuzzy [numRecords] [numQueries]\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "storage") == 0) {
+        int lookupPercent = (argc > 4) ? atoi(argv[4]) : DEFAULT_LOOKUP_PERCENT;
+        if (lookupPercent < 0 || lookupPercent > 100) {
+            fprintf(stderr, "Invalid lookup percentage: %s\n", argv[4]);
+            return 1;
+        }
+        benchmarkStorage(parseCount(argc, argv, 2, DEFAULT_STORAGE_RECORDS),
+                         parseCount(argc, argv, 3, DEFAULT_STORAGE_OPERATIONS), lookupPercent);
+    } else if (strcmp(argv[1], "generate") == 0 && argc >= 4) {
+        int invalidPercent = (argc > 4) ? atoi(argv[4]) : 0;
+        if (invalidPercent < 0 || invalidPercent > 100) {
+            fprintf(stderr, "Invalid percentage: %s\n", argv[4]);
+            return 1;
+        }
+        generateEmployeeFile(parseCount(argc, argv, 2, 0), argv[3], invalidPercent);
+    } else if (strcmp(argv[1], "ingest") == 0 && argc >= 3) {
+        benchmarkIngest(argv[2], parseCount(argc, argv, 3, DEFAULT_INGEST_REPETITIONS));
+    } else if (strcmp(argv[1], "columnar") == 0 && argc >= 3) {
+        benchmarkColumnar(argv[2], parseCount(argc, argv, 3, DEFAULT_INGEST_REPETITIONS));
+    } else if (strcmp(argv[1], "snapshot") == 0) {
+        benchmarkSnapshots(parseCount(argc, argv, 2, DEFAULT_SNAPSHOT_RECORDS),
+                           parseCount(argc, argv, 3, DEFAULT_SNAPSHOT_OPERATIONS),
+                           parseCount(argc, argv, 4, DEFAULT_SNAPSHOT_READERS));
+    } else if (strcmp(argv[1], "lookup") == 0) {
+        benchmarkLookups(parseCount(argc, argv, 2, DEFAULT_LOOKUP_RECORDS),
+                         parseCount(argc, argv, 3, DEFAULT_LOOKUP_THREADS),
+                         parseCount(argc, argv, 4, DEFAULT_LOOKUP_MILLISECONDS));
+    } else if (strcmp(argv[1], "alloc") == 0) {
+        benchmarkAllocation(parseCount(argc, argv, 2, DEFAULT_ALLOC_OBJECTS),
+                            parseCount(argc, argv, 3, DEFAULT_ALLOC_OPERATIONS),
+                            parseCount(argc, argv, 4, DEFAULT_ALLOC_THREADS));
+    } else if (strcmp(argv[1], "transaction") == 0) {
+        benchmarkTransactions(parseCount(argc, argv, 2, DEFAULT_TRANSACTION_RECORDS),
+                              parseCount(argc, argv, 3, DEFAULT_TRANSACTION_BATCH));
+    } else if (strcmp(argv[1], "fuzzy") == 0) {
+        benchmarkFuzzy(parseCount(argc, argv, 2, DEFAULT_FUZZY_RECORDS),
+                       parseCount(argc, argv, 3, DEFAULT_FUZZY_QUERIES));
+    } else {
+        fprintf(stderr, "Unknown benchmark: %s\n", argv[1]);
+        return 1;
+    }
+    return 0;
+}
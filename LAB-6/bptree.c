@@ -0,0 +1,693 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <pthread.h>
+
+#include "bptree.h"
+#include "pool.h"
+
+/*
+ * A B+-tree keyed on employee ID. The records live in the leaves, so a lookup, an insert and a removal
+ * touch one page per level (O(log n)) and an ordered scan reads the leaves from left to right. Nodes are
+ * kept at least half full: an insert splits a full node, and a removal that leaves a node below half
+ * full borrows a record (or key) from a sibling, or merges with it when the sibling is at its minimum.
+ *
+ * Snapshots share nodes with the tree (copy-on-write). Taking a snapshot freezes the nodes of the current
+ * version and starts a new one; a change to a frozen node writes a copy in the new version, links the
+ * copy into its parent (copying the parent too if it is frozen, up to the root) and retires the frozen
+ * node. Retired nodes are freed by bptreeReclaim once the snapshots older than their retirement are
+ * released, so a snapshot always sees the tree as it was when it was taken.
+ *
+ * Leaves and internal nodes come from two pools shared by every tree (pool.c), so the splits, merges
+ * and copies of a busy tree do not call malloc for each node, and a node freed by a report thread is
+ * reused through that thread's cache.
+ */
+
+// Fewest records in a leaf and keys in an internal node, except in the root
+#define MIN_LEAF_RECORDS (BPTREE_LEAF_CAPACITY / 2)
+#define MIN_INTERNAL_KEYS (BPTREE_FANOUT / 2 - 1)
+
+
+// Nodes of every tree, created by the first bptreeInit
+static struct Pool leafPool;
+static struct Pool internalPool;
+static pthread_once_t nodePoolsOnce = PTHREAD_ONCE_INIT;
+
+
+/**
+ * @brief Creates the node pools.
+ */
+static void initNodePools(void) {
+    poolInit(&leafPool, sizeof(struct BPlusLeaf));
+    poolInit(&internalPool, sizeof(struct BPlusInternal));
+}
+
+
+/**
+ * @brief Allocates a node for the given level (the program exits on allocation failure).
+ */
+static void* allocateNode(int level) {
+    return poolAlloc((level > 0) ? &internalPool : &leafPool);
+}
+
+
+/**
+ * @brief Frees a node of the given level.
+ */
+static void deallocateNode(void* node, int level) {
+    poolFree((level > 0) ? &internalPool : &leafPool, node);
+}
+
+
+/**
+ * @brief Returns the version a node on the given level was written in.
+ */
+static int nodeVersion(const void* node, int level) {
+    return (level > 0) ? ((const struct BPlusInternal*)node)->version : ((const struct BPlusLeaf*)node)->version;
+}
+
+
+/**
+ * @brief Adds a node that is no longer part of the tree to the retired nodes.
+ */
+static void retireNode(struct BPlusTree* tree, void* node, int level) {
+    if (tree->numRetired == tree->retiredCapacity) {
+        tree->retiredCapacity = (tree->retiredCapacity > 0) ? 2 * tree->retiredCapacity : 64;
+        tree->retired = (struct RetiredNode*)realloc(tree->retired, sizeof(struct RetiredNode) * tree->retiredCapacity);
+        if (tree->retired == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    tree->retired[tree->numRetired].node = node;
+    tree->retired[tree->numRetired].version = tree->version;
+    tree->retired[tree->numRetired].level = level;
+    tree->numRetired++;
+}
+
+
+/**
+ * @brief Gives back a node removed from the tree: freed at once if it is of the current version,
+ *        retired if a snapshot may still reach it.
+ */
+static void releaseNode(struct BPlusTree* tree, void* node, int level) {
+    if (nodeVersion(node, level) == tree->version) {
+        deallocateNode(node, level);
+    } else {
+        retireNode(tree, node, level);
+    }
+}
+
+
+/**
+ * @brief Returns the node stored in *slot, ready to be changed in place.
+ *
+ * A node of an older version is copied into the current version, the copy is stored in *slot and the
+ * original is retired. The node holding slot must already be writable.
+ *
+ * @param slot Pointer to the root pointer of the tree or to the child pointer of the parent.
+ * @param level Level of the node (0 for a leaf).
+ */
+static void* writableNode(struct BPlusTree* tree, void** slot, int level) {
+    void* node = *slot;
+    if (nodeVersion(node, level) == tree->version) {
+        return node;
+    }
+    size_t size = (level > 0) ? sizeof(struct BPlusInternal) : sizeof(struct BPlusLeaf);
+    void* copy = allocateNode(level);
+    memcpy(copy, node, size);
+    if (level > 0) {
+        ((struct BPlusInternal*)copy)->version = tree->version;
+    } else {
+        ((struct BPlusLeaf*)copy)->version = tree->version;
+    }
+    retireNode(tree, node, level);
+    *slot = copy;
+    return copy;
+}
+
+
+/**
+ * @brief Returns the index of the first record of a leaf whose ID is >= id.
+ */
+static int leafLowerBound(const struct BPlusLeaf* leaf, int id) {
+    int low = 0;
+    int high = leaf->numRecords;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (leaf->records[mid].id < id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+
+/**
+ * @brief Returns the index of the child of an internal node whose subtree can hold id.
+ */
+static int childIndex(const struct BPlusInternal* node, int id) {
+    int low = 0;
+    int high = node->numKeys;
+    while (low < high) {
+        int mid = (low + high) / 2;
+        if (node->keys[mid] <= id) {
+            low = mid + 1;
+        } else {
+            high = mid;
+        }
+    }
+    return low;
+}
+
+
+/**
+ * @brief Initializes an empty tree.
+ *
+ * @param tree Pointer to the tree.
+ */
+void bptreeInit(struct BPlusTree* tree) {
+    pthread_once(&nodePoolsOnce, initNodePools);
+    tree->root = NULL;
+    tree->height = 0;
+    tree->size = 0;
+    tree->version = 0;
+    tree->retired = NULL;
+    tree->numRetired = 0;
+    tree->retiredCapacity = 0;
+}
+
+
+/**
+ * @brief Frees a subtree.
+ */
+static void freeNode(void* node, int level) {
+    if (level > 0) {
+        struct BPlusInternal* internal = (struct BPlusInternal*)node;
+        for (int i = 0; i <= internal->numKeys; i++) {
+            freeNode(internal->children[i], level - 1);
+        }
+    }
+    deallocateNode(node, level);
+}
+
+
+/**
+ * @brief Frees every node of a tree, including the retired ones, and leaves it empty.
+ *
+ * Snapshots of the tree must not be used afterwards.
+ *
+ * @param tree Pointer to the tree.
+ */
+void bptreeFree(struct BPlusTree* tree) {
+    if (tree->root != NULL) {
+        freeNode(tree->root, tree->height);
+    }
+    bptreeReclaim(tree, INT_MAX);
+    free(tree->retired);
+    bptreeInit(tree);
+}
+
+
+/**
+ * @brief Looks up an employee by ID.
+ *
+ * @param tree Pointer to the tree.
+ * @param id ID to look up.
+ * @return Pointer to the record inside its leaf, or NULL if there is no employee with this ID. The
+ *         pointer stays valid until the tree is next modified (or the snapshot is released).
+ */
+const struct Employee* bptreeFind(const struct BPlusTree* tree, int id) {
+    if (tree->root == NULL) {
+        return NULL;
+    }
+    void* node = tree->root;
+    for (int level = tree->height; level > 0; level--) {
+        const struct BPlusInternal* internal = (const struct BPlusInternal*)node;
+        node = internal->children[childIndex(internal, id)];
+    }
+    const struct BPlusLeaf* leaf = (const struct BPlusLeaf*)node;
+    int pos = leafLowerBound(leaf, id);
+    if (pos < leaf->numRecords && leaf->records[pos].id == id) {
+        return &leaf->records[pos];
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Inserts a record into a leaf, splitting the leaf if it is full.
+ *
+ * The ID must not be in the leaf yet. On a split, *splitNode receives the new right leaf and *splitKey
+ * its first ID; otherwise *splitNode is NULL.
+ */
+static void insertIntoLeaf(struct BPlusTree* tree, struct BPlusLeaf* leaf, const struct Employee* employee,
+                           int* splitKey, void** splitNode) {
+    int pos = leafLowerBound(leaf, employee->id);
+    if (leaf->numRecords < BPTREE_LEAF_CAPACITY) {
+        memmove(&leaf->records[pos + 1], &leaf->records[pos], sizeof(struct Employee) * (leaf->numRecords - pos));
+        leaf->records[pos] = *employee;
+        leaf->numRecords++;
+        return;
+    }
+
+    // Split the full leaf: the left half keeps mid records, the right half gets the rest
+    struct BPlusLeaf* right = (struct BPlusLeaf*)allocateNode(0);
+    right->version = tree->version;
+    int mid = (BPTREE_LEAF_CAPACITY + 1) / 2;
+    struct BPlusLeaf* target = leaf;
+    if (pos < mid) {
+        mid--; // The new record goes to the left half
+    } else {
+        target = right;
+    }
+    right->numRecords = BPTREE_LEAF_CAPACITY - mid;
+    memcpy(right->records, &leaf->records[mid], sizeof(struct Employee) * right->numRecords);
+    leaf->numRecords = mid;
+    if (target == right) {
+        pos -= mid;
+    }
+    memmove(&target->records[pos + 1], &target->records[pos], sizeof(struct Employee) * (target->numRecords - pos));
+    target->records[pos] = *employee;
+    target->numRecords++;
+
+    *splitKey = right->records[0].id;
+    *splitNode = right;
+}
+
+
+/**
+ * @brief Inserts a record into the subtree stored in *slot, splitting nodes on the way back up.
+ *
+ * The ID must not be in the tree yet. The nodes on the path are made writable first. On a split of
+ * the node, *splitNode receives the new right sibling and *splitKey the key that separates them.
+ */
+static void insertInto(struct BPlusTree* tree, void** slot, int level, const struct Employee* employee,
+                       int* splitKey, void** splitNode) {
+    *splitNode = NULL;
+    void* node = writableNode(tree, slot, level);
+    if (level == 0) {
+        insertIntoLeaf(tree, (struct BPlusLeaf*)node, employee, splitKey, splitNode);
+        return;
+    }
+
+    struct BPlusInternal* internal = (struct BPlusInternal*)node;
+    int index = childIndex(internal, employee->id);
+    int childKey;
+    void* childSplit;
+    insertInto(tree, &internal->children[index], level - 1, employee, &childKey, &childSplit);
+    if (childSplit == NULL) {
+        return;
+    }
+
+    if (internal->numKeys < BPTREE_FANOUT - 1) {
+        memmove(&internal->keys[index + 1], &internal->keys[index], sizeof(int) * (internal->numKeys - index));
+        memmove(&internal->children[index + 2], &internal->children[index + 1],
+                sizeof(void*) * (internal->numKeys - index));
+        internal->keys[index] = childKey;
+        internal->children[index + 1] = childSplit;
+        internal->numKeys++;
+        return;
+    }
+
+    // Split the full node around its middle key, which moves up to the parent
+    int keys[BPTREE_FANOUT];
+    void* children[BPTREE_FANOUT + 1];
+    memcpy(keys, internal->keys, sizeof(int) * index);
+    keys[index] = childKey;
+    memcpy(&keys[index + 1], &internal->keys[index], sizeof(int) * (BPTREE_FANOUT - 1 - index));
+    memcpy(children, internal->children, sizeof(void*) * (index + 1));
+    children[index + 1] = childSplit;
+    memcpy(&children[index + 2], &internal->children[index + 1], sizeof(void*) * (BPTREE_FANOUT - 1 - index));
+
+    struct BPlusInternal* right = (struct BPlusInternal*)allocateNode(level);
+    right->version = tree->version;
+    int mid = BPTREE_FANOUT / 2;
+    internal->numKeys = mid;
+    memcpy(internal->keys, keys, sizeof(int) * mid);
+    memcpy(internal->children, children, sizeof(void*) * (mid + 1));
+    right->numKeys = BPTREE_FANOUT - mid - 1;
+    memcpy(right->keys, &keys[mid + 1], sizeof(int) * right->numKeys);
+    memcpy(right->children, &children[mid + 1], sizeof(void*) * (right->numKeys + 1));
+
+    *splitKey = keys[mid];
+    *splitNode = right;
+}
+
+
+/**
+ * @brief Inserts an employee.
+ *
+ * @param tree Pointer to the tree.
+ * @param employee Record to insert (copied into the tree).
+ * @return 1 if the employee was inserted, 0 if an employee with the same ID is already in the tree.
+ */
+int bptreeInsert(struct BPlusTree* tree, const struct Employee* employee) {
+    // Check first, so that no nodes are copied for nothing
+    if (bptreeFind(tree, employee->id) != NULL) {
+        return 0;
+    }
+    if (tree->root == NULL) {
+        struct BPlusLeaf* leaf = (struct BPlusLeaf*)allocateNode(0);
+        leaf->version = tree->version;
+        leaf->numRecords = 0;
+        tree->root = leaf;
+        tree->height = 0;
+    }
+
+    int splitKey;
+    void* splitNode;
+    insertInto(tree, &tree->root, tree->height, employee, &splitKey, &splitNode);
+    if (splitNode != NULL) {
+        // The root was split: grow the tree by one level
+        struct BPlusInternal* root = (struct BPlusInternal*)allocateNode(tree->height + 1);
+        root->version = tree->version;
+        root->numKeys = 1;
+        root->keys[0] = splitKey;
+        root->children[0] = tree->root;
+        root->children[1] = splitNode;
+        tree->root = root;
+        tree->height++;
+    }
+    tree->size++;
+    return 1;
+}
+
+
+/**
+ * @brief Refills the leaf children[index] of a node, which has fallen below half full.
+ *
+ * The node and the leaf must be writable; a sibling is made writable if it gives up a record.
+ */
+static void rebalanceLeaf(struct BPlusTree* tree, struct BPlusInternal* parent, int index) {
+    struct BPlusLeaf* child = (struct BPlusLeaf*)parent->children[index];
+    struct BPlusLeaf* left = (index > 0) ? (struct BPlusLeaf*)parent->children[index - 1] : NULL;
+    struct BPlusLeaf* right = (index < parent->numKeys) ? (struct BPlusLeaf*)parent->children[index + 1] : NULL;
+
+    if (left != NULL && left->numRecords > MIN_LEAF_RECORDS) {
+        // Borrow the last record of the left sibling
+        left = (struct BPlusLeaf*)writableNode(tree, &parent->children[index - 1], 0);
+        memmove(&child->records[1], child->records, sizeof(struct Employee) * child->numRecords);
+        child->records[0] = left->records[--left->numRecords];
+        child->numRecords++;
+        parent->keys[index - 1] = child->records[0].id;
+        return;
+    }
+    if (right != NULL && right->numRecords > MIN_LEAF_RECORDS) {
+        // Borrow the first record of the right sibling
+        right = (struct BPlusLeaf*)writableNode(tree, &parent->children[index + 1], 0);
+        child->records[child->numRecords++] = right->records[0];
+        right->numRecords--;
+        memmove(right->records, &right->records[1], sizeof(struct Employee) * right->numRecords);
+        parent->keys[index] = right->records[0].id;
+        return;
+    }
+
+    // Merge with a sibling at its minimum: the right one of the pair goes away
+    if (left == NULL) {
+        left = child;
+        index++;
+    } else {
+        left = (struct BPlusLeaf*)writableNode(tree, &parent->children[index - 1], 0);
+        right = child;
+    }
+    memcpy(&left->records[left->numRecords], right->records, sizeof(struct Employee) * right->numRecords);
+    left->numRecords += right->numRecords;
+    releaseNode(tree, right, 0);
+    memmove(&parent->keys[index - 1], &parent->keys[index], sizeof(int) * (parent->numKeys - index));
+    memmove(&parent->children[index], &parent->children[index + 1], sizeof(void*) * (parent->numKeys - index));
+    parent->numKeys--;
+}
+
+
+/**
+ * @brief Refills the internal node children[index] of a node, which has fallen below half full.
+ *
+ * The node and its child must be writable; a sibling is made writable if it gives up a child.
+ */
+static void rebalanceInternal(struct BPlusTree* tree, struct BPlusInternal* parent, int index, int level) {
+    struct BPlusInternal* child = (struct BPlusInternal*)parent->children[index];
+    struct BPlusInternal* left = (index > 0) ? (struct BPlusInternal*)parent->children[index - 1] : NULL;
+    struct BPlusInternal* right = (index < parent->numKeys) ? (struct BPlusInternal*)parent->children[index + 1] : NULL;
+
+    if (left != NULL && left->numKeys > MIN_INTERNAL_KEYS) {
+        // Rotate the last child of the left sibling through the parent
+        left = (struct BPlusInternal*)writableNode(tree, &parent->children[index - 1], level);
+        memmove(&child->keys[1], child->keys, sizeof(int) * child->numKeys);
+        memmove(&child->children[1], child->children, sizeof(void*) * (child->numKeys + 1));
+        child->keys[0] = parent->keys[index - 1];
+        child->children[0] = left->children[left->numKeys];
+        child->numKeys++;
+        parent->keys[index - 1] = left->keys[--left->numKeys];
+        return;
+    }
+    if (right != NULL && right->numKeys > MIN_INTERNAL_KEYS) {
+        // Rotate the first child of the right sibling through the parent
+        right = (struct BPlusInternal*)writableNode(tree, &parent->children[index + 1], level);
+        child->keys[child->numKeys] = parent->keys[index];
+        child->children[child->numKeys + 1] = right->children[0];
+        child->numKeys++;
+        parent->keys[index] = right->keys[0];
+        right->numKeys--;
+        memmove(right->keys, &right->keys[1], sizeof(int) * right->numKeys);
+        memmove(right->children, &right->children[1], sizeof(void*) * (right->numKeys + 1));
+        return;
+    }
+
+    // Merge with a sibling at its minimum, pulling down the key that separates them
+    if (left == NULL) {
+        left = child;
+        index++;
+    } else {
+        left = (struct BPlusInternal*)writableNode(tree, &parent->children[index - 1], level);
+        right = child;
+    }
+    left->keys[left->numKeys] = parent->keys[index - 1];
+    memcpy(&left->keys[left->numKeys + 1], right->keys, sizeof(int) * right->numKeys);
+    memcpy(&left->children[left->numKeys + 1], right->children, sizeof(void*) * (right->numKeys + 1));
+    left->numKeys += right->numKeys + 1;
+    releaseNode(tree, right, level);
+    memmove(&parent->keys[index - 1], &parent->keys[index], sizeof(int) * (parent->numKeys - index));
+    memmove(&parent->children[index], &parent->children[index + 1], sizeof(void*) * (parent->numKeys - index));
+    parent->numKeys--;
+}
+
+
+/**
+ * @brief Removes a record from the subtree stored in *slot, rebalancing the children that fall below
+ *        half full.
+ *
+ * The record must be in the tree. The nodes on the path are made writable first.
+ */
+static void removeFrom(struct BPlusTree* tree, void** slot, int level, int id, struct Employee* removed) {
+    void* node = writableNode(tree, slot, level);
+    if (level == 0) {
+        struct BPlusLeaf* leaf = (struct BPlusLeaf*)node;
+        int pos = leafLowerBound(leaf, id);
+        if (removed != NULL) {
+            *removed = leaf->records[pos];
+        }
+        leaf->numRecords--;
+        memmove(&leaf->records[pos], &leaf->records[pos + 1], sizeof(struct Employee) * (leaf->numRecords - pos));
+        return;
+    }
+
+    struct BPlusInternal* internal = (struct BPlusInternal*)node;
+    int index = childIndex(internal, id);
+    removeFrom(tree, &internal->children[index], level - 1, id, removed);
+    if (level == 1) {
+        if (((struct BPlusLeaf*)internal->children[index])->numRecords < MIN_LEAF_RECORDS) {
+            rebalanceLeaf(tree, internal, index);
+        }
+    } else if (((struct BPlusInternal*)internal->children[index])->numKeys < MIN_INTERNAL_KEYS) {
+        rebalanceInternal(tree, internal, index, level - 1);
+    }
+}
+
+
+/**
+ * @brief Removes an employee.
+ *
+ * @param tree Pointer to the tree.
+ * @param id ID of the employee to remove.
+ * @param removed Receives the removed record (may be NULL).
+ * @return 1 if the employee was removed, 0 if there is no employee with this ID.
+ */
+int bptreeRemove(struct BPlusTree* tree, int id, struct Employee* removed) {
+    if (bptreeFind(tree, id) == NULL) {
+        return 0;
+    }
+    removeFrom(tree, &tree->root, tree->height, id, removed);
+    tree->size--;
+
+    // Shrink the tree when the root is left with a single child or no records
+    if (tree->height > 0 && ((struct BPlusInternal*)tree->root)->numKeys == 0) {
+        void* child = ((struct BPlusInternal*)tree->root)->children[0];
+        releaseNode(tree, tree->root, tree->height);
+        tree->root = child;
+        tree->height--;
+    } else if (tree->height == 0 && ((struct BPlusLeaf*)tree->root)->numRecords == 0) {
+        releaseNode(tree, tree->root, 0);
+        tree->root = NULL;
+    }
+    return 1;
+}
+
+
+/**
+ * @brief Replaces the record of an employee with a new version of it.
+ *
+ * @param tree Pointer to the tree.
+ * @param employee New record; its ID selects the record to replace.
+ * @param replaced Receives the previous record (may be NULL).
+ * @return 1 if the record was replaced, 0 if there is no employee with this ID.
+ */
+int bptreeReplace(struct BPlusTree* tree, const struct Employee* employee, struct Employee* replaced) {
+    if (bptreeFind(tree, employee->id) == NULL) {
+        return 0;
+    }
+    void** slot = &tree->root;
+    for (int level = tree->height; level > 0; level--) {
+        struct BPlusInternal* internal = (struct BPlusInternal*)writableNode(tree, slot, level);
+        slot = &internal->children[childIndex(internal, employee->id)];
+    }
+    struct BPlusLeaf* leaf = (struct BPlusLeaf*)writableNode(tree, slot, 0);
+    struct Employee* record = &leaf->records[leafLowerBound(leaf, employee->id)];
+    if (replaced != NULL) {
+        *replaced = *record;
+    }
+    *record = *employee;
+    return 1;
+}
+
+
+/**
+ * @brief Takes a snapshot of a tree.
+ *
+ * The snapshot is a read-only tree that shares every node with the tree and can be read with
+ * bptreeFind, bptreeSeek and bptreeNext while the tree is changed. Its version is the version of
+ * the tree it shows; the nodes it reaches are not freed while bptreeReclaim is given a version
+ * at most that old. The snapshot itself owns nothing and is not freed.
+ *
+ * @param tree Pointer to the tree.
+ * @param snapshot Receives the snapshot.
+ */
+void bptreeSnapshot(struct BPlusTree* tree, struct BPlusTree* snapshot) {
+    snapshot->root = tree->root;
+    snapshot->height = tree->height;
+    snapshot->size = tree->size;
+    snapshot->version = tree->version;
+    snapshot->retired = NULL;
+    snapshot->numRetired = 0;
+    snapshot->retiredCapacity = 0;
+    tree->version++; // Freeze the nodes the snapshot shares
+}
+
+
+/**
+ * @brief Frees the retired nodes that no snapshot can reach any more.
+ *
+ * A node retired in version v is reachable only from snapshots of versions before v, so it is freed
+ * once the oldest snapshot still in use is of version v or later. Nodes are retired in version order,
+ * so the ones to free are at the front of the list.
+ *
+ * @param tree Pointer to the tree.
+ * @param oldestSnapshot Version of the oldest snapshot still in use, INT_MAX if there is none.
+ * @return Number of nodes freed.
+ */
+int bptreeReclaim(struct BPlusTree* tree, int oldestSnapshot) {
+    int freed = 0;
+    while (freed < tree->numRetired && tree->retired[freed].version <= oldestSnapshot) {
+        deallocateNode(tree->retired[freed].node, tree->retired[freed].level);
+        freed++;
+    }
+    if (freed > 0) {
+        tree->numRetired -= freed;
+        memmove(tree->retired, &tree->retired[freed], sizeof(struct RetiredNode) * tree->numRetired);
+    }
+    return freed;
+}
+
+
+/**
+ * @brief Returns the highest ID in the tree, or -1 if the tree is empty.
+ *
+ * @param tree Pointer to the tree.
+ */
+int bptreeMaxId(const struct BPlusTree* tree) {
+    if (tree->root == NULL) {
+        return -1;
+    }
+    const void* node = tree->root;
+    for (int level = tree->height; level > 0; level--) {
+        const struct BPlusInternal* internal = (const struct BPlusInternal*)node;
+        node = internal->children[internal->numKeys];
+    }
+    const struct BPlusLeaf* leaf = (const struct BPlusLeaf*)node;
+    return leaf->records[leaf->numRecords - 1].id;
+}
+
+
+/**
+ * @brief Starts an ordered scan at the first employee whose ID is >= id.
+ *
+ * @param tree Pointer to the tree; it must not be modified while the cursor is in use.
+ * @param id Lowest ID of the scan (MIN_ID or less scans the whole tree).
+ * @param cursor Pointer to the cursor to position.
+ */
+void bptreeSeek(const struct BPlusTree* tree, int id, struct BPlusCursor* cursor) {
+    if (tree->root == NULL) {
+        cursor->height = -1;
+        return;
+    }
+    const void* node = tree->root;
+    for (int level = 0; level < tree->height; level++) {
+        const struct BPlusInternal* internal = (const struct BPlusInternal*)node;
+        cursor->nodes[level] = node;
+        cursor->positions[level] = childIndex(internal, id);
+        node = internal->children[cursor->positions[level]];
+    }
+    cursor->nodes[tree->height] = node;
+    cursor->positions[tree->height] = leafLowerBound((const struct BPlusLeaf*)node, id);
+    cursor->height = tree->height;
+}
+
+
+/**
+ * @brief Returns the next employee of an ordered scan.
+ *
+ * @param cursor Pointer to a cursor positioned by bptreeSeek.
+ * @return Pointer to the record, or NULL when the scan has passed the highest ID.
+ */
+const struct Employee* bptreeNext(struct BPlusCursor* cursor) {
+    int height = cursor->height;
+    if (height < 0) {
+        return NULL;
+    }
+    const struct BPlusLeaf* leaf = (const struct BPlusLeaf*)cursor->nodes[height];
+    if (cursor->positions[height] < leaf->numRecords) {
+        return &leaf->records[cursor->positions[height]++];
+    }
+
+    // Climb to the nearest ancestor with a child to the right, then descend to its leftmost leaf
+    int level = height - 1;
+    while (level >= 0 && cursor->positions[level] == ((const struct BPlusInternal*)cursor->nodes[level])->numKeys) {
+        level--;
+    }
+    if (level < 0) {
+        cursor->height = -1;
+        return NULL;
+    }
+    cursor->positions[level]++;
+    for (; level < height; level++) {
+        const struct BPlusInternal* internal = (const struct BPlusInternal*)cursor->nodes[level];
+        cursor->nodes[level + 1] = internal->children[cursor->positions[level]];
+        cursor->positions[level + 1] = 0;
+    }
+    leaf = (const struct BPlusLeaf*)cursor->nodes[height];
+    cursor->positions[height] = 1;
+    return &leaf->records[0];
+}
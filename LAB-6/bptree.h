@@ -0,0 +1,67 @@
+#ifndef BPTREE_H
+#define BPTREE_H
+
+#include "employee.h"
+
+// Employees per leaf page (a page is about 4 KB)
+#define BPTREE_LEAF_CAPACITY 32
+// Children per internal node
+#define BPTREE_FANOUT 64
+// Deepest tree a cursor can walk; with half-full nodes this is far more than 2^31 records
+#define BPTREE_MAX_HEIGHT 8
+
+// Leaf page holding employee records sorted by ID
+struct BPlusLeaf {
+    int version;                            // Version of the tree the page was written in
+    int numRecords;
+    struct Employee records[BPTREE_LEAF_CAPACITY];
+};
+
+// Internal node: every ID in children[i + 1] is >= keys[i], every ID in children[i] is < keys[i]
+struct BPlusInternal {
+    int version;                            // Version of the tree the node was written in
+    int numKeys;                            // The node has numKeys + 1 children
+    int keys[BPTREE_FANOUT - 1];
+    void* children[BPTREE_FANOUT];          // Leaves if the node is on the lowest internal level
+};
+
+// Node replaced by a copy, waiting until no snapshot can reach it
+struct RetiredNode {
+    void* node;
+    int version;                            // Version of the tree that replaced it
+    int level;                              // Level of the node (0 for a leaf)
+};
+
+// B+-tree of employees keyed on ID.
+// Nodes of the current version are changed in place; older nodes may be shared with snapshots, so a
+// change copies them (and the path above them) and retires the originals.
+struct BPlusTree {
+    void* root;                             // NULL when the tree is empty
+    int height;                             // Number of internal levels; 0 when the root is a leaf
+    int size;                               // Number of records
+    int version;                            // Version new and copied nodes are written in
+    struct RetiredNode* retired;            // Replaced nodes not freed yet
+    int numRetired;
+    int retiredCapacity;
+};
+
+// Position in an ordered scan of a tree
+struct BPlusCursor {
+    const void* nodes[BPTREE_MAX_HEIGHT + 1];   // Path from the root (index 0) to the current leaf
+    int positions[BPTREE_MAX_HEIGHT + 1];       // Child index on internal levels, next record in the leaf
+    int height;                                 // Index of the leaf in the path; -1 when the scan is over
+};
+
+void bptreeInit(struct BPlusTree* tree);
+void bptreeFree(struct BPlusTree* tree);
+const struct Employee* bptreeFind(const struct BPlusTree* tree, int id);
+int bptreeInsert(struct BPlusTree* tree, const struct Employee* employee);
+int bptreeRemove(struct BPlusTree* tree, int id, struct Employee* removed);
+int bptreeReplace(struct BPlusTree* tree, const struct Employee* employee, struct Employee* replaced);
+void bptreeSnapshot(struct BPlusTree* tree, struct BPlusTree* snapshot);
+int bptreeReclaim(struct BPlusTree* tree, int oldestSnapshot);
+int bptreeMaxId(const struct BPlusTree* tree);
+void bptreeSeek(const struct BPlusTree* tree, int id, struct BPlusCursor* cursor);
+const struct Employee* bptreeNext(struct BPlusCursor* cursor);
+
+#endif
@@ -0,0 +1,674 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "columnar.h"
+
+/*
+ * A columnar snapshot stores the employees in ID order, column by column, in blocks of
+ * COLUMNAR_BLOCK_RECORDS records. All numbers are little-endian.
+ *
+ *   header      magic, format version, number of records, number of blocks, number of last names,
+ *               size and CRC-32 of the dictionary
+ *   dictionary  the distinct last names, each as a length byte and its characters
+ *   block       number of records, size and CRC-32 of the payload, then the payload:
+ *                 IDs          the first ID, then the gaps between consecutive IDs minus one, bit-packed
+ *                 salaries     the lowest salary of the block, then each salary minus it, bit-packed
+ *                              (frame of reference)
+ *                 last names   the dictionary index of each name, bit-packed
+ *                 first names  the end offset of each name in the blob, bit-packed, then the blob
+ *
+ * A bit-packed column is a width byte and the values at that many bits each, lowest bit first. The width
+ * is the smallest that fits the largest value of the block, so dense IDs take a bit or two and salaries 17
+ * bits. Decoding unpacks each column with a loop that has no branches (an unaligned 64-bit load, a shift
+ * and a mask per value) and then adds the frame or prefix-sums the gaps, which compilers can unroll and
+ * vectorize; the loaded file has LOAD_PADDING zero bytes behind it so the last loads stay in bounds.
+ */
+
+#define COLUMNAR_VERSION 1
+// Magic and six 32-bit fields
+#define HEADER_BYTES (COLUMNAR_MAGIC_LENGTH + 6 * 4)
+// Number of records, payload size and checksum
+#define BLOCK_HEADER_BYTES (3 * 4)
+// Smallest payload of a block: the first ID, the salary frame, the blob length and four width bytes
+#define MIN_PAYLOAD_BYTES (3 * 4 + 4)
+// Zero bytes after the loaded file, so unpacking may load 8 bytes at any position of it
+#define LOAD_PADDING 8
+// Initial number of last names of the dictionary of a snapshot being written; it doubles as needed
+#define INITIAL_DICTIONARY_CAPACITY 1024
+
+// Bytes of a file or block being written
+struct ByteBuffer {
+    unsigned char* data;
+    size_t length;
+    size_t capacity;
+};
+
+// Distinct last names of a snapshot being written, with a hash table from name to index
+struct Dictionary {
+    char (*names)[MAX_NAME_LENGTH];
+    int count;
+    int capacity;
+    int* slots;                     // Index in names, -1 if empty
+    int numSlots;                   // Power of two, at least twice count
+};
+
+// Part of a loaded file still to be decoded
+struct Decoder {
+    const unsigned char* position;
+    const unsigned char* end;
+};
+
+// A last name of a loaded dictionary, inside the file
+struct DictionaryName {
+    const unsigned char* name;
+    int length;
+};
+
+
+/**
+ * @brief Resizes an array (the program exits on allocation failure).
+ */
+static void* resizeArray(void* array, size_t size) {
+    array = realloc(array, size);
+    if (array == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+
+/**
+ * @brief Makes room for count more bytes in a buffer.
+ */
+static void reserveBytes(struct ByteBuffer* buffer, size_t count) {
+    if (buffer->length + count > buffer->capacity) {
+        buffer->capacity = 2 * (buffer->length + count);
+        buffer->data = (unsigned char*)resizeArray(buffer->data, buffer->capacity);
+    }
+}
+
+
+/**
+ * @brief Appends bytes to a buffer.
+ */
+static void putBytes(struct ByteBuffer* buffer, const void* bytes, size_t count) {
+    reserveBytes(buffer, count);
+    memcpy(buffer->data + buffer->length, bytes, count);
+    buffer->length += count;
+}
+
+
+/**
+ * @brief Appends a byte to a buffer.
+ */
+static void putByte(struct ByteBuffer* buffer, int value) {
+    unsigned char byte = (unsigned char)value;
+    putBytes(buffer, &byte, 1);
+}
+
+
+/**
+ * @brief Appends a little-endian 32-bit number to a buffer.
+ */
+static void putUint32(struct ByteBuffer* buffer, uint32_t value) {
+    unsigned char bytes[4] = {(unsigned char)value, (unsigned char)(value >> 8), (unsigned char)(value >> 16),
+                              (unsigned char)(value >> 24)};
+    putBytes(buffer, bytes, 4);
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit number.
+ */
+static uint32_t getUint32(const unsigned char* bytes) {
+    return (uint32_t)bytes[0] | (uint32_t)bytes[1] << 8 | (uint32_t)bytes[2] << 16 | (uint32_t)bytes[3] << 24;
+}
+
+
+/**
+ * @brief Reads a little-endian 64-bit number (a single unaligned load on common machines).
+ */
+static uint64_t getUint64(const unsigned char* bytes) {
+    return (uint64_t)getUint32(bytes) | (uint64_t)getUint32(bytes + 4) << 32;
+}
+
+
+/**
+ * @brief Fills the table of the CRC-32 (IEEE) checksum.
+ */
+static void crcInit(uint32_t table[256]) {
+    for (uint32_t i = 0; i < 256; i++) {
+        uint32_t crc = i;
+        for (int bit = 0; bit < 8; bit++) {
+            crc = (crc & 1) ? (crc >> 1) ^ 0xEDB88320u : crc >> 1;
+        }
+        table[i] = crc;
+    }
+}
+
+
+/**
+ * @brief Returns the CRC-32 of bytes.
+ */
+static uint32_t crc32(const uint32_t table[256], const unsigned char* bytes, size_t count) {
+    uint32_t crc = 0xFFFFFFFFu;
+    for (size_t i = 0; i < count; i++) {
+        crc = table[(crc ^ bytes[i]) & 0xFF] ^ (crc >> 8);
+    }
+    return crc ^ 0xFFFFFFFFu;
+}
+
+
+/**
+ * @brief Returns the number of bits needed for values up to maxValue.
+ */
+static int bitWidth(uint32_t maxValue) {
+    int width = 0;
+    while (width < 32 && (maxValue >> width) != 0) {
+        width++;
+    }
+    return width;
+}
+
+
+/**
+ * @brief Appends a bit-packed column: the width byte, then count values of that many bits each.
+ */
+static void packColumn(struct ByteBuffer* buffer, const uint32_t* values, int count) {
+    uint32_t maxValue = 0;
+    for (int i = 0; i < count; i++) {
+        maxValue = (values[i] > maxValue) ? values[i] : maxValue;
+    }
+    int width = bitWidth(maxValue);
+    putByte(buffer, width);
+
+    size_t numBytes = ((size_t)count * width + 7) / 8;
+    reserveBytes(buffer, numBytes);
+    unsigned char* packed = buffer->data + buffer->length;
+    memset(packed, 0, numBytes);
+    for (int i = 0; i < count; i++) {
+        size_t position = (size_t)i * width;
+        uint64_t bits = (uint64_t)values[i] << (position % 8);
+        for (size_t byte = position / 8; bits != 0; byte++) {
+            packed[byte] |= (unsigned char)bits;
+            bits >>= 8;
+        }
+    }
+    buffer->length += numBytes;
+}
+
+
+/**
+ * @brief Returns the FNV-1a hash of a name.
+ */
+static unsigned int hashName(const char* name) {
+    unsigned int hash = 2166136261u;
+    for (; *name != '\0'; name++) {
+        hash = (hash ^ (unsigned char)*name) * 16777619u;
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Returns the slot of the hash table of a dictionary holding a name, or the empty slot where it belongs.
+ */
+static int dictionarySlot(const struct Dictionary* dictionary, const char* name) {
+    int mask = dictionary->numSlots - 1;
+    int slot = (int)(hashName(name) & (unsigned int)mask);
+    while (dictionary->slots[slot] >= 0 && strcmp(dictionary->names[dictionary->slots[slot]], name) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Returns the index of a last name in a dictionary, adding the name if it is new.
+ */
+static int dictionaryCode(struct Dictionary* dictionary, const char* name) {
+    int slot = dictionarySlot(dictionary, name);
+    if (dictionary->slots[slot] >= 0) {
+        return dictionary->slots[slot];
+    }
+    if (dictionary->count == dictionary->capacity) {
+        dictionary->capacity *= 2;
+        dictionary->names = resizeArray(dictionary->names, sizeof(*dictionary->names) * dictionary->capacity);
+    }
+    int code = dictionary->count++;
+    snprintf(dictionary->names[code], MAX_NAME_LENGTH, "%s", name);
+    dictionary->slots[slot] = code;
+
+    if (2 * dictionary->count > dictionary->numSlots) {
+        free(dictionary->slots);
+        dictionary->numSlots *= 2;
+        dictionary->slots = (int*)resizeArray(NULL, sizeof(int) * dictionary->numSlots);
+        for (int s = 0; s < dictionary->numSlots; s++) {
+            dictionary->slots[s] = -1;
+        }
+        for (int c = 0; c < dictionary->count; c++) {
+            dictionary->slots[dictionarySlot(dictionary, dictionary->names[c])] = c;
+        }
+    }
+    return code;
+}
+
+
+/**
+ * @brief Appends the payload of a block of employees to a buffer.
+ */
+static void encodeBlock(struct ByteBuffer* buffer, const struct Employee* const* employees, int count,
+                        struct Dictionary* dictionary, uint32_t* values) {
+    // IDs: the first one, then the gaps minus one
+    putUint32(buffer, (uint32_t)employees[0]->id);
+    for (int i = 1; i < count; i++) {
+        values[i - 1] = (uint32_t)(employees[i]->id - employees[i - 1]->id - 1);
+    }
+    packColumn(buffer, values, count - 1);
+
+    // Salaries: offsets from the lowest one
+    int minSalary = employees[0]->salary;
+    for (int i = 1; i < count; i++) {
+        minSalary = (employees[i]->salary < minSalary) ? employees[i]->salary : minSalary;
+    }
+    putUint32(buffer, (uint32_t)minSalary);
+    for (int i = 0; i < count; i++) {
+        values[i] = (uint32_t)employees[i]->salary - (uint32_t)minSalary;
+    }
+    packColumn(buffer, values, count);
+
+    // Last names: dictionary indexes
+    for (int i = 0; i < count; i++) {
+        values[i] = (uint32_t)dictionaryCode(dictionary, employees[i]->last_name);
+    }
+    packColumn(buffer, values, count);
+
+    // First names: end offsets, then the blob
+    uint32_t end = 0;
+    for (int i = 0; i < count; i++) {
+        end += (uint32_t)strlen(employees[i]->first_name);
+        values[i] = end;
+    }
+    packColumn(buffer, values, count);
+    putUint32(buffer, end);
+    for (int i = 0; i < count; i++) {
+        putBytes(buffer, employees[i]->first_name, strlen(employees[i]->first_name));
+    }
+}
+
+
+/**
+ * @brief Writes the records of a tree (or of a snapshot of it) to a columnar snapshot file.
+ *
+ * @param records The records; they must not change while the file is written.
+ * @param filename Name of the file.
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int writeColumnarSnapshot(const struct BPlusTree* records, const char* filename) {
+    FILE* file = fopen(filename, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+    uint32_t crcTable[256];
+    crcInit(crcTable);
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+
+    // The dictionary comes first, so it is built in a first scan
+    struct Dictionary dictionary;
+    dictionary.count = 0;
+    dictionary.capacity = INITIAL_DICTIONARY_CAPACITY;
+    dictionary.names = resizeArray(NULL, sizeof(*dictionary.names) * dictionary.capacity);
+    dictionary.numSlots = 2 * INITIAL_DICTIONARY_CAPACITY;
+    dictionary.slots = (int*)resizeArray(NULL, sizeof(int) * dictionary.numSlots);
+    for (int s = 0; s < dictionary.numSlots; s++) {
+        dictionary.slots[s] = -1;
+    }
+    bptreeSeek(records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        dictionaryCode(&dictionary, employee->last_name);
+    }
+
+    struct ByteBuffer buffer = {NULL, 0, 0};
+    for (int c = 0; c < dictionary.count; c++) {
+        size_t length = strlen(dictionary.names[c]);
+        putByte(&buffer, (int)length);
+        putBytes(&buffer, dictionary.names[c], length);
+    }
+    struct ByteBuffer header = {NULL, 0, 0};
+    putBytes(&header, COLUMNAR_MAGIC, COLUMNAR_MAGIC_LENGTH);
+    putUint32(&header, COLUMNAR_VERSION);
+    putUint32(&header, (uint32_t)records->size);
+    putUint32(&header, (uint32_t)((records->size + COLUMNAR_BLOCK_RECORDS - 1) / COLUMNAR_BLOCK_RECORDS));
+    putUint32(&header, (uint32_t)dictionary.count);
+    putUint32(&header, (uint32_t)buffer.length);
+    putUint32(&header, crc32(crcTable, buffer.data, buffer.length));
+    fwrite(header.data, 1, header.length, file);
+    fwrite(buffer.data, 1, buffer.length, file);
+
+    // Then the blocks, from a second scan
+    const struct Employee** block =
+        (const struct Employee**)resizeArray(NULL, sizeof(struct Employee*) * COLUMNAR_BLOCK_RECORDS);
+    uint32_t* values = (uint32_t*)resizeArray(NULL, sizeof(uint32_t) * COLUMNAR_BLOCK_RECORDS);
+    bptreeSeek(records, MIN_ID, &cursor);
+    int count;
+    do {
+        count = 0;
+        while (count < COLUMNAR_BLOCK_RECORDS && (employee = bptreeNext(&cursor)) != NULL) {
+            block[count++] = employee;
+        }
+        if (count > 0) {
+            buffer.length = 0;
+            encodeBlock(&buffer, block, count, &dictionary, values);
+            header.length = 0;
+            putUint32(&header, (uint32_t)count);
+            putUint32(&header, (uint32_t)buffer.length);
+            putUint32(&header, crc32(crcTable, buffer.data, buffer.length));
+            fwrite(header.data, 1, header.length, file);
+            fwrite(buffer.data, 1, buffer.length, file);
+        }
+    } while (count == COLUMNAR_BLOCK_RECORDS);
+
+    free(block);
+    free(values);
+    free(buffer.data);
+    free(header.data);
+    free(dictionary.names);
+    free(dictionary.slots);
+    int failed = ferror(file);
+    if (fclose(file) != 0) {
+        failed = 1;
+    }
+    return failed ? -1 : 0;
+}
+
+
+/**
+ * @brief Tells whether a file is a columnar snapshot.
+ *
+ * @param filename Name of the file.
+ * @return 1 if the file starts with the columnar magic, 0 otherwise (also if it cannot be opened).
+ */
+int isColumnarFile(const char* filename) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    char magic[COLUMNAR_MAGIC_LENGTH];
+    int columnar = fread(magic, 1, COLUMNAR_MAGIC_LENGTH, file) == COLUMNAR_MAGIC_LENGTH &&
+                   memcmp(magic, COLUMNAR_MAGIC, COLUMNAR_MAGIC_LENGTH) == 0;
+    fclose(file);
+    return columnar;
+}
+
+
+/**
+ * @brief Takes the next count bytes of a decoder.
+ *
+ * @return The bytes, or NULL if fewer are left.
+ */
+static const unsigned char* takeBytes(struct Decoder* decoder, size_t count) {
+    if ((size_t)(decoder->end - decoder->position) < count) {
+        return NULL;
+    }
+    const unsigned char* bytes = decoder->position;
+    decoder->position += count;
+    return bytes;
+}
+
+
+/**
+ * @brief Reads a little-endian 32-bit number from a decoder.
+ *
+ * @return 0 on success, -1 if the decoder is out of bytes.
+ */
+static int takeUint32(struct Decoder* decoder, uint32_t* value) {
+    const unsigned char* bytes = takeBytes(decoder, 4);
+    if (bytes == NULL) {
+        return -1;
+    }
+    *value = getUint32(bytes);
+    return 0;
+}
+
+
+/**
+ * @brief Decodes a bit-packed column of count values.
+ *
+ * @return 0 on success, -1 if the column is malformed.
+ */
+static int unpackColumn(struct Decoder* decoder, int count, uint32_t* values) {
+    const unsigned char* widthByte = takeBytes(decoder, 1);
+    if (widthByte == NULL || *widthByte > 32) {
+        return -1;
+    }
+    int width = *widthByte;
+    const unsigned char* packed = takeBytes(decoder, ((size_t)count * width + 7) / 8);
+    if (packed == NULL) {
+        return -1;
+    }
+    uint64_t mask = ((uint64_t)1 << width) - 1;
+    for (int i = 0; i < count; i++) {
+        size_t position = (size_t)i * width;
+        values[i] = (uint32_t)((getUint64(packed + position / 8) >> (position % 8)) & mask);
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Decodes the payload of a block into employee records.
+ *
+ * @param columns Scratch space for four columns of COLUMNAR_BLOCK_RECORDS values.
+ * @param previousId ID of the last record of the previous block (0 for the first block).
+ * @return 0 on success, -1 if the block is malformed.
+ */
+static int decodeBlock(struct Decoder* decoder, int count, const struct DictionaryName* dictionary,
+                       uint32_t numNames, int previousId, uint32_t* columns, struct Employee* employees) {
+    uint32_t* ids = columns;
+    uint32_t* salaries = columns + COLUMNAR_BLOCK_RECORDS;
+    uint32_t* codes = columns + 2 * COLUMNAR_BLOCK_RECORDS;
+    uint32_t* ends = columns + 3 * COLUMNAR_BLOCK_RECORDS;
+
+    // IDs: prefix sums of the gaps, in 64 bits so a corrupt gap cannot wrap around
+    uint32_t firstId;
+    if (takeUint32(decoder, &firstId) != 0 || (int64_t)firstId <= previousId ||
+        unpackColumn(decoder, count - 1, ids + 1) != 0) {
+        return -1;
+    }
+    ids[0] = firstId;
+    uint64_t id = firstId;
+    for (int i = 1; i < count; i++) {
+        id += (uint64_t)ids[i] + 1;
+        ids[i] = (uint32_t)id;
+    }
+    if (id > INT32_MAX) {
+        return -1;
+    }
+
+    // Salaries: the frame plus the offsets
+    uint32_t minSalary;
+    if (takeUint32(decoder, &minSalary) != 0 || unpackColumn(decoder, count, salaries) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < count; i++) {
+        salaries[i] += minSalary;
+    }
+
+    // Last names: every index must be in the dictionary
+    if (unpackColumn(decoder, count, codes) != 0) {
+        return -1;
+    }
+    uint32_t maxCode = 0;
+    for (int i = 0; i < count; i++) {
+        maxCode = (codes[i] > maxCode) ? codes[i] : maxCode;
+    }
+    if (maxCode >= numNames) {
+        return -1;
+    }
+
+    // First names: increasing end offsets within the blob
+    uint32_t blobLength;
+    if (unpackColumn(decoder, count, ends) != 0 || takeUint32(decoder, &blobLength) != 0) {
+        return -1;
+    }
+    const unsigned char* blob = takeBytes(decoder, blobLength);
+    if (blob == NULL) {
+        return -1;
+    }
+
+    uint32_t start = 0;
+    for (int i = 0; i < count; i++) {
+        struct Employee* employee = &employees[i];
+        if (ends[i] < start || ends[i] > blobLength || ends[i] - start >= MAX_NAME_LENGTH) {
+            return -1;
+        }
+        employee->id = (int)ids[i];
+        employee->salary = (int)salaries[i];
+        memcpy(employee->first_name, blob + start, ends[i] - start);
+        employee->first_name[ends[i] - start] = '\0';
+        const struct DictionaryName* lastName = &dictionary[codes[i]];
+        memcpy(employee->last_name, lastName->name, lastName->length);
+        employee->last_name[lastName->length] = '\0';
+        start = ends[i];
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Decodes a whole columnar snapshot held in memory (followed by LOAD_PADDING zero bytes).
+ *
+ * @return COLUMNAR_OK or COLUMNAR_CORRUPT.
+ */
+static int decodeSnapshot(const unsigned char* data, size_t size, struct Employee** employees, int* numEmployees) {
+    struct Decoder decoder = {data, data + size};
+    uint32_t crcTable[256];
+    crcInit(crcTable);
+
+    const unsigned char* header = takeBytes(&decoder, HEADER_BYTES);
+    if (header == NULL || memcmp(header, COLUMNAR_MAGIC, COLUMNAR_MAGIC_LENGTH) != 0) {
+        return COLUMNAR_CORRUPT;
+    }
+    const unsigned char* fields = header + COLUMNAR_MAGIC_LENGTH;
+    uint32_t version = getUint32(fields);
+    uint32_t numRecords = getUint32(fields + 4);
+    uint32_t numBlocks = getUint32(fields + 8);
+    uint32_t numNames = getUint32(fields + 12);
+    uint32_t dictionaryBytes = getUint32(fields + 16);
+    uint32_t dictionaryChecksum = getUint32(fields + 20);
+    // The header has no checksum: its counts must fit in the file before anything is allocated for them
+    if (version != COLUMNAR_VERSION || numRecords > INT32_MAX ||
+        numBlocks != (numRecords + COLUMNAR_BLOCK_RECORDS - 1) / COLUMNAR_BLOCK_RECORDS ||
+        (uint64_t)numBlocks * (BLOCK_HEADER_BYTES + MIN_PAYLOAD_BYTES) + dictionaryBytes > size - HEADER_BYTES ||
+        numNames > dictionaryBytes) {
+        return COLUMNAR_CORRUPT;
+    }
+
+    // The dictionary: names point into the loaded file
+    const unsigned char* dictionaryData = takeBytes(&decoder, dictionaryBytes);
+    if (dictionaryData == NULL || crc32(crcTable, dictionaryData, dictionaryBytes) != dictionaryChecksum) {
+        return COLUMNAR_CORRUPT;
+    }
+    struct DictionaryName* dictionary =
+        (struct DictionaryName*)resizeArray(NULL, sizeof(struct DictionaryName) * (numNames + 1));
+    struct Decoder names = {dictionaryData, dictionaryData + dictionaryBytes};
+    for (uint32_t c = 0; c < numNames; c++) {
+        const unsigned char* length = takeBytes(&names, 1);
+        if (length == NULL || *length >= MAX_NAME_LENGTH || (dictionary[c].name = takeBytes(&names, *length)) == NULL) {
+            free(dictionary);
+            return COLUMNAR_CORRUPT;
+        }
+        dictionary[c].length = *length;
+    }
+
+    // The blocks; the records grow with the blocks whose checksum holds, so a corrupt count of records
+    // cannot make the array larger than the blocks actually in the file
+    uint32_t capacity = 1;
+    *employees = (struct Employee*)resizeArray(NULL, sizeof(struct Employee) * capacity);
+    uint32_t* columns = (uint32_t*)resizeArray(NULL, sizeof(uint32_t) * 4 * COLUMNAR_BLOCK_RECORDS);
+    int status = (names.position == names.end) ? COLUMNAR_OK : COLUMNAR_CORRUPT;
+    uint32_t numDecoded = 0;
+    for (uint32_t b = 0; b < numBlocks && status == COLUMNAR_OK; b++) {
+        uint32_t count, payloadBytes, checksum;
+        const unsigned char* payload = NULL;
+        uint32_t expected = numRecords - numDecoded;
+        expected = (expected < COLUMNAR_BLOCK_RECORDS) ? expected : COLUMNAR_BLOCK_RECORDS;
+        if (takeUint32(&decoder, &count) != 0 || takeUint32(&decoder, &payloadBytes) != 0 ||
+            takeUint32(&decoder, &checksum) != 0 || count != expected ||
+            (payload = takeBytes(&decoder, payloadBytes)) == NULL ||
+            crc32(crcTable, payload, payloadBytes) != checksum) {
+            status = COLUMNAR_CORRUPT;
+            break;
+        }
+        if (numDecoded + count > capacity) {
+            capacity = (capacity < numRecords / 2) ? 2 * capacity : numRecords;
+            capacity = (capacity < numDecoded + count) ? numDecoded + count : capacity;
+            *employees = (struct Employee*)resizeArray(*employees, sizeof(struct Employee) * capacity);
+        }
+        struct Decoder block = {payload, payload + payloadBytes};
+        int previousId = (numDecoded > 0) ? (*employees)[numDecoded - 1].id : 0;
+        if (decodeBlock(&block, (int)count, dictionary, numNames, previousId, columns, *employees + numDecoded) != 0 ||
+            block.position != block.end) {
+            status = COLUMNAR_CORRUPT;
+        }
+        numDecoded += count;
+    }
+    if (decoder.position != decoder.end) {
+        status = COLUMNAR_CORRUPT;
+    }
+
+    free(columns);
+    free(dictionary);
+    if (status != COLUMNAR_OK) {
+        free(*employees);
+        *employees = NULL;
+        return status;
+    }
+    *numEmployees = (int)numRecords;
+    return COLUMNAR_OK;
+}
+
+
+/**
+ * @brief Loads the employees of a columnar snapshot file.
+ *
+ * Every block and the dictionary are checked against their checksums, and the records must be in
+ * increasing ID order.
+ *
+ * @param filename Name of the file.
+ * @param employees Receives the records in ID order; free it with free().
+ * @param numEmployees Receives the number of records.
+ * @return COLUMNAR_OK, COLUMNAR_OPEN_FAILED if the file could not be read, or COLUMNAR_CORRUPT if it
+ *         is not a valid snapshot.
+ */
+int loadColumnarSnapshot(const char* filename, struct Employee** employees, int* numEmployees) {
+    FILE* file = fopen(filename, "rb");
+    if (file == NULL) {
+        return COLUMNAR_OPEN_FAILED;
+    }
+    long size = -1;
+    if (fseek(file, 0, SEEK_END) == 0) {
+        size = ftell(file);
+        rewind(file);
+    }
+    if (size < 0) {
+        fclose(file);
+        return COLUMNAR_OPEN_FAILED;
+    }
+    unsigned char* data = (unsigned char*)resizeArray(NULL, (size_t)size + LOAD_PADDING);
+    size_t numRead = fread(data, 1, (size_t)size, file);
+    fclose(file);
+    if (numRead != (size_t)size) {
+        free(data);
+        return COLUMNAR_OPEN_FAILED;
+    }
+    memset(data + size, 0, LOAD_PADDING);
+
+    int status = decodeSnapshot(data, (size_t)size, employees, numEmployees);
+    free(data);
+    return status;
+}
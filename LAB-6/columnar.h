@@ -0,0 +1,22 @@
+#ifndef COLUMNAR_H
+#define COLUMNAR_H
+
+#include "employee.h"
+#include "bptree.h"
+
+// First bytes of a columnar snapshot file
+#define COLUMNAR_MAGIC "EMPCOLS1"
+#define COLUMNAR_MAGIC_LENGTH 8
+// Records per block; each block is encoded and checksummed on its own
+#define COLUMNAR_BLOCK_RECORDS 4096
+
+// Results of loading a columnar snapshot
+#define COLUMNAR_OK 0
+#define COLUMNAR_OPEN_FAILED -1
+#define COLUMNAR_CORRUPT -2
+
+int writeColumnarSnapshot(const struct BPlusTree* records, const char* filename);
+int isColumnarFile(const char* filename);
+int loadColumnarSnapshot(const char* filename, struct Employee** employees, int* numEmployees);
+
+#endif
@@ -2,10 +2,441 @@
 #include <string.h>
 #include <stdlib.h>
 #include <ctype.h> 
+#include <limits.h>
+#include <pthread.h>
 
 
 #include "database.h"
 #include "employee.h"
+#include "readfile.h"
+#include "columnar.h"
+
+
+/*
+ * Reports read snapshots of the records rather than the live tree. Pinning a snapshot freezes the
+ * current version (epoch) of the B+-tree and notes it in a slot of db->pinnedVersions; the writer then
+ * copies the nodes it changes instead of changing them in place, so the snapshot stays as it was
+ * without holding any lock. Every change ends by reclaiming the replaced nodes that are older than
+ * every pinned version; releasing the oldest snapshot frees the rest. db->lock is held only for one
+ * change or to pin or release a snapshot, so long reports never block the writer.
+ *
+ * A transaction pins the version it began from and keeps an undo log with the record before each of its
+ * changes. While it is open, reports are given that version rather than the current one, so they see its
+ * changes only once it commits; a rollback reverts them from the log, last first, without copying the table.
+ *
+ * Lookups by ID go to a hash index (idIndex.c) that readers search without any lock, so lookups from many
+ * threads neither contend with each other nor wait for the lock; the writer updates it with each change.
+ * The changes of a transaction reach the index only when it commits, in one batch, so lookups, like
+ * reports, see all of them or none (a rollback has nothing to revert there).
+ */
+
+// Largest file name of an export
+#define MAX_FILENAME_LENGTH 256
+// Most names listed per field by a fuzzy search
+#define MAX_LISTED_NAMES 10
+// Initial length of the undo log of a transaction; it doubles as needed
+#define INITIAL_UNDO_CAPACITY 64
+// Longest name of a change in a change file
+#define MAX_OPERATION_LENGTH 16
+// Exports to a file with this extension are columnar snapshots
+#define COLUMNAR_EXTENSION ".col"
+
+// A background export of a snapshot to a file
+struct ExportTask {
+    struct Database* db;
+    struct Snapshot snapshot;
+    char filename[MAX_FILENAME_LENGTH];
+};
+
+
+/**
+ * @brief Initializes an empty database.
+ *
+ * @param db Pointer to the database.
+ */
+void initDatabase(struct Database* db) {
+    bptreeInit(&db->records);
+    salaryIndexInit(&db->salaries);
+    nameIndexInit(&db->lastNames);
+    nameIndexInit(&db->firstNames);
+    idIndexInit(&db->ids, MAX_ID - MIN_ID + 1);
+    pthread_mutex_init(&db->lock, NULL);
+    db->pinnedVersions = NULL;
+    db->numPinSlots = 0;
+    db->exports = NULL;
+    db->numExports = 0;
+    db->exportCapacity = 0;
+    db->inTransaction = 0;
+}
+
+
+/**
+ * @brief Frees the storage of a database and leaves it empty.
+ *
+ * Waits for the background exports to finish first; no other snapshot may still be pinned.
+ *
+ * @param db Pointer to the database.
+ */
+void freeDatabase(struct Database* db) {
+    for (int i = 0; i < db->numExports; i++) {
+        pthread_join(db->exports[i], NULL);
+    }
+    free(db->exports);
+    db->exports = NULL;
+    db->numExports = 0;
+    db->exportCapacity = 0;
+
+    bptreeFree(&db->records);
+    salaryIndexFree(&db->salaries);
+    nameIndexFree(&db->lastNames);
+    nameIndexFree(&db->firstNames);
+    idIndexFree(&db->ids);
+    free(db->pinnedVersions);
+    db->pinnedVersions = NULL;
+    db->numPinSlots = 0;
+    pthread_mutex_destroy(&db->lock);
+}
+
+
+/**
+ * @brief Frees the replaced nodes that no pinned snapshot can reach. The lock must be held.
+ */
+static void reclaimNodes(struct Database* db) {
+    int oldest = INT_MAX;
+    for (int i = 0; i < db->numPinSlots; i++) {
+        if (db->pinnedVersions[i] >= 0 && db->pinnedVersions[i] < oldest) {
+            oldest = db->pinnedVersions[i];
+        }
+    }
+    bptreeReclaim(&db->records, oldest);
+}
+
+
+/**
+ * @brief Finds the record of an employee by ID.
+ *
+ * Any thread can call it, also while the database is changed; it takes no lock. Changes of an open
+ * transaction are not visible until it commits.
+ *
+ * @param db Pointer to the database.
+ * @param id ID of the employee.
+ * @param employee Receives a copy of the record.
+ * @return 1 if the employee was found, 0 otherwise.
+ */
+int findEmployee(const struct Database* db, int id, struct Employee* employee) {
+    return idIndexLookup(&db->ids, id, employee);
+}
+
+
+/**
+ * @brief Pins a snapshot of the employee records.
+ *
+ * The snapshot can be read from any thread while the database is changed, and must be released
+ * with releaseSnapshot. Until then the nodes it shares with newer versions are not freed.
+ *
+ * @param db Pointer to the database.
+ * @param snapshot Receives the snapshot.
+ */
+void pinSnapshot(struct Database* db, struct Snapshot* snapshot) {
+    pthread_mutex_lock(&db->lock);
+    int slot = 0;
+    while (slot < db->numPinSlots && db->pinnedVersions[slot] >= 0) {
+        slot++;
+    }
+    if (slot == db->numPinSlots) {
+        int numSlots = (db->numPinSlots > 0) ? 2 * db->numPinSlots : 8;
+        db->pinnedVersions = (int*)realloc(db->pinnedVersions, sizeof(int) * numSlots);
+        if (db->pinnedVersions == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+        for (int i = db->numPinSlots; i < numSlots; i++) {
+            db->pinnedVersions[i] = -1;
+        }
+        db->numPinSlots = numSlots;
+    }
+    if (db->inTransaction) {
+        snapshot->records = db->beforeTransaction.records; // Changes of the open transaction are not visible
+    } else {
+        bptreeSnapshot(&db->records, &snapshot->records);
+    }
+    db->pinnedVersions[slot] = snapshot->records.version;
+    snapshot->slot = slot;
+    pthread_mutex_unlock(&db->lock);
+}
+
+
+/**
+ * @brief Releases a snapshot and frees the nodes only it could still reach.
+ *
+ * @param db Pointer to the database.
+ * @param snapshot Pointer to the snapshot; it must not be read afterwards.
+ */
+void releaseSnapshot(struct Database* db, struct Snapshot* snapshot) {
+    pthread_mutex_lock(&db->lock);
+    db->pinnedVersions[snapshot->slot] = -1;
+    reclaimNodes(db);
+    pthread_mutex_unlock(&db->lock);
+}
+
+
+/**
+ * @brief Inserts an employee record into the database.
+ *
+ * @param db Pointer to the database.
+ * @param employee Record to insert.
+ * @return 1 if the employee was inserted, 0 if an employee with the same ID is already in the database.
+ */
+int insertEmployee(struct Database* db, const struct Employee* employee) {
+    pthread_mutex_lock(&db->lock);
+    int inserted = bptreeInsert(&db->records, employee);
+    if (inserted) {
+        salaryIndexAdd(&db->salaries, employee->salary, 1);
+        nameIndexAdd(&db->lastNames, employee->last_name, employee->id);
+        nameIndexAdd(&db->firstNames, employee->first_name, employee->id);
+        if (!db->inTransaction) {
+            idIndexPut(&db->ids, employee);
+        }
+        reclaimNodes(db);
+    }
+    pthread_mutex_unlock(&db->lock);
+    return inserted;
+}
+
+
+/**
+ * @brief Deletes an employee record from the database.
+ *
+ * @param db Pointer to the database.
+ * @param id ID of the employee to delete.
+ * @param removed Receives the deleted record (may be NULL).
+ * @return 1 if the employee was deleted, 0 if there is no employee with this ID.
+ */
+int deleteEmployee(struct Database* db, int id, struct Employee* removed) {
+    struct Employee employee;
+    pthread_mutex_lock(&db->lock);
+    int deleted = bptreeRemove(&db->records, id, &employee);
+    if (deleted) {
+        salaryIndexAdd(&db->salaries, employee.salary, -1);
+        nameIndexRemove(&db->lastNames, employee.last_name, id);
+        nameIndexRemove(&db->firstNames, employee.first_name, id);
+        if (!db->inTransaction) {
+            idIndexRemove(&db->ids, id);
+        }
+        reclaimNodes(db);
+    }
+    pthread_mutex_unlock(&db->lock);
+    if (deleted && removed != NULL) {
+        *removed = employee;
+    }
+    return deleted;
+}
+
+
+/**
+ * @brief Replaces the record of an employee as a whole, so a snapshot sees either the old or the new one.
+ *
+ * @param db Pointer to the database.
+ * @param employee New record; its ID selects the employee.
+ * @return 1 if the record was replaced, 0 if there is no employee with this ID.
+ */
+int replaceEmployee(struct Database* db, const struct Employee* employee) {
+    struct Employee previous;
+    pthread_mutex_lock(&db->lock);
+    int replaced = bptreeReplace(&db->records, employee, &previous);
+    if (replaced) {
+        salaryIndexAdd(&db->salaries, previous.salary, -1);
+        salaryIndexAdd(&db->salaries, employee->salary, 1);
+        if (strcmp(previous.last_name, employee->last_name) != 0) {
+            nameIndexRemove(&db->lastNames, previous.last_name, employee->id);
+            nameIndexAdd(&db->lastNames, employee->last_name, employee->id);
+        }
+        if (strcmp(previous.first_name, employee->first_name) != 0) {
+            nameIndexRemove(&db->firstNames, previous.first_name, employee->id);
+            nameIndexAdd(&db->firstNames, employee->first_name, employee->id);
+        }
+        if (!db->inTransaction) {
+            idIndexPut(&db->ids, employee);
+        }
+        reclaimNodes(db);
+    }
+    pthread_mutex_unlock(&db->lock);
+    return replaced;
+}
+
+/**
+ * @brief Begins a transaction.
+ *
+ * Until the transaction ends, the changes are made through it and noted in its undo log, and
+ * snapshots pinned by reports show the database as it was when the transaction began. Only one
+ * transaction can be open at a time.
+ *
+ * @param db Pointer to the database.
+ * @param transaction Receives the transaction.
+ * @return 0 on success, -1 if another transaction is open.
+ */
+int beginTransaction(struct Database* db, struct Transaction* transaction) {
+    if (db->inTransaction) {
+        return -1;
+    }
+    pinSnapshot(db, &db->beforeTransaction);
+    pthread_mutex_lock(&db->lock);
+    db->inTransaction = 1;
+    pthread_mutex_unlock(&db->lock);
+
+    transaction->db = db;
+    transaction->numUndo = 0;
+    transaction->undoCapacity = INITIAL_UNDO_CAPACITY;
+    transaction->undo = (struct UndoRecord*)malloc(sizeof(struct UndoRecord) * transaction->undoCapacity);
+    if (transaction->undo == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Appends a change to the undo log of a transaction.
+ */
+static void logUndo(struct Transaction* transaction, enum UndoKind kind, const struct Employee* before) {
+    if (transaction->numUndo == transaction->undoCapacity) {
+        transaction->undoCapacity *= 2;
+        transaction->undo = (struct UndoRecord*)realloc(transaction->undo,
+                                                        sizeof(struct UndoRecord) * transaction->undoCapacity);
+        if (transaction->undo == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    transaction->undo[transaction->numUndo].kind = kind;
+    transaction->undo[transaction->numUndo].before = *before;
+    transaction->numUndo++;
+}
+
+
+/**
+ * @brief Inserts an employee record as part of a transaction.
+ *
+ * @param transaction Pointer to the transaction.
+ * @param employee Record to insert.
+ * @return 1 if the employee was inserted, 0 if an employee with the same ID is already in the database.
+ */
+int transactionInsert(struct Transaction* transaction, const struct Employee* employee) {
+    if (!insertEmployee(transaction->db, employee)) {
+        return 0;
+    }
+    logUndo(transaction, UNDO_INSERT, employee);
+    return 1;
+}
+
+
+/**
+ * @brief Deletes an employee record as part of a transaction.
+ *
+ * @param transaction Pointer to the transaction.
+ * @param id ID of the employee to delete.
+ * @return 1 if the employee was deleted, 0 if there is no employee with this ID.
+ */
+int transactionDelete(struct Transaction* transaction, int id) {
+    struct Employee removed;
+    if (!deleteEmployee(transaction->db, id, &removed)) {
+        return 0;
+    }
+    logUndo(transaction, UNDO_DELETE, &removed);
+    return 1;
+}
+
+
+/**
+ * @brief Replaces the record of an employee as part of a transaction.
+ *
+ * @param transaction Pointer to the transaction.
+ * @param employee New record; its ID selects the employee.
+ * @return 1 if the record was replaced, 0 if there is no employee with this ID.
+ */
+int transactionReplace(struct Transaction* transaction, const struct Employee* employee) {
+    const struct Employee* current = bptreeFind(&transaction->db->records, employee->id);
+    if (current == NULL) {
+        return 0;
+    }
+    struct Employee before = *current;
+    replaceEmployee(transaction->db, employee);
+    logUndo(transaction, UNDO_REPLACE, &before);
+    return 1;
+}
+
+
+/**
+ * @brief Ends a transaction: reports see the current version again and the undo log is freed.
+ */
+static void endTransaction(struct Transaction* transaction) {
+    struct Database* db = transaction->db;
+    pthread_mutex_lock(&db->lock);
+    db->inTransaction = 0;
+    pthread_mutex_unlock(&db->lock);
+    releaseSnapshot(db, &db->beforeTransaction);
+    free(transaction->undo);
+    transaction->undo = NULL;
+    transaction->numUndo = 0;
+}
+
+
+/**
+ * @brief Commits a transaction, so its changes become visible to reports all at once.
+ *
+ * The ID index, left as it was while the transaction was open, is brought up to date with the
+ * record each changed ID has now, in one batch: a lookup sees all of the changes or none of them,
+ * and reports switch to the current version under the same lock.
+ *
+ * @param transaction Pointer to the transaction; it must not be used afterwards.
+ */
+void commitTransaction(struct Transaction* transaction) {
+    struct Database* db = transaction->db;
+    pthread_mutex_lock(&db->lock);
+    db->inTransaction = 0;
+    idIndexBeginBatch(&db->ids);
+    for (int i = 0; i < transaction->numUndo; i++) {
+        int id = transaction->undo[i].before.id;
+        const struct Employee* current = bptreeFind(&db->records, id);
+        if (current != NULL) {
+            idIndexPut(&db->ids, current);
+        } else {
+            idIndexRemove(&db->ids, id);
+        }
+    }
+    idIndexEndBatch(&db->ids);
+    pthread_mutex_unlock(&db->lock);
+    endTransaction(transaction);
+}
+
+
+/**
+ * @brief Rolls back a transaction, reverting its changes from the last to the first.
+ *
+ * Reports never see the reverted changes. The cost is one change per change of the transaction,
+ * however large the database is.
+ *
+ * @param transaction Pointer to the transaction; it must not be used afterwards.
+ */
+void rollbackTransaction(struct Transaction* transaction) {
+    for (int i = transaction->numUndo - 1; i >= 0; i--) {
+        const struct UndoRecord* undo = &transaction->undo[i];
+        switch (undo->kind) {
+            case UNDO_INSERT:
+                deleteEmployee(transaction->db, undo->before.id, NULL);
+                break;
+            case UNDO_DELETE:
+                insertEmployee(transaction->db, &undo->before);
+                break;
+            default:
+                replaceEmployee(transaction->db, &undo->before);
+                break;
+        }
+    }
+    endTransaction(transaction);
+}
+
 
 
 /**
@@ -14,10 +445,9 @@
  * This function allows the user to search for an employee in the database by their ID. It prompts
  * the user to enter a 6-digit ID and then searches the database for a matching ID.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Number of employees in the database.
+ * @param db Pointer to the database.
  */
-void lookupById(const struct Employee* employees, int numEmployees) {
+void lookupById(const struct Database* db) {
     // Variable to store the user input for the employee ID
     int searchId;
     
@@ -31,13 +461,11 @@ void lookupById(const struct Employee* employees, int numEmployees) {
         return;
     }
 
-    // Iterate through the array of employees to find a matching ID
-    for (int i = 0; i < numEmployees; i++) {
-        // If a matching ID is found, print the details of the employee and return
-        if (employees[i].id == searchId) {
-            printEmployee(&employees[i]);
-            return;
-        }
+    // Search the ID index for a matching ID
+    struct Employee employee;
+    if (findEmployee(db, searchId, &employee)) {
+        printEmployee(&employee);
+        return;
     }
 
     // If no matching ID is found, notify the user
@@ -48,22 +476,28 @@ void lookupById(const struct Employee* employees, int numEmployees) {
 /**
  * @brief Prints the database of employees.
  *
- * This function prints the details of employees stored in an array of struct Employee.
+ * This function prints the details of the employees in ID order, scanning the leaves of a snapshot
+ * of the tree, so changes made while it prints do not show up half way through.
  * It prints the name, salary, and ID of each employee in a tabular format.
  *
- * @param employees Pointer to an array of struct Employee containing employee records.
- * @param numEmployees Number of employees in the database.
+ * @param db Pointer to the database.
  */
-void printDatabase(const struct Employee* employees, int numEmployees) {
+void printDatabase(struct Database* db) {
+    struct Snapshot snapshot;
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    pinSnapshot(db, &snapshot);
     printf("NAME\t\tSALARY\t\tID\n");
     printf("-------------------------------------------------------------\n");
-    for (int i = 0; i < numEmployees; i++) {
+    bptreeSeek(&snapshot.records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
         // Print the details of each employee
-        printf("%s %s\t%d\t\t%d\n", employees[i].first_name, employees[i].last_name, employees[i].salary, employees[i].id);
+        printf("%s %s\t%d\t\t%d\n", employee->first_name, employee->last_name, employee->salary, employee->id);
     }
     printf("-------------------------------------------------------------\n");
     // Print the total number of employees
-    printf("Number of Employees: %d\n", numEmployees);
+    printf("Number of Employees: %d\n", snapshot.records.size);
+    releaseSnapshot(db, &snapshot);
 }
 
 
@@ -75,10 +509,9 @@ void printDatabase(const struct Employee* employees, int numEmployees) {
  * This function allows the user to search for employee(s) in the database by last name. It prompts
  * the user to enter a last name and then searches the database for any matching last names.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Number of employees in the database.
+ * @param db Pointer to the database.
  */
-void lookupByLastName(const struct Employee* employees, int numEmployees) {
+void lookupByLastName(const struct Database* db) {
     // Variable to store the user input for the last name
     char searchLastName[MAX_NAME_LENGTH];
     
@@ -95,11 +528,14 @@ void lookupByLastName(const struct Employee* employees, int numEmployees) {
     // Flag to track if any employee with the given last name is found
     int found = 0;
     
-    // Iterate through the array of employees to find matching last names
-    for (int i = 0; i < numEmployees; i++) {
+    // Scan the employees in ID order to find matching last names
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    bptreeSeek(&db->records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
         // If a matching last name is found, print the details of the employee
-        if (strcmp(employees[i].last_name, searchLastName) == 0) {
-            printEmployee(&employees[i]);
+        if (strcmp(employee->last_name, searchLastName) == 0) {
+            printEmployee(employee);
             found = 1;
             break;
         }
@@ -121,12 +557,11 @@ void lookupByLastName(const struct Employee* employees, int numEmployees) {
  * is provided and validated, the function assigns the next available ID to the new employee and
  * adds them to the database.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Pointer to the number of employees in the database.
+ * @param db Pointer to the database.
  */
-void addEmployee(struct Employee* employees, int* numEmployees) {
-    if (*numEmployees >= MAX_EMPLOYEES) {
-        printf("Cannot add more employees. Maximum capacity reached.\n");
+void addEmployee(struct Database* db) {
+    if (bptreeMaxId(&db->records) >= MAX_ID) {
+        printf("Cannot add more employees. No employee IDs left.\n");
         return;
     }
 
@@ -171,14 +606,9 @@ void addEmployee(struct Employee* employees, int* numEmployees) {
         }
     } while (newEmployee.salary < MIN_SALARY || newEmployee.salary > MAX_SALARY );
 
-    // Find the next available ID
-    int nextId = MIN_ID;
-    for (int i = 0; i < *numEmployees; i++) {
-        if (employees[i].id >= nextId) {
-            nextId = employees[i].id + 1;
-        }
-    }
-    newEmployee.id = nextId;
+    // The next available ID follows the highest ID, which is in the rightmost leaf
+    int nextId = bptreeMaxId(&db->records) + 1;
+    newEmployee.id = (nextId > MIN_ID) ? nextId : MIN_ID;
 
     int confirm;
 
@@ -194,8 +624,7 @@ void addEmployee(struct Employee* employees, int* numEmployees) {
     } while (confirm != 0 && confirm != 1);
 
     if (confirm == 1) {
-        employees[*numEmployees] = newEmployee;
-        (*numEmployees)++;
+        insertEmployee(db, &newEmployee);
         printf("Employee added to the database.\n");
     } else {
         printf("Employee not added to the database.\n");
@@ -209,13 +638,12 @@ void addEmployee(struct Employee* employees, int* numEmployees) {
  *
  * This function prompts the user to enter the ID of the employee to remove.
  * If the employee is found, the user is prompted for confirmation before removing the employee.
- * If confirmed, the employee is removed from the database by shifting the remaining employees.
+ * If confirmed, the employee is removed from its leaf, which is rebalanced with its siblings if needed.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Pointer to the number of employees in the database.
+ * @param db Pointer to the database.
  */
-void removeEmployee(struct Employee* employees, int* numEmployees) {
-    if (*numEmployees == 0) {
+void removeEmployee(struct Database* db) {
+    if (db->records.size == 0) {
         printf("No employees in the database to remove.\n");
         return;
     }
@@ -228,20 +656,14 @@ void removeEmployee(struct Employee* employees, int* numEmployees) {
         return;
     }
 
-    // Find the index of the employee with the specified ID
-    int index = -1;
-    for (int i = 0; i < *numEmployees; i++) {
-        if (employees[i].id == searchId) {
-            index = i;
-            break;
-        }
-    }
+    // Find the employee with the specified ID
+    const struct Employee* employee = bptreeFind(&db->records, searchId);
 
-    if (index == -1) {
+    if (employee == NULL) {
         printf("Employee with ID %d not found in the database.\n", searchId);
     } else {
         printf("Employee found:\n");
-        printEmployee(&employees[index]);
+        printEmployee(employee);
 
         int confirm;
         printf("Do you want to remove this employee? (1 for yes, 0 for no): ");
@@ -252,11 +674,7 @@ void removeEmployee(struct Employee* employees, int* numEmployees) {
         }
 
         if (confirm == 1) {
-            // Remove the employee by shifting the remaining employees
-            for (int i = index; i < *numEmployees - 1; i++) {
-                employees[i] = employees[i + 1];
-            }
-            (*numEmployees)--;
+            deleteEmployee(db, searchId, NULL);
             printf("Employee with ID %d has been removed from the database.\n", searchId);
         } else {
             printf("Employee with ID %d was not removed.\n", searchId);
@@ -265,17 +683,63 @@ void removeEmployee(struct Employee* employees, int* numEmployees) {
 }
 
 
+/**
+ * @brief Orders employees by salary (in descending order), then by ID, for qsort.
+ */
+static int compareBySalaryDescending(const void* a, const void* b) {
+    const struct Employee* first = (const struct Employee*)a;
+    const struct Employee* second = (const struct Employee*)b;
+    if (first->salary != second->salary) {
+        return (first->salary < second->salary) ? 1 : -1;
+    }
+    return (first->id > second->id) - (first->id < second->id);
+}
+
+
+/**
+ * @brief Returns whether employee a ranks below employee b: a lower salary, or the same salary and a higher ID.
+ */
+static int ranksBelow(const struct Employee* a, const struct Employee* b) {
+    return a->salary < b->salary || (a->salary == b->salary && a->id > b->id);
+}
+
+
+/**
+ * @brief Restores the heap order below position i of a heap whose root is the lowest-ranked employee.
+ */
+static void siftDown(struct Employee* heap, int size, int i) {
+    while (1) {
+        int lowest = i;
+        int left = 2 * i + 1;
+        int right = left + 1;
+        if (left < size && ranksBelow(&heap[left], &heap[lowest])) {
+            lowest = left;
+        }
+        if (right < size && ranksBelow(&heap[right], &heap[lowest])) {
+            lowest = right;
+        }
+        if (lowest == i) {
+            return;
+        }
+        struct Employee temp = heap[i];
+        heap[i] = heap[lowest];
+        heap[lowest] = temp;
+        i = lowest;
+    }
+}
+
+
 /**
  * @brief Prints the employees with the highest salaries.
  *
  * This function prompts the user to enter the number of employees with the highest salaries to print.
- * It then sorts the employees by salary (in descending order) and prints the details of the top M employees.
+ * It scans a snapshot of the database once, keeping the top M employees in a heap whose root is the
+ * lowest-ranked of them, then prints them by salary (in descending order), ties in ID order.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Number of employees in the database.
+ * @param db Pointer to the database.
  */
-void printHighestSalaries(struct Employee* employees, int numEmployees){
-    if (numEmployees == 0) {
+void printHighestSalaries(struct Database* db){
+    if (db->records.size == 0) {
         printf("No employees in the database to print.\n");
         return;
     }
@@ -288,59 +752,87 @@ void printHighestSalaries(struct Employee* employees, int numEmployees){
         return;
     }
 
-    // Sort employees by salary (in descending order) using counting sort
-    int maxSalary = -1;
-    for (int i = 0; i < numEmployees; i++) {
-        if (employees[i].salary > maxSalary) {
-            maxSalary = employees[i].salary;
-        }
-    }
-
-    int* salaryCount = (int*)calloc(maxSalary + 1, sizeof(int));
-    if (salaryCount == NULL) {
+    struct Snapshot snapshot;
+    pinSnapshot(db, &snapshot);
+    int capacity = (M < snapshot.records.size) ? M : snapshot.records.size;
+    struct Employee* top = (struct Employee*)malloc(sizeof(struct Employee) * (capacity + 1));
+    if (top == NULL) {
         printf("Memory allocation failed.\n");
+        releaseSnapshot(db, &snapshot);
         return;
     }
 
-    for (int i = 0; i < numEmployees; i++) {
-        salaryCount[employees[i].salary]++;
+    struct BPlusCursor cursor;
+    const struct Employee* employee;
+    int count = 0;
+    bptreeSeek(&snapshot.records, MIN_ID, &cursor);
+    while ((employee = bptreeNext(&cursor)) != NULL) {
+        if (count < capacity) {
+            // Fill the heap, then heapify it once it is full
+            top[count++] = *employee;
+            if (count == capacity) {
+                for (int i = count / 2 - 1; i >= 0; i--) {
+                    siftDown(top, count, i);
+                }
+            }
+        } else if (ranksBelow(&top[0], employee)) {
+            top[0] = *employee;
+            siftDown(top, count, 0);
+        }
     }
+    releaseSnapshot(db, &snapshot);
+
+    // Sort the top employees by salary (in descending order), then by ID
+    qsort(top, count, sizeof(struct Employee), compareBySalaryDescending);
 
-    int printed = 0;
     printf("Top %d Employees with the Highest Salaries:\n\n", M);
     printf("NAME\t\t\tSALARY\t\tID\n");
     printf("---------------------------------------------------------------\n");
-    for (int salary = maxSalary; salary >= 0; salary--) {
-        for (int i = 0; i < numEmployees; i++) {
-            if (employees[i].salary == salary) {
-                printf("%s %s\t\t%d\t\t%d\n", employees[i].first_name, employees[i].last_name, employees[i].salary, employees[i].id);
-                printed++;
-            }
-
-            if (printed == M) {
-                break;
-            }
-        }
-
-        if (printed == M) {
-            break;
-        }
+    for (int i = 0; i < count; i++) {
+        printf("%s %s\t\t%d\t\t%d\n", top[i].first_name, top[i].last_name, top[i].salary, top[i].id);
     }
     printf("---------------------------------------------------------------\n\n");
 
-    free(salaryCount);
+    free(top);
+}
+
+/**
+ * @brief Compares two employee IDs, for qsort.
+ */
+static int compareIds(const void* a, const void* b) {
+    return *(const int*)a - *(const int*)b;
+}
+
+
+/**
+ * @brief Prints the employees of an indexed name in ID order, in the format of the name searches.
+ */
+static void printEmployeesWithName(const struct Database* db, const struct IndexedName* name) {
+    int* ids = (int*)malloc(sizeof(int) * name->numIds);
+    if (ids == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    memcpy(ids, name->ids, sizeof(int) * name->numIds);
+    qsort(ids, name->numIds, sizeof(int), compareIds);
+    for (int i = 0; i < name->numIds; i++) {
+        const struct Employee* employee = bptreeFind(&db->records, ids[i]);
+        printf("%s %s\t\t%d\t\t%d\n", employee->first_name, employee->last_name, employee->salary, employee->id);
+    }
+    free(ids);
 }
 
+
 /**
  * @brief Finds all employees with a given last name.
  *
  * This function searches for employees in the database with a specified last name (case-insensitive)
- * and prints their details if found.
+ * and prints their details if found. The employees are looked up in the last name index, so the
+ * search does not scan the table.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Number of employees in the database.
+ * @param db Pointer to the database.
  */
-void findAllEmployeesByLastName(struct Employee* employees, int numEmployees) {
+void findAllEmployeesByLastName(const struct Database* db) {
     char searchLastName[MAX_NAME_LENGTH];
     printf("Enter the last name to search for (case-insensitive): ");
     if (scanf("%64s", searchLastName) != 1) {
@@ -349,35 +841,96 @@ void findAllEmployeesByLastName(struct Employee* employees, int numEmployees) {
         return;
     }
 
-    int found = 0;
+    const struct IndexedName* name = nameIndexFind(&db->lastNames, searchLastName);
     printf("\nNAME\t\t\tSALARY\t\tID\n");
     printf("---------------------------------------------------------------\n");
-    for (int i = 0; i < numEmployees; i++) {
-        // Perform a case-insensitive comparison
-        if (strcasecmp(employees[i].last_name, searchLastName) == 0) {
-            printf("%s %s\t\t%d\t\t%d\n", employees[i].first_name, employees[i].last_name, employees[i].salary, employees[i].id);
-            found = 1;
-        }
+    if (name != NULL) {
+        printEmployeesWithName(db, name);
     }
     printf("---------------------------------------------------------------\n\n");
 
-    if (!found) {
+    if (name == NULL) {
         printf("No employees found with last name: %s\n", searchLastName);
     }
 }
 
+
+/**
+ * @brief Returns the number of typos a fuzzy search allows in a name of a given length.
+ */
+static int allowedEdits(int length) {
+    if (length <= 2) {
+        return 0;
+    }
+    return (length <= 4) ? 1 : 2;
+}
+
+
+/**
+ * @brief Prints the names of one field that match a fuzzy search, each with its employees.
+ *
+ * @return Number of names printed.
+ */
+static int printNameMatches(const struct Database* db, struct NameIndex* index, const char* field,
+                            const char* query, int maxDistance) {
+    struct NameMatch* matches;
+    int numMatches = nameIndexSearch(index, query, maxDistance, &matches);
+    for (int m = 0; m < numMatches && m < MAX_LISTED_NAMES; m++) {
+        printf("%s name \"%s\": %d edit%s, similarity %.2f\n", field, matches[m].name->name, matches[m].distance,
+               (matches[m].distance == 1) ? "" : "s", matches[m].similarity);
+        printEmployeesWithName(db, matches[m].name);
+    }
+    if (numMatches > MAX_LISTED_NAMES) {
+        printf("... and %d more %s names\n", numMatches - MAX_LISTED_NAMES, field);
+    }
+    free(matches);
+    return numMatches;
+}
+
+
+/**
+ * @brief Finds the employees whose last or first name is close to a name, allowing typos.
+ *
+ * This function prompts the user for a name and prints the last names and then the first names within
+ * a few edits of it (none for names of up to 2 characters, 1 up to 4 and 2 beyond), closest first, each
+ * followed by its employees. The trigram indexes narrow the names down to a few candidates before their
+ * edit distance is checked, so the search does not scan the table.
+ *
+ * @param db Pointer to the database.
+ */
+void findEmployeesByApproximateName(struct Database* db) {
+    char query[MAX_NAME_LENGTH];
+    printf("Enter a last or first name to search for (typos allowed): ");
+    if (scanf("%64s", query) != 1) {
+        printf("Invalid input. Please enter a valid name.\n");
+        while (getchar() != '\n'); // Clear the input buffer
+        return;
+    }
+
+    int maxDistance = allowedEdits((int)strlen(query));
+    printf("\nNAME\t\t\tSALARY\t\tID\n");
+    printf("---------------------------------------------------------------\n");
+    int found = printNameMatches(db, &db->lastNames, "Last", query, maxDistance);
+    found += printNameMatches(db, &db->firstNames, "First", query, maxDistance);
+    printf("---------------------------------------------------------------\n\n");
+
+    if (found == 0) {
+        printf("No names found within %d edit%s of: %s\n", maxDistance, (maxDistance == 1) ? "" : "s", query);
+    }
+}
+
 /**
  * @brief Updates information for a specific employee.
  *
  * This function prompts the user to enter the ID of the employee to update.
  * If the employee is found, it offers options to update the employee's information such as first name, last name, and salary.
- * The user is prompted for confirmation before each update.
+ * The user is prompted for confirmation before each update. The updates are one transaction: if an
+ * answer is invalid, the fields already updated are restored.
  *
- * @param employees Pointer to the array of employees.
- * @param numEmployees Number of employees in the database.
+ * @param db Pointer to the database.
  */
-void updateEmployee(struct Employee* employees, int numEmployees) {
-    if (numEmployees == 0) {
+void updateEmployee(struct Database* db) {
+    if (db->records.size == 0) {
         printf("No employees in the database to update.\n");
         return;
     }
@@ -390,20 +943,16 @@ void updateEmployee(struct Employee* employees, int numEmployees) {
         return;
     }
 
-    int index = -1; // Index of the employee to update
+    // Each change is made to a copy of the record, which then replaces the record as a whole; the
+    // changes are made in a transaction, so they are kept together or not at all
+    const struct Employee* employee = bptreeFind(&db->records, searchId);
 
-    for (int i = 0; i < numEmployees; i++) {
-        if (employees[i].id == searchId) {
-            index = i;
-            break;
-        }
-    }
-
-    if (index == -1) {
+    if (employee == NULL) {
         printf("Employee with ID %d not found in the database.\n", searchId);
     } else {
+        struct Employee updated = *employee;
         printf("Employee found:\n");
-        printEmployee(&employees[index]);
+        printEmployee(employee);
 
         int confirm;
         printf("Do you want to update this employee's information? (1 for yes, 0 for no): ");
@@ -414,33 +963,47 @@ void updateEmployee(struct Employee* employees, int numEmployees) {
         }
 
         if (confirm == 1) {
+            struct Transaction transaction;
+            if (beginTransaction(db, &transaction) != 0) {
+                printf("Error: Another transaction is open.\n");
+                return;
+            }
+
             // Prompt the user for each field and ask for confirmation before updating
             printf("Do you want to update the first name? (1 for yes, 0 for no): ");
             if (scanf("%d", &confirm) != 1 || (confirm != 0 && confirm != 1)) {
                 printf("Invalid input. Please enter 0 or 1.\n");
                 while (getchar() != '\n'); // Clear the input buffer
+                rollbackTransaction(&transaction);
+                printf("Employee information was not updated.\n");
                 return;
             }
             if (confirm == 1) {
                 printf("Enter updated first name: ");
-                scanf("%64s", employees[index].first_name);
+                scanf("%64s", updated.first_name);
+                transactionReplace(&transaction, &updated);
             }
 
             printf("Do you want to update the last name? (1 for yes, 0 for no): ");
             if (scanf("%d", &confirm) != 1 || (confirm != 0 && confirm != 1)) {
                 printf("Invalid input. Please enter 0 or 1.\n");
                 while (getchar() != '\n'); // Clear the input buffer
+                rollbackTransaction(&transaction);
+                printf("Employee information was not updated.\n");
                 return;
             }
             if (confirm == 1) {
                 printf("Enter updated last name: ");
-                scanf("%64s", employees[index].last_name);
+                scanf("%64s", updated.last_name);
+                transactionReplace(&transaction, &updated);
             }
 
             printf("Do you want to update the salary? (1 for yes, 0 for no): ");
             if (scanf("%d", &confirm) != 1 || (confirm != 0 && confirm != 1)) {
                 printf("Invalid input. Please enter 0 or 1.\n");
                 while (getchar() != '\n'); // Clear the input buffer
+                rollbackTransaction(&transaction);
+                printf("Employee information was not updated.\n");
                 return;
             }
             if (confirm == 1) {
@@ -459,7 +1022,8 @@ void updateEmployee(struct Employee* employees, int numEmployees) {
                     } else if (updatedSalary < MIN_SALARY || updatedSalary > MAX_SALARY) {
                         printf("Invalid input. Salary out of range. Please enter a valid salary between %d and %d.\n", MIN_SALARY, MAX_SALARY);
                     } else {
-                        employees[index].salary = (int)updatedSalary;
+                        updated.salary = (int)updatedSalary;
+                        transactionReplace(&transaction, &updated);
                         break; // Break the loop when a valid salary is entered
                     }
                 }
@@ -467,6 +1031,7 @@ void updateEmployee(struct Employee* employees, int numEmployees) {
 
             // You can add more fields to update here if needed
 
+            commitTransaction(&transaction);
             printf("Employee information updated successfully.\n");
         } else {
             printf("Employee information was not updated.\n");
@@ -475,3 +1040,264 @@ void updateEmployee(struct Employee* employees, int numEmployees) {
 }
 
 
+/**
+ * @brief Counts the employees with a salary in a range.
+ *
+ * This function prompts the user for the lowest and highest salary of the range and prints how many
+ * employees earn between them (inclusive), using the salary index.
+ *
+ * @param db Pointer to the database.
+ */
+void countEmployeesInSalaryRange(const struct Database* db) {
+    int low, high;
+    printf("Enter the lowest and highest salary of the range: ");
+    if (scanf("%d %d", &low, &high) != 2 || low > high) {
+        printf("Invalid input. Please enter two salaries, the lowest first.\n");
+        while (getchar() != '\n'); // Clear the input buffer
+        return;
+    }
+
+    int count = salaryIndexCountBetween(&db->salaries, low, high);
+    printf("%d of %d employees earn between %d and %d.\n", count, db->salaries.total, low, high);
+}
+
+
+/**
+ * @brief Prints the k-th highest salary.
+ *
+ * This function prompts the user for a rank k and prints the k-th highest salary (1 is the highest),
+ * counting every employee, so equal salaries take consecutive ranks.
+ *
+ * @param db Pointer to the database.
+ */
+void printKthHighestSalary(const struct Database* db) {
+    if (db->salaries.total == 0) {
+        printf("No employees in the database.\n");
+        return;
+    }
+
+    int k;
+    printf("Enter the rank k of the salary (1 to %d): ", db->salaries.total);
+    if (scanf("%d", &k) != 1 || k < 1 || k > db->salaries.total) {
+        printf("Invalid input. Please enter a rank between 1 and %d.\n", db->salaries.total);
+        while (getchar() != '\n'); // Clear the input buffer
+        return;
+    }
+
+    printf("Salary of rank %d from the top: %d.\n", k, salaryIndexKthHighest(&db->salaries, k));
+}
+
+
+/**
+ * @brief Prints the salary percentile of an employee.
+ *
+ * This function prompts the user for an employee ID and prints the percentile rank of the salary of the
+ * employee: the percentage of employees who earn less, counting half of those who earn the same.
+ *
+ * @param db Pointer to the database.
+ */
+void printSalaryPercentile(const struct Database* db) {
+    int searchId;
+    printf("Enter the employee ID: ");
+    if (scanf("%d", &searchId) != 1) {
+        printf("Invalid input. Please enter a valid employee ID.\n");
+        while (getchar() != '\n'); // Clear the input buffer
+        return;
+    }
+
+    const struct Employee* employee = bptreeFind(&db->records, searchId);
+    if (employee == NULL) {
+        printf("Employee with ID %d not found in the database.\n", searchId);
+        return;
+    }
+
+    int below = salaryIndexCountAtMost(&db->salaries, employee->salary - 1);
+    printf("%s %s earns %d, more than %d of %d employees (percentile %.1f).\n", employee->first_name,
+           employee->last_name, employee->salary, below, db->salaries.total,
+           salaryIndexPercentile(&db->salaries, employee->salary));
+}
+
+
+/**
+ * @brief Writes a snapshot to a file, then releases it.
+ *
+ * The file is a columnar snapshot if its name ends with COLUMNAR_EXTENSION, and in the format of the
+ * input files otherwise.
+ *
+ * @param arg Pointer to the struct ExportTask, which is freed.
+ * @return NULL.
+ */
+static void* exportSnapshot(void* arg) {
+    struct ExportTask* task = (struct ExportTask*)arg;
+    size_t length = strlen(task->filename);
+    size_t extensionLength = strlen(COLUMNAR_EXTENSION);
+    int failed;
+    if (length > extensionLength && strcmp(task->filename + length - extensionLength, COLUMNAR_EXTENSION) == 0) {
+        failed = writeColumnarSnapshot(&task->snapshot.records, task->filename) != 0;
+    } else {
+        FILE* file = fopen(task->filename, "w");
+        failed = file == NULL;
+        if (file != NULL) {
+            struct BPlusCursor cursor;
+            const struct Employee* employee;
+            bptreeSeek(&task->snapshot.records, MIN_ID, &cursor);
+            while ((employee = bptreeNext(&cursor)) != NULL) {
+                fprintf(file, "%d %s %s %d\n", employee->id, employee->first_name, employee->last_name, employee->salary);
+            }
+            fclose(file);
+        }
+    }
+    if (failed) {
+        printf("\nError: Unable to write the export file %s.\n", task->filename);
+    } else {
+        printf("\nExport of %d employees to %s finished.\n", task->snapshot.records.size, task->filename);
+    }
+    releaseSnapshot(task->db, &task->snapshot);
+    free(task);
+    return NULL;
+}
+
+
+/**
+ * @brief Exports the database to a file in the background.
+ *
+ * This function prompts the user for a file name, pins a snapshot of the database and writes it to
+ * the file in the format of the input files from a separate thread; a name ending with ".col" gives a
+ * compressed columnar snapshot instead, which can be loaded like an input file. The menu stays available,
+ * and changes made during the export do not appear in the file.
+ *
+ * @param db Pointer to the database.
+ */
+void exportDatabase(struct Database* db) {
+    struct ExportTask* task = (struct ExportTask*)malloc(sizeof(struct ExportTask));
+    if (task == NULL) {
+        printf("Memory allocation failed.\n");
+        return;
+    }
+    printf("Enter the name of the file to export to: ");
+    if (scanf("%255s", task->filename) != 1) {
+        printf("Invalid input. Please enter a valid file name.\n");
+        while (getchar() != '\n'); // Clear the input buffer
+        free(task);
+        return;
+    }
+
+    if (db->numExports == db->exportCapacity) {
+        db->exportCapacity = (db->exportCapacity > 0) ? 2 * db->exportCapacity : 4;
+        db->exports = (pthread_t*)realloc(db->exports, sizeof(pthread_t) * db->exportCapacity);
+        if (db->exports == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    task->db = db;
+    pinSnapshot(db, &task->snapshot);
+    if (pthread_create(&db->exports[db->numExports], NULL, exportSnapshot, task) == 0) {
+        db->numExports++;
+        printf("Exporting %d employees to %s in the background.\n", task->snapshot.records.size, task->filename);
+    } else {
+        exportSnapshot(task); // Fall back to exporting in this thread
+    }
+}
+
+
+/**
+ * @brief Reads the arguments of one change of a change file and applies it through a transaction.
+ *
+ * @return NULL if the change was applied, otherwise the reason it was not.
+ */
+static const char* applyChange(struct Transaction* transaction, struct reader* reader, const char* operation) {
+    struct Employee employee;
+    if (strcmp(operation, "remove") == 0) {
+        if (reader_read_int(reader, &employee.id) != 1) {
+            return "malformed change";
+        }
+        return transactionDelete(transaction, employee.id) ? NULL : "no employee with this ID";
+    }
+
+    if (strcmp(operation, "salary") == 0) {
+        int salary;
+        if (reader_read_int(reader, &employee.id) != 1 || reader_read_int(reader, &salary) != 1) {
+            return "malformed change";
+        }
+        const struct Employee* current = bptreeFind(&transaction->db->records, employee.id);
+        if (current == NULL) {
+            return "no employee with this ID";
+        }
+        employee = *current;
+        employee.salary = salary;
+    } else if (strcmp(operation, "add") == 0 || strcmp(operation, "update") == 0) {
+        if (reader_read_int(reader, &employee.id) != 1 ||
+            reader_read_string(reader, employee.first_name, MAX_NAME_LENGTH) != 1 ||
+            reader_read_string(reader, employee.last_name, MAX_NAME_LENGTH) != 1 ||
+            reader_read_int(reader, &employee.salary) != 1) {
+            return "malformed change";
+        }
+    } else {
+        return "unknown change";
+    }
+
+    if (!validateEmployee(&employee)) {
+        return "ID or salary out of range";
+    }
+    if (strcmp(operation, "add") == 0) {
+        return transactionInsert(transaction, &employee) ? NULL : "an employee with this ID already exists";
+    }
+    return transactionReplace(transaction, &employee) ? NULL : "no employee with this ID";
+}
+
+
+/**
+ * @brief Applies the changes of a file as one transaction.
+ *
+ * This function prompts the user for the name of a change file and applies its changes, one per
+ * line: "add <id> <first name> <last name> <salary>", "update <id> <first name> <last name> <salary>",
+ * "salary <id> <salary>" or "remove <id>". Either every change is applied or, if one of them fails
+ * or the file cannot be read to its end, none is: the changes already made are rolled back.
+ *
+ * @param db Pointer to the database.
+ */
+void applyChangeFile(struct Database* db) {
+    char filename[MAX_FILENAME_LENGTH];
+    printf("Enter the name of the change file: ");
+    if (scanf("%255s", filename) != 1) {
+        printf("Invalid input. Please enter a valid file name.\n");
+        while (getchar() != '\n'); // Clear the input buffer
+        return;
+    }
+    struct reader* reader = reader_open(filename);
+    if (reader == NULL) {
+        printf("Error: Unable to open the change file %s.\n", filename);
+        return;
+    }
+
+    struct Transaction transaction;
+    if (beginTransaction(db, &transaction) != 0) {
+        printf("Error: Another transaction is open.\n");
+        reader_close(reader);
+        return;
+    }
+    int numChanges = 0;
+    const char* error = NULL;
+    struct token_view token;
+    int status;
+    while (error == NULL && (status = reader_next_token(reader, &token)) == 1) {
+        char operation[MAX_OPERATION_LENGTH];
+        snprintf(operation, sizeof(operation), "%s", token.data);
+        numChanges++;
+        error = applyChange(&transaction, reader, operation);
+    }
+    reader_close(reader);
+
+    if (error != NULL) {
+        rollbackTransaction(&transaction);
+        printf("Change %d of %s failed (%s); no changes were applied.\n", numChanges, filename, error);
+    } else if (status != 0) {
+        // Only the end of the file commits; a read error leaves the file unread past the last change
+        rollbackTransaction(&transaction);
+        printf("Error: Unable to read the change file %s; no changes were applied.\n", filename);
+    } else {
+        commitTransaction(&transaction);
+        printf("Applied %d changes from %s.\n", numChanges, filename);
+    }
+}
@@ -1,16 +1,86 @@
 #ifndef DATABASE_H
 #define DATABASE_H
 
+#include <pthread.h>
 #include "employee.h"
-#define MAX_EMPLOYEES 1024
+#include "bptree.h"
+#include "salaryIndex.h"
+#include "nameIndex.h"
+#include "idIndex.h"
 
+// An unchanging view of the employee records, as they were when it was pinned
+struct Snapshot {
+    struct BPlusTree records;
+    int slot;                       // Entry of the snapshot in db->pinnedVersions
+};
 
-void printDatabase(const struct Employee* employees, int numEmployees);
-void lookupById(const struct Employee* employees, int numEmployees);
-void lookupByLastName(const struct Employee* employees, int numEmployees);
-void addEmployee(struct Employee* employees, int* numEmployees);
-void removeEmployee(struct Employee* employees, int* numEmployees);
-void updateEmployee(struct Employee* employees, int numEmployees);
-void printHighestSalaries(struct Employee* employees, int numEmployees);
-void findAllEmployeesByLastName(struct Employee* employees, int numEmployees);
+// The employee table: records stored in a B+-tree keyed and ordered by ID.
+// Changes are made by one writer thread; reports read snapshots, from any thread.
+struct Database {
+    struct BPlusTree records;
+    struct SalaryIndex salaries;    // Number of employees per salary
+    struct NameIndex lastNames;     // Trigram indexes of the names, used by the writer thread only
+    struct NameIndex firstNames;
+    struct IdIndex ids;             // Copies of the records by ID, for lookups from any thread without the lock
+    pthread_mutex_t lock;           // Held for one change, and to pin or release a snapshot
+    int* pinnedVersions;            // Version of the tree pinned by each snapshot slot, -1 if free
+    int numPinSlots;
+    pthread_t* exports;             // Background exports, joined by freeDatabase
+    int numExports;
+    int exportCapacity;
+    int inTransaction;              // 1 while a transaction is open
+    struct Snapshot beforeTransaction;  // Version reports see while a transaction is open
+};
+
+// Kinds of changes an undo record reverts
+enum UndoKind {
+    UNDO_INSERT,                    // Delete the inserted employee
+    UNDO_DELETE,                    // Insert the deleted record again
+    UNDO_REPLACE                    // Put the replaced record back
+};
+
+// A change made by a transaction, with the record it changed
+struct UndoRecord {
+    enum UndoKind kind;
+    struct Employee before;         // Record before the change; for UNDO_INSERT, the inserted record
+};
+
+// Changes that take effect together: reports and lookups see none of them before the commit, and a rollback
+// reverts them all
+struct Transaction {
+    struct Database* db;
+    struct UndoRecord* undo;        // Undo log, in the order of the changes
+    int numUndo;
+    int undoCapacity;
+};
+
+void initDatabase(struct Database* db);
+void freeDatabase(struct Database* db);
+int insertEmployee(struct Database* db, const struct Employee* employee);
+int deleteEmployee(struct Database* db, int id, struct Employee* removed);
+int replaceEmployee(struct Database* db, const struct Employee* employee);
+int findEmployee(const struct Database* db, int id, struct Employee* employee);
+void pinSnapshot(struct Database* db, struct Snapshot* snapshot);
+void releaseSnapshot(struct Database* db, struct Snapshot* snapshot);
+int beginTransaction(struct Database* db, struct Transaction* transaction);
+int transactionInsert(struct Transaction* transaction, const struct Employee* employee);
+int transactionDelete(struct Transaction* transaction, int id);
+int transactionReplace(struct Transaction* transaction, const struct Employee* employee);
+void commitTransaction(struct Transaction* transaction);
+void rollbackTransaction(struct Transaction* transaction);
+
+void printDatabase(struct Database* db);
+void lookupById(const struct Database* db);
+void lookupByLastName(const struct Database* db);
+void addEmployee(struct Database* db);
+void removeEmployee(struct Database* db);
+void updateEmployee(struct Database* db);
+void printHighestSalaries(struct Database* db);
+void findAllEmployeesByLastName(const struct Database* db);
+void countEmployeesInSalaryRange(const struct Database* db);
+void printKthHighestSalary(const struct Database* db);
+void printSalaryPercentile(const struct Database* db);
+void findEmployeesByApproximateName(struct Database* db);
+void applyChangeFile(struct Database* db);
+void exportDatabase(struct Database* db);
 #endif
@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <string.h>
+
+#include "idIndex.h"
+
+/*
+ * Records are kept in slots chained from hash buckets, and every bucket has a sequence counter (a
+ * seqlock) that the single writer makes odd while it unlinks a slot from the chain or rewrites one of
+ * its records, and even again afterwards. A lookup reads the counter, walks the chain and copies the
+ * record, then reads the counter again: if it changed, or was odd, the copy may be torn and the lookup
+ * starts over. Readers never write shared memory, so they do not contend with each other, and they never
+ * wait for the writer except to retry a bucket it is changing.
+ *
+ * A new record is written to its slot before the slot is published at the head of its chain, so adding
+ * needs no odd sequence. The slot of a removed record is reused for a later record, possibly in another
+ * chain; a reader still walking the old chain sees the sequence of that chain change (it was bumped when
+ * the slot was unlinked) and starts over rather than following the reused slot. Slots live in chunks that
+ * are never moved or freed while the index is in use, so a slot index read by a lookup is always safe
+ * to follow.
+ *
+ * The records are copied a 64-bit word at a time with relaxed atomic loads between the two reads of the
+ * counter (and stored the same way by the writer), so a copy that races with the writer is well defined
+ * and merely torn; the fences order the words against the counter, and a torn copy is thrown away.
+ *
+ * A batch of changes, such as the commit of a transaction, is published as a whole: the writer makes
+ * the index-wide batch sequence odd while it applies the batch, and a lookup that overlaps it starts
+ * over, so no lookup sees some changes of the batch but not the others.
+ */
+
+// Fewest buckets of an index
+#define MIN_BUCKETS 1024
+// Initial capacity of the list of free slots; it doubles as needed
+#define INITIAL_FREE_CAPACITY 1024
+
+
+/**
+ * @brief Returns a slot of an index.
+ */
+static struct IdSlot* slotAt(const struct IdIndex* index, int slot) {
+    return &index->chunks[slot / ID_INDEX_CHUNK_SLOTS][slot % ID_INDEX_CHUNK_SLOTS];
+}
+
+
+/**
+ * @brief Stores a record in a slot, a word at a time. The caller orders the stores against the readers.
+ */
+static void storeRecord(struct IdSlot* slot, const struct Employee* employee) {
+    uint64_t words[ID_RECORD_WORDS] = {0};
+    memcpy(words, employee, sizeof(struct Employee));
+    for (size_t w = 0; w < ID_RECORD_WORDS; w++) {
+        atomic_store_explicit(&slot->words[w], words[w], memory_order_relaxed);
+    }
+}
+
+
+/**
+ * @brief Copies the record of a slot, a word at a time; the copy is torn if the writer changed it meanwhile.
+ */
+static void loadRecord(const struct IdSlot* slot, struct Employee* employee) {
+    uint64_t words[ID_RECORD_WORDS];
+    for (size_t w = 0; w < ID_RECORD_WORDS; w++) {
+        words[w] = atomic_load_explicit(&slot->words[w], memory_order_relaxed);
+    }
+    memcpy(employee, words, sizeof(struct Employee));
+}
+
+
+/**
+ * @brief Returns the bucket of an ID (multiplicative hashing).
+ */
+static struct IdBucket* bucketOf(const struct IdIndex* index, int id) {
+    return &index->buckets[((uint32_t)id * 2654435761u) >> index->bucketShift];
+}
+
+
+/**
+ * @brief Initializes an empty index (the program exits on allocation failure).
+ *
+ * The number of buckets is fixed: the smallest power of two that is at least expectedRecords. More
+ * records still fit, in longer chains.
+ *
+ * @param index Pointer to the index.
+ * @param expectedRecords Number of records the index is sized for.
+ */
+void idIndexInit(struct IdIndex* index, int expectedRecords) {
+    int bits = 0;
+    while ((1 << bits) < MIN_BUCKETS || (1 << bits) < expectedRecords) {
+        bits++;
+    }
+    index->numBuckets = 1 << bits;
+    index->bucketShift = 32 - bits;
+    atomic_init(&index->batchSequence, 0);
+    index->buckets = (struct IdBucket*)malloc(sizeof(struct IdBucket) * index->numBuckets);
+    index->freeSlots = (int*)malloc(sizeof(int) * INITIAL_FREE_CAPACITY);
+    if (index->buckets == NULL || index->freeSlots == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int b = 0; b < index->numBuckets; b++) {
+        atomic_init(&index->buckets[b].sequence, 0);
+        atomic_init(&index->buckets[b].head, -1);
+    }
+    for (int c = 0; c < ID_INDEX_MAX_CHUNKS; c++) {
+        index->chunks[c] = NULL;
+    }
+    index->numSlots = 0;
+    index->numFree = 0;
+    index->freeCapacity = INITIAL_FREE_CAPACITY;
+    index->size = 0;
+}
+
+
+/**
+ * @brief Frees the memory of an index. No lookup may be running.
+ *
+ * @param index Pointer to the index.
+ */
+void idIndexFree(struct IdIndex* index) {
+    for (int c = 0; c < ID_INDEX_MAX_CHUNKS; c++) {
+        free(index->chunks[c]);
+        index->chunks[c] = NULL;
+    }
+    free(index->buckets);
+    free(index->freeSlots);
+    index->buckets = NULL;
+    index->freeSlots = NULL;
+    index->size = 0;
+}
+
+
+/**
+ * @brief Returns a free slot, from the removed records first (the program exits if none is left).
+ */
+static int allocateSlot(struct IdIndex* index) {
+    if (index->numFree > 0) {
+        return index->freeSlots[--index->numFree];
+    }
+    int slot = index->numSlots;
+    int chunk = slot / ID_INDEX_CHUNK_SLOTS;
+    if (chunk == ID_INDEX_MAX_CHUNKS) {
+        fprintf(stderr, "Error: The ID index is full.\n");
+        exit(EXIT_FAILURE);
+    }
+    if (index->chunks[chunk] == NULL) {
+        index->chunks[chunk] = (struct IdSlot*)malloc(sizeof(struct IdSlot) * ID_INDEX_CHUNK_SLOTS);
+        if (index->chunks[chunk] == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    index->numSlots++;
+    return slot;
+}
+
+
+/**
+ * @brief Adds a record, or replaces the record with the same ID. Only the writer thread may call it.
+ *
+ * @param index Pointer to the index.
+ * @param employee The record.
+ * @return 1 if the record was added, 0 if it replaced one.
+ */
+int idIndexPut(struct IdIndex* index, const struct Employee* employee) {
+    struct IdBucket* bucket = bucketOf(index, employee->id);
+    int head = atomic_load_explicit(&bucket->head, memory_order_relaxed);
+    for (int s = head; s >= 0; s = atomic_load_explicit(&slotAt(index, s)->next, memory_order_relaxed)) {
+        struct IdSlot* slot = slotAt(index, s);
+        if (atomic_load_explicit(&slot->id, memory_order_relaxed) == employee->id) {
+            unsigned int sequence = atomic_load_explicit(&bucket->sequence, memory_order_relaxed);
+            atomic_store_explicit(&bucket->sequence, sequence + 1, memory_order_relaxed);
+            atomic_thread_fence(memory_order_release);
+            storeRecord(slot, employee);
+            atomic_store_explicit(&bucket->sequence, sequence + 2, memory_order_release);
+            return 0;
+        }
+    }
+
+    // The new slot is filled in before it is published at the head of the chain
+    int s = allocateSlot(index);
+    struct IdSlot* slot = slotAt(index, s);
+    atomic_store_explicit(&slot->id, employee->id, memory_order_relaxed);
+    storeRecord(slot, employee);
+    atomic_store_explicit(&slot->next, head, memory_order_relaxed);
+    atomic_store_explicit(&bucket->head, s, memory_order_release);
+    index->size++;
+    return 1;
+}
+
+
+/**
+ * @brief Removes the record with an ID. Only the writer thread may call it.
+ *
+ * @param index Pointer to the index.
+ * @param id The ID.
+ * @return 1 if the record was removed, 0 if there is no record with this ID.
+ */
+int idIndexRemove(struct IdIndex* index, int id) {
+    struct IdBucket* bucket = bucketOf(index, id);
+    int previous = -1;
+    int s = atomic_load_explicit(&bucket->head, memory_order_relaxed);
+    while (s >= 0 && atomic_load_explicit(&slotAt(index, s)->id, memory_order_relaxed) != id) {
+        previous = s;
+        s = atomic_load_explicit(&slotAt(index, s)->next, memory_order_relaxed);
+    }
+    if (s < 0) {
+        return 0;
+    }
+
+    int next = atomic_load_explicit(&slotAt(index, s)->next, memory_order_relaxed);
+    unsigned int sequence = atomic_load_explicit(&bucket->sequence, memory_order_relaxed);
+    atomic_store_explicit(&bucket->sequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+    if (previous < 0) {
+        atomic_store_explicit(&bucket->head, next, memory_order_release);
+    } else {
+        atomic_store_explicit(&slotAt(index, previous)->next, next, memory_order_release);
+    }
+    atomic_store_explicit(&bucket->sequence, sequence + 2, memory_order_release);
+
+    if (index->numFree == index->freeCapacity) {
+        index->freeCapacity *= 2;
+        index->freeSlots = (int*)realloc(index->freeSlots, sizeof(int) * index->freeCapacity);
+        if (index->freeSlots == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    index->freeSlots[index->numFree++] = s;
+    index->size--;
+    return 1;
+}
+
+
+/**
+ * @brief Begins a batch of changes that lookups see all at once, after idIndexEndBatch. Only the writer
+ * thread may call it, and lookups wait for the batch to end, so it should be short.
+ *
+ * @param index Pointer to the index.
+ */
+void idIndexBeginBatch(struct IdIndex* index) {
+    unsigned int sequence = atomic_load_explicit(&index->batchSequence, memory_order_relaxed);
+    atomic_store_explicit(&index->batchSequence, sequence + 1, memory_order_relaxed);
+    atomic_thread_fence(memory_order_release);
+}
+
+
+/**
+ * @brief Ends a batch of changes, which become visible to lookups together.
+ *
+ * @param index Pointer to the index.
+ */
+void idIndexEndBatch(struct IdIndex* index) {
+    unsigned int sequence = atomic_load_explicit(&index->batchSequence, memory_order_relaxed);
+    atomic_store_explicit(&index->batchSequence, sequence + 1, memory_order_release);
+}
+
+
+/**
+ * @brief Looks up the record with an ID. Any number of threads may call it, also while the writer
+ * changes the index.
+ *
+ * @param index Pointer to the index.
+ * @param id The ID.
+ * @param employee Receives a copy of the record.
+ * @return 1 if the record was found, 0 otherwise.
+ */
+int idIndexLookup(const struct IdIndex* index, int id, struct Employee* employee) {
+    struct IdBucket* bucket = bucketOf(index, id);
+    for (;;) {
+        unsigned int batch = atomic_load_explicit(&index->batchSequence, memory_order_acquire);
+        unsigned int sequence = atomic_load_explicit(&bucket->sequence, memory_order_acquire);
+        if ((batch | sequence) & 1) {
+            continue; // The writer is changing the chain or applying a batch
+        }
+        int found = 0;
+        int s = atomic_load_explicit(&bucket->head, memory_order_acquire);
+        while (s >= 0) {
+            const struct IdSlot* slot = slotAt(index, s);
+            if (atomic_load_explicit(&slot->id, memory_order_relaxed) == id) {
+                loadRecord(slot, employee);
+                found = 1;
+                break;
+            }
+            s = atomic_load_explicit(&slot->next, memory_order_acquire);
+            if (atomic_load_explicit(&bucket->sequence, memory_order_relaxed) != sequence) {
+                break; // The chain changed; the next slot may be in another chain by now
+            }
+        }
+        atomic_thread_fence(memory_order_acquire);
+        if (atomic_load_explicit(&bucket->sequence, memory_order_relaxed) == sequence &&
+            atomic_load_explicit(&index->batchSequence, memory_order_relaxed) == batch) {
+            return found;
+        }
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef ID_INDEX_H
+#define ID_INDEX_H
+
+#include <stdatomic.h>
+#include <stdint.h>
+#include "employee.h"
+
+// Record slots per chunk; chunks are never moved or freed while the index is in use
+#define ID_INDEX_CHUNK_SLOTS 65536
+// Most chunks, for up to 2^26 records
+#define ID_INDEX_MAX_CHUNKS 1024
+// Bytes of a cache line, to keep the batch sequence apart from the fields the writer changes
+#define ID_INDEX_CACHE_LINE 64
+// 64-bit words that hold a record in a slot
+#define ID_RECORD_WORDS ((sizeof(struct Employee) + sizeof(uint64_t) - 1) / sizeof(uint64_t))
+
+// A record of the index, in the chain of its bucket. Lookups read it while the writer may rewrite it,
+// so it is kept in atomic words rather than as a struct Employee.
+struct IdSlot {
+    atomic_int id;                  // ID of the record
+    atomic_int next;                // Next slot of the chain, -1 at its end
+    atomic_uint_least64_t words[ID_RECORD_WORDS];   // The record, copied a word at a time
+};
+
+// Head of a chain, with the sequence counter that guards it
+struct IdBucket {
+    atomic_uint sequence;           // Odd while the writer changes the chain or one of its records
+    atomic_int head;                // First slot of the chain, -1 if empty
+};
+
+// Hash map from employee ID to record, read by any number of threads without locks while one
+// writer thread changes it
+struct IdIndex {
+    // Odd while the writer applies a batch of changes that show up together. Every lookup reads it, so it
+    // has a cache line to itself rather than one with fields the writer changes.
+    _Alignas(ID_INDEX_CACHE_LINE) atomic_uint batchSequence;
+    _Alignas(ID_INDEX_CACHE_LINE) struct IdBucket* buckets;
+    int numBuckets;                 // Power of two
+    int bucketShift;                // 32 - log2(numBuckets), for the multiplicative hash
+    struct IdSlot* chunks[ID_INDEX_MAX_CHUNKS];
+    int numSlots;                   // Slots handed out so far
+    int* freeSlots;                 // Slots of removed records, reused first (writer only)
+    int numFree;
+    int freeCapacity;
+    int size;                       // Number of records
+};
+
+void idIndexInit(struct IdIndex* index, int expectedRecords);
+void idIndexFree(struct IdIndex* index);
+int idIndexPut(struct IdIndex* index, const struct Employee* employee);
+int idIndexRemove(struct IdIndex* index, int id);
+void idIndexBeginBatch(struct IdIndex* index);
+void idIndexEndBatch(struct IdIndex* index);
+int idIndexLookup(const struct IdIndex* index, int id, struct Employee* employee);
+
+#endif
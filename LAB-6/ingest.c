@@ -0,0 +1,241 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "ingest.h"
+#include "readfile.h"
+#include "columnar.h"
+
+/*
+ * Loading an input file validates each record as it is parsed, in the same loop: validateEmployee checks
+ * the ID and salary ranges, and a bitmap with one bit per possible ID (900,000 bits, about 110 KB, which
+ * stays in the L2 cache) finds IDs that already appeared in the file. A valid record is parsed directly
+ * into its place in the result and kept by advancing the count, so validation adds a few compares and
+ * one bit test per record; a rejected record is noted with its reason instead.
+ *
+ * A columnar snapshot (columnar.c) is decoded as a whole instead; its IDs are strictly increasing, so
+ * validation only checks the ranges.
+ */
+
+// Number of 64-bit words of the bitmap of seen IDs
+#define ID_BITMAP_WORDS ((MAX_ID - MIN_ID + 1 + 63) / 64)
+
+// Initial capacities of the arrays of a result; they double as needed
+#define INITIAL_RECORD_CAPACITY 1024
+#define INITIAL_REJECTED_CAPACITY 16
+
+static const char *const REJECT_REASON_NAMES[NUM_REJECT_REASONS] = {
+    "ID out of range", "salary out of range", "duplicate ID", "malformed record"
+};
+
+
+/**
+ * @brief Resizes an array (the program exits on allocation failure).
+ */
+static void* resizeArray(void* array, size_t size) {
+    array = realloc(array, size);
+    if (array == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+
+/**
+ * @brief Notes a record that is not loaded.
+ */
+static void rejectRecord(struct IngestResult* result, int record, const struct Employee* employee,
+                         enum RejectReason reason) {
+    if (result->numRejected == result->rejectedCapacity) {
+        result->rejectedCapacity *= 2;
+        result->rejected = (struct RejectedRecord*)resizeArray(result->rejected,
+                                                               sizeof(struct RejectedRecord) * result->rejectedCapacity);
+    }
+    struct RejectedRecord* rejected = &result->rejected[result->numRejected++];
+    rejected->record = record;
+    rejected->id = employee->id;
+    rejected->salary = employee->salary;
+    rejected->reason = reason;
+    result->rejectCounts[reason]++;
+}
+
+
+/**
+ * @brief Reads the employee records of a columnar snapshot into a result prepared by ingestEmployeeFile.
+ */
+static int ingestColumnarFile(const char* filename, int validate, struct IngestResult* result) {
+    struct Employee* employees;
+    int numEmployees;
+    int status = loadColumnarSnapshot(filename, &employees, &numEmployees);
+    if (status != COLUMNAR_OK) {
+        result->status = status;
+        return -1;
+    }
+    free(result->employees);
+    result->employees = employees;
+    result->capacity = numEmployees;
+    for (int i = 0; i < numEmployees; i++) {
+        if (validate && !validateEmployee(&employees[i])) {
+            int idInRange = employees[i].id >= MIN_ID && employees[i].id <= MAX_ID;
+            rejectRecord(result, i + 1, &employees[i], idInRange ? REJECT_SALARY_RANGE : REJECT_ID_RANGE);
+            continue;
+        }
+        employees[result->numEmployees++] = employees[i];
+    }
+    result->status = 0;
+    return 0;
+}
+
+
+/**
+ * @brief Reads the employee records of an input file.
+ *
+ * Reading stops at the end of the file or at the first malformed record. With validation, records with
+ * an ID or salary out of range, or with the ID of an earlier record of the file, are left out and noted
+ * in result->rejected; without it every well-formed record is kept. The function keeps no shared state,
+ * so several files can be read at the same time from different threads. The file may also be a columnar
+ * snapshot, which is recognized by its first bytes.
+ *
+ * @param filename Name of the input file.
+ * @param validate 1 to validate the records, 0 to keep them all.
+ * @param result Receives the records; free it with freeIngestResult.
+ * @return 0 on success, -1 if the file could not be opened or is a corrupt snapshot (see result->status).
+ */
+int ingestEmployeeFile(const char* filename, int validate, struct IngestResult* result) {
+    result->numEmployees = 0;
+    result->capacity = INITIAL_RECORD_CAPACITY;
+    result->employees = (struct Employee*)resizeArray(NULL, sizeof(struct Employee) * result->capacity);
+    result->numRejected = 0;
+    result->rejectedCapacity = INITIAL_REJECTED_CAPACITY;
+    result->rejected = (struct RejectedRecord*)resizeArray(NULL, sizeof(struct RejectedRecord) * result->rejectedCapacity);
+    for (int r = 0; r < NUM_REJECT_REASONS; r++) {
+        result->rejectCounts[r] = 0;
+    }
+
+    if (isColumnarFile(filename)) {
+        return ingestColumnarFile(filename, validate, result);
+    }
+    struct reader* reader = reader_open(filename);
+    if (reader == NULL) {
+        result->status = -1;
+        return -1;
+    }
+    uint64_t* seen = NULL;
+    if (validate) {
+        seen = (uint64_t*)calloc(ID_BITMAP_WORDS, sizeof(uint64_t));
+        if (seen == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    for (int record = 1; ; record++) {
+        if (result->numEmployees == result->capacity) {
+            result->capacity *= 2;
+            result->employees = (struct Employee*)resizeArray(result->employees,
+                                                              sizeof(struct Employee) * result->capacity);
+        }
+        // Parse into the next free slot; it only counts as loaded once it is accepted
+        struct Employee* employee = &result->employees[result->numEmployees];
+        int status = reader_read_int(reader, &employee->id);
+        if (status == EOF) {
+            break;
+        }
+        employee->salary = 0;
+        if (status != 1 ||
+            reader_read_string(reader, employee->first_name, MAX_NAME_LENGTH) != 1 ||
+            reader_read_string(reader, employee->last_name, MAX_NAME_LENGTH) != 1 ||
+            reader_read_int(reader, &employee->salary) != 1) {
+            if (validate) {
+                rejectRecord(result, record, employee, REJECT_MALFORMED);
+            }
+            break;
+        }
+
+        if (validate) {
+            if (!validateEmployee(employee)) {
+                int idInRange = employee->id >= MIN_ID && employee->id <= MAX_ID;
+                rejectRecord(result, record, employee, idInRange ? REJECT_SALARY_RANGE : REJECT_ID_RANGE);
+                continue;
+            }
+            int bit = employee->id - MIN_ID;
+            uint64_t mask = (uint64_t)1 << (bit % 64);
+            if (seen[bit / 64] & mask) {
+                rejectRecord(result, record, employee, REJECT_DUPLICATE_ID);
+                continue;
+            }
+            seen[bit / 64] |= mask;
+        }
+        result->numEmployees++;
+    }
+
+    free(seen);
+    reader_close(reader);
+    result->status = 0;
+    return 0;
+}
+
+
+/**
+ * @brief Frees the arrays of a result.
+ *
+ * @param result Pointer to the result.
+ */
+void freeIngestResult(struct IngestResult* result) {
+    free(result->employees);
+    free(result->rejected);
+    result->employees = NULL;
+    result->rejected = NULL;
+    result->numEmployees = 0;
+    result->numRejected = 0;
+}
+
+
+/**
+ * @brief Prints the report of the records of a file that were not loaded.
+ *
+ * Prints the number of rejected records per reason and the first maxRecords of them with their
+ * position in the file. Nothing is printed if every record was loaded.
+ *
+ * @param filename Name of the input file.
+ * @param result Pointer to the result of ingestEmployeeFile for the file.
+ * @param maxRecords Largest number of records to list.
+ */
+void printRejectedRecords(const char* filename, const struct IngestResult* result, int maxRecords) {
+    if (result->numRejected == 0) {
+        return;
+    }
+    printf("Rejected %d records of %s:", result->numRejected, filename);
+    const char* separator = " ";
+    for (int r = 0; r < NUM_REJECT_REASONS; r++) {
+        if (result->rejectCounts[r] > 0) {
+            printf("%s%d %s", separator, result->rejectCounts[r], REJECT_REASON_NAMES[r]);
+            separator = ", ";
+        }
+    }
+    printf("\n");
+
+    for (int i = 0; i < result->numRejected && i < maxRecords; i++) {
+        const struct RejectedRecord* rejected = &result->rejected[i];
+        printf("  record %d: ", rejected->record);
+        switch (rejected->reason) {
+            case REJECT_ID_RANGE:
+                printf("ID %d is not between %d and %d\n", rejected->id, MIN_ID, MAX_ID);
+                break;
+            case REJECT_SALARY_RANGE:
+                printf("salary %d of ID %d is not between %d and %d\n", rejected->salary, rejected->id,
+                       MIN_SALARY, MAX_SALARY);
+                break;
+            case REJECT_DUPLICATE_ID:
+                printf("ID %d was already loaded from this file\n", rejected->id);
+                break;
+            default:
+                printf("malformed record, the rest of the file was not loaded\n");
+                break;
+        }
+    }
+    if (result->numRejected > maxRecords) {
+        printf("  ... and %d more\n", result->numRejected - maxRecords);
+    }
+}
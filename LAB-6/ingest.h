@@ -0,0 +1,39 @@
+#ifndef INGEST_H
+#define INGEST_H
+
+#include "employee.h"
+
+// Reasons a record of an input file is not loaded
+enum RejectReason {
+    REJECT_ID_RANGE,            // ID outside MIN_ID..MAX_ID
+    REJECT_SALARY_RANGE,        // Salary outside MIN_SALARY..MAX_SALARY
+    REJECT_DUPLICATE_ID,        // ID of an earlier record of the file
+    REJECT_MALFORMED,           // Not an ID, two names and an integer salary; loading stops there
+    NUM_REJECT_REASONS
+};
+
+// A record that was not loaded
+struct RejectedRecord {
+    int record;                 // Position of the record in the file, from 1
+    int id;
+    int salary;
+    enum RejectReason reason;
+};
+
+// Records of one input file
+struct IngestResult {
+    struct Employee* employees;
+    int numEmployees;
+    int capacity;
+    struct RejectedRecord* rejected;
+    int numRejected;
+    int rejectedCapacity;
+    int rejectCounts[NUM_REJECT_REASONS];
+    int status;                 // 0 on success, -1 if the file could not be opened, -2 if it is a corrupt snapshot
+};
+
+int ingestEmployeeFile(const char* filename, int validate, struct IngestResult* result);
+void freeIngestResult(struct IngestResult* result);
+void printRejectedRecords(const char* filename, const struct IngestResult* result, int maxRecords);
+
+#endif
@@ -1,7 +1,35 @@
 #include <stdio.h>
-#include "readfile.h" // Include the readfile library header
+#include <stdlib.h>
+#include <pthread.h>
 #include "employee.h"
 #include "database.h"
+#include "ingest.h"
+#include "columnar.h"
+
+// Largest number of rejected records listed per input file
+#define MAX_LISTED_REJECTS 10
+
+// Input file loaded by one thread
+struct LoadTask {
+    const char* filename;
+    struct IngestResult result;
+    pthread_t thread;
+    int threaded;                   // 1 if the file is read by its own thread
+};
+
+/**
+ * @brief Reads and validates the employee records of one input file.
+ *
+ * Every task has its own reader and result, so the input files are read in parallel threads.
+ *
+ * @param arg Pointer to the struct LoadTask of the file.
+ * @return NULL.
+ */
+static void* loadEmployeeFile(void* arg) {
+    struct LoadTask* task = (struct LoadTask*)arg;
+    ingestEmployeeFile(task->filename, 1, &task->result);
+    return NULL;
+}
 
 /**
  * @brief Main function to manage the Employee Database application.
@@ -9,7 +37,10 @@
  * This function is the entry point of the Employee Database application. It prompts the user with
  * a menu to perform various operations such as printing the database, looking up employees by ID
  * or last name, adding, removing, updating employees, finding employees with the highest salaries,
- * and quitting the application.
+ * salary range, rank and percentile queries, exporting in the background, searching names with
+ * typos, applying a file of changes as one transaction, and quitting the application. Several
+ * input files can be given; they are read and validated in parallel and their records are
+ * combined in the order of the files.
  *
  * @param argc Number of command-line arguments.
  * @param argv Array of command-line argument strings.
@@ -17,61 +48,61 @@
  */
 int main(int argc, char* argv[]) {
     // Check if the correct number of command line arguments is provided
-    if (argc != 2) {
-        printf("Usage: %s <input_file>\n", argv[0]);
+    if (argc < 2) {
+        printf("Usage: %s <input_file>...\n", argv[0]);
         return 1;
     }
 
-    // Attempt to open the input file
-    if (open_file(argv[1]) != 0) {
-        printf("Error: Unable to open the input file.\n");
+    // Read every input file in its own thread
+    int numFiles = argc - 1;
+    struct LoadTask* tasks = (struct LoadTask*)calloc(numFiles, sizeof(struct LoadTask));
+    if (tasks == NULL) {
+        printf("Error: Unable to allocate memory.\n");
         return 1;
     }
-
-    // Array to store employee data
-    struct Employee employees[MAX_EMPLOYEES];
-    int numEmployees = 0;
-
-    // Read employee data from the input file and populate the array
-    while (numEmployees < MAX_EMPLOYEES) {
-        int ret;
-        int x;
-        char s[MAX_NAME_LENGTH];
-
-        // Read employee ID
-        ret = read_int(&x);
-        if (ret != 1) {
-            break;
+    for (int f = 0; f < numFiles; f++) {
+        tasks[f].filename = argv[f + 1];
+        tasks[f].threaded = pthread_create(&tasks[f].thread, NULL, loadEmployeeFile, &tasks[f]) == 0;
+        if (!tasks[f].threaded) {
+            loadEmployeeFile(&tasks[f]); // Fall back to reading it in this thread
         }
-        employees[numEmployees].id = x;
+    }
 
-        // Read employee first name
-        ret = read_string(employees[numEmployees].first_name, MAX_NAME_LENGTH);
-        if (ret != 1) {
-            break;
+    // The database keeps the records in a B+-tree ordered by ID
+    struct Database db;
+    initDatabase(&db);
+    int numDuplicates = 0;
+    int status = 0;
+
+    // Combine the records of the files in order; the first record with a given ID is kept
+    for (int f = 0; f < numFiles; f++) {
+        struct IngestResult* result = &tasks[f].result;
+        if (tasks[f].threaded) {
+            pthread_join(tasks[f].thread, NULL);
         }
-
-        // Read employee last name
-        ret = read_string(employees[numEmployees].last_name, MAX_NAME_LENGTH);
-        if (ret != 1) {
-            break;
+        if (result->status == COLUMNAR_CORRUPT) {
+            printf("Error: The snapshot file %s is corrupt.\n", tasks[f].filename);
+            status = 1;
+        } else if (result->status != 0) {
+            printf("Error: Unable to open the input file %s.\n", tasks[f].filename);
+            status = 1;
         }
-
-        // Read employee salary
-        ret = read_int(&x);
-        if (ret != 1) {
-            break;
+        printRejectedRecords(tasks[f].filename, result, MAX_LISTED_REJECTS);
+        for (int i = 0; i < result->numEmployees; i++) {
+            if (!insertEmployee(&db, &result->employees[i])) {
+                numDuplicates++;
+            }
         }
-        employees[numEmployees].salary = x;
-
-        numEmployees++;
+        freeIngestResult(result);
+    }
+    free(tasks);
+    if (status != 0) {
+        freeDatabase(&db);
+        return 1;
+    }
+    if (numDuplicates > 0) {
+        printf("Skipped %d records with IDs loaded from an earlier file.\n", numDuplicates);
     }
-
-    // Close the input file
-    close_file();
-
-    // Call the function to read and sort employee data
-    readAndSortEmployeeData(employees, &numEmployees);
 
     int choice;
 
@@ -90,46 +121,70 @@ int main(int argc, char* argv[]) {
         printf("  (6) Update an Employee's Information\n");
         printf("  (7) Print the M employees with the highest salaries\n");
         printf("  (8) Find all employees with matching last name\n");
-        printf("  (9) Quit\n");
+        printf("  (10) Count employees with a salary in a range\n");
+        printf("  (11) Find the k-th highest salary\n");
+        printf("  (12) Salary percentile of an employee\n");
+        printf("  (13) Export the database to a file in the background\n");
+        printf("  (14) Find employees by a name with typos\n");
+        printf("  (15) Apply the changes of a file as one transaction\n");
+        printf("  (9) Quit\n"); // Kept at 9, so scripted input written for the first menu still quits
         printf("----------------------------------\n");
         printf("Enter your choice: ");
 
         // Get user's choice
-        if (scanf("%d", &choice) != 1 || choice < 1 || choice > 9) {
+        if (scanf("%d", &choice) != 1 || choice < 1 || choice > 15) {
             validChoice = 0;
-            printf("Invalid input. Please enter a number between 1 and 9.\n");
+            printf("Invalid input. Please enter a number between 1 and 15.\n");
             while (getchar() != '\n');
         }
 
         if (validChoice) {
             switch (choice) {
                 case 1:
-                    printDatabase(employees, numEmployees);
+                    printDatabase(&db);
                     break;
                 case 2:
-                    lookupById(employees, numEmployees);
+                    lookupById(&db);
                     break;
                 case 3:
-                    lookupByLastName(employees, numEmployees);
+                    lookupByLastName(&db);
                     break;
                 case 4:
-                    addEmployee(employees, &numEmployees);
+                    addEmployee(&db);
                     break;
                 case 5:
-                    removeEmployee(employees, &numEmployees);
+                    removeEmployee(&db);
                     break;
                 case 6:
-                    updateEmployee(employees, numEmployees);
+                    updateEmployee(&db);
                     break;
                 case 7:
-                    printHighestSalaries(employees, numEmployees);
+                    printHighestSalaries(&db);
                     break;
                 case 8:
-                    findAllEmployeesByLastName(employees, numEmployees);
+                    findAllEmployeesByLastName(&db);
                     break;
                 case 9:
                     printf("GOODBYE!\n");
                     break;
+                case 10:
+                    countEmployeesInSalaryRange(&db);
+                    break;
+                case 11:
+                    printKthHighestSalary(&db);
+                    break;
+                case 12:
+                    printSalaryPercentile(&db);
+                    break;
+                case 13:
+                    exportDatabase(&db);
+                    break;
+                case 14:
+                    findEmployeesByApproximateName(&db);
+                    break;
+                case 15:
+                    applyChangeFile(&db);
+                    break;
                 default:
                     printf("Invalid choice. Please enter a valid option.\n");
                     break;
@@ -137,5 +192,6 @@ int main(int argc, char* argv[]) {
         }
     } while (choice != 9);
 
+    freeDatabase(&db);
     return 0;
 }
@@ -0,0 +1,448 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+
+#include "nameIndex.h"
+
+/*
+ * Names are indexed by their trigrams, the three-character pieces of the lowercase name padded with two
+ * spaces on each side ("  smith  " gives "  s", " sm", "smi", "mit", "ith", "th ", "h  "). Each distinct
+ * name is stored once with the IDs of its employees, and the posting list of a trigram holds the names
+ * that contain it, so the index grows with the number of distinct names rather than with the rows.
+ *
+ * A name within d edits of the query keeps every trigram of the query except at most 3 per edit, so a
+ * fuzzy search counts the trigrams each name shares with the query from the posting lists, drops the names
+ * below that bound or whose length differs by more than d, and runs a banded Levenshtein check only on the
+ * names left; when the bound is not positive (short names, many edits) every name is checked. Characters
+ * are folded to 64 symbols, so the posting lists are a direct array; a folded collision only adds
+ * candidates, which the exact check then rejects.
+ */
+
+// Initial capacities; the arrays double as needed
+#define INITIAL_NAME_CAPACITY 256
+#define INITIAL_LIST_CAPACITY 4
+
+// Most trigrams of a name: one per character plus two
+#define MAX_NAME_TRIGRAMS (MAX_NAME_LENGTH + 1)
+
+
+/**
+ * @brief Resizes an array (the program exits on allocation failure).
+ */
+static void* resizeArray(void* array, size_t size) {
+    array = realloc(array, size);
+    if (array == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    return array;
+}
+
+
+/**
+ * @brief Copies a name in lowercase and returns its length.
+ */
+static int lowercaseName(const char* name, char* lower) {
+    int length = 0;
+    while (name[length] != '\0' && length < MAX_NAME_LENGTH - 1) {
+        lower[length] = (char)tolower((unsigned char)name[length]);
+        length++;
+    }
+    lower[length] = '\0';
+    return length;
+}
+
+
+/**
+ * @brief Returns the symbol of a lowercase character in a trigram; 0 is the padding.
+ */
+static int trigramSymbol(unsigned char c) {
+    if (c >= 'a' && c <= 'z') {
+        return 1 + (c - 'a');
+    }
+    if (c >= '0' && c <= '9') {
+        return 27 + (c - '0');
+    }
+    if (c == ' ') {
+        return 0;
+    }
+    return 37 + c % 27;
+}
+
+
+/**
+ * @brief Computes the distinct trigrams of a lowercase name, in increasing order.
+ *
+ * @return Number of distinct trigrams.
+ */
+static int nameTrigrams(const char* lower, int length, int* trigrams) {
+    int count = 0;
+    // Symbols of the padded name: two in front, the name, two behind
+    int previous = 0;
+    int current = 0;
+    for (int i = 0; i <= length + 1; i++) {
+        int next = (i < length) ? trigramSymbol((unsigned char)lower[i]) : 0;
+        int trigram = (previous * TRIGRAM_ALPHABET + current) * TRIGRAM_ALPHABET + next;
+        previous = current;
+        current = next;
+
+        // Insert in order, skipping repeats
+        int position = count;
+        while (position > 0 && trigrams[position - 1] > trigram) {
+            position--;
+        }
+        if (position > 0 && trigrams[position - 1] == trigram) {
+            continue;
+        }
+        memmove(&trigrams[position + 1], &trigrams[position], sizeof(int) * (count - position));
+        trigrams[position] = trigram;
+        count++;
+    }
+    return count;
+}
+
+
+/**
+ * @brief Returns the FNV-1a hash of a lowercase name.
+ */
+static unsigned int hashName(const char* lower) {
+    unsigned int hash = 2166136261u;
+    for (; *lower != '\0'; lower++) {
+        hash = (hash ^ (unsigned char)*lower) * 16777619u;
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Returns the slot of the hash table holding a lowercase name, or the empty slot where it belongs.
+ */
+static int findSlot(const struct NameIndex* index, const char* lower) {
+    int mask = index->numSlots - 1;
+    int slot = (int)(hashName(lower) & (unsigned int)mask);
+    while (index->slots[slot] >= 0 && strcmp(index->names[index->slots[slot]].name, lower) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Doubles the hash table and inserts the names again.
+ */
+static void growSlots(struct NameIndex* index) {
+    free(index->slots);
+    index->numSlots *= 2;
+    index->slots = (int*)resizeArray(NULL, sizeof(int) * index->numSlots);
+    for (int s = 0; s < index->numSlots; s++) {
+        index->slots[s] = -1;
+    }
+    for (int n = 0; n < index->numNames; n++) {
+        index->slots[findSlot(index, index->names[n].name)] = n;
+    }
+}
+
+
+/**
+ * @brief Initializes an empty index (the program exits on allocation failure).
+ *
+ * @param index Pointer to the index.
+ */
+void nameIndexInit(struct NameIndex* index) {
+    index->numNames = 0;
+    index->nameCapacity = INITIAL_NAME_CAPACITY;
+    index->names = (struct IndexedName*)resizeArray(NULL, sizeof(struct IndexedName) * index->nameCapacity);
+    index->shared = (int*)calloc(index->nameCapacity, sizeof(int));
+    index->numSlots = 2 * INITIAL_NAME_CAPACITY;
+    index->slots = (int*)resizeArray(NULL, sizeof(int) * index->numSlots);
+    index->postings = (struct PostingList*)calloc(NUM_TRIGRAMS, sizeof(struct PostingList));
+    if (index->shared == NULL || index->postings == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int s = 0; s < index->numSlots; s++) {
+        index->slots[s] = -1;
+    }
+}
+
+
+/**
+ * @brief Frees the memory of an index.
+ *
+ * @param index Pointer to the index.
+ */
+void nameIndexFree(struct NameIndex* index) {
+    for (int n = 0; n < index->numNames; n++) {
+        free(index->names[n].ids);
+    }
+    for (int t = 0; t < NUM_TRIGRAMS; t++) {
+        free(index->postings[t].names);
+    }
+    free(index->names);
+    free(index->shared);
+    free(index->slots);
+    free(index->postings);
+    index->names = NULL;
+    index->shared = NULL;
+    index->slots = NULL;
+    index->postings = NULL;
+    index->numNames = 0;
+}
+
+
+/**
+ * @brief Adds a new distinct name to the index and to the posting lists of its trigrams.
+ *
+ * @return Index of the name in index->names.
+ */
+static int addName(struct NameIndex* index, const char* lower, int length, int slot) {
+    if (index->numNames == index->nameCapacity) {
+        int capacity = 2 * index->nameCapacity;
+        index->names = (struct IndexedName*)resizeArray(index->names, sizeof(struct IndexedName) * capacity);
+        index->shared = (int*)resizeArray(index->shared, sizeof(int) * capacity);
+        memset(&index->shared[index->nameCapacity], 0, sizeof(int) * (capacity - index->nameCapacity));
+        index->nameCapacity = capacity;
+    }
+    int n = index->numNames++;
+    struct IndexedName* name = &index->names[n];
+    memcpy(name->name, lower, length + 1);
+    name->length = length;
+    name->ids = NULL;
+    name->numIds = 0;
+    name->idCapacity = 0;
+
+    int trigrams[MAX_NAME_TRIGRAMS];
+    name->numTrigrams = nameTrigrams(lower, length, trigrams);
+    for (int t = 0; t < name->numTrigrams; t++) {
+        struct PostingList* list = &index->postings[trigrams[t]];
+        if (list->count == list->capacity) {
+            list->capacity = (list->capacity > 0) ? 2 * list->capacity : INITIAL_LIST_CAPACITY;
+            list->names = (int*)resizeArray(list->names, sizeof(int) * list->capacity);
+        }
+        list->names[list->count++] = n;
+    }
+
+    index->slots[slot] = n;
+    if (2 * index->numNames > index->numSlots) {
+        growSlots(index);
+    }
+    return n;
+}
+
+
+/**
+ * @brief Adds an employee under a name.
+ *
+ * @param index Pointer to the index.
+ * @param name The name (any case).
+ * @param id ID of the employee.
+ */
+void nameIndexAdd(struct NameIndex* index, const char* name, int id) {
+    char lower[MAX_NAME_LENGTH];
+    int length = lowercaseName(name, lower);
+    int slot = findSlot(index, lower);
+    int n = (index->slots[slot] >= 0) ? index->slots[slot] : addName(index, lower, length, slot);
+
+    struct IndexedName* entry = &index->names[n];
+    if (entry->numIds == entry->idCapacity) {
+        entry->idCapacity = (entry->idCapacity > 0) ? 2 * entry->idCapacity : INITIAL_LIST_CAPACITY;
+        entry->ids = (int*)resizeArray(entry->ids, sizeof(int) * entry->idCapacity);
+    }
+    entry->ids[entry->numIds++] = id;
+}
+
+
+/**
+ * @brief Removes an employee from a name.
+ *
+ * The name stays in the posting lists with no employees, and is used again if it comes back.
+ *
+ * @param index Pointer to the index.
+ * @param name The name (any case).
+ * @param id ID of the employee.
+ */
+void nameIndexRemove(struct NameIndex* index, const char* name, int id) {
+    char lower[MAX_NAME_LENGTH];
+    lowercaseName(name, lower);
+    int n = index->slots[findSlot(index, lower)];
+    if (n < 0) {
+        return;
+    }
+    struct IndexedName* entry = &index->names[n];
+    for (int i = 0; i < entry->numIds; i++) {
+        if (entry->ids[i] == id) {
+            entry->ids[i] = entry->ids[--entry->numIds];
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief Finds the employees with a name, ignoring case.
+ *
+ * @param index Pointer to the index.
+ * @param name The name.
+ * @return The indexed name, or NULL if no employee has it.
+ */
+const struct IndexedName* nameIndexFind(const struct NameIndex* index, const char* name) {
+    char lower[MAX_NAME_LENGTH];
+    lowercaseName(name, lower);
+    int n = index->slots[findSlot(index, lower)];
+    if (n < 0 || index->names[n].numIds == 0) {
+        return NULL;
+    }
+    return &index->names[n];
+}
+
+
+/**
+ * @brief Orders matches by distance, then by similarity (highest first), then by name.
+ */
+static int compareMatches(const void* a, const void* b) {
+    const struct NameMatch* matchA = (const struct NameMatch*)a;
+    const struct NameMatch* matchB = (const struct NameMatch*)b;
+    if (matchA->distance != matchB->distance) {
+        return matchA->distance - matchB->distance;
+    }
+    if (matchA->similarity != matchB->similarity) {
+        return (matchA->similarity < matchB->similarity) ? 1 : -1;
+    }
+    return strcmp(matchA->name->name, matchB->name->name);
+}
+
+
+/**
+ * @brief Finds the names within maxDistance edits of a query, ignoring case.
+ *
+ * Only names that share enough trigrams with the query are checked with nameEditDistance. The index is
+ * not changed, but its scratch counters are, so searches must not run at the same time as each other or
+ * as changes.
+ *
+ * @param index Pointer to the index.
+ * @param query The name to search for.
+ * @param maxDistance Largest Levenshtein distance of a match.
+ * @param matches Receives the matches, closest first; free it with free().
+ * @return Number of matches.
+ */
+int nameIndexSearch(struct NameIndex* index, const char* query, int maxDistance, struct NameMatch** matches) {
+    char lower[MAX_NAME_LENGTH];
+    int length = lowercaseName(query, lower);
+    int trigrams[MAX_NAME_TRIGRAMS];
+    int numTrigrams = nameTrigrams(lower, length, trigrams);
+    int minShared = numTrigrams - 3 * maxDistance;
+    int checkAll = minShared < 1;
+
+    // Count the trigrams each name shares with the query, noting the names seen
+    int* candidates = NULL;
+    int numCandidates = 0;
+    int candidateCapacity = 0;
+    for (int t = 0; t < numTrigrams; t++) {
+        const struct PostingList* list = &index->postings[trigrams[t]];
+        for (int i = 0; i < list->count; i++) {
+            int n = list->names[i];
+            if (index->shared[n]++ == 0) {
+                if (numCandidates == candidateCapacity) {
+                    candidateCapacity = (candidateCapacity > 0) ? 2 * candidateCapacity : INITIAL_NAME_CAPACITY;
+                    candidates = (int*)resizeArray(candidates, sizeof(int) * candidateCapacity);
+                }
+                candidates[numCandidates++] = n;
+            }
+        }
+    }
+
+    // Check the candidates that pass the trigram and length bounds
+    int numMatches = 0;
+    int matchCapacity = 0;
+    *matches = NULL;
+    int numChecked = checkAll ? index->numNames : numCandidates;
+    for (int c = 0; c < numChecked; c++) {
+        int n = checkAll ? c : candidates[c];
+        int shared = index->shared[n];
+        index->shared[n] = 0;
+        const struct IndexedName* name = &index->names[n];
+        if (name->numIds == 0 || shared < minShared || abs(name->length - length) > maxDistance) {
+            continue;
+        }
+        int distance = nameEditDistance(lower, name->name, maxDistance);
+        if (distance > maxDistance) {
+            continue;
+        }
+        if (numMatches == matchCapacity) {
+            matchCapacity = (matchCapacity > 0) ? 2 * matchCapacity : INITIAL_LIST_CAPACITY;
+            *matches = (struct NameMatch*)resizeArray(*matches, sizeof(struct NameMatch) * matchCapacity);
+        }
+        struct NameMatch* match = &(*matches)[numMatches++];
+        match->name = name;
+        match->distance = distance;
+        match->similarity = (double)shared / (numTrigrams + name->numTrigrams - shared);
+    }
+    free(candidates);
+
+    if (numMatches > 1) {
+        qsort(*matches, numMatches, sizeof(struct NameMatch), compareMatches);
+    }
+    return numMatches;
+}
+
+
+/**
+ * @brief Returns the Levenshtein distance between two names, ignoring case, if it is at most maxDistance.
+ *
+ * Only the cells within maxDistance of the diagonal are computed, and the check stops as soon as a whole
+ * row is over the bound.
+ *
+ * @param a First name.
+ * @param b Second name.
+ * @param maxDistance Largest distance of interest.
+ * @return The distance, or maxDistance + 1 if it is larger.
+ */
+int nameEditDistance(const char* a, const char* b, int maxDistance) {
+    int lengthA = (int)strnlen(a, MAX_NAME_LENGTH - 1);
+    int lengthB = (int)strnlen(b, MAX_NAME_LENGTH - 1);
+    int over = maxDistance + 1;
+    if (abs(lengthA - lengthB) > maxDistance) {
+        return over;
+    }
+
+    int rows[2][MAX_NAME_LENGTH];
+    int* previous = rows[0];
+    int* current = rows[1];
+    for (int j = 0; j <= lengthB; j++) {
+        previous[j] = (j <= maxDistance) ? j : over;
+    }
+    for (int i = 1; i <= lengthA; i++) {
+        int low = (i - maxDistance > 1) ? i - maxDistance : 1;
+        int high = (i + maxDistance < lengthB) ? i + maxDistance : lengthB;
+        current[0] = (i <= maxDistance) ? i : over;
+        if (low > 1) {
+            current[low - 1] = over;
+        }
+        int best = (low == 1) ? current[0] : over;
+        char c = (char)tolower((unsigned char)a[i - 1]);
+        for (int j = low; j <= high; j++) {
+            int value = previous[j - 1] + (c != (char)tolower((unsigned char)b[j - 1]));
+            if (previous[j] + 1 < value) {
+                value = previous[j] + 1;
+            }
+            if (current[j - 1] + 1 < value) {
+                value = current[j - 1] + 1;
+            }
+            current[j] = (value < over) ? value : over;
+            if (current[j] < best) {
+                best = current[j];
+            }
+        }
+        if (high < lengthB) {
+            current[high + 1] = over;
+        }
+        if (best > maxDistance) {
+            return over;
+        }
+        int* swap = previous;
+        previous = current;
+        current = swap;
+    }
+    return previous[lengthB];
+}
@@ -0,0 +1,54 @@
+#ifndef NAME_INDEX_H
+#define NAME_INDEX_H
+
+#include "employee.h"
+
+// Symbols a name character is folded to: padding, 26 letters, 10 digits and 27 classes of other bytes
+#define TRIGRAM_ALPHABET 64
+// Number of distinct trigrams, one posting list each
+#define NUM_TRIGRAMS (TRIGRAM_ALPHABET * TRIGRAM_ALPHABET * TRIGRAM_ALPHABET)
+
+// A distinct name (lowercase) and the employees who have it
+struct IndexedName {
+    char name[MAX_NAME_LENGTH];
+    int length;
+    int numTrigrams;                // Number of distinct trigrams of the padded name
+    int* ids;                       // Employees with the name, in no particular order
+    int numIds;
+    int idCapacity;
+};
+
+// Distinct names of the posting list of one trigram
+struct PostingList {
+    int* names;                     // Indexes in NameIndex.names
+    int count;
+    int capacity;
+};
+
+// Trigram index of the names of one field (last or first names), for exact and fuzzy lookups
+struct NameIndex {
+    struct IndexedName* names;      // Every name seen so far; a name whose employees all left keeps its slot
+    int numNames;
+    int nameCapacity;
+    int* slots;                     // Hash table of indexes in names, -1 if empty
+    int numSlots;                   // Power of two, at least twice numNames
+    struct PostingList* postings;   // One list per trigram, NUM_TRIGRAMS of them
+    int* shared;                    // Per name, trigrams shared with the current query (scratch)
+};
+
+// A name found by a fuzzy search
+struct NameMatch {
+    const struct IndexedName* name;
+    int distance;                   // Levenshtein distance to the query (case-insensitive)
+    double similarity;              // Shared trigrams / all distinct trigrams of both (0 to 1)
+};
+
+void nameIndexInit(struct NameIndex* index);
+void nameIndexFree(struct NameIndex* index);
+void nameIndexAdd(struct NameIndex* index, const char* name, int id);
+void nameIndexRemove(struct NameIndex* index, const char* name, int id);
+const struct IndexedName* nameIndexFind(const struct NameIndex* index, const char* name);
+int nameIndexSearch(struct NameIndex* index, const char* query, int maxDistance, struct NameMatch** matches);
+int nameEditDistance(const char* a, const char* b, int maxDistance);
+
+#endif
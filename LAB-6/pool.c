@@ -0,0 +1,274 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stddef.h>
+
+#include "pool.h"
+
+/*
+ * A pool hands out objects of one size from slabs of POOL_SLAB_BYTES, so allocating a node costs a few
+ * pointer moves instead of a call to malloc, and the objects of a pool sit next to each other. Free
+ * objects are linked through their first word.
+ *
+ * Every thread has a cache of free objects for each pool slot. Allocations and frees go to the cache of
+ * the calling thread without a lock; only when the cache is empty does it take a batch of objects from the
+ * pool (first freed ones, then new ones carved from the newest slab), and when it holds more than two
+ * batches it gives one back. A thread that exits gives its cached objects back to their pools.
+ *
+ * Slabs are returned to the system only when the pool is destroyed. A pool that is destroyed leaves stale
+ * objects in the caches of other threads; the generation of the slot tells them apart from the objects of
+ * a later pool in the same slot, and they are dropped (their memory went with the slabs).
+ */
+
+// Free objects cached by one thread for one pool slot
+struct PoolCache {
+    void* head;
+    int count;
+    unsigned int generation;        // Generation of the pool the objects belong to
+};
+
+// Pools in use, by slot
+static pthread_mutex_t registryLock = PTHREAD_MUTEX_INITIALIZER;
+static struct Pool* registeredPools[POOL_MAX_POOLS];
+static unsigned int lastGeneration;
+
+// Thread-exit hook that gives the cached objects back
+static pthread_once_t cacheKeyOnce = PTHREAD_ONCE_INIT;
+static pthread_key_t cacheKey;
+
+static _Thread_local struct PoolCache threadCaches[POOL_MAX_POOLS];
+static _Thread_local int threadCachesHooked;
+
+
+/**
+ * @brief Gives a chain of count cached objects, from head to tail, back to a pool.
+ */
+static void returnObjects(struct Pool* pool, void* head, void* tail, int count) {
+    pthread_mutex_lock(&pool->lock);
+    *(void**)tail = pool->freeList;
+    pool->freeList = head;
+    pool->numFree += count;
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+/**
+ * @brief Gives the cached objects of an exiting thread back to the pools that still exist.
+ */
+static void flushThreadCaches(void* caches) {
+    struct PoolCache* cache = (struct PoolCache*)caches;
+    pthread_mutex_lock(&registryLock);
+    for (int slot = 0; slot < POOL_MAX_POOLS; slot++) {
+        struct Pool* pool = registeredPools[slot];
+        if (pool != NULL && cache[slot].generation == pool->generation && cache[slot].head != NULL) {
+            void* tail = cache[slot].head;
+            while (*(void**)tail != NULL) {
+                tail = *(void**)tail;
+            }
+            returnObjects(pool, cache[slot].head, tail, cache[slot].count);
+        }
+        cache[slot].head = NULL;
+        cache[slot].count = 0;
+    }
+    pthread_mutex_unlock(&registryLock);
+}
+
+
+/**
+ * @brief Creates the key whose destructor flushes the caches of an exiting thread.
+ */
+static void createCacheKey(void) {
+    if (pthread_key_create(&cacheKey, flushThreadCaches) != 0) {
+        fprintf(stderr, "Error: Unable to create the pool cache key.\n");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Initializes an empty pool (the program exits if there are already POOL_MAX_POOLS pools).
+ *
+ * @param pool Pointer to the pool.
+ * @param objectSize Size of the objects, in bytes.
+ */
+void poolInit(struct Pool* pool, size_t objectSize) {
+    size_t alignment = _Alignof(max_align_t);
+    if (objectSize < sizeof(void*)) {
+        objectSize = sizeof(void*); // Room for the free-list link
+    }
+    pool->objectSize = (objectSize + alignment - 1) / alignment * alignment;
+    pool->objectsPerSlab = (pool->objectSize < POOL_SLAB_BYTES) ? (int)(POOL_SLAB_BYTES / pool->objectSize) : 1;
+    pthread_mutex_init(&pool->lock, NULL);
+    pool->freeList = NULL;
+    pool->numFree = 0;
+    pool->unused = NULL;
+    pool->unusedEnd = NULL;
+    pool->slabs = NULL;
+    pool->numSlabs = 0;
+    pool->slabCapacity = 0;
+
+    pthread_mutex_lock(&registryLock);
+    pool->slot = 0;
+    while (pool->slot < POOL_MAX_POOLS && registeredPools[pool->slot] != NULL) {
+        pool->slot++;
+    }
+    if (pool->slot == POOL_MAX_POOLS) {
+        fprintf(stderr, "Error: Too many pools.\n");
+        exit(EXIT_FAILURE);
+    }
+    pool->generation = ++lastGeneration;
+    registeredPools[pool->slot] = pool;
+    pthread_mutex_unlock(&registryLock);
+}
+
+
+/**
+ * @brief Frees every slab of a pool. No object of the pool may be used afterwards.
+ *
+ * @param pool Pointer to the pool.
+ */
+void poolDestroy(struct Pool* pool) {
+    pthread_mutex_lock(&registryLock);
+    registeredPools[pool->slot] = NULL;
+    pthread_mutex_unlock(&registryLock);
+
+    for (int s = 0; s < pool->numSlabs; s++) {
+        free(pool->slabs[s]);
+    }
+    free(pool->slabs);
+    pool->slabs = NULL;
+    pool->numSlabs = 0;
+    pool->slabCapacity = 0;
+    pool->freeList = NULL;
+    pool->numFree = 0;
+    pool->unused = NULL;
+    pool->unusedEnd = NULL;
+    pthread_mutex_destroy(&pool->lock);
+}
+
+
+/**
+ * @brief Returns the cache of the calling thread for a pool, emptied if it held objects of an earlier pool.
+ */
+static struct PoolCache* cacheOf(struct Pool* pool) {
+    struct PoolCache* cache = &threadCaches[pool->slot];
+    if (cache->generation != pool->generation) {
+        cache->head = NULL;
+        cache->count = 0;
+        cache->generation = pool->generation;
+        if (!threadCachesHooked) {
+            pthread_once(&cacheKeyOnce, createCacheKey);
+            pthread_setspecific(cacheKey, threadCaches);
+            threadCachesHooked = 1;
+        }
+    }
+    return cache;
+}
+
+
+/**
+ * @brief Adds a slab to a pool, whose lock is held (the program exits on allocation failure).
+ */
+static void addSlab(struct Pool* pool) {
+    if (pool->numSlabs == pool->slabCapacity) {
+        pool->slabCapacity = (pool->slabCapacity > 0) ? 2 * pool->slabCapacity : 16;
+        pool->slabs = (char**)realloc(pool->slabs, sizeof(char*) * pool->slabCapacity);
+        if (pool->slabs == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    char* slab = (char*)malloc(pool->objectSize * pool->objectsPerSlab);
+    if (slab == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    pool->slabs[pool->numSlabs++] = slab;
+    pool->unused = slab;
+    pool->unusedEnd = slab + pool->objectSize * pool->objectsPerSlab;
+}
+
+
+/**
+ * @brief Fills an empty cache with a batch of objects: freed ones first, then new ones.
+ */
+static void refillCache(struct Pool* pool, struct PoolCache* cache) {
+    pthread_mutex_lock(&pool->lock);
+    while (cache->count < POOL_CACHE_BATCH && pool->freeList != NULL) {
+        void* object = pool->freeList;
+        pool->freeList = *(void**)object;
+        pool->numFree--;
+        *(void**)object = cache->head;
+        cache->head = object;
+        cache->count++;
+    }
+    while (cache->count < POOL_CACHE_BATCH) {
+        if (pool->unused == pool->unusedEnd) {
+            addSlab(pool);
+        }
+        void* object = pool->unused;
+        pool->unused += pool->objectSize;
+        *(void**)object = cache->head;
+        cache->head = object;
+        cache->count++;
+    }
+    pthread_mutex_unlock(&pool->lock);
+}
+
+
+/**
+ * @brief Allocates an object (the program exits on allocation failure).
+ *
+ * @param pool Pointer to the pool.
+ * @return The object, aligned for any type, with undefined contents.
+ */
+void* poolAlloc(struct Pool* pool) {
+    struct PoolCache* cache = cacheOf(pool);
+    if (cache->head == NULL) {
+        refillCache(pool, cache);
+    }
+    void* object = cache->head;
+    cache->head = *(void**)object;
+    cache->count--;
+    return object;
+}
+
+
+/**
+ * @brief Frees an object of a pool. Any thread may free it, not only the one that allocated it.
+ *
+ * @param pool Pointer to the pool.
+ * @param object The object, or NULL.
+ */
+void poolFree(struct Pool* pool, void* object) {
+    if (object == NULL) {
+        return;
+    }
+    struct PoolCache* cache = cacheOf(pool);
+    *(void**)object = cache->head;
+    cache->head = object;
+    cache->count++;
+    if (cache->count > 2 * POOL_CACHE_BATCH) {
+        // Give the most recently freed batch back, keep the rest
+        void* head = cache->head;
+        void* tail = head;
+        for (int i = 1; i < POOL_CACHE_BATCH; i++) {
+            tail = *(void**)tail;
+        }
+        cache->head = *(void**)tail;
+        cache->count -= POOL_CACHE_BATCH;
+        returnObjects(pool, head, tail, POOL_CACHE_BATCH);
+    }
+}
+
+
+/**
+ * @brief Returns the memory a pool has taken from the system, in bytes.
+ *
+ * @param pool Pointer to the pool.
+ */
+size_t poolReservedBytes(struct Pool* pool) {
+    pthread_mutex_lock(&pool->lock);
+    size_t bytes = (size_t)pool->numSlabs * pool->objectsPerSlab * pool->objectSize;
+    pthread_mutex_unlock(&pool->lock);
+    return bytes;
+}
@@ -0,0 +1,37 @@
+#ifndef POOL_H
+#define POOL_H
+
+#include <stddef.h>
+#include <pthread.h>
+
+// Most pools that can exist at the same time (each has a cache in every thread)
+#define POOL_MAX_POOLS 16
+// Bytes of memory a pool takes from the system at a time
+#define POOL_SLAB_BYTES (1 << 20)
+// Objects moved between a thread cache and its pool at a time; a cache holds at most twice as many
+#define POOL_CACHE_BATCH 32
+
+// Allocator of objects of one size, carved from large slabs. Each thread keeps a small cache of free
+// objects of every pool, so most allocations and frees take no lock.
+struct Pool {
+    size_t objectSize;              // Requested size rounded up to the alignment of any type
+    int objectsPerSlab;
+    int slot;                       // Index of the pool's cache in every thread
+    unsigned int generation;        // Tells the caches of this pool from those of an earlier pool in its slot
+    pthread_mutex_t lock;           // Guards the fields below
+    void* freeList;                 // Free objects not cached by any thread, linked through their first word
+    int numFree;
+    char* unused;                   // Part of the newest slab never handed out, up to unusedEnd
+    char* unusedEnd;
+    char** slabs;
+    int numSlabs;
+    int slabCapacity;
+};
+
+void poolInit(struct Pool* pool, size_t objectSize);
+void poolDestroy(struct Pool* pool);
+void* poolAlloc(struct Pool* pool);
+void poolFree(struct Pool* pool, void* object);
+size_t poolReservedBytes(struct Pool* pool);
+
+#endif
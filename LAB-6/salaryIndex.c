@@ -0,0 +1,151 @@
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "salaryIndex.h"
+
+/*
+ * Salaries are integers in MIN_SALARY..MAX_SALARY, so the number of employees per salary fits a
+ * Fenwick (binary indexed) tree over that range. Adding or removing an employee, counting the employees
+ * in a salary range and finding the k-th highest salary each take O(log SALARY_RANGE) steps, about 17,
+ * whatever the number of employees. Salaries outside the range are counted at the nearest bound.
+ */
+
+
+/**
+ * @brief Returns the 1-based position of a salary in the tree, clamped to the salary range.
+ */
+static int salaryPosition(int salary) {
+    if (salary < MIN_SALARY) {
+        return 1;
+    }
+    if (salary > MAX_SALARY) {
+        return SALARY_RANGE;
+    }
+    return salary - MIN_SALARY + 1;
+}
+
+
+/**
+ * @brief Initializes an empty index (the program exits on allocation failure).
+ *
+ * @param index Pointer to the index.
+ */
+void salaryIndexInit(struct SalaryIndex* index) {
+    index->size = SALARY_RANGE;
+    index->total = 0;
+    index->tree = (int*)calloc(index->size + 1, sizeof(int));
+    if (index->tree == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+}
+
+
+/**
+ * @brief Frees the memory of an index.
+ *
+ * @param index Pointer to the index.
+ */
+void salaryIndexFree(struct SalaryIndex* index) {
+    free(index->tree);
+    index->tree = NULL;
+    index->total = 0;
+}
+
+
+/**
+ * @brief Adds employees with a salary to the index, or removes them if delta is negative.
+ *
+ * @param index Pointer to the index.
+ * @param salary The salary.
+ * @param delta Number of employees to add (1) or remove (-1).
+ */
+void salaryIndexAdd(struct SalaryIndex* index, int salary, int delta) {
+    for (int i = salaryPosition(salary); i <= index->size; i += i & -i) {
+        index->tree[i] += delta;
+    }
+    index->total += delta;
+}
+
+
+/**
+ * @brief Returns the number of employees with a salary of at most the given salary.
+ *
+ * @param index Pointer to the index.
+ * @param salary The salary.
+ */
+int salaryIndexCountAtMost(const struct SalaryIndex* index, int salary) {
+    if (salary < MIN_SALARY) {
+        return 0;
+    }
+    int count = 0;
+    for (int i = salaryPosition(salary); i > 0; i -= i & -i) {
+        count += index->tree[i];
+    }
+    return count;
+}
+
+
+/**
+ * @brief Returns the number of employees with a salary between low and high (inclusive).
+ *
+ * @param index Pointer to the index.
+ * @param low Lowest salary of the range.
+ * @param high Highest salary of the range.
+ */
+int salaryIndexCountBetween(const struct SalaryIndex* index, int low, int high) {
+    if (low > high) {
+        return 0;
+    }
+    return salaryIndexCountAtMost(index, high) - salaryIndexCountAtMost(index, low - 1);
+}
+
+
+/**
+ * @brief Returns the k-th highest salary (k = 1 is the highest).
+ *
+ * Descends the tree by powers of two to find the lowest salary with at least total - k + 1 employees
+ * at or below it.
+ *
+ * @param index Pointer to the index.
+ * @param k Rank of the salary, from 1 to the number of employees.
+ * @return The salary, or -1 if k is out of range.
+ */
+int salaryIndexKthHighest(const struct SalaryIndex* index, int k) {
+    if (k < 1 || k > index->total) {
+        return -1;
+    }
+    int remaining = index->total - k + 1; // Rank from the lowest salary
+    int position = 0;
+    int step = 1;
+    while (step * 2 <= index->size) {
+        step *= 2;
+    }
+    for (; step > 0; step /= 2) {
+        if (position + step <= index->size && index->tree[position + step] < remaining) {
+            position += step;
+            remaining -= index->tree[position];
+        }
+    }
+    return MIN_SALARY + position; // Position + 1 is the answer, 1-based
+}
+
+
+/**
+ * @brief Returns the percentile rank of a salary among all employees.
+ *
+ * The rank counts the employees who earn less, plus half of those who earn the same, as a percentage
+ * of all employees; the lowest of many distinct salaries is near 0 and the highest near 100.
+ *
+ * @param index Pointer to the index.
+ * @param salary The salary.
+ * @return The percentile rank (0 to 100), or 0 if the index is empty.
+ */
+double salaryIndexPercentile(const struct SalaryIndex* index, int salary) {
+    if (index->total == 0) {
+        return 0.0;
+    }
+    int below = salaryIndexCountAtMost(index, salary - 1);
+    int same = salaryIndexCountAtMost(index, salary) - below;
+    return 100.0 * (below + 0.5 * same) / index->total;
+}
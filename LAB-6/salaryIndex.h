@@ -0,0 +1,24 @@
+#ifndef SALARY_INDEX_H
+#define SALARY_INDEX_H
+
+#include "employee.h"
+
+// Number of distinct salaries in the index
+#define SALARY_RANGE (MAX_SALARY - MIN_SALARY + 1)
+
+// Fenwick tree of the number of employees per salary, over MIN_SALARY..MAX_SALARY
+struct SalaryIndex {
+    int* tree;          // tree[i] counts the salaries of positions i - (i & -i) + 1 .. i (1-based)
+    int size;           // Number of positions (SALARY_RANGE)
+    int total;          // Number of employees
+};
+
+void salaryIndexInit(struct SalaryIndex* index);
+void salaryIndexFree(struct SalaryIndex* index);
+void salaryIndexAdd(struct SalaryIndex* index, int salary, int delta);
+int salaryIndexCountAtMost(const struct SalaryIndex* index, int salary);
+int salaryIndexCountBetween(const struct SalaryIndex* index, int low, int high);
+int salaryIndexKthHighest(const struct SalaryIndex* index, int k);
+double salaryIndexPercentile(const struct SalaryIndex* index, int salary);
+
+#endif
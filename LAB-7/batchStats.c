@@ -0,0 +1,444 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <dirent.h>
+#include <sys/stat.h>
+
+#include "batchStats.h"
+#include "parallelStats.h"
+#include "frequencyTable.h"
+#include "readFile.h"
+
+/*
+ * Statistics over many files in one process. A pool of worker threads takes the next file from a
+ * shared index; each worker keeps its own data buffer and frequency table and reuses them for every
+ * file it processes, so the threads share nothing but the index and the result slots. Each file's
+ * mean, variance and geometric/harmonic mean terms are kept as a partial (see parallelStats.h), and
+ * the optional aggregate row merges those partials and the frequency tables. The median and the
+ * percentiles of the union cannot be merged from per-file values and are not reported for it.
+ */
+
+// Initial number of slots of a worker's frequency table
+#define INITIAL_TABLE_SIZE 1024
+
+
+// Statistics of one input file
+struct FileResult {
+    int readFailed;             // 1 if the file could not be read
+    int policyFailed;           // 1 if POLICY_ERROR rejected the file
+    struct StatsPartial partial;
+    struct AlternativeMeans means;
+    double median;
+    double *quantiles;          // One per requested percentile
+    double *modes;              // NULL if no mode
+    int numModes;
+};
+
+// State shared by the workers of a batch
+struct Batch {
+    char *const *files;
+    int numFiles;
+    const struct BatchOptions *options;
+    struct FileResult *results;
+    int nextFile;               // Index of the next file to process
+    pthread_mutex_t lock;       // Protects nextFile
+};
+
+// One worker of the pool with the buffers it reuses across files
+struct BatchWorker {
+    struct Batch *batch;
+    double *buffer;
+    int capacity;
+    struct FrequencyTable table;        // Counts of the current file
+    struct FrequencyTable mergedTable;  // Counts of all files of this worker (only with options->merge)
+    struct StatsPartial merged;         // Partials of all files of this worker
+};
+
+
+/**
+ * @brief Duplicates a string and exits with an error message on failure.
+ */
+static char *duplicateString(const char *text) {
+    char *copy = (char *)malloc(strlen(text) + 1);
+    if (copy == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(copy, text);
+    return copy;
+}
+
+
+/**
+ * @brief Appends a path to a growing list of paths.
+ */
+static void appendPath(char ***files, int *numFiles, int *capacity, const char *path) {
+    if (*numFiles == *capacity) {
+        *capacity *= 2;
+        *files = (char **)realloc(*files, sizeof(char *) * *capacity);
+        if (*files == NULL) {
+            perror("Error reallocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    (*files)[(*numFiles)++] = duplicateString(path);
+}
+
+
+/**
+ * @brief Compares two strings for qsort.
+ */
+static int compareStrings(const void *a, const void *b) {
+    return strcmp(*(char *const *)a, *(char *const *)b);
+}
+
+
+/**
+ * @brief Returns whether a path is a directory.
+ *
+ * @param path Path to check.
+ *
+ * @return 1 for a directory, 0 otherwise (including paths that do not exist).
+ */
+int isDirectory(const char *path) {
+    struct stat info;
+    return stat(path, &info) == 0 && S_ISDIR(info.st_mode);
+}
+
+
+/**
+ * @brief Appends the regular files of a directory, in name order, skipping hidden files.
+ */
+static void appendDirectory(char ***files, int *numFiles, int *capacity, const char *directory) {
+    DIR *dir = opendir(directory);
+    if (dir == NULL) {
+        perror("Error opening directory");
+        exit(1);
+    }
+    int first = *numFiles;
+    struct dirent *entry;
+    while ((entry = readdir(dir)) != NULL) {
+        if (entry->d_name[0] == '.') {
+            continue;
+        }
+        size_t length = strlen(directory) + strlen(entry->d_name) + 2;
+        char *path = (char *)malloc(length);
+        if (path == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+        snprintf(path, length, "%s/%s", directory, entry->d_name);
+        struct stat info;
+        if (stat(path, &info) == 0 && S_ISREG(info.st_mode)) {
+            appendPath(files, numFiles, capacity, path);
+        }
+        free(path);
+    }
+    closedir(dir);
+    qsort(*files + first, *numFiles - first, sizeof(char *), compareStrings);
+}
+
+
+/**
+ * @brief Builds the list of input files.
+ *
+ * Every argument that is a directory contributes its regular files (sorted by name); other arguments
+ * are taken as files. The list file, if given, holds one path per line ("-" reads it from standard
+ * input); blank lines are skipped. The program exits with an error message if a directory or the
+ * list file cannot be read.
+ *
+ * @param arguments File and directory arguments.
+ * @param numArguments Number of arguments.
+ * @param fileList Name of a file listing more input files, or NULL.
+ * @param numFiles Pointer to an integer variable to store the number of files.
+ *
+ * @return Dynamically allocated list of paths; release it with freeInputFiles.
+ */
+char **collectInputFiles(char *const *arguments, int numArguments, const char *fileList, int *numFiles) {
+    int capacity = 16;
+    char **files = (char **)malloc(sizeof(char *) * capacity);
+    if (files == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    *numFiles = 0;
+
+    for (int i = 0; i < numArguments; i++) {
+        if (isDirectory(arguments[i])) {
+            appendDirectory(&files, numFiles, &capacity, arguments[i]);
+        } else {
+            appendPath(&files, numFiles, &capacity, arguments[i]);
+        }
+    }
+
+    if (fileList != NULL) {
+        FILE *list = (strcmp(fileList, "-") == 0) ? stdin : fopen(fileList, "r");
+        if (list == NULL) {
+            perror("Error opening file list");
+            exit(1);
+        }
+        char *line = NULL;
+        size_t lineCapacity = 0;
+        ssize_t length;
+        while ((length = getline(&line, &lineCapacity, list)) != -1) {
+            while (length > 0 && (line[length - 1] == '\n' || line[length - 1] == '\r')) {
+                line[--length] = '\0';
+            }
+            if (length > 0) {
+                appendPath(&files, numFiles, &capacity, line);
+            }
+        }
+        free(line);
+        if (list != stdin) {
+            fclose(list);
+        }
+    }
+    return files;
+}
+
+
+/**
+ * @brief Computes the statistics of one file with the buffers of a worker.
+ */
+static void processFile(struct BatchWorker *worker, const char *filename, struct FileResult *result) {
+    const struct BatchOptions *options = worker->batch->options;
+    int numVals;
+    double *data = readDataIntoBuffer(filename, &worker->buffer, &worker->capacity, &numVals);
+    if (data == NULL) {
+        result->readFailed = 1;
+        return;
+    }
+
+    computeStatsPartial(data, numVals, STAT_ALL, &result->partial);
+    result->policyFailed = finalizeAlternativeMeans(&result->partial.meanTerms, options->policy, &result->means) != 0;
+    mergeStatsPartials(&worker->merged, &result->partial);
+
+    if (numVals > 0) {
+        clearFrequencyTable(&worker->table);
+        for (int i = 0; i < numVals; i++) {
+            addToFrequencyTable(&worker->table, data[i], 1);
+        }
+        result->modes = modesFromFrequencyTables(&worker->table, 1, &result->numModes);
+        if (options->merge) {
+            mergeFrequencyTables(&worker->mergedTable, &worker->table);
+        }
+
+        // The median is one more quantile after the requested ones; the selection reorders the buffer
+        int numQuantiles = options->numProbabilities + 1;
+        double *probabilities = (double *)malloc(sizeof(double) * numQuantiles);
+        result->quantiles = (double *)malloc(sizeof(double) * numQuantiles);
+        if (probabilities == NULL || result->quantiles == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+        for (int p = 0; p < options->numProbabilities; p++) {
+            probabilities[p] = options->probabilities[p];
+        }
+        probabilities[options->numProbabilities] = 0.5;
+        calculateQuantiles(data, numVals, probabilities, numQuantiles, result->quantiles);
+        result->median = result->quantiles[options->numProbabilities];
+        free(probabilities);
+    }
+
+    if (data != worker->buffer) {
+        releaseData(data); // A mapped binary data file
+    }
+}
+
+
+/**
+ * @brief Worker of the pool: processes files until none are left.
+ */
+static void *batchWorker(void *arg) {
+    struct BatchWorker *worker = (struct BatchWorker *)arg;
+    struct Batch *batch = worker->batch;
+    while (1) {
+        pthread_mutex_lock(&batch->lock);
+        int file = batch->nextFile++;
+        pthread_mutex_unlock(&batch->lock);
+        if (file >= batch->numFiles) {
+            return NULL;
+        }
+        processFile(worker, batch->files[file], &batch->results[file]);
+    }
+}
+
+
+/**
+ * @brief Prints a geometric or harmonic mean cell.
+ */
+static void printMeanCell(int defined, double mean) {
+    if (defined) {
+        printf(" %12.3f", mean);
+    } else {
+        printf(" %12s", "undefined");
+    }
+}
+
+
+/**
+ * @brief Prints the mode cell of a row.
+ */
+static void printModeCell(const double *modes, int numModes) {
+    printf(" ");
+    if (numModes == 0) {
+        printf(" -");
+    }
+    for (int m = 0; m < numModes; m++) {
+        printf("%s%g", (m == 0) ? " " : ",", modes[m]);
+    }
+    printf("\n");
+}
+
+
+/**
+ * @brief Computes the statistics of many files with a thread pool and prints one row per file.
+ *
+ * Rows are printed in the order of the files once all files are done. Files that cannot be read are
+ * reported as such and the others are still processed. With options->merge an aggregate row follows,
+ * computed by merging the per-file partials (count, mean, variance, geometric/harmonic mean terms) and
+ * frequency tables (modes); its median and percentiles are reported as n/a since they cannot be
+ * merged from per-file values.
+ *
+ * @param files Paths of the input files.
+ * @param numFiles Number of input files.
+ * @param options Thread count, merge flag, invalid value policy and percentiles.
+ *
+ * @return 0 on success, 1 if a file could not be read or was rejected by POLICY_ERROR.
+ */
+int runBatchStatistics(char *const *files, int numFiles, const struct BatchOptions *options) {
+    struct Batch batch;
+    batch.files = files;
+    batch.numFiles = numFiles;
+    batch.options = options;
+    batch.nextFile = 0;
+    batch.results = (struct FileResult *)calloc(numFiles > 0 ? numFiles : 1, sizeof(struct FileResult));
+    if (batch.results == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    pthread_mutex_init(&batch.lock, NULL);
+
+    int numThreads = options->numThreads;
+    if (numThreads > numFiles) {
+        numThreads = numFiles;
+    }
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    struct BatchWorker *workers = (struct BatchWorker *)calloc(numThreads, sizeof(struct BatchWorker));
+    if (workers == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < numThreads; t++) {
+        workers[t].batch = &batch;
+        initFrequencyTable(&workers[t].table, INITIAL_TABLE_SIZE);
+        initFrequencyTable(&workers[t].mergedTable, options->merge ? INITIAL_TABLE_SIZE : 0);
+    }
+
+    runThreads(numThreads, batchWorker, workers, sizeof(struct BatchWorker));
+
+    // Print one row per file
+    int nameWidth = 4;
+    for (int f = 0; f < numFiles; f++) {
+        int length = (int)strlen(files[f]);
+        nameWidth = (length > nameWidth) ? length : nameWidth;
+    }
+    nameWidth = (nameWidth > 48) ? 48 : nameWidth;
+
+    printf("%-*s %10s %12s %12s %12s %12s %12s", nameWidth, "file", "count", "mean", "median", "stddev",
+           "geometric", "harmonic");
+    for (int p = 0; p < options->numProbabilities; p++) {
+        char label[32];
+        snprintf(label, sizeof(label), "p%g", options->probabilities[p] * 100.0);
+        printf(" %12s", label);
+    }
+    printf("  mode(s)\n");
+
+    int status = 0;
+    for (int f = 0; f < numFiles; f++) {
+        const struct FileResult *result = &batch.results[f];
+        printf("%-*s", nameWidth, files[f]);
+        if (result->readFailed || result->partial.count == 0) {
+            printf(" %10s\n", result->readFailed ? "unreadable" : "empty");
+            status |= result->readFailed;
+            continue;
+        }
+        if (result->policyFailed) {
+            printf(" %10d  invalid values: %d non-positive, %d zero, %d NaN\n", result->partial.count,
+                   result->means.numNonPositive, result->means.numZeros, result->means.numNaN);
+            status = 1;
+            continue;
+        }
+        printf(" %10d %12.3f %12.3f %12.3f", result->partial.count, result->partial.mean, result->median,
+               sqrt(result->partial.m2 / result->partial.count));
+        printMeanCell(result->means.geometricDefined, result->means.geometricMean);
+        printMeanCell(result->means.harmonicDefined, result->means.harmonicMean);
+        for (int p = 0; p < options->numProbabilities; p++) {
+            printf(" %12.3f", result->quantiles[p]);
+        }
+        printModeCell(result->modes, result->numModes);
+    }
+
+    if (options->merge) {
+        // Merge the partials and tables of all workers
+        struct StatsPartial merged = workers[0].merged;
+        for (int t = 1; t < numThreads; t++) {
+            mergeStatsPartials(&merged, &workers[t].merged);
+            mergeFrequencyTables(&workers[0].mergedTable, &workers[t].mergedTable);
+        }
+        printf("%-*s", nameWidth, "(all files)");
+        if (merged.count == 0) {
+            printf(" %10s\n", "empty");
+        } else {
+            struct AlternativeMeans means;
+            if (finalizeAlternativeMeans(&merged.meanTerms, options->policy, &means) != 0) {
+                printf(" %10d  invalid values: %d non-positive, %d zero, %d NaN\n", merged.count,
+                       means.numNonPositive, means.numZeros, means.numNaN);
+                status = 1;
+            } else {
+                printf(" %10d %12.3f %12s %12.3f", merged.count, merged.mean, "n/a", sqrt(merged.m2 / merged.count));
+                printMeanCell(means.geometricDefined, means.geometricMean);
+                printMeanCell(means.harmonicDefined, means.harmonicMean);
+                for (int p = 0; p < options->numProbabilities; p++) {
+                    printf(" %12s", "n/a");
+                }
+                int numModes;
+                double *modes = modesFromFrequencyTables(&workers[0].mergedTable, 1, &numModes);
+                printModeCell(modes, numModes);
+                free(modes);
+            }
+        }
+    }
+
+    for (int t = 0; t < numThreads; t++) {
+        free(workers[t].buffer);
+        freeFrequencyTable(&workers[t].table);
+        freeFrequencyTable(&workers[t].mergedTable);
+    }
+    for (int f = 0; f < numFiles; f++) {
+        free(batch.results[f].quantiles);
+        free(batch.results[f].modes);
+    }
+    free(workers);
+    free(batch.results);
+    pthread_mutex_destroy(&batch.lock);
+    return status;
+}
+
+
+/**
+ * @brief Releases a list built by collectInputFiles.
+ *
+ * @param files List of paths.
+ * @param numFiles Number of paths in the list.
+ */
+void freeInputFiles(char **files, int numFiles) {
+    for (int f = 0; f < numFiles; f++) {
+        free(files[f]);
+    }
+    free(files);
+}
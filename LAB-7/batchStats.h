@@ -0,0 +1,27 @@
+#ifndef BATCHSTATS_H
+#define BATCHSTATS_H
+
+#include "statsFunctions.h"
+
+// Settings of a run over many input files
+struct BatchOptions {
+    int numThreads;                 // Size of the thread pool (files are processed concurrently)
+    int merge;                      // Whether to print an aggregate row merged from the per-file partials
+    enum InvalidValuePolicy policy;
+    const double *probabilities;    // Requested percentiles as probabilities
+    int numProbabilities;
+};
+
+// Function to build the list of input files from arguments (files or directories) and an optional list file
+char **collectInputFiles(char *const *arguments, int numArguments, const char *fileList, int *numFiles);
+
+// Function to check whether a path is a directory
+int isDirectory(const char *path);
+
+// Function to compute the statistics of every file with a thread pool and print one row per file; returns 0 on success
+int runBatchStatistics(char *const *files, int numFiles, const struct BatchOptions *options);
+
+// Function to release a list built by collectInputFiles
+void freeInputFiles(char **files, int numFiles);
+
+#endif
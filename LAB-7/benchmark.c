@@ -0,0 +1,490 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "reductionKernels.h"
+#include "parallelStats.h"
+#include "readFile.h"
+#include "rollingStats.h"
+#include "statsFunctions.h"
+#include "dataGenerator.h"
+
+// Default number of values and repetitions for the kernel benchmark
+#define DEFAULT_KERNEL_VALUES (1 << 24)
+#define DEFAULT_REPETITIONS 10
+#define DEFAULT_SCALING_VALUES 10000000
+#define DEFAULT_ROLLING_UPDATES 4000000
+
+// Sizes of the stats benchmark run from 10^3 up to this many values by default (10^8 needs 1.6 GB)
+#define DEFAULT_STATS_MAX_VALUES 10000000
+#define DEFAULT_STATS_REPETITIONS 5
+
+// Each timed repetition processes at least this many values, so small sizes are not dominated by the clock
+#define MIN_VALUES_PER_REPETITION 1000000
+
+// calculateMode compares every pair of values, so larger sizes are skipped
+#define MODE_MAX_VALUES 10000
+
+// Sink for benchmark results so the compiler cannot drop the timed calls
+static volatile double benchmarkSink;
+
+
+/**
+ * @brief Returns the current time of a monotonic clock in seconds.
+ */
+static double nowSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief Times one reduction kernel and prints its throughput.
+ *
+ * The kernel is run once to warm up caches and page tables, then timed over the given
+ * number of repetitions; the fastest repetition is reported.
+ *
+ * @param isaName Name of the instruction set the kernel is compiled for.
+ * @param kernelName Name of the kernel.
+ * @param kernels Kernel table to take the kernel from.
+ * @param which Index of the kernel: 0 = sum, 1 = squared deviations, 2 = reciprocals.
+ * @param data Input data.
+ * @param numVals Number of values in the input data.
+ * @param repetitions Number of timed repetitions.
+ */
+static void timeKernel(const char *isaName, const char *kernelName, const struct ReductionKernels *kernels,
+                       int which, const double *data, int numVals, int repetitions) {
+    double best = 0.0;
+    for (int rep = -1; rep < repetitions; rep++) {
+        int numZeros;
+        double start = nowSeconds();
+        switch (which) {
+            case 0:
+                benchmarkSink = kernels->sum(data, numVals);
+                break;
+            case 1:
+                benchmarkSink = kernels->sumSquaredDeviations(data, numVals, 500.0);
+                break;
+            default:
+                benchmarkSink = kernels->sumReciprocals(data, numVals, &numZeros);
+                break;
+        }
+        double elapsed = nowSeconds() - start;
+        // Repetition -1 is the warmup run
+        if (rep == 0 || (rep > 0 && elapsed < best)) {
+            best = elapsed;
+        }
+    }
+
+    double bytes = (double)numVals * sizeof(double);
+    printf("%-8s %-22s %10.3f ms %8.2f GB/s %20.6f\n", isaName, kernelName, best * 1e3,
+           bytes / best / 1e9, benchmarkSink);
+}
+
+
+/**
+ * @brief Benchmarks every reduction kernel for every instruction set supported by the CPU.
+ *
+ * @param numVals Number of values to reduce.
+ * @param repetitions Number of timed repetitions per kernel.
+ */
+static void benchmarkKernels(int numVals, int repetitions) {
+    static const char *kernelNames[] = {"sum", "sumSquaredDeviations", "sumReciprocals"};
+    double *data = generateData(DIST_UNIFORM, numVals, 42);
+
+    printf("Reduction kernels: %d values (%.1f MB), best of %d runs\n", numVals,
+           numVals * sizeof(double) / 1e6, repetitions);
+    printf("Selected at runtime: %s\n\n", selectReductionKernels()->name);
+    printf("%-8s %-22s %13s %13s %20s\n", "ISA", "KERNEL", "TIME", "THROUGHPUT", "RESULT");
+    printf("-------------------------------------------------------------------------------\n");
+
+    for (int isa = 0; isa < KERNEL_ISA_COUNT; isa++) {
+        const struct ReductionKernels *kernels = getReductionKernels((enum KernelIsa)isa);
+        if (kernels == NULL) {
+            continue; // Not supported by this CPU
+        }
+        for (int which = 0; which < 3; which++) {
+            timeKernel(kernels->name, kernelNames[which], kernels, which, data, numVals, repetitions);
+        }
+    }
+
+    free(data);
+}
+
+
+/**
+ * @brief Measures how the parallel statistics engine scales with the number of threads.
+ *
+ * The full set of statistics is computed with 1, 2, 4, ... threads up to the number of cores
+ * (always including the core count itself), and the speedup over one thread is reported.
+ *
+ * @param numVals Number of values in the dataset.
+ * @param repetitions Number of timed repetitions per thread count.
+ */
+static void benchmarkScaling(int numVals, int repetitions) {
+    double *data = generateData(DIST_UNIFORM, numVals, 42);
+    int numCores = getNumCores();
+    double baseline = 0.0;
+
+    printf("Parallel statistics: %d values, best of %d runs, %d cores\n\n", numVals, repetitions, numCores);
+    printf("%8s %13s %10s %12s\n", "THREADS", "TIME", "SPEEDUP", "EFFICIENCY");
+    printf("---------------------------------------------\n");
+
+    int numThreads = 1;
+    while (1) {
+        double best = 0.0;
+        for (int rep = -1; rep < repetitions; rep++) {
+            struct ParallelResults results;
+            double start = nowSeconds();
+            calculateStatisticsParallel(data, numVals, numThreads, STAT_ALL, &results);
+            double elapsed = nowSeconds() - start;
+            benchmarkSink = results.mean + results.median;
+            free(results.modes);
+            // Repetition -1 is the warmup run
+            if (rep == 0 || (rep > 0 && elapsed < best)) {
+                best = elapsed;
+            }
+        }
+        if (numThreads == 1) {
+            baseline = best;
+        }
+        printf("%8d %10.3f ms %9.2fx %11.1f%%\n", numThreads, best * 1e3, baseline / best,
+               100.0 * baseline / best / numThreads);
+
+        if (numThreads == numCores) {
+            break;
+        }
+        numThreads = (numThreads * 2 < numCores) ? numThreads * 2 : numCores;
+    }
+
+    free(data);
+}
+
+
+/**
+ * @brief Measures how long it takes to load a data file and touch every value.
+ *
+ * Text files are parsed; binary data files are memory-mapped, so their load time is dominated by the
+ * page faults taken while the values are summed. Run it on a text file and on the same data converted
+ * with textToBinary to compare the two. The peak resident set size is process-wide, so compare the
+ * text load strategies in separate runs.
+ *
+ * @param filename Name of the data file.
+ * @param strategy How the array of a text file is sized.
+ * @param repetitions Number of timed repetitions.
+ */
+static void benchmarkLoad(const char *filename, enum LoadStrategy strategy, int repetitions) {
+    double best = 0.0;
+    int numVals = 0;
+    int cap = 0;
+    for (int rep = -1; rep < repetitions; rep++) {
+        double start = nowSeconds();
+        double *data = readDataFromFileWithStrategy(filename, strategy, &numVals, &cap);
+        benchmarkSink = selectReductionKernels()->sum(data, numVals);
+        double elapsed = nowSeconds() - start;
+        releaseData(data);
+        // Repetition -1 is the warmup run
+        if (rep == 0 || (rep > 0 && elapsed < best)) {
+            best = elapsed;
+        }
+    }
+
+    double megabytes = numVals * sizeof(double) / 1e6;
+    printf("Load %s (%s): %d values (%.1f MB of doubles), best of %d runs\n", filename,
+           (strategy == LOAD_PRESIZED) ? "presized" : "doubling", numVals, megabytes, repetitions);
+    printf("  load + sum: %.3f ms, %.2f MB/s\n", best * 1e3, megabytes / best);
+    printf("  capacity: %d values (%d unused), peak RSS: %ld KB\n", cap, cap - numVals, getPeakRssKilobytes());
+}
+
+
+/**
+ * @brief Measures the update rate of the rolling statistics for several window sizes.
+ *
+ * Every update adds one value (evicting the oldest once the window is full) and queries the mean,
+ * standard deviation, median and largest mode frequency, as a monitoring loop would. The values
+ * are rounded to integers so that the window contains repeated values.
+ *
+ * @param numUpdates Number of values streamed through the window.
+ * @param repetitions Number of timed repetitions per window size.
+ */
+static void benchmarkRolling(int numUpdates, int repetitions) {
+    static const int windows[] = {16, 256, 4096, 65536, 1048576};
+    double *data = generateData(DIST_UNIFORM, numUpdates, 42);
+    for (int i = 0; i < numUpdates; i++) {
+        data[i] = (double)(long)data[i];
+    }
+
+    printf("Rolling statistics: %d updates, best of %d runs\n\n", numUpdates, repetitions);
+    printf("%10s %13s %16s %12s\n", "WINDOW", "TIME", "UPDATES/S", "NS/UPDATE");
+    printf("------------------------------------------------------\n");
+
+    for (size_t w = 0; w < sizeof(windows) / sizeof(windows[0]); w++) {
+        double best = 0.0;
+        for (int rep = -1; rep < repetitions; rep++) {
+            struct RollingStats stats;
+            initRollingStats(&stats, windows[w]);
+            double sink = 0.0;
+            double start = nowSeconds();
+            for (int i = 0; i < numUpdates; i++) {
+                addRollingValue(&stats, data[i]);
+                sink += rollingMean(&stats) + rollingStandardDeviation(&stats) + rollingMedian(&stats) +
+                        rollingModeFrequency(&stats);
+            }
+            double elapsed = nowSeconds() - start;
+            benchmarkSink = sink;
+            freeRollingStats(&stats);
+            // Repetition -1 is the warmup run
+            if (rep == 0 || (rep > 0 && elapsed < best)) {
+                best = elapsed;
+            }
+        }
+        printf("%10d %10.3f ms %16.0f %12.1f\n", windows[w], best * 1e3, numUpdates / best, best * 1e9 / numUpdates);
+    }
+
+    free(data);
+}
+
+
+// Statistics functions timed by the stats benchmark
+enum StatsFunction {
+    STATS_MEAN,
+    STATS_STDDEV,
+    STATS_MEDIAN,
+    STATS_MODE,
+    STATS_GEOMETRIC_MEAN,
+    STATS_HARMONIC_MEAN,
+    STATS_FUNCTION_COUNT
+};
+
+static const char *statsFunctionNames[STATS_FUNCTION_COUNT] = {
+    "calculateMean", "calculateStandardDeviation", "calculateMedian", "calculateMode",
+    "calculateGeometricMean", "calculateHarmonicMean"
+};
+
+
+/**
+ * @brief Calls one statistics function once.
+ *
+ * @param function The function to call.
+ * @param data Input data (reordered by calculateMedian).
+ * @param numVals Number of values in the input data.
+ *
+ * @return A result of the call, to be stored in the benchmark sink.
+ */
+static double callStatsFunction(enum StatsFunction function, double *data, int numVals) {
+    switch (function) {
+        case STATS_MEAN:
+            return calculateMean(data, numVals);
+        case STATS_STDDEV:
+            return calculateStandardDeviation(data, numVals, 500.0);
+        case STATS_MEDIAN:
+            return calculateMedian(data, numVals);
+        case STATS_MODE: {
+            int numModes;
+            double *modes = calculateMode(data, numVals, &numModes);
+            free(modes);
+            return numModes;
+        }
+        case STATS_GEOMETRIC_MEAN:
+            return calculateGeometricMean(data, numVals);
+        default:
+            return calculateHarmonicMean(data, numVals);
+    }
+}
+
+
+/**
+ * @brief Times one statistics function on a dataset.
+ *
+ * Functions that only read the data are called repeatedly inside each repetition until at least
+ * MIN_VALUES_PER_REPETITION values were processed. calculateMedian reorders its input, so it gets a
+ * fresh copy of the data before every call and only the call itself is timed. One warmup repetition
+ * precedes the timed ones; the fastest repetition is reported.
+ *
+ * @return The best time of one call in seconds.
+ */
+static double timeStatsFunction(enum StatsFunction function, const double *data, double *scratch, int numVals,
+                                int repetitions) {
+    int callsPerRepetition = (numVals < MIN_VALUES_PER_REPETITION) ? MIN_VALUES_PER_REPETITION / numVals : 1;
+    if (function == STATS_MODE) {
+        callsPerRepetition = 1;
+    }
+    double best = 0.0;
+    for (int rep = -1; rep < repetitions; rep++) {
+        double elapsed = 0.0;
+        if (function == STATS_MEDIAN) {
+            for (int call = 0; call < callsPerRepetition; call++) {
+                memcpy(scratch, data, sizeof(double) * numVals);
+                double start = nowSeconds();
+                benchmarkSink = callStatsFunction(function, scratch, numVals);
+                elapsed += nowSeconds() - start;
+            }
+        } else {
+            double start = nowSeconds();
+            for (int call = 0; call < callsPerRepetition; call++) {
+                benchmarkSink = callStatsFunction(function, (double *)data, numVals);
+            }
+            elapsed = nowSeconds() - start;
+        }
+        elapsed /= callsPerRepetition;
+        // Repetition -1 is the warmup run
+        if (rep == 0 || (rep > 0 && elapsed < best)) {
+            best = elapsed;
+        }
+    }
+    return best;
+}
+
+
+/**
+ * @brief Times every statistics function on synthetic datasets of growing size.
+ *
+ * For each distribution, datasets of 10^3, 10^4, ... values up to maxVals are generated and every
+ * function in statsFunctions.h is timed on them; time per call, ns per element and throughput are
+ * printed. calculateMode is quadratic and only timed up to MODE_MAX_VALUES values.
+ *
+ * @param distributions Distributions to benchmark.
+ * @param numDistributions Number of distributions.
+ * @param maxVals Largest dataset size.
+ * @param repetitions Number of timed repetitions per function and size.
+ */
+static void benchmarkStats(const enum Distribution *distributions, int numDistributions, int maxVals, int repetitions) {
+    printf("Statistics functions: 10^3 to %d values, best of %d runs\n\n", maxVals, repetitions);
+    printf("%-15s %10s %-27s %13s %12s %14s\n", "DATA", "VALUES", "FUNCTION", "TIME", "NS/ELEMENT", "MELEMENTS/S");
+    printf("----------------------------------------------------------------------------------------------------\n");
+
+    for (int d = 0; d < numDistributions; d++) {
+        for (long long size = 1000; size <= maxVals; size *= 10) {
+            int numVals = (int)size;
+            double *data = generateData(distributions[d], numVals, 42);
+            double *scratch = (double *)malloc(sizeof(double) * numVals);
+            if (scratch == NULL) {
+                perror("Error allocating memory");
+                exit(1);
+            }
+
+            for (int f = 0; f < STATS_FUNCTION_COUNT; f++) {
+                printf("%-15s %10d %-27s", distributionName(distributions[d]), numVals, statsFunctionNames[f]);
+                if (f == STATS_MODE && numVals > MODE_MAX_VALUES) {
+                    printf(" %13s\n", "skipped");
+                    continue;
+                }
+                double best = timeStatsFunction((enum StatsFunction)f, data, scratch, numVals, repetitions);
+                printf(" %10.1f us %12.3f %14.1f\n", best * 1e6, best * 1e9 / numVals, numVals / best / 1e6);
+                fflush(stdout);
+            }
+
+            free(scratch);
+            free(data);
+        }
+    }
+}
+
+
+/**
+ * @brief Entry point of the benchmark program.
+ *
+ * Usage: benchmark kernels [numVals] [repetitions]
+ *        benchmark scaling [numVals] [repetitions]
+ *        benchmark rolling [numUpdates] [repetitions]
+ *        benchmark stats [distribution|all] [maxVals] [repetitions]
+ *        benchmark generate <distribution> <numVals> <file> [seed]
+ *        benchmark load <file> [repetitions] [presized|doubling]
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Array of command-line argument strings.
+ * @return 0 upon success, 1 on incorrect usage.
+ */
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        printf("Usage: %s kernels|scaling [numVals] [repetitions]\n", argv[0]);
+        printf("       %s rolling [numUpdates] [repetitions]\n", argv[0]);
+        printf("       %s stats [uniform|normal|duplicates|sorted|reverse-sorted|all] [maxVals] [repetitions]\n", argv[0]);
+        printf("       %s generate <distribution> <numVals> <file> [seed]\n", argv[0]);
+        printf("       %s load <file> [repetitions] [presized|doubling]\n", argv[0]);
+        return 1;
+    }
+
+    if (strcmp(argv[1], "load") == 0) {
+        if (argc < 3) {
+            printf("Missing data file for the load benchmark.\n");
+            return 1;
+        }
+        int repetitions = (argc > 3) ? atoi(argv[3]) : DEFAULT_REPETITIONS;
+        if (repetitions <= 0) {
+            printf("repetitions must be a positive integer.\n");
+            return 1;
+        }
+        enum LoadStrategy strategy = LOAD_PRESIZED;
+        if (argc > 4 && strcmp(argv[4], "doubling") == 0) {
+            strategy = LOAD_DOUBLING;
+        } else if (argc > 4 && strcmp(argv[4], "presized") != 0) {
+            printf("Unknown load strategy: %s (expected presized or doubling)\n", argv[4]);
+            return 1;
+        }
+        benchmarkLoad(argv[2], strategy, repetitions);
+        return 0;
+    }
+
+    if (strcmp(argv[1], "stats") == 0 || strcmp(argv[1], "generate") == 0) {
+        int isGenerate = (argv[1][0] == 'g');
+        enum Distribution distributions[DIST_COUNT];
+        int numDistributions = DIST_COUNT;
+        for (int d = 0; d < DIST_COUNT; d++) {
+            distributions[d] = (enum Distribution)d;
+        }
+        if (argc > 2 && !(strcmp(argv[2], "all") == 0 && !isGenerate)) {
+            if (parseDistribution(argv[2], &distributions[0]) != 0) {
+                printf("Unknown distribution: %s\n", argv[2]);
+                return 1;
+            }
+            numDistributions = 1;
+        }
+
+        if (isGenerate) {
+            if (argc < 5 || numDistributions != 1 || atoi(argv[3]) <= 0) {
+                printf("Usage: %s generate <distribution> <numVals> <file> [seed]\n", argv[0]);
+                return 1;
+            }
+            int numVals = atoi(argv[3]);
+            double *data = generateData(distributions[0], numVals, (argc > 5) ? strtoull(argv[5], NULL, 10) : 42);
+            int status = writeTextDataFile(argv[4], data, numVals);
+            free(data);
+            return (status == 0) ? 0 : 1;
+        }
+
+        int maxVals = (argc > 3) ? atoi(argv[3]) : DEFAULT_STATS_MAX_VALUES;
+        int repetitions = (argc > 4) ? atoi(argv[4]) : DEFAULT_STATS_REPETITIONS;
+        if (maxVals < 1000 || repetitions <= 0) {
+            printf("maxVals must be at least 1000 and repetitions a positive integer.\n");
+            return 1;
+        }
+        benchmarkStats(distributions, numDistributions, maxVals, repetitions);
+        return 0;
+    }
+
+    int isKernels = (strcmp(argv[1], "kernels") == 0);
+    int isRolling = (strcmp(argv[1], "rolling") == 0);
+    int defaultValues = isKernels ? DEFAULT_KERNEL_VALUES : (isRolling ? DEFAULT_ROLLING_UPDATES : DEFAULT_SCALING_VALUES);
+    int numVals = (argc > 2) ? atoi(argv[2]) : defaultValues;
+    int repetitions = (argc > 3) ? atoi(argv[3]) : DEFAULT_REPETITIONS;
+    if (numVals <= 0 || repetitions <= 0) {
+        printf("numVals and repetitions must be positive integers.\n");
+        return 1;
+    }
+
+    if (isKernels) {
+        benchmarkKernels(numVals, repetitions);
+    } else if (strcmp(argv[1], "scaling") == 0) {
+        benchmarkScaling(numVals, repetitions);
+    } else if (isRolling) {
+        benchmarkRolling(numVals, repetitions);
+    } else {
+        printf("Unknown benchmark: %s\n", argv[1]);
+        return 1;
+    }
+
+    return 0;
+}
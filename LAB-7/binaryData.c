@@ -0,0 +1,221 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <limits.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "binaryData.h"
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define HOST_IS_LITTLE_ENDIAN 0
+#else
+#define HOST_IS_LITTLE_ENDIAN 1
+#endif
+
+// A mapped binary data file, remembered so the mapping can be released from the data pointer
+struct Mapping {
+    double *data;
+    void *base;
+    size_t length;
+    struct Mapping *next;
+};
+
+// List of the active mappings
+static struct Mapping *mappings = NULL;
+static pthread_mutex_t mappingsLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/**
+ * @brief Decodes a little-endian unsigned integer of the given number of bytes.
+ */
+static uint64_t decodeLittleEndian(const unsigned char *bytes, int numBytes) {
+    uint64_t value = 0;
+    for (int i = numBytes - 1; i >= 0; i--) {
+        value = (value << 8) | bytes[i];
+    }
+    return value;
+}
+
+
+/**
+ * @brief Encodes an unsigned integer as little-endian bytes.
+ */
+static void encodeLittleEndian(unsigned char *bytes, uint64_t value, int numBytes) {
+    for (int i = 0; i < numBytes; i++) {
+        bytes[i] = (unsigned char)(value >> (8 * i));
+    }
+}
+
+
+/**
+ * @brief Checks whether a file starts with the binary data magic bytes.
+ *
+ * @param filename Name of the file to check.
+ *
+ * @return 1 if the file is a binary data file, 0 otherwise (including when it cannot be opened).
+ */
+int isBinaryDataFile(const char *filename) {
+    FILE *file = fopen(filename, "rb");
+    if (file == NULL) {
+        return 0;
+    }
+    char magic[BINARY_DATA_MAGIC_LENGTH];
+    int isBinary = fread(magic, 1, sizeof(magic), file) == sizeof(magic) &&
+                   memcmp(magic, BINARY_DATA_MAGIC, BINARY_DATA_MAGIC_LENGTH) == 0;
+    fclose(file);
+    return isBinary;
+}
+
+
+/**
+ * @brief Writes values to a binary data file.
+ *
+ * The header is followed by the values as packed little-endian doubles.
+ *
+ * @param filename Name of the file to create (overwritten if it exists).
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ *
+ * @return 0 on success, -1 if the file could not be written.
+ */
+int writeBinaryDataFile(const char *filename, const double *data, int numVals) {
+    FILE *file = fopen(filename, "wb");
+    if (file == NULL) {
+        return -1;
+    }
+
+    unsigned char header[sizeof(struct BinaryDataHeader)];
+    memcpy(header, BINARY_DATA_MAGIC, BINARY_DATA_MAGIC_LENGTH);
+    encodeLittleEndian(header + 8, BINARY_DATA_VERSION, 4);
+    encodeLittleEndian(header + 12, 0, 4);
+    encodeLittleEndian(header + 16, (uint64_t)numVals, 8);
+    int ok = fwrite(header, 1, sizeof(header), file) == sizeof(header);
+
+    if (HOST_IS_LITTLE_ENDIAN) {
+        ok = ok && fwrite(data, sizeof(double), numVals, file) == (size_t)numVals;
+    } else {
+        for (int i = 0; ok && i < numVals; i++) {
+            uint64_t bits;
+            unsigned char bytes[8];
+            memcpy(&bits, &data[i], sizeof(bits));
+            encodeLittleEndian(bytes, bits, 8);
+            ok = fwrite(bytes, 1, sizeof(bytes), file) == sizeof(bytes);
+        }
+    }
+
+    if (fclose(file) != 0) {
+        ok = 0;
+    }
+    return ok ? 0 : -1;
+}
+
+
+/**
+ * @brief Maps a binary data file into memory.
+ *
+ * The file is mapped privately, so the values can be read without being copied and pages are only
+ * read from disk when they are first touched. Writes to the returned array (for example sorting it
+ * in place) go to private copy-on-write pages and never change the file. On big-endian hosts the
+ * values are instead copied into a malloc'ed array and byte-swapped.
+ * The returned array must be released with unmapBinaryData (or free, if that returns 0).
+ *
+ * @param filename Name of the binary data file.
+ * @param numVals Pointer to an integer variable to store the number of values in the file.
+ *
+ * @return Pointer to the values, or NULL if the file cannot be opened or is not a valid binary data file.
+ */
+double *mapBinaryDataFile(const char *filename, int *numVals) {
+    int fd = open(filename, O_RDONLY);
+    if (fd < 0) {
+        return NULL;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < sizeof(struct BinaryDataHeader)) {
+        close(fd);
+        return NULL;
+    }
+
+    size_t length = (size_t)st.st_size;
+    void *base = mmap(NULL, length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    close(fd); // The mapping stays valid after the descriptor is closed
+    if (base == MAP_FAILED) {
+        return NULL;
+    }
+
+    const unsigned char *header = (const unsigned char *)base;
+    uint64_t version = decodeLittleEndian(header + 8, 4);
+    uint64_t count = decodeLittleEndian(header + 16, 8);
+    if (memcmp(header, BINARY_DATA_MAGIC, BINARY_DATA_MAGIC_LENGTH) != 0 || version != BINARY_DATA_VERSION ||
+        count > INT_MAX || count > (length - sizeof(struct BinaryDataHeader)) / sizeof(double)) {
+        munmap(base, length);
+        return NULL;
+    }
+
+    double *data = (double *)((char *)base + sizeof(struct BinaryDataHeader));
+    *numVals = (int)count;
+
+    if (!HOST_IS_LITTLE_ENDIAN) {
+        double *copy = (double *)malloc(sizeof(double) * (count > 0 ? count : 1));
+        if (copy == NULL) {
+            munmap(base, length);
+            return NULL;
+        }
+        for (uint64_t i = 0; i < count; i++) {
+            uint64_t bits = decodeLittleEndian((const unsigned char *)&data[i], 8);
+            memcpy(&copy[i], &bits, sizeof(bits));
+        }
+        munmap(base, length);
+        return copy;
+    }
+
+    // The values are read front to back by every statistic
+    madvise(base, length, MADV_SEQUENTIAL);
+
+    struct Mapping *mapping = (struct Mapping *)malloc(sizeof(struct Mapping));
+    if (mapping == NULL) {
+        munmap(base, length);
+        return NULL;
+    }
+    mapping->data = data;
+    mapping->base = base;
+    mapping->length = length;
+    pthread_mutex_lock(&mappingsLock);
+    mapping->next = mappings;
+    mappings = mapping;
+    pthread_mutex_unlock(&mappingsLock);
+
+    return data;
+}
+
+
+/**
+ * @brief Releases data returned by mapBinaryDataFile.
+ *
+ * @param data Pointer returned by mapBinaryDataFile.
+ *
+ * @return 1 if the data was a mapping and has been unmapped, 0 if it is not a mapping
+ *         (the caller then owns a malloc'ed array).
+ */
+int unmapBinaryData(double *data) {
+    pthread_mutex_lock(&mappingsLock);
+    struct Mapping **link = &mappings;
+    while (*link != NULL && (*link)->data != data) {
+        link = &(*link)->next;
+    }
+    struct Mapping *mapping = *link;
+    if (mapping != NULL) {
+        *link = mapping->next;
+    }
+    pthread_mutex_unlock(&mappingsLock);
+
+    if (mapping == NULL) {
+        return 0;
+    }
+    munmap(mapping->base, mapping->length);
+    free(mapping);
+    return 1;
+}
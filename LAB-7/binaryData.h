@@ -0,0 +1,39 @@
+#ifndef BINARYDATA_H
+#define BINARYDATA_H
+
+#include <stdint.h>
+
+// Magic bytes at the start of every binary data file
+#define BINARY_DATA_MAGIC "BSTATDBL"
+#define BINARY_DATA_MAGIC_LENGTH 8
+#define BINARY_DATA_VERSION 1
+
+/*
+ * Layout of a binary data file (all fields little-endian):
+ *   offset  0: magic "BSTATDBL"
+ *   offset  8: uint32 format version
+ *   offset 12: uint32 reserved (0)
+ *   offset 16: uint64 number of values
+ *   offset 24: the values, packed IEEE-754 doubles
+ * The header is a multiple of 8 bytes, so the values are aligned when the file is mapped.
+ */
+struct BinaryDataHeader {
+    char magic[BINARY_DATA_MAGIC_LENGTH];
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t numValues;
+};
+
+// Function to check whether a file starts with the binary data magic
+int isBinaryDataFile(const char *filename);
+
+// Function to write values to a binary data file
+int writeBinaryDataFile(const char *filename, const double *dataArray, int numVals);
+
+// Function to map a binary data file into memory, returning a pointer to its values
+double *mapBinaryDataFile(const char *filename, int *numVals);
+
+// Function to release data returned by mapBinaryDataFile (returns 0 if data was not mapped)
+int unmapBinaryData(double *dataArray);
+
+#endif
@@ -0,0 +1,657 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "csvStats.h"
+#include "parallelStats.h"
+#include "frequencyTable.h"
+
+/*
+ * Grouped statistics over delimited files. The file is scanned once: every row is split into
+ * fields, its key is looked up in an open-addressing hash table of groups, and the numeric cells
+ * of the selected columns are appended to the accumulators of that group. Because the groups are
+ * hash-partitioned as the rows arrive, the scan stays single-pass however many groups there are,
+ * and the statistics of each group and column are computed from its accumulator afterwards.
+ */
+
+// Initial number of slots of the group hash table
+#define INITIAL_GROUP_SLOTS 64
+
+// Initial capacity of a column accumulator
+#define INITIAL_COLUMN_CAPACITY 16
+
+
+/**
+ * @brief Duplicates a string and exits with an error message on failure.
+ */
+static char *duplicateString(const char *text) {
+    char *copy = (char *)malloc(strlen(text) + 1);
+    if (copy == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    strcpy(copy, text);
+    return copy;
+}
+
+
+/**
+ * @brief Splits a line into fields in place.
+ *
+ * Fields are separated by the delimiter; a field may be enclosed in double quotes, in which case it
+ * may contain the delimiter and "" stands for one quote. The line terminator is removed.
+ *
+ * @param line Line to split; it is modified and the fields point into it.
+ * @param delimiter Field delimiter.
+ * @param fields Pointer to the array of field pointers (grown as needed).
+ * @param capacity Pointer to the capacity of the field array.
+ *
+ * @return The number of fields.
+ */
+static int splitFields(char *line, char delimiter, char ***fields, int *capacity) {
+    int numFields = 0;
+    char *read = line;
+    while (1) {
+        if (numFields == *capacity) {
+            *capacity *= 2;
+            *fields = (char **)realloc(*fields, sizeof(char *) * *capacity);
+            if (*fields == NULL) {
+                perror("Error reallocating memory");
+                exit(EXIT_FAILURE);
+            }
+        }
+
+        // Copy the field onto itself, dropping quotes; write never passes read
+        char *write = read;
+        (*fields)[numFields++] = write;
+        int quoted = 0;
+        while (*read != '\0' && *read != '\n' && *read != '\r' && (quoted || *read != delimiter)) {
+            if (*read == '"') {
+                if (quoted && read[1] == '"') {
+                    *write++ = '"';
+                    read += 2;
+                    continue;
+                }
+                quoted = !quoted;
+                read++;
+                continue;
+            }
+            *write++ = *read++;
+        }
+        char terminator = *read;
+        *write = '\0';
+        if (terminator != delimiter) {
+            return numFields;
+        }
+        read++;
+    }
+}
+
+
+/**
+ * @brief Parses a field as a number, allowing surrounding whitespace.
+ *
+ * @return 1 if the whole field is a number, 0 otherwise (including empty fields).
+ */
+static int parseNumber(const char *field, double *value) {
+    char *end;
+    *value = strtod(field, &end);
+    if (end == field) {
+        return 0;
+    }
+    while (isspace((unsigned char)*end)) {
+        end++;
+    }
+    return *end == '\0';
+}
+
+
+/**
+ * @brief Returns whether a column specification is a 1-based column number.
+ */
+static int isColumnNumber(const char *spec) {
+    if (*spec == '\0') {
+        return 0;
+    }
+    for (const char *c = spec; *c != '\0'; c++) {
+        if (!isdigit((unsigned char)*c)) {
+            return 0;
+        }
+    }
+    return atoi(spec) > 0;
+}
+
+
+/**
+ * @brief Resolves a column name or 1-based number to a 0-based field index.
+ *
+ * @param spec Column name or number.
+ * @param header Fields of the header line (NULL if the file has no header).
+ * @param numFields Number of fields of the first line.
+ *
+ * @return The field index; the program exits with an error message if the column does not exist.
+ */
+static int resolveColumn(const char *spec, char **header, int numFields) {
+    if (isColumnNumber(spec)) {
+        int index = atoi(spec) - 1;
+        if (index < numFields) {
+            return index;
+        }
+    } else if (header != NULL) {
+        for (int i = 0; i < numFields; i++) {
+            if (strcmp(header[i], spec) == 0) {
+                return i;
+            }
+        }
+    }
+    fprintf(stderr, "Error: unknown column: %s\n", spec);
+    exit(1);
+}
+
+
+/**
+ * @brief Hashes a group key with 64-bit FNV-1a.
+ */
+static uint64_t hashKey(const char *key) {
+    uint64_t hash = 0xcbf29ce484222325ULL;
+    for (const unsigned char *c = (const unsigned char *)key; *c != '\0'; c++) {
+        hash ^= *c;
+        hash *= 0x100000001b3ULL;
+    }
+    return hash;
+}
+
+
+/**
+ * @brief Finds the slot of a key in the group hash table, or the empty slot where it belongs.
+ */
+static int findGroupSlot(const struct CsvDataset *dataset, const char *key) {
+    int mask = dataset->numSlots - 1;
+    int slot = (int)(hashKey(key) & (uint64_t)mask);
+    // Linear probing; the load factor of at most one half guarantees an empty slot exists
+    while (dataset->slots[slot] != -1 && strcmp(dataset->groups[dataset->slots[slot]].key, key) != 0) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Allocates an empty group hash table with the given number of slots.
+ */
+static void allocateGroupSlots(struct CsvDataset *dataset, int numSlots) {
+    dataset->slots = (int *)malloc(sizeof(int) * numSlots);
+    if (dataset->slots == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < numSlots; i++) {
+        dataset->slots[i] = -1;
+    }
+    dataset->numSlots = numSlots;
+}
+
+
+/**
+ * @brief Returns the index of the group with a key, creating the group on its first appearance.
+ */
+static int findOrAddGroup(struct CsvDataset *dataset, const char *key) {
+    int slot = findGroupSlot(dataset, key);
+    if (dataset->slots[slot] != -1) {
+        return dataset->slots[slot];
+    }
+
+    // Keep the load factor at or below one half
+    if (2 * (dataset->numGroups + 1) > dataset->numSlots) {
+        free(dataset->slots);
+        allocateGroupSlots(dataset, dataset->numSlots * 2);
+        for (int g = 0; g < dataset->numGroups; g++) {
+            dataset->slots[findGroupSlot(dataset, dataset->groups[g].key)] = g;
+        }
+        slot = findGroupSlot(dataset, key);
+    }
+
+    if (dataset->numGroups == dataset->groupCapacity) {
+        dataset->groupCapacity *= 2;
+        dataset->groups = (struct CsvGroup *)realloc(dataset->groups, sizeof(struct CsvGroup) * dataset->groupCapacity);
+        if (dataset->groups == NULL) {
+            perror("Error reallocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+
+    struct CsvGroup *group = &dataset->groups[dataset->numGroups];
+    group->key = duplicateString(key);
+    group->columns = (struct ColumnAccumulator *)calloc(dataset->numColumns, sizeof(struct ColumnAccumulator));
+    if (group->columns == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    dataset->slots[slot] = dataset->numGroups;
+    return dataset->numGroups++;
+}
+
+
+/**
+ * @brief Appends a value to a column accumulator.
+ */
+static void appendValue(struct ColumnAccumulator *column, double value) {
+    if (column->numVals == column->capacity) {
+        column->capacity = (column->capacity == 0) ? INITIAL_COLUMN_CAPACITY : column->capacity * 2;
+        column->values = (double *)realloc(column->values, sizeof(double) * column->capacity);
+        if (column->values == NULL) {
+            perror("Error reallocating memory");
+            exit(EXIT_FAILURE);
+        }
+    }
+    column->values[column->numVals++] = value;
+}
+
+
+/**
+ * @brief Adds one row to the dataset.
+ */
+static void addRow(struct CsvDataset *dataset, char **fields, int numFields) {
+    const char *key = "";
+    if (dataset->groupIndex >= 0 && dataset->groupIndex < numFields) {
+        key = fields[dataset->groupIndex];
+    }
+    // Look the group up before taking its address: adding a group may move the group array
+    int groupIndex = findOrAddGroup(dataset, key);
+    struct CsvGroup *group = &dataset->groups[groupIndex];
+
+    for (int c = 0; c < dataset->numColumns; c++) {
+        int index = dataset->columnIndices[c];
+        double value;
+        if (index < numFields && parseNumber(fields[index], &value)) {
+            appendValue(&group->columns[c], value);
+        } else {
+            group->columns[c].numMissing++;
+        }
+    }
+    dataset->numRows++;
+}
+
+
+/**
+ * @brief Selects the numeric columns and the key column from the first line of the file.
+ *
+ * The first line is a header if a column is selected by name or if a selected column does not hold
+ * a number in it but does in the second line. A column that holds text in both lines is a text
+ * column, not evidence of a header.
+ *
+ * @param nextFields Fields of the second line, or NULL if the file has a single line.
+ * @return 1 if the first line is a header, 0 if it is a data row.
+ */
+static int selectColumns(struct CsvDataset *dataset, const struct CsvOptions *options, char **fields, int numFields,
+                         char **nextFields, int numNextFields) {
+    // Split the column list
+    int numSpecs = 0;
+    char **specs = NULL;
+    char *list = NULL;
+    if (options->columns != NULL) {
+        list = duplicateString(options->columns);
+        numSpecs = 1;
+        for (const char *c = list; *c != '\0'; c++) {
+            numSpecs += (*c == ',');
+        }
+        specs = (char **)malloc(sizeof(char *) * numSpecs);
+        if (specs == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+        int capacity = numSpecs;
+        numSpecs = splitFields(list, ',', &specs, &capacity);
+    }
+
+    int hasHeader = options->groupBy != NULL && !isColumnNumber(options->groupBy);
+    for (int s = 0; s < numSpecs; s++) {
+        hasHeader |= !isColumnNumber(specs[s]);
+    }
+
+    dataset->groupIndex =
+        (options->groupBy != NULL) ? resolveColumn(options->groupBy, hasHeader ? fields : NULL, numFields) : -1;
+    dataset->numColumns = (numSpecs > 0) ? numSpecs : numFields - (dataset->groupIndex >= 0);
+    if (dataset->numColumns == 0) {
+        fprintf(stderr, "Error: no numeric columns to report\n");
+        exit(1);
+    }
+    dataset->columnIndices = (int *)malloc(sizeof(int) * dataset->numColumns);
+    dataset->columnNames = (char **)malloc(sizeof(char *) * dataset->numColumns);
+    if (dataset->columnIndices == NULL || dataset->columnNames == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    int numSelected = 0;
+    for (int i = 0; i < ((numSpecs > 0) ? numSpecs : numFields); i++) {
+        int index = (numSpecs > 0) ? resolveColumn(specs[i], hasHeader ? fields : NULL, numFields) : i;
+        if (numSpecs == 0 && index == dataset->groupIndex) {
+            continue;
+        }
+        dataset->columnIndices[numSelected++] = index;
+    }
+
+    // Without names in the options, a cell that is not a number above one that is marks a header
+    if (!hasHeader) {
+        for (int c = 0; c < dataset->numColumns; c++) {
+            double value;
+            int index = dataset->columnIndices[c];
+            if (fields[index][0] != '\0' && !parseNumber(fields[index], &value)) {
+                hasHeader |= nextFields == NULL || (index < numNextFields && parseNumber(nextFields[index], &value));
+            }
+        }
+    }
+
+    for (int c = 0; c < dataset->numColumns; c++) {
+        char number[16];
+        snprintf(number, sizeof(number), "%d", dataset->columnIndices[c] + 1);
+        dataset->columnNames[c] = duplicateString(hasHeader ? fields[dataset->columnIndices[c]] : number);
+    }
+
+    free(specs);
+    free(list);
+    return hasHeader;
+}
+
+
+/**
+ * @brief Drops the columns in which no cell held a number, once the whole file has been read.
+ */
+static void dropColumnsWithoutNumbers(struct CsvDataset *dataset) {
+    int numKept = 0;
+    for (int c = 0; c < dataset->numColumns; c++) {
+        int numVals = 0;
+        for (int g = 0; g < dataset->numGroups; g++) {
+            numVals += dataset->groups[g].columns[c].numVals;
+        }
+        if (numVals == 0) {
+            free(dataset->columnNames[c]); // Its accumulators hold no values
+            continue;
+        }
+        dataset->columnIndices[numKept] = dataset->columnIndices[c];
+        dataset->columnNames[numKept] = dataset->columnNames[c];
+        for (int g = 0; g < dataset->numGroups; g++) {
+            dataset->groups[g].columns[numKept] = dataset->groups[g].columns[c];
+        }
+        numKept++;
+    }
+    dataset->numColumns = numKept;
+    if (numKept == 0) {
+        fprintf(stderr, "Error: no numeric columns to report\n");
+        exit(1);
+    }
+}
+
+
+/**
+ * @brief Reads the selected columns of a delimited file, grouped by the key column, in one pass.
+ *
+ * The first two lines decide which columns are read and whether the first one is a header (see
+ * selectColumns). Without a column list, the columns in which no cell is a number (text columns
+ * such as an unused key) are left out. Cells that are empty or not a number are counted as
+ * missing. The program exits with an error message if the file cannot be read or a selected column
+ * does not exist.
+ *
+ * @param filename Name of the file from which data is to be read.
+ * @param options Delimiter, selected columns and key column.
+ * @param dataset Pointer to the dataset to fill in; release it with freeCsvDataset.
+ */
+void readCsvDataset(const char *filename, const struct CsvOptions *options, struct CsvDataset *dataset) {
+    memset(dataset, 0, sizeof(*dataset));
+    dataset->groupIndex = -1;
+    dataset->groupCapacity = 16;
+    dataset->groups = (struct CsvGroup *)malloc(sizeof(struct CsvGroup) * dataset->groupCapacity);
+    if (dataset->groups == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    allocateGroupSlots(dataset, INITIAL_GROUP_SLOTS);
+
+    FILE *file = fopen(filename, "r");
+    // Check if file opened successfully
+    if (file == NULL) {
+        perror("Error opening file");
+        exit(1);
+    }
+
+    char *line = NULL;
+    size_t lineCapacity = 0;
+    int fieldCapacity = 16;
+    char **fields = (char **)malloc(sizeof(char *) * fieldCapacity);
+    if (fields == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    // The first line is kept until the second one tells whether it is a header
+    char *firstLine = NULL;
+    int firstCapacity = 16;
+    char **firstFields = (char **)malloc(sizeof(char *) * firstCapacity);
+    if (firstFields == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    int numFirstFields = 0;
+    int numLines = 0;
+    while (getline(&line, &lineCapacity, file) != -1) {
+        if (line[0] == '\n' || (line[0] == '\r' && line[1] == '\n')) {
+            continue; // Skip blank lines
+        }
+        if (numLines++ == 0) {
+            firstLine = duplicateString(line);
+            numFirstFields = splitFields(firstLine, options->delimiter, &firstFields, &firstCapacity);
+            continue;
+        }
+        int numFields = splitFields(line, options->delimiter, &fields, &fieldCapacity);
+        if (numLines == 2 && !selectColumns(dataset, options, firstFields, numFirstFields, fields, numFields)) {
+            addRow(dataset, firstFields, numFirstFields); // Not a header
+        }
+        addRow(dataset, fields, numFields);
+    }
+    if (numLines == 1 && !selectColumns(dataset, options, firstFields, numFirstFields, NULL, 0)) {
+        addRow(dataset, firstFields, numFirstFields);
+    }
+    if (numLines > 0 && options->columns == NULL) {
+        dropColumnsWithoutNumbers(dataset);
+    }
+
+    free(firstFields);
+    free(firstLine);
+    free(fields);
+    free(line);
+    fclose(file);
+}
+
+
+// Statistics of one column within one group
+struct ColumnResults {
+    struct StatsPartial partial;
+    struct AlternativeMeans means;
+    double median;
+    double *quantiles;
+    double *modes;
+    int numModes;
+};
+
+
+/**
+ * @brief Computes every statistic of one accumulator.
+ *
+ * The values are reordered by the quantile selection.
+ *
+ * @return 0 on success, -1 under POLICY_ERROR with invalid values.
+ */
+static int computeColumnResults(struct ColumnAccumulator *column, enum InvalidValuePolicy policy,
+                                const double *probabilities, int numProbabilities, struct ColumnResults *results) {
+    computeStatsPartial(column->values, column->numVals, STAT_ALL, &results->partial);
+    int status = finalizeAlternativeMeans(&results->partial.meanTerms, policy, &results->means);
+
+    results->quantiles = (double *)malloc(sizeof(double) * (numProbabilities + 1));
+    if (results->quantiles == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    results->modes = NULL;
+    results->numModes = 0;
+    if (column->numVals == 0) {
+        return status;
+    }
+
+    struct FrequencyTable table;
+    initFrequencyTable(&table, 16);
+    for (int i = 0; i < column->numVals; i++) {
+        addToFrequencyTable(&table, column->values[i], 1);
+    }
+    results->modes = modesFromFrequencyTables(&table, 1, &results->numModes);
+    freeFrequencyTable(&table);
+
+    // The median is one more quantile after the requested ones
+    double *allProbabilities = (double *)malloc(sizeof(double) * (numProbabilities + 1));
+    if (allProbabilities == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    if (numProbabilities > 0) {
+        memcpy(allProbabilities, probabilities, sizeof(double) * numProbabilities);
+    }
+    allProbabilities[numProbabilities] = 0.5;
+    calculateQuantiles(column->values, column->numVals, allProbabilities, numProbabilities + 1, results->quantiles);
+    results->median = results->quantiles[numProbabilities];
+    free(allProbabilities);
+    return status;
+}
+
+
+/**
+ * @brief Prints a geometric or harmonic mean cell of the statistics table.
+ */
+static void printMeanCell(int defined, double mean) {
+    if (defined) {
+        printf(" %12.3f", mean);
+    } else {
+        printf(" %12s", "undefined");
+    }
+}
+
+
+/**
+ * @brief Computes and prints the statistics of every column in every group.
+ *
+ * One row is printed per group and column, in order of first appearance of the groups. Each row holds
+ * the count, missing cells, mean, median, standard deviation, geometric and harmonic means, the
+ * requested percentiles and the modes.
+ *
+ * @param dataset Pointer to the dataset (its values are reordered).
+ * @param policy How values the geometric and harmonic means are undefined for are treated.
+ * @param probabilities Requested percentiles as probabilities.
+ * @param numProbabilities Number of requested percentiles.
+ *
+ * @return 0 on success, -1 if the policy is POLICY_ERROR and invalid values were seen (nothing is printed then).
+ */
+int printCsvStatistics(const struct CsvDataset *dataset, enum InvalidValuePolicy policy,
+                       const double *probabilities, int numProbabilities) {
+    int numResults = dataset->numGroups * dataset->numColumns;
+    struct ColumnResults *results =
+        (struct ColumnResults *)malloc(sizeof(struct ColumnResults) * (numResults > 0 ? numResults : 1));
+    if (results == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    int status = 0;
+    for (int g = 0; g < dataset->numGroups; g++) {
+        for (int c = 0; c < dataset->numColumns; c++) {
+            struct ColumnResults *result = &results[g * dataset->numColumns + c];
+            if (computeColumnResults(&dataset->groups[g].columns[c], policy, probabilities, numProbabilities,
+                                     result) != 0) {
+                if (status == 0) {
+                    fprintf(stderr, "Error: invalid values for the geometric/harmonic mean in column %s%s%s: "
+                            "%d non-positive, %d zero, %d NaN\n", dataset->columnNames[c],
+                            dataset->groupIndex >= 0 ? " of group " : "",
+                            dataset->groupIndex >= 0 ? dataset->groups[g].key : "",
+                            result->means.numNonPositive, result->means.numZeros, result->means.numNaN);
+                }
+                status = -1;
+            }
+        }
+    }
+
+    if (status == 0) {
+        printf("Rows: %d, groups: %d, columns: %d\n", dataset->numRows, dataset->numGroups, dataset->numColumns);
+        if (dataset->groupIndex >= 0) {
+            printf("%-16s ", "group");
+        }
+        printf("%-16s %10s %8s %12s %12s %12s %12s %12s", "column", "count", "missing", "mean", "median",
+               "stddev", "geometric", "harmonic");
+        for (int p = 0; p < numProbabilities; p++) {
+            char label[32];
+            snprintf(label, sizeof(label), "p%g", probabilities[p] * 100.0);
+            printf(" %12s", label);
+        }
+        printf("  mode(s)\n");
+
+        for (int g = 0; g < dataset->numGroups; g++) {
+            for (int c = 0; c < dataset->numColumns; c++) {
+                const struct ColumnAccumulator *column = &dataset->groups[g].columns[c];
+                const struct ColumnResults *result = &results[g * dataset->numColumns + c];
+                if (dataset->groupIndex >= 0) {
+                    printf("%-16s ", dataset->groups[g].key);
+                }
+                printf("%-16s %10d %8d", dataset->columnNames[c], column->numVals, column->numMissing);
+                if (column->numVals == 0) {
+                    printf(" %12s\n", "n/a");
+                    continue;
+                }
+                printf(" %12.3f %12.3f %12.3f", result->partial.mean, result->median,
+                       sqrt(result->partial.m2 / column->numVals));
+                printMeanCell(result->means.geometricDefined, result->means.geometricMean);
+                printMeanCell(result->means.harmonicDefined, result->means.harmonicMean);
+                for (int p = 0; p < numProbabilities; p++) {
+                    printf(" %12.3f", result->quantiles[p]);
+                }
+                printf(" ");
+                if (result->numModes == 0) {
+                    printf(" -");
+                }
+                for (int m = 0; m < result->numModes; m++) {
+                    printf("%s%g", (m == 0) ? " " : ",", result->modes[m]);
+                }
+                printf("\n");
+            }
+        }
+    }
+
+    for (int r = 0; r < numResults; r++) {
+        free(results[r].quantiles);
+        free(results[r].modes);
+    }
+    free(results);
+    return status;
+}
+
+
+/**
+ * @brief Releases the memory held by a dataset.
+ *
+ * @param dataset Pointer to the dataset.
+ */
+void freeCsvDataset(struct CsvDataset *dataset) {
+    for (int g = 0; g < dataset->numGroups; g++) {
+        for (int c = 0; c < dataset->numColumns; c++) {
+            free(dataset->groups[g].columns[c].values);
+        }
+        free(dataset->groups[g].columns);
+        free(dataset->groups[g].key);
+    }
+    for (int c = 0; c < dataset->numColumns; c++) {
+        free(dataset->columnNames[c]);
+    }
+    free(dataset->groups);
+    free(dataset->slots);
+    free(dataset->columnNames);
+    free(dataset->columnIndices);
+    memset(dataset, 0, sizeof(*dataset));
+}
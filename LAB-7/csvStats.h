@@ -0,0 +1,51 @@
+#ifndef CSVSTATS_H
+#define CSVSTATS_H
+
+#include "statsFunctions.h"
+
+// How a delimited file is split into groups and columns
+struct CsvOptions {
+    char delimiter;         // Field delimiter, ',' by default
+    const char *columns;    // Comma-separated column names or 1-based numbers (NULL = all numeric but the key column)
+    const char *groupBy;    // Name or 1-based number of the key column (NULL = one group)
+};
+
+// Values of one numeric column within one group
+struct ColumnAccumulator {
+    double *values;
+    int numVals;
+    int capacity;
+    int numMissing;         // Rows whose cell was empty or not a number
+};
+
+// One distinct key of the group-by column with an accumulator per selected column
+struct CsvGroup {
+    char *key;
+    struct ColumnAccumulator *columns;
+};
+
+// Grouped columns of a delimited file, collected in one scan
+struct CsvDataset {
+    int numColumns;         // Number of selected numeric columns
+    char **columnNames;     // Header name (or column number) of each selected column
+    int *columnIndices;     // 0-based field index of each selected column
+    int groupIndex;         // 0-based field index of the key column, -1 if not grouped
+    int numRows;
+    struct CsvGroup *groups; // Groups in order of first appearance
+    int numGroups;
+    int groupCapacity;
+    int *slots;             // Open-addressing hash table of group indices (-1 = empty)
+    int numSlots;           // Number of slots (always a power of two)
+};
+
+// Function to read the selected columns of a delimited file, grouped by the key column, in one pass
+void readCsvDataset(const char *filename, const struct CsvOptions *options, struct CsvDataset *dataset);
+
+// Function to compute and print all statistics per group and column; returns -1 under POLICY_ERROR with invalid values
+int printCsvStatistics(const struct CsvDataset *dataset, enum InvalidValuePolicy policy,
+                       const double *probabilities, int numProbabilities);
+
+// Function to release the memory held by a dataset
+void freeCsvDataset(struct CsvDataset *dataset);
+
+#endif
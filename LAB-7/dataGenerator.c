@@ -0,0 +1,149 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "dataGenerator.h"
+
+static const char *distributionNames[DIST_COUNT] = {
+    "uniform", "normal", "duplicates", "sorted", "reverse-sorted"
+};
+
+
+/**
+ * @brief Returns the next number of a xorshift64* generator.
+ *
+ * The C library rand() is too slow for 10^8 values and has only 31 bits on most platforms.
+ */
+static uint64_t nextRandom(uint64_t *state) {
+    uint64_t x = *state;
+    x ^= x >> 12;
+    x ^= x << 25;
+    x ^= x >> 27;
+    *state = x;
+    return x * 0x2545f4914f6cdd1dULL;
+}
+
+
+/**
+ * @brief Returns a uniformly distributed double in [0, 1).
+ */
+static double nextUniform(uint64_t *state) {
+    return (nextRandom(state) >> 11) * 0x1p-53;
+}
+
+
+/**
+ * @brief Returns the name of a distribution.
+ *
+ * @param distribution The distribution.
+ *
+ * @return Name such as "uniform" or "reverse-sorted".
+ */
+const char *distributionName(enum Distribution distribution) {
+    return distributionNames[distribution];
+}
+
+
+/**
+ * @brief Parses a distribution name.
+ *
+ * @param name Name of the distribution (see distributionName).
+ * @param distribution Pointer to the variable that receives the distribution.
+ *
+ * @return 0 on success, -1 if the name is unknown.
+ */
+int parseDistribution(const char *name, enum Distribution *distribution) {
+    for (int d = 0; d < DIST_COUNT; d++) {
+        if (strcmp(name, distributionNames[d]) == 0) {
+            *distribution = (enum Distribution)d;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+
+/**
+ * @brief Generates a synthetic dataset.
+ *
+ * Normal values use the Box-Muller transform. Sorted data is generated directly as a random walk
+ * with positive steps, so no sort is needed even for 10^8 values.
+ *
+ * @param distribution Shape of the dataset.
+ * @param numVals Number of values to generate.
+ * @param seed Seed of the random number generator (0 is replaced by a fixed constant).
+ *
+ * @return Pointer to the dynamically allocated array (the program exits on allocation failure).
+ */
+double *generateData(enum Distribution distribution, int numVals, uint64_t seed) {
+    double *data = (double *)malloc(sizeof(double) * (numVals > 0 ? numVals : 1));
+    if (data == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    uint64_t state = (seed != 0) ? seed : 0x9e3779b97f4a7c15ULL;
+
+    switch (distribution) {
+        case DIST_UNIFORM:
+            for (int i = 0; i < numVals; i++) {
+                data[i] = 1000.0 * nextUniform(&state);
+            }
+            break;
+        case DIST_NORMAL:
+            for (int i = 0; i < numVals; i += 2) {
+                // 1 - u keeps the logarithm finite
+                double radius = sqrt(-2.0 * log(1.0 - nextUniform(&state)));
+                double angle = 2.0 * M_PI * nextUniform(&state);
+                data[i] = 500.0 + 100.0 * radius * cos(angle);
+                if (i + 1 < numVals) {
+                    data[i + 1] = 500.0 + 100.0 * radius * sin(angle);
+                }
+            }
+            break;
+        case DIST_DUPLICATES:
+            for (int i = 0; i < numVals; i++) {
+                data[i] = (double)(1 + nextRandom(&state) % DUPLICATE_DISTINCT_VALUES);
+            }
+            break;
+        case DIST_SORTED:
+        case DIST_REVERSE_SORTED: {
+            double value = 0.0;
+            for (int i = 0; i < numVals; i++) {
+                value += nextUniform(&state);
+                int index = (distribution == DIST_SORTED) ? i : numVals - 1 - i;
+                data[index] = value;
+            }
+            break;
+        }
+        default:
+            break;
+    }
+    return data;
+}
+
+
+/**
+ * @brief Writes a dataset as a text data file with one value per line.
+ *
+ * @param filename Name of the file to write.
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ *
+ * @return 0 on success, -1 if the file cannot be written.
+ */
+int writeTextDataFile(const char *filename, const double *data, int numVals) {
+    FILE *file = fopen(filename, "w");
+    if (file == NULL) {
+        perror("Error opening file");
+        return -1;
+    }
+    for (int i = 0; i < numVals; i++) {
+        fprintf(file, "%.17g\n", data[i]);
+    }
+    if (fclose(file) != 0) {
+        perror("Error writing file");
+        return -1;
+    }
+    return 0;
+}
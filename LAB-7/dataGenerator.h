@@ -0,0 +1,31 @@
+#ifndef DATAGENERATOR_H
+#define DATAGENERATOR_H
+
+#include <stdint.h>
+
+// Shapes of synthetic datasets
+enum Distribution {
+    DIST_UNIFORM,           // Uniform in [0, 1000)
+    DIST_NORMAL,            // Normal with mean 500 and standard deviation 100
+    DIST_DUPLICATES,        // Only DUPLICATE_DISTINCT_VALUES distinct integers
+    DIST_SORTED,            // Ascending random walk with positive steps
+    DIST_REVERSE_SORTED,    // The same walk in descending order
+    DIST_COUNT
+};
+
+// Number of distinct values of the heavy-duplicate distribution
+#define DUPLICATE_DISTINCT_VALUES 100
+
+// Function to get the name of a distribution as accepted by parseDistribution
+const char *distributionName(enum Distribution distribution);
+
+// Function to parse a distribution name, returns -1 if unknown
+int parseDistribution(const char *name, enum Distribution *distribution);
+
+// Function to generate a dataset of the given distribution (same seed gives the same data)
+double *generateData(enum Distribution distribution, int numVals, uint64_t seed);
+
+// Function to write a dataset as a text data file readable by basicstats, returns -1 on failure
+int writeTextDataFile(const char *filename, const double *dataArray, int numVals);
+
+#endif
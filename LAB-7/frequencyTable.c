@@ -0,0 +1,334 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "frequencyTable.h"
+
+// Smallest number of slots a table is created with
+#define MIN_TABLE_CAPACITY 16
+
+
+/**
+ * @brief Hashes a floating-point value.
+ *
+ * The bit pattern of the value is mixed with the splitmix64 finalizer. 0.0 and -0.0
+ * compare equal, so -0.0 is hashed as 0.0.
+ *
+ * @param value Value to hash.
+ *
+ * @return 64-bit hash of the value.
+ */
+uint64_t hashValue(double value) {
+    if (value == 0.0) {
+        value = 0.0; // Fold -0.0 onto 0.0
+    }
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits ^= bits >> 30;
+    bits *= 0xbf58476d1ce4e5b9ULL;
+    bits ^= bits >> 27;
+    bits *= 0x94d049bb133111ebULL;
+    bits ^= bits >> 31;
+    return bits;
+}
+
+
+/**
+ * @brief Allocates the slot arrays of a table.
+ *
+ * @param table Pointer to the table.
+ * @param capacity Number of slots (must be a power of two).
+ */
+static void allocateSlots(struct FrequencyTable *table, int capacity) {
+    table->values = (double *)malloc(sizeof(double) * capacity);
+    table->counts = (int *)calloc(capacity, sizeof(int));
+    if (table->values == NULL || table->counts == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    table->capacity = capacity;
+    table->size = 0;
+}
+
+
+/**
+ * @brief Initializes an empty frequency table.
+ *
+ * The table is sized so that expectedSize distinct values fit without growing.
+ *
+ * @param table Pointer to the table to initialize.
+ * @param expectedSize Expected number of distinct values.
+ */
+void initFrequencyTable(struct FrequencyTable *table, int expectedSize) {
+    int capacity = MIN_TABLE_CAPACITY;
+    // Keep the load factor at or below one half
+    while (capacity / 2 < expectedSize) {
+        capacity *= 2;
+    }
+    allocateSlots(table, capacity);
+    table->numNaN = 0;
+}
+
+
+/**
+ * @brief Finds the slot of a value, or the empty slot where it would be inserted.
+ *
+ * @param table Pointer to the table.
+ * @param value Value to look for.
+ *
+ * @return Index of the slot.
+ */
+static int findSlot(const struct FrequencyTable *table, double value) {
+    int mask = table->capacity - 1;
+    int slot = (int)(hashValue(value) & (uint64_t)mask);
+    // Linear probing; the load factor guarantees an empty slot exists
+    while (table->counts[slot] != 0 && table->values[slot] != value) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Doubles the number of slots of a table and reinserts all values.
+ *
+ * @param table Pointer to the table.
+ */
+static void growFrequencyTable(struct FrequencyTable *table) {
+    struct FrequencyTable old = *table;
+    allocateSlots(table, old.capacity * 2);
+    for (int i = 0; i < old.capacity; i++) {
+        if (old.counts[i] != 0) {
+            int slot = findSlot(table, old.values[i]);
+            table->values[slot] = old.values[i];
+            table->counts[slot] = old.counts[i];
+            table->size++;
+        }
+    }
+    freeFrequencyTable(&old);
+}
+
+
+/**
+ * @brief Adds occurrences of a value to a frequency table.
+ *
+ * NaN values are only counted, since a NaN never compares equal to any value (including itself).
+ *
+ * @param table Pointer to the table.
+ * @param value Value that occurred.
+ * @param count Number of occurrences to add.
+ *
+ * @return The number of occurrences of the value after the addition (0 for NaN).
+ */
+int addToFrequencyTable(struct FrequencyTable *table, double value, int count) {
+    if (isnan(value)) {
+        table->numNaN += (count > 0) ? count : 0;
+        return 0;
+    }
+    if (count <= 0) {
+        return lookupFrequency(table, value);
+    }
+    int slot = findSlot(table, value);
+    if (table->counts[slot] == 0) {
+        if (2 * (table->size + 1) > table->capacity) {
+            growFrequencyTable(table);
+            slot = findSlot(table, value);
+        }
+        table->values[slot] = value;
+        table->size++;
+    }
+    table->counts[slot] += count;
+    return table->counts[slot];
+}
+
+
+/**
+ * @brief Removes occurrences of a value from a frequency table.
+ *
+ * When the count of a value drops to zero its slot is freed by shifting the following entries of
+ * the probe sequence back, so lookups stay correct without tombstones.
+ *
+ * @param table Pointer to the table.
+ * @param value Value to remove.
+ * @param count Number of occurrences to remove (at most the current count).
+ *
+ * @return The number of occurrences of the value after the removal.
+ */
+int removeFromFrequencyTable(struct FrequencyTable *table, double value, int count) {
+    if (isnan(value)) {
+        table->numNaN -= (count < table->numNaN) ? count : table->numNaN;
+        return 0;
+    }
+    int slot = findSlot(table, value);
+    if (table->counts[slot] == 0) {
+        return 0;
+    }
+    table->counts[slot] -= count;
+    if (table->counts[slot] > 0) {
+        return table->counts[slot];
+    }
+
+    // Backward-shift deletion: move later entries of the cluster into the hole if their home slot allows it
+    int mask = table->capacity - 1;
+    int hole = slot;
+    int next = slot;
+    table->counts[hole] = 0;
+    table->size--;
+    while (1) {
+        next = (next + 1) & mask;
+        if (table->counts[next] == 0) {
+            break;
+        }
+        int home = (int)(hashValue(table->values[next]) & (uint64_t)mask);
+        // The entry may move if its home slot is not cyclically in (hole, next]
+        int movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            table->values[hole] = table->values[next];
+            table->counts[hole] = table->counts[next];
+            table->counts[next] = 0;
+            hole = next;
+        }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Returns how many times a value occurs in a frequency table.
+ *
+ * @param table Pointer to the table.
+ * @param value Value to look up.
+ *
+ * @return The number of occurrences, or 0 if the value is not in the table.
+ */
+int lookupFrequency(const struct FrequencyTable *table, double value) {
+    if (isnan(value)) {
+        return 0;
+    }
+    return table->counts[findSlot(table, value)];
+}
+
+
+/**
+ * @brief Adds all counts of one frequency table to another.
+ *
+ * @param into Pointer to the table that receives the counts.
+ * @param from Pointer to the table whose counts are added.
+ */
+void mergeFrequencyTables(struct FrequencyTable *into, const struct FrequencyTable *from) {
+    into->numNaN += from->numNaN;
+    for (int i = 0; i < from->capacity; i++) {
+        if (from->counts[i] != 0) {
+            addToFrequencyTable(into, from->values[i], from->counts[i]);
+        }
+    }
+}
+
+
+/**
+ * @brief Compares two doubles for qsort in ascending order.
+ */
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief Computes the mode(s) from one or more frequency tables.
+ *
+ * The tables must hold disjoint sets of values (for example, the partitions of a hash-partitioned
+ * count). The same rules as calculateMode apply: if every distinct value occurs equally often, or
+ * there are no values, no mode is returned. A NaN has a frequency of 0 there, since it equals
+ * nothing, so NaN values next to equally frequent values leave those values as the modes. The modes
+ * are returned in ascending order.
+ *
+ * @param tables Array of frequency tables.
+ * @param numTables Number of tables in the array.
+ * @param numModes Pointer to an integer variable to store the number of modes found.
+ *
+ * @return Pointer to the dynamically allocated array of modes if mode(s) exist, NULL otherwise.
+ */
+double *modesFromFrequencyTables(const struct FrequencyTable *tables, int numTables, int *numModes) {
+    int maxCount = 0;
+    int minCount = 0;
+    int numNaN = 0;
+    for (int t = 0; t < numTables; t++) {
+        numNaN += tables[t].numNaN;
+        for (int i = 0; i < tables[t].capacity; i++) {
+            int count = tables[t].counts[i];
+            if (count == 0) {
+                continue;
+            }
+            if (count > maxCount) {
+                maxCount = count;
+            }
+            if (minCount == 0 || count < minCount) {
+                minCount = count;
+            }
+        }
+    }
+
+    // No values, or all values (and no NaN, with frequency 0) occur equally often
+    if (maxCount == 0 || (minCount == maxCount && numNaN == 0)) {
+        *numModes = 0;
+        return NULL;
+    }
+
+    int numModesCount = 0;
+    for (int t = 0; t < numTables; t++) {
+        for (int i = 0; i < tables[t].capacity; i++) {
+            if (tables[t].counts[i] == maxCount) {
+                numModesCount++;
+            }
+        }
+    }
+
+    double *modes = (double *)malloc(numModesCount * sizeof(double));
+    if (modes == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    int modeIndex = 0;
+    for (int t = 0; t < numTables; t++) {
+        for (int i = 0; i < tables[t].capacity; i++) {
+            if (tables[t].counts[i] == maxCount) {
+                modes[modeIndex++] = tables[t].values[i];
+            }
+        }
+    }
+    qsort(modes, numModesCount, sizeof(double), compareDoubles);
+
+    *numModes = numModesCount;
+    return modes;
+}
+
+
+/**
+ * @brief Removes all values from a frequency table, keeping its slots for reuse.
+ *
+ * @param table Pointer to the table.
+ */
+void clearFrequencyTable(struct FrequencyTable *table) {
+    memset(table->counts, 0, sizeof(int) * table->capacity);
+    table->size = 0;
+    table->numNaN = 0;
+}
+
+
+/**
+ * @brief Releases the memory held by a frequency table.
+ *
+ * @param table Pointer to the table.
+ */
+void freeFrequencyTable(struct FrequencyTable *table) {
+    free(table->values);
+    free(table->counts);
+    table->values = NULL;
+    table->counts = NULL;
+    table->capacity = 0;
+    table->size = 0;
+}
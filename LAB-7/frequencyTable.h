@@ -0,0 +1,42 @@
+#ifndef FREQUENCYTABLE_H
+#define FREQUENCYTABLE_H
+
+#include <stdint.h>
+
+// Open-addressing hash table that counts how often each value occurs
+struct FrequencyTable {
+    double *values;   // Distinct values (slot is empty when its count is 0)
+    int *counts;      // Number of occurrences of each value
+    int capacity;     // Number of slots (always a power of two)
+    int size;         // Number of distinct values stored
+    int numNaN;       // Number of NaN values added (they equal nothing, so they are not stored)
+};
+
+// Function to hash a value (equal values, including 0.0 and -0.0, hash the same)
+uint64_t hashValue(double value);
+
+// Function to initialize an empty table sized for the expected number of distinct values
+void initFrequencyTable(struct FrequencyTable *table, int expectedSize);
+
+// Function to add count occurrences of a value to the table; returns the new count of the value
+int addToFrequencyTable(struct FrequencyTable *table, double value, int count);
+
+// Function to remove count occurrences of a value from the table; returns the new count of the value
+int removeFromFrequencyTable(struct FrequencyTable *table, double value, int count);
+
+// Function to get the number of occurrences of a value (0 if absent)
+int lookupFrequency(const struct FrequencyTable *table, double value);
+
+// Function to add all counts of one table to another
+void mergeFrequencyTables(struct FrequencyTable *into, const struct FrequencyTable *from);
+
+// Function to calculate the mode(s) over one or more tables holding disjoint sets of values
+double *modesFromFrequencyTables(const struct FrequencyTable *tables, int numTables, int *numModes);
+
+// Function to remove all values from a table, keeping its memory for reuse
+void clearFrequencyTable(struct FrequencyTable *table);
+
+// Function to release the memory held by a table
+void freeFrequencyTable(struct FrequencyTable *table);
+
+#endif
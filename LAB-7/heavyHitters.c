@@ -0,0 +1,328 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "heavyHitters.h"
+#include "frequencyTable.h"
+
+/*
+ * Space-Saving heavy-hitters sketch (Metwally et al.). k counters track k values. A value that is
+ * already tracked increments its counter; an untracked value takes over the counter with the
+ * smallest count c, which becomes c + 1 with an error of c. Every estimate is an upper bound of
+ * the true count and exceeds it by at most its error, and a value that is not tracked occurs at
+ * most as often as the smallest counter (which is at most n / k). The counters form a min-heap by
+ * count and a hash table maps values to counters, so an update takes O(1) expected time plus a heap
+ * sift, and memory is O(k) regardless of the number of distinct values.
+ */
+
+
+/**
+ * @brief Initializes a heavy-hitters sketch.
+ *
+ * @param sketch Pointer to the sketch to initialize.
+ * @param k Number of counters (must be positive).
+ * @param binWidth If positive, values are quantized to the lower edge of their bin of this width.
+ */
+void initHeavyHitters(struct HeavyHitters *sketch, int k, double binWidth) {
+    sketch->capacity = k;
+    sketch->size = 0;
+    sketch->binWidth = binWidth;
+    sketch->numValues = 0;
+    sketch->numSlots = 16;
+    // Keep the load factor at or below one half
+    while (sketch->numSlots / 2 < k) {
+        sketch->numSlots *= 2;
+    }
+    sketch->counters = (struct HeavyHitter *)malloc(sizeof(struct HeavyHitter) * k);
+    sketch->slotOfCounter = (int *)malloc(sizeof(int) * k);
+    sketch->slots = (int *)malloc(sizeof(int) * sketch->numSlots);
+    if (sketch->counters == NULL || sketch->slotOfCounter == NULL || sketch->slots == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int i = 0; i < sketch->numSlots; i++) {
+        sketch->slots[i] = -1;
+    }
+}
+
+
+/**
+ * @brief Finds the hash table slot of a value, or the empty slot where it belongs.
+ */
+static int findSlot(const struct HeavyHitters *sketch, double value) {
+    int mask = sketch->numSlots - 1;
+    int slot = (int)(hashValue(value) & (uint64_t)mask);
+    while (sketch->slots[slot] != -1 && sketch->counters[sketch->slots[slot]].value != value) {
+        slot = (slot + 1) & mask;
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Points a hash table slot at a counter.
+ */
+static void linkSlot(struct HeavyHitters *sketch, int slot, int counter) {
+    sketch->slots[slot] = counter;
+    sketch->slotOfCounter[counter] = slot;
+}
+
+
+/**
+ * @brief Removes the value of a counter from the hash table with backward-shift deletion.
+ */
+static void unlinkCounter(struct HeavyHitters *sketch, int counter) {
+    int mask = sketch->numSlots - 1;
+    int hole = sketch->slotOfCounter[counter];
+    int next = hole;
+    sketch->slots[hole] = -1;
+    while (1) {
+        next = (next + 1) & mask;
+        if (sketch->slots[next] == -1) {
+            break;
+        }
+        int home = (int)(hashValue(sketch->counters[sketch->slots[next]].value) & (uint64_t)mask);
+        // The entry may move if its home slot is not cyclically in (hole, next]
+        int movable = (hole <= next) ? (home <= hole || home > next) : (home <= hole && home > next);
+        if (movable) {
+            linkSlot(sketch, hole, sketch->slots[next]);
+            sketch->slots[next] = -1;
+            hole = next;
+        }
+    }
+}
+
+
+/**
+ * @brief Swaps two counters of the heap and keeps the hash table pointing at them.
+ */
+static void swapCounters(struct HeavyHitters *sketch, int a, int b) {
+    struct HeavyHitter temp = sketch->counters[a];
+    sketch->counters[a] = sketch->counters[b];
+    sketch->counters[b] = temp;
+    int slotA = sketch->slotOfCounter[a];
+    int slotB = sketch->slotOfCounter[b];
+    linkSlot(sketch, slotB, a);
+    linkSlot(sketch, slotA, b);
+}
+
+
+/**
+ * @brief Moves a counter whose count grew down the min-heap.
+ */
+static void siftDown(struct HeavyHitters *sketch, int index) {
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= sketch->size) {
+            return;
+        }
+        if (child + 1 < sketch->size && sketch->counters[child + 1].count < sketch->counters[child].count) {
+            child++;
+        }
+        if (sketch->counters[child].count >= sketch->counters[index].count) {
+            return;
+        }
+        swapCounters(sketch, index, child);
+        index = child;
+    }
+}
+
+
+/**
+ * @brief Moves a new counter up the min-heap.
+ */
+static void siftUp(struct HeavyHitters *sketch, int index) {
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (sketch->counters[parent].count <= sketch->counters[index].count) {
+            return;
+        }
+        swapCounters(sketch, index, parent);
+        index = parent;
+    }
+}
+
+
+/**
+ * @brief Adds one value to a sketch.
+ *
+ * NaN values are ignored, since a NaN never compares equal to any value.
+ *
+ * @param sketch Pointer to the sketch.
+ * @param value Value to add.
+ */
+void addToHeavyHitters(struct HeavyHitters *sketch, double value) {
+    if (isnan(value)) {
+        return;
+    }
+    if (sketch->binWidth > 0.0) {
+        value = floor(value / sketch->binWidth) * sketch->binWidth;
+    }
+    sketch->numValues++;
+
+    int slot = findSlot(sketch, value);
+    if (sketch->slots[slot] != -1) {
+        int counter = sketch->slots[slot];
+        sketch->counters[counter].count++;
+        siftDown(sketch, counter);
+        return;
+    }
+
+    if (sketch->size < sketch->capacity) {
+        // A free counter: the count is exact
+        int counter = sketch->size++;
+        sketch->counters[counter].value = value;
+        sketch->counters[counter].count = 1;
+        sketch->counters[counter].error = 0;
+        linkSlot(sketch, slot, counter);
+        siftUp(sketch, counter);
+        return;
+    }
+
+    // Take over the counter with the smallest count
+    unlinkCounter(sketch, 0);
+    struct HeavyHitter *minimum = &sketch->counters[0];
+    minimum->value = value;
+    minimum->error = minimum->count;
+    minimum->count++;
+    linkSlot(sketch, findSlot(sketch, value), 0);
+    siftDown(sketch, 0);
+}
+
+
+/**
+ * @brief Adds an array of values to a sketch.
+ *
+ * @param sketch Pointer to the sketch.
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ */
+void addArrayToHeavyHitters(struct HeavyHitters *sketch, const double *data, int numVals) {
+    for (int i = 0; i < numVals; i++) {
+        addToHeavyHitters(sketch, data[i]);
+    }
+}
+
+
+/**
+ * @brief Orders counters by descending count, then ascending value.
+ */
+static int compareHeavyHitters(const void *a, const void *b) {
+    const struct HeavyHitter *x = (const struct HeavyHitter *)a;
+    const struct HeavyHitter *y = (const struct HeavyHitter *)b;
+    if (x->count != y->count) {
+        return (x->count < y->count) - (x->count > y->count);
+    }
+    return (x->value > y->value) - (x->value < y->value);
+}
+
+
+/**
+ * @brief Copies the tracked counters of a sketch, most frequent first.
+ *
+ * @param sketch Pointer to the sketch.
+ * @param top Array of at least sketch->capacity counters that receives the copies.
+ *
+ * @return The number of tracked counters.
+ */
+int topHeavyHitters(const struct HeavyHitters *sketch, struct HeavyHitter *top) {
+    memcpy(top, sketch->counters, sizeof(struct HeavyHitter) * sketch->size);
+    qsort(top, sketch->size, sizeof(struct HeavyHitter), compareHeavyHitters);
+    return sketch->size;
+}
+
+
+/**
+ * @brief Formats a tracked value, or its bin if the values are quantized.
+ */
+static void formatTrackedValue(const struct HeavyHitters *sketch, double value, char *label, size_t size) {
+    if (sketch->binWidth > 0.0) {
+        snprintf(label, size, "[%.3f, %.3f)", value, value + sketch->binWidth);
+    } else {
+        snprintf(label, size, "%.3f", value);
+    }
+}
+
+
+/**
+ * @brief Prints the tracked values of a sketch with their error bounds and the approximate mode(s).
+ *
+ * Each tracked value is listed with its estimated count and the range its true count lies in. The
+ * mode(s) are the values with the largest estimate; they are reported as guaranteed when their lower
+ * bound is at least the upper bound of every other value, tracked or not. As for calculateMode, there
+ * is no mode when the counts are exact and all equal.
+ *
+ * @param sketch Pointer to the sketch.
+ */
+void printHeavyHitters(const struct HeavyHitters *sketch) {
+    struct HeavyHitter *top = (struct HeavyHitter *)malloc(sizeof(struct HeavyHitter) * sketch->capacity);
+    if (top == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    int size = topHeavyHitters(sketch, top);
+
+    int isExact = 1;
+    for (int i = 0; i < size; i++) {
+        isExact &= (top[i].error == 0);
+    }
+    // Any value that is not tracked occurs at most as often as the smallest counter
+    int untrackedBound = (isExact || size == 0) ? 0 : sketch->counters[0].count;
+
+    printf("Approximate mode (Space-Saving, %d counters", sketch->capacity);
+    if (sketch->binWidth > 0.0) {
+        printf(", bin width %g", sketch->binWidth);
+    }
+    printf("):\n");
+    printf("  %4s  %-28s %10s   %s\n", "rank", "value", "estimate", "true count");
+    for (int i = 0; i < size; i++) {
+        char label[64];
+        formatTrackedValue(sketch, top[i].value, label, sizeof(label));
+        printf("  %4d  %-28s %10d   [%d, %d]\n", i + 1, label, top[i].count, top[i].count - top[i].error, top[i].count);
+    }
+
+    int numModes = 0;
+    while (numModes < size && top[numModes].count == top[0].count) {
+        numModes++;
+    }
+    if (size == 0 || (isExact && numModes == size)) {
+        printf(" mode: No Mode Found\n");
+    } else {
+        int lowerBound = top[0].count;
+        for (int i = 0; i < numModes; i++) {
+            lowerBound = (top[i].count - top[i].error < lowerBound) ? top[i].count - top[i].error : lowerBound;
+        }
+        int otherBound = (numModes < size) ? top[numModes].count : 0;
+        otherBound = (untrackedBound > otherBound) ? untrackedBound : otherBound;
+
+        printf(" mode(s):");
+        for (int i = 0; i < numModes; i++) {
+            char label[64];
+            formatTrackedValue(sketch, top[i].value, label, sizeof(label));
+            printf(" %s,", label);
+        }
+        printf(" (%s)\n", (lowerBound >= otherBound) ? "guaranteed" : "not guaranteed");
+    }
+    if (untrackedBound > 0) {
+        printf(" Values not listed occur at most %d times.\n", untrackedBound);
+    }
+
+    free(top);
+}
+
+
+/**
+ * @brief Releases the memory held by a sketch.
+ *
+ * @param sketch Pointer to the sketch.
+ */
+void freeHeavyHitters(struct HeavyHitters *sketch) {
+    free(sketch->counters);
+    free(sketch->slotOfCounter);
+    free(sketch->slots);
+    sketch->counters = NULL;
+    sketch->slotOfCounter = NULL;
+    sketch->slots = NULL;
+    sketch->size = 0;
+}
@@ -0,0 +1,41 @@
+#ifndef HEAVYHITTERS_H
+#define HEAVYHITTERS_H
+
+// Counter of one tracked value of a heavy-hitters sketch
+struct HeavyHitter {
+    double value;       // Value (or lower edge of its bin)
+    int count;          // Estimated number of occurrences, never below the true number
+    int error;          // Largest possible overestimate: the true count is at least count - error
+};
+
+// Space-Saving sketch that tracks the (approximately) k most frequent values of a stream
+struct HeavyHitters {
+    int capacity;                   // Number of counters k
+    int size;                       // Number of counters in use
+    double binWidth;                // Values are quantized to multiples of this (0 = exact values)
+    int numValues;                  // Number of values added
+    struct HeavyHitter *counters;   // Min-heap of the counters by count
+    int *slotOfCounter;             // Hash table slot of each counter
+    int *slots;                     // Open-addressing hash table of counter indices (-1 = empty)
+    int numSlots;                   // Number of slots (always a power of two)
+};
+
+// Function to initialize a sketch with k counters, quantizing values to bins of binWidth (0 = exact)
+void initHeavyHitters(struct HeavyHitters *sketch, int k, double binWidth);
+
+// Function to add one value to a sketch
+void addToHeavyHitters(struct HeavyHitters *sketch, double value);
+
+// Function to add an array of values to a sketch
+void addArrayToHeavyHitters(struct HeavyHitters *sketch, const double *dataArray, int numVals);
+
+// Function to copy the tracked counters, most frequent first; returns their number
+int topHeavyHitters(const struct HeavyHitters *sketch, struct HeavyHitter *top);
+
+// Function to print the tracked values with their error bounds and the approximate mode(s)
+void printHeavyHitters(const struct HeavyHitters *sketch);
+
+// Function to release the memory held by a sketch
+void freeHeavyHitters(struct HeavyHitters *sketch);
+
+#endif
@@ -1,7 +1,86 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <getopt.h>
 #include "statsFunctions.h"
 #include "readFile.h"
+#include "parallelStats.h"
+#include "typedStats.h"
+#include "rollingStats.h"
+#include "csvStats.h"
+#include "batchStats.h"
+#include "statsPlan.h"
+#include "resultsFormat.h"
+#include "profiler.h"
+
+/**
+ * @brief Prints the command-line usage of the program.
+ *
+ * @param programName Name the program was invoked with.
+ */
+static void printUsage(const char *programName) {
+    printf("Usage: %s [-j N] [--stats LIST] [--plan] [--format FORMAT] [--profile] [--invalid POLICY]\n"
+           "       [--percentiles[=LIST]] [--histogram BINS] [--float32] [--load STRATEGY] [--memory]\n"
+           "       [--window W] [--approx-mode K [--bin-width W]]\n"
+           "       [--csv] [--columns LIST] [--group-by COLUMN] [--delimiter CHAR] <input_file>\n", programName);
+    printf("       %s [-j N] [--invalid POLICY] [--percentiles[=LIST]] [--merge] [--file-list FILE]\n"
+           "       <input_file|directory>...\n", programName);
+    printf("  -j, --jobs N             compute the statistics with N threads (0 = all cores)\n");
+    printf("  -s, --stats LIST         statistics to compute: mean,stddev,median,mode,geometric,harmonic (default all)\n");
+    printf("      --plan               print the passes over the data planned for the selected statistics\n");
+    printf("  -o, --format FORMAT      print the results as text (default), json or csv, with the time of every stage\n");
+    printf("      --profile            print wall time, CPU time and hardware counters (if available) per stage\n");
+    printf("  -i, --invalid POLICY     how the geometric/harmonic means treat values they are undefined for:\n");
+    printf("                           reject (mean is undefined, default), skip (leave them out), error (fail)\n");
+    printf("  -p, --percentiles[=LIST] report percentiles, e.g. 50,90,99,99.9 (the default list)\n");
+    printf("  -H, --histogram BINS     print a histogram with BINS equal-width bins\n");
+    printf("  -f, --float32            store non-integer text data as float32 (half the memory, ~7 digits)\n");
+    printf("  -l, --load STRATEGY      size the data array by counting values first (presized, default) or by doubling\n");
+    printf("  -M, --memory             print the peak resident set size of the process\n");
+    printf("  -w, --window W           print rolling statistics over the last W values after every value\n");
+    printf("  -k, --approx-mode K      estimate the mode with a K-counter heavy-hitters sketch (O(K) memory)\n");
+    printf("  -b, --bin-width W        quantize values to bins of width W for --approx-mode\n");
+    printf("      --csv                read a delimited file and report statistics per column\n");
+    printf("  -c, --columns LIST       numeric columns to report, by header name or 1-based number (implies --csv)\n");
+    printf("  -g, --group-by COLUMN    report every column per distinct key of COLUMN (implies --csv)\n");
+    printf("  -d, --delimiter CHAR     field delimiter of the delimited file, ',' by default (implies --csv)\n");
+    printf("  -F, --file-list FILE     also process the files listed in FILE, one path per line (- = stdin)\n");
+    printf("      --merge              with several files, add a row merged from all of them\n");
+    printf("With several files, a directory or a file list, one row is printed per file and -j sets the\n");
+    printf("number of files processed at the same time (all cores by default).\n");
+}
+
+/**
+ * @brief Feeds a dataset value by value into rolling statistics and prints a row after every value.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param window Number of values in the window.
+ */
+static void printRollingStatistics(const double *data, int numVals, int window) {
+    struct RollingStats stats;
+    initRollingStats(&stats, window);
+
+    printf("%10s %15s %15s %15s  %s\n", "index", "mean", "stddev", "median", "mode(s)");
+    for (int i = 0; i < numVals; i++) {
+        addRollingValue(&stats, data[i]);
+        printf("%10d %15.3f %15.3f %15.3f ", i, rollingMean(&stats), rollingStandardDeviation(&stats),
+               rollingMedian(&stats));
+
+        int numModes;
+        double *modes = rollingModes(&stats, &numModes);
+        if (modes == NULL) {
+            printf(" -");
+        }
+        for (int m = 0; m < numModes; m++) {
+            printf(" %g", modes[m]);
+        }
+        printf("\n");
+        free(modes);
+    }
+
+    freeRollingStats(&stats);
+}
 
 /**
  * @brief Reads data from a file and stores it in a dynamically allocated array.
@@ -19,44 +98,398 @@
  *   - NULL if an error occurs during file opening or memory allocation.
  */
 int main(int argc, char *argv[]) {
+    static const struct option longOptions[] = {
+        {"jobs", required_argument, NULL, 'j'},
+        {"stats", required_argument, NULL, 's'},
+        {"plan", no_argument, NULL, 'P'},
+        {"format", required_argument, NULL, 'o'},
+        {"profile", no_argument, NULL, 'R'},
+        {"invalid", required_argument, NULL, 'i'},
+        {"percentiles", optional_argument, NULL, 'p'},
+        {"histogram", required_argument, NULL, 'H'},
+        {"float32", no_argument, NULL, 'f'},
+        {"load", required_argument, NULL, 'l'},
+        {"memory", no_argument, NULL, 'M'},
+        {"window", required_argument, NULL, 'w'},
+        {"approx-mode", required_argument, NULL, 'k'},
+        {"bin-width", required_argument, NULL, 'b'},
+        {"csv", no_argument, NULL, 'C'},
+        {"columns", required_argument, NULL, 'c'},
+        {"group-by", required_argument, NULL, 'g'},
+        {"delimiter", required_argument, NULL, 'd'},
+        {"file-list", required_argument, NULL, 'F'},
+        {"merge", no_argument, NULL, 'm'},
+        {NULL, 0, NULL, 0}
+    };
+
+    int numThreads = -1; // -1 selects the serial computation
+    unsigned int statistics = STAT_ALL;
+    int selectStatistics = 0; // --stats was given
+    int printPlan = 0;
+    enum OutputFormat format = FORMAT_TEXT;
+    int profile = 0;
+    enum InvalidValuePolicy policy = POLICY_REJECT;
+    double *percentiles = NULL; // Requested percentiles as probabilities
+    int numPercentiles = 0;
+    int numBins = 0; // 0 means no histogram
+    int allowFloat32 = 0;
+    enum LoadStrategy loadStrategy = LOAD_PRESIZED;
+    int reportMemory = 0;
+    int window = 0; // 0 means statistics over the whole dataset
+    int approxCounters = 0; // 0 means exact modes
+    double binWidth = 0.0;
+    int isCsv = 0;
+    struct CsvOptions csvOptions = {',', NULL, NULL};
+    const char *fileList = NULL;
+    int merge = 0;
+    int option;
+    while ((option = getopt_long(argc, argv, "j:s:o:i:p::H:fl:Mw:k:b:c:g:d:F:", longOptions, NULL)) != -1) {
+        switch (option) {
+            case 'j':
+                numThreads = atoi(optarg);
+                if (numThreads < 0) {
+                    printf("Invalid number of threads: %s\n", optarg);
+                    return 1;
+                }
+                if (numThreads == 0) {
+                    numThreads = getNumCores();
+                }
+                break;
+            case 's':
+                if (parseStatisticList(optarg, &statistics) != 0) {
+                    printf("Invalid statistic list: %s (expected mean, stddev, median, mode, geometric, harmonic or all)\n", optarg);
+                    return 1;
+                }
+                selectStatistics = 1;
+                break;
+            case 'P':
+                printPlan = 1;
+                break;
+            case 'o':
+                if (parseOutputFormat(optarg, &format) != 0) {
+                    printf("Invalid output format: %s (expected text, json or csv)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'R':
+                profile = 1;
+                break;
+            case 'i':
+                if (parseInvalidValuePolicy(optarg, &policy) != 0) {
+                    printf("Invalid policy: %s (expected reject, skip or error)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'p':
+                free(percentiles);
+                percentiles = parsePercentiles(optarg != NULL ? optarg : DEFAULT_PERCENTILES, &numPercentiles);
+                if (percentiles == NULL) {
+                    printf("Invalid percentile list: %s (expected values between 0 and 100)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'H':
+                numBins = atoi(optarg);
+                if (numBins <= 0) {
+                    printf("Invalid number of histogram bins: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'f':
+                allowFloat32 = 1;
+                break;
+            case 'l':
+                if (strcmp(optarg, "presized") == 0) {
+                    loadStrategy = LOAD_PRESIZED;
+                } else if (strcmp(optarg, "doubling") == 0) {
+                    loadStrategy = LOAD_DOUBLING;
+                } else {
+                    printf("Invalid load strategy: %s (expected presized or doubling)\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'M':
+                reportMemory = 1;
+                break;
+            case 'w':
+                window = atoi(optarg);
+                if (window <= 0) {
+                    printf("Invalid window size: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'k':
+                approxCounters = atoi(optarg);
+                if (approxCounters <= 0) {
+                    printf("Invalid number of counters: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'b':
+                binWidth = atof(optarg);
+                if (!(binWidth > 0.0)) {
+                    printf("Invalid bin width: %s\n", optarg);
+                    return 1;
+                }
+                break;
+            case 'C':
+                isCsv = 1;
+                break;
+            case 'c':
+                csvOptions.columns = optarg;
+                isCsv = 1;
+                break;
+            case 'g':
+                csvOptions.groupBy = optarg;
+                isCsv = 1;
+                break;
+            case 'd':
+                if (optarg[0] == '\0' || (optarg[1] != '\0' && strcmp(optarg, "\\t") != 0)) {
+                    printf("Invalid delimiter: %s (expected one character or \\t)\n", optarg);
+                    return 1;
+                }
+                csvOptions.delimiter = (optarg[1] == '\0') ? optarg[0] : '\t';
+                isCsv = 1;
+                break;
+            case 'F':
+                fileList = optarg;
+                break;
+            case 'm':
+                merge = 1;
+                break;
+            default:
+                printUsage(argv[0]);
+                return 1; // Error code for incorrect usage
+        }
+    }
+
+    if (profile) {
+        // The table is printed when the program exits; keep machine-readable output parseable
+        enableProfiling((format == FORMAT_TEXT) ? stdout : stderr);
+    }
+
+    // Several files, a directory or a file list select the per-file statistics
+    int numArguments = argc - optind;
+    if (numArguments > 1 || fileList != NULL || (numArguments == 1 && isDirectory(argv[optind]))) {
+        if (window > 0 || isCsv || numBins > 0 || approxCounters > 0 || allowFloat32 || format != FORMAT_TEXT ||
+            selectStatistics || printPlan) {
+            printf("--window, --csv, --histogram, --approx-mode, --float32, --format, --stats and --plan take a single input file\n");
+            free(percentiles);
+            return 1;
+        }
+        int numFiles;
+        char **files = collectInputFiles(argv + optind, numArguments, fileList, &numFiles);
+        struct BatchOptions batchOptions;
+        batchOptions.numThreads = (numThreads > 0) ? numThreads : getNumCores();
+        batchOptions.merge = merge;
+        batchOptions.policy = policy;
+        batchOptions.probabilities = percentiles;
+        batchOptions.numProbabilities = numPercentiles;
+        profileBegin("batch");
+        int batchStatus = runBatchStatistics(files, numFiles, &batchOptions);
+        profileEnd();
+        if (reportMemory) {
+            printf("Peak RSS: %ld KB\n", getPeakRssKilobytes());
+        }
+        freeInputFiles(files, numFiles);
+        free(percentiles);
+        return batchStatus;
+    }
+
     // Check if the correct number of arguments are provided
-    if (argc != 2) {
-        printf("Missing arguments: %s <input_file>\n", argv[0]);
+    if (numArguments != 1) {
+        printUsage(argv[0]);
         return 1; // Error code for incorrect usage
     }
 
+    // The per-column statistics are always computed in full, and the parallel engine has no pass plan
+    if (isCsv && (selectStatistics || printPlan || format != FORMAT_TEXT)) {
+        printf("--stats, --plan and --format cannot be combined with --csv\n");
+        free(percentiles);
+        return 1;
+    }
+    // The rolling statistics are a fixed set, computed serially value by value
+    if (window > 0 && (numThreads > 0 || selectStatistics || printPlan || format != FORMAT_TEXT)) {
+        printf("-j, --stats, --plan and --format cannot be combined with --window\n");
+        free(percentiles);
+        return 1;
+    }
+    if (numThreads > 0 && printPlan) {
+        printf("--plan cannot be combined with -j (the parallel engine does not use the planner)\n");
+        free(percentiles);
+        return 1;
+    }
+
     // Get the filename from the command line argument
-    const char *filename = argv[1];
+    const char *filename = argv[optind];
 
-    // Declare variables for storing data
-    int numVals, cap, num_modes;
+    if (isCsv) {
+        // Grouped statistics of the selected columns, collected in one scan of the file
+        struct CsvDataset dataset;
+        profileBegin("read csv");
+        readCsvDataset(filename, &csvOptions, &dataset);
+        profileEnd();
+        profileBegin("csv statistics");
+        int csvStatus = printCsvStatistics(&dataset, policy, percentiles, numPercentiles);
+        profileEnd();
+        freeCsvDataset(&dataset);
+        free(percentiles);
+        return (csvStatus == 0) ? 0 : 1;
+    }
 
-    // Read data from file into an array
-    double *data = readDataFromFile(filename, &numVals, &cap);
+    // Read data from file; integer files keep their integer type
+    double parseStart = monotonicSeconds();
+    profileBegin("parse");
+    struct TypedData typed;
+    readTypedDataFromFile(filename, allowFloat32, loadStrategy, &typed);
+    int numVals = typed.numVals;
+    int cap = typed.capacity;
+    enum DataType inputType = typed.type; // Converting the values to doubles changes typed.type
 
     // Check if any data was read
     if (numVals == 0) {
         printf("No data in the input file.\n");
-        free(data);
+        releaseTypedData(&typed);
+        free(percentiles);
         return 1; // Error code for no data
     }
 
-    // Calculate various statistical measures
-    double mean = calculateMean(data, numVals); // Calculate mean
-    double median = calculateMedian(data, numVals); // Calculate median
-    double stddev = calculateStandardDeviation(data, numVals, mean); // Calculate standard deviation
-    double geometricMean = calculateGeometricMean(data, numVals); // Calculate geometric mean
-    double harmonicMean = calculateHarmonicMean(data, numVals); // Calculate harmonic mean
+    if (window > 0) {
+        // Replay the file as a stream through the rolling statistics
+        profileEnd();
+        profileBegin("rolling");
+        printRollingStatistics(typedDataToDoubles(&typed), numVals, window);
+        profileEnd();
+        releaseTypedData(&typed);
+        free(percentiles);
+        return 0;
+    }
+
+    // The specialized kernels run the serial plans; the parallel engine, the histogram and the sketch work on doubles
+    int useTypedPath = typed.type != DATA_DOUBLE && numThreads <= 0 && numBins == 0 && approxCounters == 0;
+    double *data = useTypedPath ? NULL : typedDataToDoubles(&typed);
+    profileEnd();
+    double parseSeconds = monotonicSeconds() - parseStart;
+
+    // The median is computed as one more quantile, placed after the requested percentiles
+    double *probabilities = (double *)malloc(sizeof(double) * (numPercentiles + 1));
+    double *quantiles = (double *)malloc(sizeof(double) * (numPercentiles + 1));
+    if (probabilities == NULL || quantiles == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    for (int i = 0; i < numPercentiles; i++) {
+        probabilities[i] = percentiles[i];
+    }
+    probabilities[numPercentiles] = 0.5;
+
+    struct StatsResults results = {0};
+    results.statistics = statistics;
+    results.numVals = numVals;
+    results.capacity = cap;
+    results.probabilities = probabilities;
+    results.quantiles = quantiles;
+    results.numQuantiles = numPercentiles;
+    results.dataType = (inputType != DATA_DOUBLE) ? dataTypeName(inputType) : NULL;
+    results.timings.parse = parseSeconds;
+    results.peakRssKilobytes = -1;
+    int status;
+
+    // The histogram and the heavy-hitters sketch only need the values, not their order
+    double computeStart = monotonicSeconds();
+    if (numBins > 0) {
+        profileBegin("histogram");
+        buildHistogram(data, numVals, numBins, &results.histogram);
+        profileEnd();
+        results.timings.histogram = monotonicSeconds() - computeStart;
+    }
+    struct HeavyHitters sketch;
+    if (approxCounters > 0) {
+        double sketchStart = monotonicSeconds();
+        profileBegin("heavy hitters");
+        initHeavyHitters(&sketch, approxCounters, binWidth);
+        addArrayToHeavyHitters(&sketch, data, numVals);
+        profileEnd();
+        results.heavyHitters = &sketch;
+        results.timings.mode = monotonicSeconds() - sketchStart;
+    }
 
-    // Calculate modes
-    double *modes = calculateMode(data, numVals, &num_modes); // Calculate modes
+    if (useTypedPath) {
+        // Compute the selected statistics directly on the float32 or integer values
+        struct StatsPlan plan;
+        planStatistics(statistics, numPercentiles, 1, &plan);
+        if (printPlan) {
+            // Keep machine-readable output parseable
+            printTypedStatsPlan(&plan, &typed, (format == FORMAT_TEXT) ? stdout : stderr);
+        }
+        profileBegin("typed statistics");
+        status = calculateTypedStatistics(&typed, &plan, policy, probabilities, &results);
+        profileEnd();
+    } else if (numThreads > 0) {
+        // Compute the selected statistics with the parallel engine; modes are estimated by the sketch if one is used
+        struct ParallelResults parallel;
+        unsigned int parallelStatistics = (approxCounters > 0) ? (statistics & ~STAT_MODE) : statistics;
+        profileBegin("parallel statistics");
+        calculateStatisticsParallel(data, numVals, numThreads, parallelStatistics, &parallel);
+        profileEnd();
+        results.mean = parallel.mean;
+        results.median = parallel.median;
+        results.stddev = parallel.stddev;
+        results.modes = parallel.modes;
+        results.numModes = parallel.numModes;
+        status = (statistics & (STAT_GEOMETRIC | STAT_HARMONIC))
+                     ? finalizeAlternativeMeans(&parallel.meanTerms, policy, &results.means)
+                     : 0;
+        if (numPercentiles > 0) {
+            profileBegin("median/percentiles");
+            calculateQuantiles(data, numVals, probabilities, numPercentiles, quantiles);
+            profileEnd();
+        }
+    } else {
+        // Calculate the selected statistical measures with only the passes they need; modes are
+        // estimated by the sketch if one is used
+        struct StatsPlan plan;
+        planStatistics(statistics, numPercentiles, approxCounters == 0, &plan);
+        if (printPlan) {
+            // Keep machine-readable output parseable
+            printStatsPlan(&plan, (format == FORMAT_TEXT) ? stdout : stderr);
+        }
+        double sketchSeconds = results.timings.mode;
+        status = executeStatsPlan(&plan, data, numVals, policy, &results);
+        results.timings.mode += sketchSeconds;
+    }
+    results.timings.compute = monotonicSeconds() - computeStart;
 
-    // Print results
-    printResults(numVals, cap, mean, median, stddev, modes, num_modes, geometricMean, harmonicMean); // Print results
+    if (status == 0) {
+        // Print results
+        if (reportMemory) {
+            results.peakRssKilobytes = getPeakRssKilobytes();
+        }
+        profileBegin("print");
+        printResultsInFormat(&results, format); // Print results
+        profileEnd();
+    } else {
+        // Invalid values are fatal under the error policy
+        fprintf(stderr, "Error: invalid values for the geometric/harmonic mean: %d non-positive, %d zero, %d NaN\n",
+                results.means.numNonPositive, results.means.numZeros, results.means.numNaN);
+    }
 
     // Free allocated memory
-    free(data); // Free memory allocated for data array
-    free(modes); // Free memory allocated for modes array
+    if (useTypedPath) {
+        releaseTypedData(&typed);
+    } else {
+        releaseData(data); // Free (or unmap) the data array
+    }
+    free(results.modes); // Free memory allocated for modes array
+    free(probabilities);
+    free(quantiles);
+    free(percentiles);
+    if (numBins > 0) {
+        freeHistogram(&results.histogram);
+    }
+    if (approxCounters > 0) {
+        freeHeavyHitters(&sketch);
+    }
 
-    return 0; // Return success
+    return (status == 0) ? 0 : 1; // Return success, or the error of the invalid value policy
 }
@@ -0,0 +1,468 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include "parallelStats.h"
+#include "frequencyTable.h"
+#include "reductionKernels.h"
+
+// Number of bits of the sort key resolved by each pass of the parallel selection
+#define SELECT_DIGIT_BITS 16
+#define SELECT_BUCKETS (1 << SELECT_DIGIT_BITS)
+
+// Largest number of distinct values a local frequency table is sized for up front
+#define INITIAL_PARTITION_SIZE (1 << 16)
+
+
+/**
+ * @brief Returns the number of online CPU cores.
+ *
+ * @return Number of cores, at least 1.
+ */
+int getNumCores(void) {
+    long cores = sysconf(_SC_NPROCESSORS_ONLN);
+    return (cores > 0) ? (int)cores : 1;
+}
+
+
+/**
+ * @brief Runs a worker function on several threads and waits for all of them.
+ *
+ * Thread 0 runs on the calling thread; the others are created with pthread_create.
+ *
+ * @param numThreads Number of threads.
+ * @param worker Worker function.
+ * @param args Array of numThreads worker arguments, each argSize bytes long.
+ * @param argSize Size of one worker argument.
+ */
+void runThreads(int numThreads, void *(*worker)(void *), void *args, size_t argSize) {
+    pthread_t *threads = (pthread_t *)malloc(sizeof(pthread_t) * numThreads);
+    if (threads == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    for (int t = 1; t < numThreads; t++) {
+        if (pthread_create(&threads[t], NULL, worker, (char *)args + t * argSize) != 0) {
+            perror("Error creating thread");
+            exit(EXIT_FAILURE);
+        }
+    }
+    worker(args);
+    for (int t = 1; t < numThreads; t++) {
+        pthread_join(threads[t], NULL);
+    }
+
+    free(threads);
+}
+
+
+/**
+ * @brief Returns the first index of the block of data handled by one thread.
+ */
+static int blockStart(int numVals, int numThreads, int thread) {
+    return (int)((long long)numVals * thread / numThreads);
+}
+
+
+/**
+ * @brief Computes the partial aggregates of one block of data.
+ *
+ * The mean and the sum of squared deviations are computed with two passes over the block
+ * using the reduction kernels, and the geometric and harmonic mean terms with one more,
+ * so the partial is as accurate as the serial computation. The squared deviations and the
+ * mean terms are only computed if their statistics are selected (the mean always is).
+ *
+ * @param data Pointer to the block of floating-point values.
+ * @param numVals Number of values in the block.
+ * @param statistics STAT_* flags of the selected statistics.
+ * @param partial Pointer to the partial to fill in.
+ */
+void computeStatsPartial(const double *data, int numVals, unsigned int statistics, struct StatsPartial *partial) {
+    const struct ReductionKernels *kernels = selectReductionKernels();
+    memset(partial, 0, sizeof(*partial));
+    if (numVals == 0) {
+        return;
+    }
+
+    partial->count = numVals;
+    partial->mean = kernels->sum(data, numVals) / numVals;
+    if (statistics & STAT_STDDEV) {
+        partial->m2 = kernels->sumSquaredDeviations(data, numVals, partial->mean);
+    }
+    if (statistics & (STAT_GEOMETRIC | STAT_HARMONIC)) {
+        accumulateMeanTerms(data, numVals, statistics & (STAT_GEOMETRIC | STAT_HARMONIC), &partial->meanTerms);
+    }
+}
+
+
+/**
+ * @brief Merges the partial aggregates of another block into a partial.
+ *
+ * The means and sums of squared deviations are combined with Chan's parallel variance formula:
+ * with delta = mean_b - mean_a and n = n_a + n_b,
+ *   mean = mean_a + delta * n_b / n
+ *   M2   = M2_a + M2_b + delta^2 * n_a * n_b / n
+ *
+ * @param into Pointer to the partial that receives the merged aggregates.
+ * @param from Pointer to the partial of the other block.
+ */
+void mergeStatsPartials(struct StatsPartial *into, const struct StatsPartial *from) {
+    if (from->count == 0) {
+        return;
+    }
+    if (into->count == 0) {
+        *into = *from;
+        return;
+    }
+
+    double countA = into->count;
+    double countB = from->count;
+    double count = countA + countB;
+    double delta = from->mean - into->mean;
+
+    into->mean += delta * countB / count;
+    into->m2 += from->m2 + delta * delta * countA * countB / count;
+    into->count += from->count;
+    mergeMeanTerms(&into->meanTerms, &from->meanTerms);
+}
+
+
+/**
+ * @brief Maps a double to an unsigned key with the same ordering.
+ *
+ * Positive values get their sign bit set; negative values have all bits flipped, so that
+ * comparing keys as unsigned integers orders them like the original values.
+ */
+static uint64_t doubleToKey(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x8000000000000000ULL) ? ~bits : (bits | 0x8000000000000000ULL);
+}
+
+
+/**
+ * @brief Inverse of doubleToKey.
+ */
+static double keyToDouble(uint64_t key) {
+    uint64_t bits = (key & 0x8000000000000000ULL) ? (key & ~0x8000000000000000ULL) : ~key;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+// Work of one thread in one pass of the parallel selection
+struct SelectTask {
+    const double *data;
+    int begin;
+    int end;
+    uint64_t prefix;        // Key bits resolved so far
+    uint64_t prefixMask;    // Mask of the resolved key bits
+    int shift;              // Position of the digit counted in this pass
+    unsigned int *histogram;
+};
+
+
+/**
+ * @brief Counts the digits of the keys that match the resolved prefix in one block.
+ */
+static void *selectHistogramWorker(void *arg) {
+    struct SelectTask *task = (struct SelectTask *)arg;
+    memset(task->histogram, 0, sizeof(unsigned int) * SELECT_BUCKETS);
+    for (int i = task->begin; i < task->end; i++) {
+        uint64_t key = doubleToKey(task->data[i]);
+        if ((key & task->prefixMask) == task->prefix) {
+            task->histogram[(key >> task->shift) & (SELECT_BUCKETS - 1)]++;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Finds the value of a given rank in sorted order, using several threads.
+ *
+ * This is a most-significant-digit radix selection over order-preserving 64-bit keys. Each pass
+ * resolves 16 more bits of the key: every thread builds a histogram of the next digit over its
+ * block (counting only keys that match the digits resolved so far), the histograms are summed, and
+ * the bucket that contains the requested rank fixes the next digit. Four passes find the exact
+ * value without sorting or modifying the data.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param rank 0-based rank of the requested value (0 is the smallest).
+ * @param numThreads Number of threads to use.
+ *
+ * @return The value that would be at data[rank] if the array were sorted.
+ */
+double parallelSelect(const double *data, int numVals, int rank, int numThreads) {
+    struct SelectTask *tasks = (struct SelectTask *)malloc(sizeof(struct SelectTask) * numThreads);
+    unsigned int *histograms = (unsigned int *)malloc(sizeof(unsigned int) * SELECT_BUCKETS * numThreads);
+    if (tasks == NULL || histograms == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    uint64_t prefix = 0;
+    uint64_t prefixMask = 0;
+    for (int shift = 64 - SELECT_DIGIT_BITS; shift >= 0; shift -= SELECT_DIGIT_BITS) {
+        for (int t = 0; t < numThreads; t++) {
+            tasks[t].data = data;
+            tasks[t].begin = blockStart(numVals, numThreads, t);
+            tasks[t].end = blockStart(numVals, numThreads, t + 1);
+            tasks[t].prefix = prefix;
+            tasks[t].prefixMask = prefixMask;
+            tasks[t].shift = shift;
+            tasks[t].histogram = histograms + (size_t)t * SELECT_BUCKETS;
+        }
+        runThreads(numThreads, selectHistogramWorker, tasks, sizeof(struct SelectTask));
+
+        // Find the bucket that contains the requested rank
+        uint64_t digit = 0;
+        for (; digit < SELECT_BUCKETS; digit++) {
+            unsigned int bucketCount = 0;
+            for (int t = 0; t < numThreads; t++) {
+                bucketCount += histograms[(size_t)t * SELECT_BUCKETS + digit];
+            }
+            if ((unsigned int)rank < bucketCount) {
+                break;
+            }
+            rank -= bucketCount;
+        }
+
+        prefix |= digit << shift;
+        prefixMask |= (uint64_t)(SELECT_BUCKETS - 1) << shift;
+    }
+
+    free(tasks);
+    free(histograms);
+    return keyToDouble(prefix);
+}
+
+
+// Work of one thread when looking for the value following a selected value
+struct SuccessorTask {
+    const double *data;
+    int begin;
+    int end;
+    uint64_t key;           // Key of the selected value
+    int numAtMost;          // Number of keys <= key in the block
+    uint64_t successor;     // Smallest key > key in the block (UINT64_MAX if none)
+};
+
+
+/**
+ * @brief Counts the keys not greater than the selected key and finds the next larger key in one block.
+ */
+static void *successorWorker(void *arg) {
+    struct SuccessorTask *task = (struct SuccessorTask *)arg;
+    task->numAtMost = 0;
+    task->successor = UINT64_MAX;
+    for (int i = task->begin; i < task->end; i++) {
+        uint64_t key = doubleToKey(task->data[i]);
+        if (key <= task->key) {
+            task->numAtMost++;
+        } else if (key < task->successor) {
+            task->successor = key;
+        }
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Computes the median of the data using parallel selection.
+ *
+ * For an odd number of values the middle value is selected directly. For an even number, the
+ * lower middle value is selected and one more parallel pass finds the upper middle value: it is
+ * the same value if enough copies of it exist, otherwise the next larger value.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param numThreads Number of threads to use.
+ *
+ * @return The median of the data.
+ */
+static double calculateMedianParallel(const double *data, int numVals, int numThreads) {
+    double lower = parallelSelect(data, numVals, (numVals - 1) / 2, numThreads);
+    if (numVals % 2 != 0) {
+        return lower;
+    }
+
+    struct SuccessorTask *tasks = (struct SuccessorTask *)malloc(sizeof(struct SuccessorTask) * numThreads);
+    if (tasks == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int t = 0; t < numThreads; t++) {
+        tasks[t].data = data;
+        tasks[t].begin = blockStart(numVals, numThreads, t);
+        tasks[t].end = blockStart(numVals, numThreads, t + 1);
+        tasks[t].key = doubleToKey(lower);
+    }
+    runThreads(numThreads, successorWorker, tasks, sizeof(struct SuccessorTask));
+
+    int numAtMost = 0;
+    uint64_t successor = UINT64_MAX;
+    for (int t = 0; t < numThreads; t++) {
+        numAtMost += tasks[t].numAtMost;
+        if (tasks[t].successor < successor) {
+            successor = tasks[t].successor;
+        }
+    }
+    free(tasks);
+
+    double upper = (numAtMost > numVals / 2) ? lower : keyToDouble(successor);
+    return (lower + upper) / 2.0;
+}
+
+
+// Work of one thread when computing the partial aggregates and frequency tables
+struct PartialTask {
+    const double *data;
+    int begin;
+    int end;
+    int numPartitions;
+    unsigned int statistics;
+    struct StatsPartial partial;
+    struct FrequencyTable *tables;  // One local table per hash partition
+};
+
+
+/**
+ * @brief Computes the partial aggregates and the hash-partitioned frequency tables of one block.
+ */
+static void *partialWorker(void *arg) {
+    struct PartialTask *task = (struct PartialTask *)arg;
+    int numVals = task->end - task->begin;
+
+    computeStatsPartial(task->data + task->begin, numVals, task->statistics, &task->partial);
+    if (!(task->statistics & STAT_MODE)) {
+        return NULL;
+    }
+
+    // Tables start small and grow, so heavily duplicated data does not pay for unused slots
+    int expectedSize = numVals / task->numPartitions;
+    if (expectedSize > INITIAL_PARTITION_SIZE) {
+        expectedSize = INITIAL_PARTITION_SIZE;
+    }
+    for (int p = 0; p < task->numPartitions; p++) {
+        initFrequencyTable(&task->tables[p], expectedSize);
+    }
+    for (int i = task->begin; i < task->end; i++) {
+        double value = task->data[i];
+        int partition = (int)((hashValue(value) >> 32) % (uint64_t)task->numPartitions);
+        addToFrequencyTable(&task->tables[partition], value, 1);
+    }
+    return NULL;
+}
+
+
+// Work of one thread when merging the local frequency tables of one hash partition
+struct MergeTask {
+    struct FrequencyTable *tables;  // All local tables, numThreads rows of numPartitions
+    int numThreads;
+    int numPartitions;
+    int partition;
+};
+
+
+/**
+ * @brief Merges the local frequency tables of one hash partition into the table of thread 0.
+ */
+static void *mergeWorker(void *arg) {
+    struct MergeTask *task = (struct MergeTask *)arg;
+    struct FrequencyTable *into = &task->tables[task->partition];
+    for (int t = 1; t < task->numThreads; t++) {
+        struct FrequencyTable *from = &task->tables[t * task->numPartitions + task->partition];
+        mergeFrequencyTables(into, from);
+        freeFrequencyTable(from);
+    }
+    return NULL;
+}
+
+
+/**
+ * @brief Computes every statistic of a dataset using several threads.
+ *
+ * The data is split into one block per thread. Each thread computes the partial aggregates of its
+ * block (sum, M2, log-sum, reciprocal-sum, invalid value counts) and counts its values into local
+ * frequency tables, one per hash partition. The partials are merged with Chan's formula; the
+ * frequency tables are merged in parallel, one thread per hash partition, so no two threads touch
+ * the same table. The median is found with parallel radix selection. The frequency tables, the
+ * median, the squared deviations and the mean terms are only computed for the selected statistics.
+ * The data array is not modified.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array (must be positive).
+ * @param numThreads Number of threads to use.
+ * @param statistics STAT_* flags of the selected statistics.
+ * @param results Pointer to the structure that receives the statistics.
+ */
+void calculateStatisticsParallel(const double *data, int numVals, int numThreads, unsigned int statistics,
+                                 struct ParallelResults *results) {
+    if (numThreads < 1) {
+        numThreads = 1;
+    }
+    if (numThreads > numVals) {
+        numThreads = numVals;
+    }
+
+    int numPartitions = numThreads;
+    struct PartialTask *tasks = (struct PartialTask *)malloc(sizeof(struct PartialTask) * numThreads);
+    struct FrequencyTable *tables = (struct FrequencyTable *)malloc(sizeof(struct FrequencyTable) * numThreads * numPartitions);
+    struct MergeTask *mergeTasks = (struct MergeTask *)malloc(sizeof(struct MergeTask) * numPartitions);
+    if (tasks == NULL || tables == NULL || mergeTasks == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    // Phase 1: partial aggregates and local frequency tables
+    for (int t = 0; t < numThreads; t++) {
+        tasks[t].data = data;
+        tasks[t].begin = blockStart(numVals, numThreads, t);
+        tasks[t].end = blockStart(numVals, numThreads, t + 1);
+        tasks[t].numPartitions = numPartitions;
+        tasks[t].statistics = statistics;
+        tasks[t].tables = &tables[t * numPartitions];
+    }
+    runThreads(numThreads, partialWorker, tasks, sizeof(struct PartialTask));
+
+    struct StatsPartial total = tasks[0].partial;
+    for (int t = 1; t < numThreads; t++) {
+        mergeStatsPartials(&total, &tasks[t].partial);
+    }
+
+    // Phase 2: merge the frequency tables, one thread per hash partition
+    results->modes = NULL;
+    results->numModes = 0;
+    if (statistics & STAT_MODE) {
+        for (int p = 0; p < numPartitions; p++) {
+            mergeTasks[p].tables = tables;
+            mergeTasks[p].numThreads = numThreads;
+            mergeTasks[p].numPartitions = numPartitions;
+            mergeTasks[p].partition = p;
+        }
+        runThreads(numPartitions, mergeWorker, mergeTasks, sizeof(struct MergeTask));
+        results->modes = modesFromFrequencyTables(tables, numPartitions, &results->numModes);
+        for (int p = 0; p < numPartitions; p++) {
+            freeFrequencyTable(&tables[p]);
+        }
+    }
+
+    // Phase 3: median by parallel selection
+    results->median = (statistics & STAT_MEDIAN) ? calculateMedianParallel(data, numVals, numThreads) : 0.0;
+
+    results->mean = total.mean;
+    results->stddev = sqrt(total.m2 / total.count);
+    results->meanTerms = total.meanTerms;
+
+    free(tasks);
+    free(tables);
+    free(mergeTasks);
+}
@@ -0,0 +1,45 @@
+#ifndef PARALLELSTATS_H
+#define PARALLELSTATS_H
+
+#include <stddef.h>
+
+#include "statsFunctions.h"
+
+// Partial aggregates of one block of data; partials of disjoint blocks can be merged
+struct StatsPartial {
+    int count;              // Number of values in the block
+    double mean;            // Mean of the block
+    double m2;              // Sum of squared deviations from the block mean
+    struct MeanTerms meanTerms; // Log-sum, reciprocal-sum and invalid value counts
+};
+
+// Statistics computed by the parallel engine
+struct ParallelResults {
+    double mean;
+    double median;
+    double stddev;
+    struct MeanTerms meanTerms; // Terms of the geometric and harmonic means (see finalizeAlternativeMeans)
+    double *modes;          // Dynamically allocated, NULL if no mode
+    int numModes;
+};
+
+// Function to get the number of online CPU cores
+int getNumCores(void);
+
+// Function to run a worker on numThreads threads (thread 0 is the caller) and wait for all of them
+void runThreads(int numThreads, void *(*worker)(void *), void *args, size_t argSize);
+
+// Function to compute the partial aggregates of the selected statistics (STAT_* flags) of one block of data
+void computeStatsPartial(const double *dataArray, int numVals, unsigned int statistics, struct StatsPartial *partial);
+
+// Function to merge the partial aggregates of another block into a partial
+void mergeStatsPartials(struct StatsPartial *into, const struct StatsPartial *from);
+
+// Function to find the value of the given rank (0-based) in sorted order without modifying the data
+double parallelSelect(const double *dataArray, int numVals, int rank, int numThreads);
+
+// Function to calculate the selected statistics (STAT_* flags) of a dataset using several threads
+void calculateStatisticsParallel(const double *dataArray, int numVals, int numThreads, unsigned int statistics,
+                                 struct ParallelResults *results);
+
+#endif
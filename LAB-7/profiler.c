@@ -0,0 +1,279 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/syscall.h>
+#endif
+
+#include "profiler.h"
+
+/*
+ * A process-wide profile of named stages. Each stage records its wall time, the CPU time of all
+ * threads (so a parallel stage shows more CPU than wall time), and, where the kernel allows
+ * perf_event_open, the cycles, instructions and cache misses of the process and the threads it starts.
+ * Counters that cannot be opened (another OS, a VM without a PMU, or a restrictive
+ * perf_event_paranoid setting) are reported as n/a with the reason; the times are always available.
+ * Stages may nest: an inner stage is also counted in the outer one. profileBegin and profileEnd cost a
+ * branch when profiling is off, so the calls can stay in the code. They keep no locks and must only be
+ * called from the main thread; work done by other threads is measured by the stage that waits for it.
+ */
+
+// Deepest nesting of stages
+#define MAX_STAGE_DEPTH 8
+
+static const char *const COUNTER_NAMES[NUM_PROFILE_COUNTERS] = {"cycles", "instructions", "cache misses"};
+
+// One started stage on the stack of nested stages
+struct OpenStage {
+    int index;              // Row of the stage, -1 if the table was full
+    double wall;
+    double cpu;
+    long long counters[NUM_PROFILE_COUNTERS];
+};
+
+static int enabled = 0;
+static FILE *reportStream = NULL;
+static struct StageProfile stages[MAX_PROFILE_STAGES];
+static int numStages = 0;
+static struct OpenStage openStages[MAX_STAGE_DEPTH];
+static int depth = 0;
+static int excessDepth = 0;                       // Stages started beyond MAX_STAGE_DEPTH (not recorded)
+static int counterFds[NUM_PROFILE_COUNTERS] = {-1, -1, -1};
+static int counterErrors[NUM_PROFILE_COUNTERS];   // errno of a counter that could not be opened
+static struct OpenStage total;                    // Readings taken when profiling started
+
+
+/**
+ * @brief Returns the time of a clock in seconds.
+ */
+static double clockSeconds(clockid_t clock) {
+    struct timespec ts;
+    clock_gettime(clock, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief Opens a hardware counter for this process and the threads it starts.
+ *
+ * @return The file descriptor of the counter, or -1 with errno set.
+ */
+static int openCounter(enum ProfileCounter counter) {
+#ifdef __linux__
+    static const unsigned long long configs[NUM_PROFILE_COUNTERS] = {
+        PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS, PERF_COUNT_HW_CACHE_MISSES
+    };
+    struct perf_event_attr attr;
+    memset(&attr, 0, sizeof(attr));
+    attr.size = sizeof(attr);
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.config = configs[counter];
+    attr.inherit = 1;           // Count the worker threads too
+    attr.exclude_kernel = 1;    // Allowed with perf_event_paranoid <= 2
+    attr.exclude_hv = 1;
+    return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#else
+    (void)counter;
+    errno = ENOSYS;
+    return -1;
+#endif
+}
+
+
+/**
+ * @brief Takes the current readings of the clocks and the counters.
+ */
+static void takeReadings(struct OpenStage *reading) {
+    reading->wall = clockSeconds(CLOCK_MONOTONIC);
+    reading->cpu = clockSeconds(CLOCK_PROCESS_CPUTIME_ID);
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        long long value = 0;
+        if (counterFds[c] >= 0 && read(counterFds[c], &value, sizeof(value)) != sizeof(value)) {
+            value = 0;
+        }
+        reading->counters[c] = value;
+    }
+}
+
+
+/**
+ * @brief Prints the profile and closes the counters when the program exits.
+ */
+static void reportAtExit(void) {
+    while (depth > 0) {
+        profileEnd(); // Stages left open by an early exit
+    }
+    printProfile(reportStream);
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        if (counterFds[c] >= 0) {
+            close(counterFds[c]);
+            counterFds[c] = -1;
+        }
+    }
+}
+
+
+/**
+ * @brief Starts profiling.
+ *
+ * Opens the hardware counters that are available and registers the printing of the breakdown table
+ * for when the program exits (by returning from main or by calling exit).
+ *
+ * @param stream Stream the table is printed to.
+ */
+void enableProfiling(FILE *stream) {
+    if (enabled) {
+        return;
+    }
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        counterFds[c] = openCounter((enum ProfileCounter)c);
+        counterErrors[c] = (counterFds[c] < 0) ? errno : 0;
+    }
+    reportStream = stream;
+    enabled = 1;
+    takeReadings(&total);
+    atexit(reportAtExit);
+}
+
+
+/**
+ * @brief Returns whether profiling is enabled.
+ */
+int profilingEnabled(void) {
+    return enabled;
+}
+
+
+/**
+ * @brief Starts timing a stage.
+ *
+ * Calls with the same name (compared by content) add up in one row of the table.
+ *
+ * @param stage Name of the stage; it must stay valid until the profile is printed.
+ */
+void profileBegin(const char *stage) {
+    if (!enabled) {
+        return;
+    }
+    if (depth == MAX_STAGE_DEPTH) {
+        excessDepth++;
+        return;
+    }
+    int index = 0;
+    while (index < numStages && strcmp(stages[index].name, stage) != 0) {
+        index++;
+    }
+    if (index == numStages) {
+        if (numStages == MAX_PROFILE_STAGES) {
+            index = -1;
+        } else {
+            memset(&stages[index], 0, sizeof(stages[index]));
+            stages[index].name = stage;
+            numStages++;
+        }
+    }
+    struct OpenStage *open = &openStages[depth++];
+    open->index = index;
+    takeReadings(open);
+}
+
+
+/**
+ * @brief Stops timing the stage started last and adds its readings to its row.
+ */
+void profileEnd(void) {
+    if (!enabled || depth == 0) {
+        return;
+    }
+    if (excessDepth > 0) {
+        excessDepth--;
+        return;
+    }
+    struct OpenStage now;
+    takeReadings(&now);
+    struct OpenStage *open = &openStages[--depth];
+    if (open->index < 0) {
+        return;
+    }
+    struct StageProfile *profile = &stages[open->index];
+    profile->calls++;
+    profile->wallSeconds += now.wall - open->wall;
+    profile->cpuSeconds += now.cpu - open->cpu;
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        profile->counters[c] += now.counters[c] - open->counters[c];
+    }
+}
+
+
+/**
+ * @brief Prints a counter cell, or n/a if the counter is not available.
+ */
+static void printCounterCell(FILE *stream, int counter, long long value) {
+    if (counterFds[counter] < 0) {
+        fprintf(stream, " %14s", "n/a");
+    } else {
+        fprintf(stream, " %14lld", value);
+    }
+}
+
+
+/**
+ * @brief Prints one row of the breakdown table.
+ */
+static void printProfileRow(FILE *stream, const char *name, int calls, double wall, double cpu,
+                            const long long *counters, double totalWall) {
+    fprintf(stream, "%-22s %6d %11.3f %11.3f %6.1f%%", name, calls, wall * 1e3, cpu * 1e3,
+            (totalWall > 0.0) ? 100.0 * wall / totalWall : 0.0);
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        printCounterCell(stream, c, counters[c]);
+    }
+    if (counterFds[COUNTER_CYCLES] >= 0 && counterFds[COUNTER_INSTRUCTIONS] >= 0 && counters[COUNTER_CYCLES] > 0) {
+        fprintf(stream, " %6.2f", (double)counters[COUNTER_INSTRUCTIONS] / counters[COUNTER_CYCLES]);
+    } else {
+        fprintf(stream, " %6s", "n/a");
+    }
+    fprintf(stream, "\n");
+}
+
+
+/**
+ * @brief Prints the breakdown table of all stages.
+ *
+ * One row per stage in the order the stages first ran, then the whole run since profiling started.
+ * Times are in milliseconds; the percentage is the share of the wall time of the whole run. Nested
+ * stages are included in their outer stage, so the rows can add up to more than the total.
+ *
+ * @param stream Stream to print to.
+ */
+void printProfile(FILE *stream) {
+    if (!enabled) {
+        return;
+    }
+    struct OpenStage now;
+    takeReadings(&now);
+    double totalWall = now.wall - total.wall;
+    long long totalCounters[NUM_PROFILE_COUNTERS];
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        totalCounters[c] = now.counters[c] - total.counters[c];
+    }
+
+    fprintf(stream, "Profile:\n");
+    fprintf(stream, "%-22s %6s %11s %11s %7s %14s %14s %14s %6s\n", "stage", "calls", "wall ms", "cpu ms", "wall",
+            "cycles", "instructions", "cache misses", "IPC");
+    for (int s = 0; s < numStages; s++) {
+        printProfileRow(stream, stages[s].name, stages[s].calls, stages[s].wallSeconds, stages[s].cpuSeconds,
+                        stages[s].counters, totalWall);
+    }
+    printProfileRow(stream, "(total)", 1, totalWall, now.cpu - total.cpu, totalCounters, totalWall);
+
+    for (int c = 0; c < NUM_PROFILE_COUNTERS; c++) {
+        if (counterFds[c] < 0) {
+            fprintf(stream, "%s not available (perf_event_open: %s)\n", COUNTER_NAMES[c], strerror(counterErrors[c]));
+        }
+    }
+}
@@ -0,0 +1,41 @@
+#ifndef PROFILER_H
+#define PROFILER_H
+
+#include <stdio.h>
+
+// Largest number of distinct stage names a profile records
+#define MAX_PROFILE_STAGES 32
+
+// Hardware events counted per stage where perf_event_open is available
+enum ProfileCounter {
+    COUNTER_CYCLES,
+    COUNTER_INSTRUCTIONS,
+    COUNTER_CACHE_MISSES,
+    NUM_PROFILE_COUNTERS
+};
+
+// Totals of one named stage over all its calls
+struct StageProfile {
+    const char *name;
+    int calls;
+    double wallSeconds;
+    double cpuSeconds;      // CPU time of all threads of the process
+    long long counters[NUM_PROFILE_COUNTERS];
+};
+
+// Function to start profiling; the breakdown table is printed to stream when the program exits
+void enableProfiling(FILE *stream);
+
+// Function to check whether profiling is enabled
+int profilingEnabled(void);
+
+// Function to start timing a stage (does nothing unless profiling is enabled)
+void profileBegin(const char *stage);
+
+// Function to stop timing the stage started last
+void profileEnd(void);
+
+// Function to print the breakdown table of all stages
+void printProfile(FILE *stream);
+
+#endif
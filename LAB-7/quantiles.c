@@ -0,0 +1,459 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <stdint.h>
+
+#include "quantiles.h"
+
+// Ranges at most this long are finished with insertion sort
+#define INSERTION_SORT_THRESHOLD 16
+
+// Number of key bits sorted per pass of the radix sort, and the resulting number of passes over 64-bit keys
+#define RADIX_BITS 11
+#define RADIX_PASSES ((64 + RADIX_BITS - 1) / RADIX_BITS)
+
+// Width of the longest histogram bar in characters
+#define HISTOGRAM_BAR_WIDTH 40
+
+
+/**
+ * @brief Swaps two values.
+ */
+static void swapValues(double *a, double *b) {
+    double temp = *a;
+    *a = *b;
+    *b = temp;
+}
+
+
+/**
+ * @brief Sorts data[lo..hi] (inclusive) in ascending order with insertion sort.
+ */
+static void insertionSort(double *data, int lo, int hi) {
+    for (int i = lo + 1; i <= hi; i++) {
+        double value = data[i];
+        int j = i - 1;
+        while (j >= lo && data[j] > value) {
+            data[j + 1] = data[j];
+            j--;
+        }
+        data[j + 1] = value;
+    }
+}
+
+
+/**
+ * @brief Returns the median of three values.
+ */
+static double medianOfThree(double a, double b, double c) {
+    if (a > b) {
+        swapValues(&a, &b);
+    }
+    if (b > c) {
+        b = c;
+    }
+    return (a > b) ? a : b;
+}
+
+
+/**
+ * @brief Moves the values of several ranks into their sorted positions.
+ *
+ * This is quickselect generalized to many ranks: data[lo..hi] is partitioned three ways around a
+ * median-of-three pivot, every requested rank that falls into the block of values equal to the pivot
+ * is finished, and the procedure continues only into the sides that still contain requested ranks.
+ * All ranks are answered with one shared set of partitioning passes, in expected O(n log k) time for
+ * k ranks instead of k separate selections.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param lo First index of the range.
+ * @param hi Last index of the range (inclusive).
+ * @param ranks Requested ranks inside [lo, hi], sorted ascending.
+ * @param numRanks Number of requested ranks.
+ */
+static void multiSelect(double *data, int lo, int hi, const int *ranks, int numRanks) {
+    while (numRanks > 0 && hi - lo >= INSERTION_SORT_THRESHOLD) {
+        double pivot = medianOfThree(data[lo], data[lo + (hi - lo) / 2], data[hi]);
+
+        // Three-way partition: [lo, lt) < pivot, [lt, gt] == pivot, (gt, hi] > pivot
+        int lt = lo, i = lo, gt = hi;
+        while (i <= gt) {
+            if (data[i] < pivot) {
+                swapValues(&data[lt++], &data[i++]);
+            } else if (data[i] > pivot) {
+                swapValues(&data[i], &data[gt--]);
+            } else {
+                i++;
+            }
+        }
+
+        int numLeft = 0;
+        while (numLeft < numRanks && ranks[numLeft] < lt) {
+            numLeft++;
+        }
+        int rightStart = numLeft;
+        while (rightStart < numRanks && ranks[rightStart] <= gt) {
+            rightStart++;
+        }
+
+        multiSelect(data, lo, lt - 1, ranks, numLeft);
+        ranks += rightStart;
+        numRanks -= rightStart;
+        lo = gt + 1;
+    }
+
+    if (numRanks > 0 && lo < hi) {
+        insertionSort(data, lo, hi);
+    }
+}
+
+
+/**
+ * @brief Compares two ints for qsort in ascending order.
+ */
+static int compareInts(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief Computes several quantiles of the data with one multi-selection.
+ *
+ * Each quantile is interpolated linearly between the two closest ranks: for probability p the position
+ * h = (numVals - 1) * p is computed and the result is data[floor(h)] + (h - floor(h)) * (data[floor(h) + 1]
+ * - data[floor(h)]) in sorted order. The probability 0.5 gives the median. Every rank needed by any
+ * quantile is found by a single multi-selection, so the data array is reordered (but not fully sorted).
+ *
+ * @param data Pointer to the array of floating-point values (reordered in place).
+ * @param numVals Number of values in the array (must be positive).
+ * @param probabilities Array of probabilities in [0, 1].
+ * @param numProbabilities Number of probabilities.
+ * @param quantiles Array that receives one quantile per probability.
+ */
+void calculateQuantiles(double *data, int numVals, const double *probabilities, int numProbabilities, double *quantiles) {
+    int *ranks = (int *)malloc(sizeof(int) * 2 * numProbabilities);
+    if (ranks == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    // Collect the lower and upper rank of every quantile
+    int numRanks = 0;
+    for (int i = 0; i < numProbabilities; i++) {
+        int lower = (int)floor((numVals - 1) * probabilities[i]);
+        ranks[numRanks++] = lower;
+        if (lower + 1 < numVals) {
+            ranks[numRanks++] = lower + 1;
+        }
+    }
+
+    // Sort the ranks and remove duplicates
+    qsort(ranks, numRanks, sizeof(int), compareInts);
+    int numUnique = 0;
+    for (int i = 0; i < numRanks; i++) {
+        if (numUnique == 0 || ranks[i] != ranks[numUnique - 1]) {
+            ranks[numUnique++] = ranks[i];
+        }
+    }
+
+    multiSelect(data, 0, numVals - 1, ranks, numUnique);
+
+    quantilesOfSortedData(data, numVals, probabilities, numProbabilities, quantiles);
+
+    free(ranks);
+}
+
+
+/**
+ * @brief Computes several quantiles of data that is already sorted in ascending order.
+ *
+ * The quantiles are interpolated as in calculateQuantiles. Only the ranks the quantiles need have to be
+ * in their sorted positions, which is what the multi-selection of calculateQuantiles guarantees.
+ *
+ * @param data Pointer to the sorted array of floating-point values.
+ * @param numVals Number of values in the array (must be positive).
+ * @param probabilities Array of probabilities in [0, 1].
+ * @param numProbabilities Number of probabilities.
+ * @param quantiles Array that receives one quantile per probability.
+ */
+void quantilesOfSortedData(const double *data, int numVals, const double *probabilities, int numProbabilities,
+                           double *quantiles) {
+    for (int i = 0; i < numProbabilities; i++) {
+        double position = (numVals - 1) * probabilities[i];
+        int lower = (int)floor(position);
+        double fraction = position - lower;
+        if (fraction == 0.0 || lower + 1 >= numVals) {
+            quantiles[i] = data[lower];
+        } else {
+            quantiles[i] = (1.0 - fraction) * data[lower] + fraction * data[lower + 1];
+        }
+    }
+}
+
+
+/**
+ * @brief Maps a double to an unsigned key with the same order.
+ *
+ * Positive values get the sign bit set and negative values have all bits flipped, so comparing keys
+ * as unsigned integers orders the values; -0.0 comes right before +0.0 and NaNs end up at either end.
+ */
+static inline uint64_t sortKey(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits >> 63) ? ~bits : bits | (1ULL << 63);
+}
+
+
+/**
+ * @brief Inverts sortKey.
+ */
+static inline double keyValue(uint64_t key) {
+    uint64_t bits = (key >> 63) ? key & ~(1ULL << 63) : ~key;
+    double value;
+    memcpy(&value, &bits, sizeof(value));
+    return value;
+}
+
+
+/**
+ * @brief Sorts the data in ascending order.
+ *
+ * This is an LSD radix sort on order-preserving 64-bit keys (see sortKey): the counts of every digit
+ * are gathered in one pass, and passes whose digit is the same for all values (common for the exponent
+ * bits of data within a narrow range) are skipped. It takes O(n) time and 2n words of extra memory.
+ * NaN values are moved to the ends of the array.
+ *
+ * @param data Pointer to the array of floating-point values (sorted in place).
+ * @param numVals Number of values in the array.
+ */
+void sortValues(double *data, int numVals) {
+    if (numVals <= INSERTION_SORT_THRESHOLD) {
+        // Insertion sort on the keys, which (unlike the values) are totally ordered even with NaNs
+        for (int i = 1; i < numVals; i++) {
+            double value = data[i];
+            uint64_t key = sortKey(value);
+            int j = i - 1;
+            while (j >= 0 && sortKey(data[j]) > key) {
+                data[j + 1] = data[j];
+                j--;
+            }
+            data[j + 1] = value;
+        }
+        return;
+    }
+
+    uint64_t *keys = (uint64_t *)malloc(sizeof(uint64_t) * numVals);
+    uint64_t *temp = (uint64_t *)malloc(sizeof(uint64_t) * numVals);
+    int *counts = (int *)calloc((size_t)RADIX_PASSES << RADIX_BITS, sizeof(int));
+    if (keys == NULL || temp == NULL || counts == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    const uint64_t mask = (1ULL << RADIX_BITS) - 1;
+    for (int i = 0; i < numVals; i++) {
+        uint64_t key = sortKey(data[i]);
+        keys[i] = key;
+        for (int pass = 0; pass < RADIX_PASSES; pass++) {
+            counts[(pass << RADIX_BITS) + ((key >> (pass * RADIX_BITS)) & mask)]++;
+        }
+    }
+
+    for (int pass = 0; pass < RADIX_PASSES; pass++) {
+        int *digitCounts = counts + (pass << RADIX_BITS);
+        int shift = pass * RADIX_BITS;
+        if (digitCounts[(keys[0] >> shift) & mask] == numVals) {
+            continue; // Every key has the same digit
+        }
+        int offset = 0;
+        for (int digit = 0; digit <= (int)mask; digit++) {
+            int count = digitCounts[digit];
+            digitCounts[digit] = offset;
+            offset += count;
+        }
+        for (int i = 0; i < numVals; i++) {
+            temp[digitCounts[(keys[i] >> shift) & mask]++] = keys[i];
+        }
+        uint64_t *swap = keys;
+        keys = temp;
+        temp = swap;
+    }
+
+    for (int i = 0; i < numVals; i++) {
+        data[i] = keyValue(keys[i]);
+    }
+    free(keys);
+    free(temp);
+    free(counts);
+}
+
+
+/**
+ * @brief Parses a comma-separated list of percentiles.
+ *
+ * @param list List such as "50,90,99,99.9"; every entry must be between 0 and 100.
+ * @param numPercentiles Pointer to an integer variable to store the number of entries.
+ *
+ * @return Dynamically allocated array of the corresponding probabilities (percentile / 100),
+ *         or NULL if the list is empty or an entry is invalid.
+ */
+double *parsePercentiles(const char *list, int *numPercentiles) {
+    int capacity = 1;
+    for (const char *c = list; *c != '\0'; c++) {
+        capacity += (*c == ',');
+    }
+    double *probabilities = (double *)malloc(sizeof(double) * capacity);
+    if (probabilities == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    int count = 0;
+    const char *cursor = list;
+    while (1) {
+        char *end;
+        double percentile = strtod(cursor, &end);
+        if (end == cursor || percentile < 0.0 || percentile > 100.0 || (*end != ',' && *end != '\0')) {
+            free(probabilities);
+            return NULL;
+        }
+        probabilities[count++] = percentile / 100.0;
+        if (*end == '\0') {
+            break;
+        }
+        cursor = end + 1;
+    }
+
+    *numPercentiles = count;
+    return probabilities;
+}
+
+
+/**
+ * @brief Builds a histogram with equal-width bins spanning the range of the data.
+ *
+ * The bins cover [min, max] of the data; every bin includes its lower edge and excludes its upper
+ * edge, except the last bin, which also includes max. If all values are equal they all fall into
+ * the first bin. NaN and infinite values are left out of the range and the bins, and only counted in
+ * histogram->numNonFinite, so one infinity cannot make the bin width infinite. When max - min
+ * overflows (finite values near -DBL_MAX and DBL_MAX), the bins are found from halved values, whose
+ * range is finite, so the values still spread over all bins.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param numBins Number of bins (must be positive).
+ * @param histogram Pointer to the histogram to fill in; release it with freeHistogram.
+ */
+void buildHistogram(const double *data, int numVals, int numBins, struct Histogram *histogram) {
+    histogram->numBins = numBins;
+    histogram->counts = (int *)calloc(numBins, sizeof(int));
+    if (histogram->counts == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+
+    double min = INFINITY, max = -INFINITY;
+    int numNonFinite = 0;
+    for (int i = 0; i < numVals; i++) {
+        if (!isfinite(data[i])) {
+            numNonFinite++;
+            continue;
+        }
+        if (data[i] < min) {
+            min = data[i];
+        }
+        if (data[i] > max) {
+            max = data[i];
+        }
+    }
+    if (min > max) {
+        min = max = 0.0; // No finite values
+    }
+    histogram->numNonFinite = numNonFinite;
+    histogram->min = min;
+    histogram->max = max;
+    double shrink = isfinite(max - min) ? 1.0 : 0.5;
+    double range = max * shrink - min * shrink;
+    histogram->binWidth = range / numBins / shrink;
+
+    double scale = (max > min) ? numBins / range : 0.0;
+    for (int i = 0; i < numVals; i++) {
+        if (!isfinite(data[i])) {
+            continue;
+        }
+        int bin = (int)((data[i] * shrink - min * shrink) * scale);
+        if (bin >= numBins) {
+            bin = numBins - 1; // max belongs to the last bin
+        }
+        histogram->counts[bin]++;
+    }
+}
+
+
+/**
+ * @brief Returns the lower edge of a histogram bin.
+ *
+ * min + bin * binWidth can overflow for bins spanning most of the double range even though the edge
+ * itself is finite; the edge is then computed from halved terms.
+ *
+ * @param histogram Pointer to the histogram.
+ * @param bin Index of the bin.
+ *
+ * @return The lower edge of the bin.
+ */
+static double binLowerEdge(const struct Histogram *histogram, int bin) {
+    if (bin == 0) {
+        return histogram->min; // binWidth is infinite for a single bin wider than DBL_MAX
+    }
+    double edge = histogram->min + bin * histogram->binWidth;
+    if (isinf(edge)) {
+        edge = 2.0 * (histogram->min / 2 + bin * (histogram->binWidth / 2));
+    }
+    return edge;
+}
+
+
+/**
+ * @brief Prints a histogram with one line per bin and a bar proportional to its count.
+ *
+ * @param histogram Pointer to the histogram.
+ */
+void printHistogram(const struct Histogram *histogram) {
+    int maxCount = 0;
+    for (int i = 0; i < histogram->numBins; i++) {
+        if (histogram->counts[i] > maxCount) {
+            maxCount = histogram->counts[i];
+        }
+    }
+
+    printf("Histogram (%d bins):\n", histogram->numBins);
+    for (int i = 0; i < histogram->numBins; i++) {
+        double lower = binLowerEdge(histogram, i);
+        double upper = (i == histogram->numBins - 1) ? histogram->max : binLowerEdge(histogram, i + 1);
+        int barLength = (maxCount > 0) ? (int)((long long)histogram->counts[i] * HISTOGRAM_BAR_WIDTH / maxCount) : 0;
+        printf("  [%12.3f, %12.3f%c %10d ", lower, upper, (i == histogram->numBins - 1) ? ']' : ')',
+               histogram->counts[i]);
+        for (int j = 0; j < barLength; j++) {
+            putchar('#');
+        }
+        printf("\n");
+    }
+    if (histogram->numNonFinite > 0) {
+        printf("  %d non-finite values (NaN or infinite) are not in any bin\n", histogram->numNonFinite);
+    }
+}
+
+
+/**
+ * @brief Releases the memory held by a histogram.
+ *
+ * @param histogram Pointer to the histogram.
+ */
+void freeHistogram(struct Histogram *histogram) {
+    free(histogram->counts);
+    histogram->counts = NULL;
+    histogram->numBins = 0;
+}
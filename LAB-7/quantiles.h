@@ -0,0 +1,38 @@
+#ifndef QUANTILES_H
+#define QUANTILES_H
+
+// Percentiles reported when --percentiles is given without a custom list
+#define DEFAULT_PERCENTILES "50,90,99,99.9"
+
+// Fixed-width histogram of a dataset
+struct Histogram {
+    double min;         // Lower edge of the first bin
+    double max;         // Upper edge of the last bin (inclusive)
+    double binWidth;    // Width of every bin (infinite only for one bin wider than DBL_MAX)
+    int numBins;
+    int *counts;        // Number of values in each bin
+    int numNonFinite;   // NaN and infinite values, which are in no bin
+};
+
+// Function to calculate several quantiles (probabilities in [0, 1]) with one multi-selection
+void calculateQuantiles(double *dataArray, int numVals, const double *probabilities, int numProbabilities, double *quantiles);
+
+// Function to calculate several quantiles of data sorted in ascending order
+void quantilesOfSortedData(const double *dataArray, int numVals, const double *probabilities, int numProbabilities, double *quantiles);
+
+// Function to sort a dataset in ascending order with a radix sort
+void sortValues(double *dataArray, int numVals);
+
+// Function to parse a comma-separated list of percentiles (0 to 100) into probabilities
+double *parsePercentiles(const char *list, int *numPercentiles);
+
+// Function to build a histogram with the given number of equal-width bins
+void buildHistogram(const double *dataArray, int numVals, int numBins, struct Histogram *histogram);
+
+// Function to print a histogram as a table with bars
+void printHistogram(const struct Histogram *histogram);
+
+// Function to release the memory held by a histogram
+void freeHistogram(struct Histogram *histogram);
+
+#endif
@@ -1,27 +1,123 @@
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <limits.h>
+#include <errno.h>
+#include <time.h>
+#include <sys/resource.h>
 
 #include "statsFunctions.h"
+#include "readFile.h"
+#include "binaryData.h"
+#include "profiler.h"
+
+
+// Size of the buffer the token-counting pass reads the file through
+#define COUNT_BUFFER_SIZE 65536
+
+
+/**
+ * @brief Counts the whitespace-separated tokens of a file and rewinds it.
+ *
+ * This pass only looks for transitions between whitespace and other characters, which is much
+ * cheaper than converting the tokens, so the array can be allocated with its final size.
+ *
+ * @param file File to count; it is positioned at its beginning afterwards.
+ *
+ * @return The number of tokens (at most INT_MAX).
+ */
+static int countTokens(FILE *file) {
+    char *buffer = (char *)malloc(COUNT_BUFFER_SIZE);
+    if (buffer == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    long long numTokens = 0;
+    int inToken = 0;
+    size_t length;
+    while ((length = fread(buffer, 1, COUNT_BUFFER_SIZE, file)) > 0) {
+        for (size_t i = 0; i < length; i++) {
+            char c = buffer[i];
+            int isSpace = (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v');
+            numTokens += (!isSpace && !inToken);
+            inToken = !isSpace;
+        }
+    }
+    free(buffer);
+    rewind(file);
+    return (numTokens < INT_MAX) ? (int)numTokens : INT_MAX;
+}
+
+
+/**
+ * @brief Returns the initial capacity of a data array for a load strategy.
+ *
+ * @param file File the data will be read from (rewound if it is counted).
+ * @param strategy Load strategy.
+ */
+static int initialCapacity(FILE *file, enum LoadStrategy strategy) {
+    if (strategy == LOAD_DOUBLING) {
+        return 20;
+    }
+    profileBegin("count values");
+    int numTokens = countTokens(file);
+    profileEnd();
+    return (numTokens > 0) ? numTokens : 1;
+}
 
 
 /**
  * @brief Reads data from a file and stores it in a dynamically allocated array.
  *
- * This function reads doubleing-point values from the specified file and stores them in a dynamically
- * allocated array. It dynamically adjusts the cap of the array as needed while reading the data.
- * Upon successful execution, it returns a pointer to the dynamically allocated array containing the data.
- * In case of any errors during file opening, memory allocation, or reallocation, the program exits with an error message.
+ * This function reads floating-point values from the specified file and stores them in an array that is
+ * allocated with its final size: a first pass counts the tokens of the file (see countTokens), so the
+ * values are never copied by realloc and no capacity is left unused unless parsing stops early at a token
+ * that is not a number. In case of any errors during file opening or memory allocation, the program exits
+ * with an error message. Binary data files (see binaryData.h, created with the textToBinary converter) are
+ * recognized by their magic bytes and memory-mapped instead of parsed; their capacity equals the number of
+ * values. The returned array must be released with releaseData.
  *
  * @param filename Name of the file from which data is to be read.
  * @param numValues Pointer to an integer variable to store the number of values read from the file.
- * @param cap Pointer to an integer variable to store the current cap of the dynamically allocated array.
+ * @param cap Pointer to an integer variable to store the capacity of the dynamically allocated array.
  * @return
  *   - Pointer to the dynamically allocated array containing the read data if successful.
  *   - NULL if an error occurs during file opening or memory allocation.
  */
 double *readDataFromFile(const char *filename, int *numValues, int *cap) {
+    return readDataFromFileWithStrategy(filename, LOAD_PRESIZED, numValues, cap);
+}
+
+
+/**
+ * @brief Reads data from a file with a chosen allocation strategy.
+ *
+ * LOAD_PRESIZED allocates the array once after counting the tokens. LOAD_DOUBLING is the original strategy:
+ * the array starts with a capacity of 20 and is doubled with realloc whenever it is full, which copies the
+ * values about log2(n) times and can leave up to half of the capacity unused. It is kept for comparison.
+ *
+ * @param filename Name of the file from which data is to be read.
+ * @param strategy How the array is sized.
+ * @param numValues Pointer to an integer variable to store the number of values read from the file.
+ * @param cap Pointer to an integer variable to store the capacity of the dynamically allocated array.
+ *
+ * @return Pointer to the array containing the read data; release it with releaseData.
+ */
+double *readDataFromFileWithStrategy(const char *filename, enum LoadStrategy strategy, int *numValues, int *cap) {
+    // Map binary data files without parsing them
+    if (isBinaryDataFile(filename)) {
+        double *data = mapBinaryDataFile(filename, numValues);
+        if (data == NULL) {
+            fprintf(stderr, "Error mapping file: %s is not a valid binary data file\n", filename);
+            exit(1);
+        }
+        *cap = *numValues;
+        return data;
+    }
+
     FILE *file = fopen(filename, "r");
     // Check if file opened successfully
     if (file == NULL) {
@@ -29,7 +125,7 @@ double *readDataFromFile(const char *filename, int *numValues, int *cap) {
         exit(1);
     }
 
-    *cap = 20; // Initial cap of the array
+    *cap = initialCapacity(file, strategy); // Initial cap of the array
     *numValues = 0;
     // Allocate memory for the array
     double *data = (double *)malloc(sizeof(double) * *cap);
@@ -42,7 +138,7 @@ double *readDataFromFile(const char *filename, int *numValues, int *cap) {
     double value;
     // Read data from the file
     while (fscanf(file, "%lf", &value) == 1) {
-        // Check if array is full, if so, double its cap
+        // Check if array is full, if so, double its cap (a presized array only fills up if the file grew since it was counted)
         if (*numValues == *cap) {
             *cap *= 2;
             data = (double *)realloc(data, sizeof(double) * *cap);
@@ -59,4 +155,419 @@ double *readDataFromFile(const char *filename, int *numValues, int *cap) {
     // Close the file
     fclose(file);
     return data;
-}
\ No newline at end of file
+}
+
+
+/**
+ * @brief Returns the peak resident set size of the process in kilobytes.
+ *
+ * getrusage reports ru_maxrss in kilobytes on Linux but in bytes on macOS.
+ *
+ * @return The peak resident set size, or -1 if it is not available.
+ */
+long getPeakRssKilobytes(void) {
+    struct rusage usage;
+    if (getrusage(RUSAGE_SELF, &usage) != 0) {
+        return -1;
+    }
+#ifdef __APPLE__
+    return usage.ru_maxrss / 1024;
+#else
+    return usage.ru_maxrss;
+#endif
+}
+
+
+/**
+ * @brief Returns the time of a monotonic clock in seconds, for measuring durations.
+ */
+double monotonicSeconds(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+
+/**
+ * @brief Releases an array returned by readDataFromFile.
+ *
+ * Memory-mapped binary data is unmapped; parsed text data is freed.
+ *
+ * @param data Pointer returned by readDataFromFile (may be NULL).
+ */
+void releaseData(double *data) {
+    if (data != NULL && !unmapBinaryData(data)) {
+        free(data);
+    }
+}
+
+
+// Size of the buffer the tokenizer reads the file through
+#define READ_BUFFER_SIZE 65536
+// Longest token the tokenizer accepts (longer tokens end parsing like any invalid token)
+#define MAX_TOKEN_LENGTH 127
+
+// Buffered reader that splits a file into whitespace-separated tokens
+struct TokenReader {
+    FILE *file;
+    char buffer[READ_BUFFER_SIZE];
+    size_t length;      // Number of valid bytes in buffer
+    size_t position;    // Next byte to read from buffer
+};
+
+
+/**
+ * @brief Returns the next character of the file, or EOF.
+ */
+static int readerGetChar(struct TokenReader *reader) {
+    if (reader->position == reader->length) {
+        reader->length = fread(reader->buffer, 1, READ_BUFFER_SIZE, reader->file);
+        reader->position = 0;
+        if (reader->length == 0) {
+            return EOF;
+        }
+    }
+    return (unsigned char)reader->buffer[reader->position++];
+}
+
+
+/**
+ * @brief Reads the next whitespace-separated token of the file.
+ *
+ * @param reader Pointer to the token reader.
+ * @param token Buffer of at least MAX_TOKEN_LENGTH + 2 bytes that receives the NUL-terminated token.
+ *
+ * @return 1 if a token was read, 0 at the end of the file.
+ */
+static int readToken(struct TokenReader *reader, char *token) {
+    int c;
+    do {
+        c = readerGetChar(reader);
+    } while (c == ' ' || c == '\n' || c == '\t' || c == '\r' || c == '\f' || c == '\v');
+    if (c == EOF) {
+        return 0;
+    }
+
+    int length = 0;
+    while (c != EOF && c != ' ' && c != '\n' && c != '\t' && c != '\r' && c != '\f' && c != '\v') {
+        // An over-long token keeps one extra character so that it fails to parse
+        if (length <= MAX_TOKEN_LENGTH) {
+            token[length++] = (char)c;
+        }
+        c = readerGetChar(reader);
+    }
+    token[length] = '\0';
+    return 1;
+}
+
+
+/**
+ * @brief Parses a token that consists only of an optional sign and decimal digits.
+ *
+ * @return 1 if the token is such an integer and fits into 64 bits, 0 otherwise.
+ */
+static int parseIntegerToken(const char *token, long long *value) {
+    const char *digits = (*token == '+' || *token == '-') ? token + 1 : token;
+    if (*digits == '\0') {
+        return 0;
+    }
+    for (const char *c = digits; *c != '\0'; c++) {
+        if (*c < '0' || *c > '9') {
+            return 0;
+        }
+    }
+    errno = 0;
+    *value = strtoll(token, NULL, 10);
+    return errno == 0;
+}
+
+
+/**
+ * @brief Reads a dataset from a file and stores it with the narrowest exact element type.
+ *
+ * While the file is tokenized, every value is checked for being an integer. As long as all values are
+ * integers they are stored as int64; at the first non-integer value the values read so far are converted
+ * to double in place and parsing continues with doubles. At the end, integer data whose range fits into
+ * 32 bits is narrowed to int32, and, if allowFloat32 is set, floating-point data is narrowed to float32
+ * (which trades precision for half the memory bandwidth). Narrowing happens in place. Like
+ * readDataFromFile, parsing stops at the first token that is not a number, and binary data files are
+ * memory-mapped as doubles. The program exits with an error message if the file cannot be read.
+ *
+ * @param filename Name of the file from which data is to be read.
+ * @param allowFloat32 Whether floating-point data may be stored as float32.
+ * @param strategy How the array is sized (see readDataFromFileWithStrategy).
+ * @param data Pointer to the structure that receives the dataset; release it with releaseTypedData.
+ */
+void readTypedDataFromFile(const char *filename, int allowFloat32, enum LoadStrategy strategy, struct TypedData *data) {
+    if (isBinaryDataFile(filename)) {
+        data->type = DATA_DOUBLE;
+        data->values = readDataFromFile(filename, &data->numVals, &data->capacity);
+        return;
+    }
+
+    struct TokenReader *reader = (struct TokenReader *)malloc(sizeof(struct TokenReader));
+    if (reader == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    reader->file = fopen(filename, "r");
+    // Check if file opened successfully
+    if (reader->file == NULL) {
+        perror("Error opening file");
+        exit(1);
+    }
+    reader->length = 0;
+    reader->position = 0;
+
+    // int64 and double have the same size, so one buffer serves both until the type is known
+    int cap = initialCapacity(reader->file, strategy);
+    int numValues = 0;
+    int isInteger = 1;
+    int64_t minValue = INT64_MAX, maxValue = INT64_MIN;
+    void *values = malloc(sizeof(int64_t) * cap);
+    if (values == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+
+    char token[MAX_TOKEN_LENGTH + 2];
+    while (readToken(reader, token)) {
+        long long integer;
+        double value;
+        int tokenIsInteger = isInteger && parseIntegerToken(token, &integer);
+        if (!tokenIsInteger) {
+            char *end;
+            value = strtod(token, &end);
+            if (end == token || *end != '\0') {
+                break; // Not a number: stop reading, like fscanf
+            }
+            if (isInteger) {
+                // Switch to doubles: convert the integers read so far in place
+                int64_t *integers = (int64_t *)values;
+                double *doubles = (double *)values;
+                for (int i = 0; i < numValues; i++) {
+                    doubles[i] = (double)integers[i];
+                }
+                isInteger = 0;
+            }
+        }
+
+        // Check if array is full, if so, double its cap (a presized array only fills up if the file grew since it was counted)
+        if (numValues == cap) {
+            cap *= 2;
+            values = realloc(values, sizeof(int64_t) * cap);
+            if (values == NULL) {
+                perror("Error reallocating memory");
+                exit(1);
+            }
+        }
+
+        if (isInteger) {
+            ((int64_t *)values)[numValues++] = integer;
+            if (integer < minValue) {
+                minValue = integer;
+            }
+            if (integer > maxValue) {
+                maxValue = integer;
+            }
+        } else {
+            ((double *)values)[numValues++] = value;
+        }
+    }
+
+    fclose(reader->file);
+    free(reader);
+
+    data->numVals = numValues;
+    data->capacity = cap;
+    data->values = values;
+    if (isInteger) {
+        data->type = DATA_INT64;
+        if (minValue >= INT32_MIN && maxValue <= INT32_MAX) {
+            // Narrow to int32 in place: element i moves from byte 8i to byte 4i, which never overtakes the reads
+            int64_t *wide = (int64_t *)values;
+            int32_t *narrow = (int32_t *)values;
+            for (int i = 0; i < numValues; i++) {
+                narrow[i] = (int32_t)wide[i];
+            }
+            data->type = DATA_INT32;
+        }
+    } else {
+        data->type = DATA_DOUBLE;
+        if (allowFloat32) {
+            double *wide = (double *)values;
+            float *narrow = (float *)values;
+            for (int i = 0; i < numValues; i++) {
+                narrow[i] = (float)wide[i];
+            }
+            data->type = DATA_FLOAT32;
+        }
+    }
+
+    if (data->type == DATA_INT32 || data->type == DATA_FLOAT32) {
+        // Give back the upper half of the buffer
+        void *shrunk = realloc(values, 4 * (size_t)cap);
+        if (shrunk != NULL) {
+            data->values = shrunk;
+        }
+    }
+}
+
+
+/**
+ * @brief Reads a data file into a buffer that is reused across files.
+ *
+ * Unlike readDataFromFile, errors do not end the program, so one unreadable file does not stop a batch
+ * of files. The values of a text file are counted first; the buffer is only replaced (without copying)
+ * when it is too small, so a worker that reads many files allocates about as often as its largest file
+ * grows. Binary data files are memory-mapped instead; the caller must release the returned array with
+ * releaseData if it is not *buffer.
+ *
+ * @param filename Name of the file from which data is to be read.
+ * @param buffer Pointer to the reusable buffer (may point to NULL); it is replaced when it is too small.
+ * @param capacity Pointer to the capacity of the buffer in values.
+ * @param numValues Pointer to an integer variable to store the number of values read from the file.
+ *
+ * @return Pointer to the values (*buffer or a mapping), or NULL after printing an error message.
+ */
+double *readDataIntoBuffer(const char *filename, double **buffer, int *capacity, int *numValues) {
+    *numValues = 0;
+    if (isBinaryDataFile(filename)) {
+        double *data = mapBinaryDataFile(filename, numValues);
+        if (data == NULL) {
+            fprintf(stderr, "Error mapping file: %s is not a valid binary data file\n", filename);
+        }
+        return data;
+    }
+
+    struct TokenReader *reader = (struct TokenReader *)malloc(sizeof(struct TokenReader));
+    if (reader == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    reader->file = fopen(filename, "r");
+    if (reader->file == NULL) {
+        fprintf(stderr, "Error opening file %s: %s\n", filename, strerror(errno));
+        free(reader);
+        return NULL;
+    }
+    reader->length = 0;
+    reader->position = 0;
+
+    int numTokens = countTokens(reader->file);
+    if (*buffer == NULL || numTokens > *capacity) {
+        free(*buffer);
+        *capacity = (numTokens > 0) ? numTokens : 1;
+        *buffer = (double *)malloc(sizeof(double) * *capacity);
+        if (*buffer == NULL) {
+            perror("Error allocating memory");
+            exit(1);
+        }
+    }
+
+    char token[MAX_TOKEN_LENGTH + 2];
+    int count = 0;
+    while (count < *capacity && readToken(reader, token)) {
+        char *end;
+        double value = strtod(token, &end);
+        if (end == token || *end != '\0') {
+            break; // Not a number: stop reading, like fscanf
+        }
+        (*buffer)[count++] = value;
+    }
+
+    fclose(reader->file);
+    free(reader);
+    *numValues = count;
+    return *buffer;
+}
+
+
+/**
+ * @brief Converts a typed dataset to an array of doubles, in place.
+ *
+ * The array of values is grown to numVals doubles with one realloc and the values are widened from the
+ * last to the first, so each double is written over source values that were already converted and no
+ * second full-size array is allocated. Double data is returned as is. Integers beyond 2^53 in magnitude
+ * are rounded to the nearest double.
+ *
+ * @param data Pointer to the dataset; afterwards it describes the returned double array.
+ *
+ * @return Pointer to the array of doubles; release it with releaseTypedData(data) or releaseData.
+ */
+double *typedDataToDoubles(struct TypedData *data) {
+    if (data->type == DATA_DOUBLE) {
+        return (double *)data->values;
+    }
+
+    int numVals = data->numVals;
+    double *doubles = (double *)realloc(data->values, sizeof(double) * (numVals > 0 ? numVals : 1));
+    if (doubles == NULL) {
+        perror("Error allocating memory");
+        exit(1);
+    }
+    // Element i moves from byte offset i * size to i * 8; going backwards never overwrites an unread value.
+    // The values are loaded with memcpy because the two types share the same memory.
+    const char *bytes = (const char *)doubles;
+    switch (data->type) {
+        case DATA_FLOAT32:
+            for (int i = numVals - 1; i >= 0; i--) {
+                float value;
+                memcpy(&value, bytes + sizeof(float) * i, sizeof(value));
+                doubles[i] = value;
+            }
+            break;
+        case DATA_INT32:
+            for (int i = numVals - 1; i >= 0; i--) {
+                int32_t value;
+                memcpy(&value, bytes + sizeof(int32_t) * i, sizeof(value));
+                doubles[i] = value;
+            }
+            break;
+        default:
+            for (int i = numVals - 1; i >= 0; i--) {
+                int64_t value;
+                memcpy(&value, bytes + sizeof(int64_t) * i, sizeof(value));
+                doubles[i] = (double)value;
+            }
+            break;
+    }
+
+    data->values = doubles;
+    data->type = DATA_DOUBLE;
+    data->capacity = numVals;
+    return doubles;
+}
+
+
+/**
+ * @brief Releases the values of a typed dataset.
+ *
+ * @param data Pointer to the dataset.
+ */
+void releaseTypedData(struct TypedData *data) {
+    if (data->type == DATA_DOUBLE) {
+        releaseData((double *)data->values); // May be a mapped binary data file
+    } else {
+        free(data->values);
+    }
+    data->values = NULL;
+    data->numVals = 0;
+}
+
+
+/**
+ * @brief Returns the name of a data type as printed in the results.
+ */
+const char *dataTypeName(enum DataType type) {
+    switch (type) {
+        case DATA_FLOAT32:
+            return "float32";
+        case DATA_INT32:
+            return "int32";
+        case DATA_INT64:
+            return "int64";
+        default:
+            return "double";
+    }
+}
@@ -1,6 +1,37 @@
 #ifndef READFILE_H
 #define READFILE_H
 
+// Element type of a dataset, detected while it is parsed
+enum DataType {
+    DATA_DOUBLE,
+    DATA_FLOAT32,
+    DATA_INT32,
+    DATA_INT64
+};
+
+// Dataset stored with its narrowest exact element type
+struct TypedData {
+    enum DataType type;
+    void *values;       // double, float, int32_t or int64_t array depending on type
+    int numVals;
+    int capacity;       // Capacity of values in elements of the type
+};
+
+// How the array of a text data file is sized
+enum LoadStrategy {
+    LOAD_PRESIZED,  // Count the tokens first and allocate the array once
+    LOAD_DOUBLING   // Start small and double the capacity with realloc
+};
+
 double *readDataFromFile(const char *filename, int *numVals, int *capacity);
+double *readDataFromFileWithStrategy(const char *filename, enum LoadStrategy strategy, int *numVals, int *capacity);
+void releaseData(double *dataArray);
+long getPeakRssKilobytes(void);
+double monotonicSeconds(void);
+void readTypedDataFromFile(const char *filename, int allowFloat32, enum LoadStrategy strategy, struct TypedData *data);
+double *readDataIntoBuffer(const char *filename, double **buffer, int *capacity, int *numVals);
+double *typedDataToDoubles(struct TypedData *data);
+void releaseTypedData(struct TypedData *data);
+const char *dataTypeName(enum DataType type);
 
-#endif
\ No newline at end of file
+#endif
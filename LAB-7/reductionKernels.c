@@ -0,0 +1,494 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "reductionKernels.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_X86_KERNELS 1
+#include <immintrin.h>
+#else
+#define HAVE_X86_KERNELS 0
+#endif
+
+/*
+ * All kernels keep several independent Kahan accumulators so the adds of
+ * consecutive iterations do not wait on each other, and every accumulator
+ * carries its own compensation term so long inputs do not lose precision.
+ * Compensated summation only works if the compiler keeps the order of the
+ * floating-point operations, so do not build this file with -ffast-math.
+ *
+ * An accumulator that meets an infinity (or overflows) turns its compensation
+ * into inf - inf = NaN. Rather than test every add, the kernels recompute a
+ * result that came out NaN with a plain sum, which gives the IEEE result
+ * (inf, or NaN if the data holds one); finite data never takes that path.
+ */
+
+// Number of independent accumulators used by the scalar kernels
+#define SCALAR_LANES 4
+
+
+/**
+ * @brief Adds one value to a Kahan accumulator; the kernels deal with a NaN result once, at the end.
+ */
+static inline void kahanStep(double *sum, double *comp, double value) {
+    double y = value - *comp;
+    double t = *sum + y;
+    *comp = (t - *sum) - y;
+    *sum = t;
+}
+
+
+/**
+ * @brief Returns a compensated sum, or the plain sum of the values if it came out NaN.
+ */
+static double sumOrPlain(double sum, const double *data, int numVals) {
+    if (!isnan(sum)) {
+        return sum;
+    }
+    sum = 0.0;
+    for (int i = 0; i < numVals; i++) {
+        sum += data[i];
+    }
+    return sum;
+}
+
+
+/**
+ * @brief Returns a compensated sum of squared deviations, or the plain sum if it came out NaN.
+ */
+static double sumSquaredDeviationsOrPlain(double sum, const double *data, int numVals, double mean) {
+    if (!isnan(sum)) {
+        return sum;
+    }
+    sum = 0.0;
+    for (int i = 0; i < numVals; i++) {
+        sum += (data[i] - mean) * (data[i] - mean);
+    }
+    return sum;
+}
+
+
+/**
+ * @brief Returns a compensated sum of reciprocals, or the plain sum if it came out NaN.
+ */
+static double sumReciprocalsOrPlain(double sum, const double *data, int numVals) {
+    if (!isnan(sum)) {
+        return sum;
+    }
+    sum = 0.0;
+    for (int i = 0; i < numVals; i++) {
+        sum += (data[i] == 0.0) ? 0.0 : 1.0 / data[i];
+    }
+    return sum;
+}
+
+
+/**
+ * @brief Combines the partial sums of all accumulators into one value.
+ *
+ * The partial sums and the (negated) compensation terms are added with Neumaier's
+ * variant of compensated summation, which also stays accurate when the partial
+ * sums differ widely in magnitude.
+ *
+ * @param sums Array of partial sums.
+ * @param comps Array of compensation terms, one per partial sum.
+ * @param numLanes Number of partial sums.
+ *
+ * @return The combined sum.
+ */
+static double combineLanes(const double *sums, const double *comps, int numLanes) {
+    double sum = 0.0;
+    double comp = 0.0;
+    for (int i = 0; i < 2 * numLanes; i++) {
+        double value = (i < numLanes) ? sums[i] : -comps[i - numLanes];
+        double t = sum + value;
+        if (fabs(sum) >= fabs(value)) {
+            comp += (sum - t) + value;
+        } else {
+            comp += (value - t) + sum;
+        }
+        sum = t;
+    }
+    return sum + comp;
+}
+
+
+/**
+ * @brief Computes the sum of the data using scalar code.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ *
+ * @return The compensated sum of the values.
+ */
+static double sumScalar(const double *data, int numVals) {
+    double sums[SCALAR_LANES] = {0.0};
+    double comps[SCALAR_LANES] = {0.0};
+
+    int i = 0;
+    for (; i + SCALAR_LANES <= numVals; i += SCALAR_LANES) {
+        for (int lane = 0; lane < SCALAR_LANES; lane++) {
+            kahanStep(&sums[lane], &comps[lane], data[i + lane]);
+        }
+    }
+    // Add the remaining values to the first accumulator
+    for (; i < numVals; i++) {
+        kahanStep(&sums[0], &comps[0], data[i]);
+    }
+    return sumOrPlain(combineLanes(sums, comps, SCALAR_LANES), data, numVals);
+}
+
+
+/**
+ * @brief Computes the sum of squared deviations from the mean using scalar code.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param mean Mean of the data.
+ *
+ * @return The compensated sum of (data[i] - mean)^2.
+ */
+static double sumSquaredDeviationsScalar(const double *data, int numVals, double mean) {
+    double sums[SCALAR_LANES] = {0.0};
+    double comps[SCALAR_LANES] = {0.0};
+
+    int i = 0;
+    for (; i + SCALAR_LANES <= numVals; i += SCALAR_LANES) {
+        for (int lane = 0; lane < SCALAR_LANES; lane++) {
+            double diff = data[i + lane] - mean;
+            kahanStep(&sums[lane], &comps[lane], diff * diff);
+        }
+    }
+    for (; i < numVals; i++) {
+        double diff = data[i] - mean;
+        kahanStep(&sums[0], &comps[0], diff * diff);
+    }
+    return sumSquaredDeviationsOrPlain(combineLanes(sums, comps, SCALAR_LANES), data, numVals, mean);
+}
+
+
+/**
+ * @brief Computes the sum of reciprocals of the data using scalar code.
+ *
+ * Zero values are counted instead of added, so the caller can decide what a zero means
+ * for its statistic.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param numZeros Pointer to an integer variable to store the number of zero values.
+ *
+ * @return The compensated sum of 1 / data[i] over the non-zero values.
+ */
+static double sumReciprocalsScalar(const double *data, int numVals, int *numZeros) {
+    double sums[SCALAR_LANES] = {0.0};
+    double comps[SCALAR_LANES] = {0.0};
+    int zeros = 0;
+
+    int i = 0;
+    for (; i + SCALAR_LANES <= numVals; i += SCALAR_LANES) {
+        for (int lane = 0; lane < SCALAR_LANES; lane++) {
+            double value = data[i + lane];
+            zeros += (value == 0.0);
+            kahanStep(&sums[lane], &comps[lane], (value == 0.0) ? 0.0 : 1.0 / value);
+        }
+    }
+    for (; i < numVals; i++) {
+        double value = data[i];
+        zeros += (value == 0.0);
+        kahanStep(&sums[0], &comps[0], (value == 0.0) ? 0.0 : 1.0 / value);
+    }
+
+    *numZeros = zeros;
+    return sumReciprocalsOrPlain(combineLanes(sums, comps, SCALAR_LANES), data, numVals);
+}
+
+
+#if HAVE_X86_KERNELS
+
+// Number of independent vector accumulators used by the AVX kernels
+#define VECTOR_ACCUMULATORS 4
+
+#define AVX2_TARGET __attribute__((target("avx2")))
+#define AVX512_TARGET __attribute__((target("avx512f")))
+
+/**
+ * @brief Adds four values to four Kahan accumulators held in one AVX2 register.
+ */
+AVX2_TARGET static inline void kahanAddAvx2(__m256d *sum, __m256d *comp, __m256d value) {
+    __m256d y = _mm256_sub_pd(value, *comp);
+    __m256d t = _mm256_add_pd(*sum, y);
+    *comp = _mm256_sub_pd(_mm256_sub_pd(t, *sum), y);
+    *sum = t;
+}
+
+/**
+ * @brief Combines the AVX2 accumulators and the scalar tail accumulator into one value.
+ */
+AVX2_TARGET static double combineAvx2(const __m256d *sums, const __m256d *comps, double tailSum, double tailComp) {
+    double laneSums[VECTOR_ACCUMULATORS * 4 + 1];
+    double laneComps[VECTOR_ACCUMULATORS * 4 + 1];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        _mm256_storeu_pd(&laneSums[k * 4], sums[k]);
+        _mm256_storeu_pd(&laneComps[k * 4], comps[k]);
+    }
+    laneSums[VECTOR_ACCUMULATORS * 4] = tailSum;
+    laneComps[VECTOR_ACCUMULATORS * 4] = tailComp;
+    return combineLanes(laneSums, laneComps, VECTOR_ACCUMULATORS * 4 + 1);
+}
+
+AVX2_TARGET static double sumAvx2(const double *data, int numVals) {
+    __m256d sums[VECTOR_ACCUMULATORS];
+    __m256d comps[VECTOR_ACCUMULATORS];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        sums[k] = _mm256_setzero_pd();
+        comps[k] = _mm256_setzero_pd();
+    }
+
+    int i = 0;
+    for (; i + 4 * VECTOR_ACCUMULATORS <= numVals; i += 4 * VECTOR_ACCUMULATORS) {
+        for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+            kahanAddAvx2(&sums[k], &comps[k], _mm256_loadu_pd(data + i + 4 * k));
+        }
+    }
+
+    double tailSum = 0.0, tailComp = 0.0;
+    for (; i < numVals; i++) {
+        kahanStep(&tailSum, &tailComp, data[i]);
+    }
+    return sumOrPlain(combineAvx2(sums, comps, tailSum, tailComp), data, numVals);
+}
+
+AVX2_TARGET static double sumSquaredDeviationsAvx2(const double *data, int numVals, double mean) {
+    __m256d sums[VECTOR_ACCUMULATORS];
+    __m256d comps[VECTOR_ACCUMULATORS];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        sums[k] = _mm256_setzero_pd();
+        comps[k] = _mm256_setzero_pd();
+    }
+    __m256d meanVec = _mm256_set1_pd(mean);
+
+    int i = 0;
+    for (; i + 4 * VECTOR_ACCUMULATORS <= numVals; i += 4 * VECTOR_ACCUMULATORS) {
+        for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+            __m256d diff = _mm256_sub_pd(_mm256_loadu_pd(data + i + 4 * k), meanVec);
+            kahanAddAvx2(&sums[k], &comps[k], _mm256_mul_pd(diff, diff));
+        }
+    }
+
+    double tailSum = 0.0, tailComp = 0.0;
+    for (; i < numVals; i++) {
+        double diff = data[i] - mean;
+        kahanStep(&tailSum, &tailComp, diff * diff);
+    }
+    return sumSquaredDeviationsOrPlain(combineAvx2(sums, comps, tailSum, tailComp), data, numVals, mean);
+}
+
+AVX2_TARGET static double sumReciprocalsAvx2(const double *data, int numVals, int *numZeros) {
+    __m256d sums[VECTOR_ACCUMULATORS];
+    __m256d comps[VECTOR_ACCUMULATORS];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        sums[k] = _mm256_setzero_pd();
+        comps[k] = _mm256_setzero_pd();
+    }
+    __m256d zero = _mm256_setzero_pd();
+    __m256d one = _mm256_set1_pd(1.0);
+    int zeros = 0;
+
+    int i = 0;
+    for (; i + 4 * VECTOR_ACCUMULATORS <= numVals; i += 4 * VECTOR_ACCUMULATORS) {
+        for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+            __m256d value = _mm256_loadu_pd(data + i + 4 * k);
+            __m256d isZero = _mm256_cmp_pd(value, zero, _CMP_EQ_OQ);
+            zeros += __builtin_popcount(_mm256_movemask_pd(isZero));
+            // Zero lanes contribute 0 instead of infinity
+            __m256d recip = _mm256_andnot_pd(isZero, _mm256_div_pd(one, value));
+            kahanAddAvx2(&sums[k], &comps[k], recip);
+        }
+    }
+
+    double tailSum = 0.0, tailComp = 0.0;
+    for (; i < numVals; i++) {
+        zeros += (data[i] == 0.0);
+        kahanStep(&tailSum, &tailComp, (data[i] == 0.0) ? 0.0 : 1.0 / data[i]);
+    }
+
+    *numZeros = zeros;
+    return sumReciprocalsOrPlain(combineAvx2(sums, comps, tailSum, tailComp), data, numVals);
+}
+
+
+/**
+ * @brief Adds eight values to eight Kahan accumulators held in one AVX-512 register.
+ */
+AVX512_TARGET static inline void kahanAddAvx512(__m512d *sum, __m512d *comp, __m512d value) {
+    __m512d y = _mm512_sub_pd(value, *comp);
+    __m512d t = _mm512_add_pd(*sum, y);
+    *comp = _mm512_sub_pd(_mm512_sub_pd(t, *sum), y);
+    *sum = t;
+}
+
+/**
+ * @brief Combines the AVX-512 accumulators and the scalar tail accumulator into one value.
+ */
+AVX512_TARGET static double combineAvx512(const __m512d *sums, const __m512d *comps, double tailSum, double tailComp) {
+    double laneSums[VECTOR_ACCUMULATORS * 8 + 1];
+    double laneComps[VECTOR_ACCUMULATORS * 8 + 1];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        _mm512_storeu_pd(&laneSums[k * 8], sums[k]);
+        _mm512_storeu_pd(&laneComps[k * 8], comps[k]);
+    }
+    laneSums[VECTOR_ACCUMULATORS * 8] = tailSum;
+    laneComps[VECTOR_ACCUMULATORS * 8] = tailComp;
+    return combineLanes(laneSums, laneComps, VECTOR_ACCUMULATORS * 8 + 1);
+}
+
+AVX512_TARGET static double sumAvx512(const double *data, int numVals) {
+    __m512d sums[VECTOR_ACCUMULATORS];
+    __m512d comps[VECTOR_ACCUMULATORS];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        sums[k] = _mm512_setzero_pd();
+        comps[k] = _mm512_setzero_pd();
+    }
+
+    int i = 0;
+    for (; i + 8 * VECTOR_ACCUMULATORS <= numVals; i += 8 * VECTOR_ACCUMULATORS) {
+        for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+            kahanAddAvx512(&sums[k], &comps[k], _mm512_loadu_pd(data + i + 8 * k));
+        }
+    }
+
+    double tailSum = 0.0, tailComp = 0.0;
+    for (; i < numVals; i++) {
+        kahanStep(&tailSum, &tailComp, data[i]);
+    }
+    return sumOrPlain(combineAvx512(sums, comps, tailSum, tailComp), data, numVals);
+}
+
+AVX512_TARGET static double sumSquaredDeviationsAvx512(const double *data, int numVals, double mean) {
+    __m512d sums[VECTOR_ACCUMULATORS];
+    __m512d comps[VECTOR_ACCUMULATORS];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        sums[k] = _mm512_setzero_pd();
+        comps[k] = _mm512_setzero_pd();
+    }
+    __m512d meanVec = _mm512_set1_pd(mean);
+
+    int i = 0;
+    for (; i + 8 * VECTOR_ACCUMULATORS <= numVals; i += 8 * VECTOR_ACCUMULATORS) {
+        for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+            __m512d diff = _mm512_sub_pd(_mm512_loadu_pd(data + i + 8 * k), meanVec);
+            kahanAddAvx512(&sums[k], &comps[k], _mm512_mul_pd(diff, diff));
+        }
+    }
+
+    double tailSum = 0.0, tailComp = 0.0;
+    for (; i < numVals; i++) {
+        double diff = data[i] - mean;
+        kahanStep(&tailSum, &tailComp, diff * diff);
+    }
+    return sumSquaredDeviationsOrPlain(combineAvx512(sums, comps, tailSum, tailComp), data, numVals, mean);
+}
+
+AVX512_TARGET static double sumReciprocalsAvx512(const double *data, int numVals, int *numZeros) {
+    __m512d sums[VECTOR_ACCUMULATORS];
+    __m512d comps[VECTOR_ACCUMULATORS];
+    for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+        sums[k] = _mm512_setzero_pd();
+        comps[k] = _mm512_setzero_pd();
+    }
+    __m512d zero = _mm512_setzero_pd();
+    __m512d one = _mm512_set1_pd(1.0);
+    int zeros = 0;
+
+    int i = 0;
+    for (; i + 8 * VECTOR_ACCUMULATORS <= numVals; i += 8 * VECTOR_ACCUMULATORS) {
+        for (int k = 0; k < VECTOR_ACCUMULATORS; k++) {
+            __m512d value = _mm512_loadu_pd(data + i + 8 * k);
+            __mmask8 nonZero = _mm512_cmp_pd_mask(value, zero, _CMP_NEQ_UQ);
+            zeros += 8 - __builtin_popcount(nonZero);
+            // Zero lanes contribute 0 instead of infinity
+            __m512d recip = _mm512_maskz_div_pd(nonZero, one, value);
+            kahanAddAvx512(&sums[k], &comps[k], recip);
+        }
+    }
+
+    double tailSum = 0.0, tailComp = 0.0;
+    for (; i < numVals; i++) {
+        zeros += (data[i] == 0.0);
+        kahanStep(&tailSum, &tailComp, (data[i] == 0.0) ? 0.0 : 1.0 / data[i]);
+    }
+
+    *numZeros = zeros;
+    return sumReciprocalsOrPlain(combineAvx512(sums, comps, tailSum, tailComp), data, numVals);
+}
+
+#endif
+
+
+// Kernel tables, indexed by enum KernelIsa
+static const struct ReductionKernels kernelTables[KERNEL_ISA_COUNT] = {
+    {"scalar", sumScalar, sumSquaredDeviationsScalar, sumReciprocalsScalar},
+#if HAVE_X86_KERNELS
+    {"avx2", sumAvx2, sumSquaredDeviationsAvx2, sumReciprocalsAvx2},
+    {"avx512", sumAvx512, sumSquaredDeviationsAvx512, sumReciprocalsAvx512},
+#endif
+};
+
+
+/**
+ * @brief Checks whether the running CPU supports an instruction set.
+ *
+ * @param isa Instruction set to check.
+ *
+ * @return 1 if the kernels for the instruction set can run on this CPU, 0 otherwise.
+ */
+static int cpuSupports(enum KernelIsa isa) {
+    switch (isa) {
+        case KERNEL_ISA_SCALAR:
+            return 1;
+#if HAVE_X86_KERNELS
+        case KERNEL_ISA_AVX2:
+            return __builtin_cpu_supports("avx2");
+        case KERNEL_ISA_AVX512:
+            return __builtin_cpu_supports("avx512f");
+#endif
+        default:
+            return 0;
+    }
+}
+
+
+/**
+ * @brief Returns the reduction kernels for one instruction set.
+ *
+ * @param isa Instruction set whose kernels are requested.
+ *
+ * @return Pointer to the kernel table, or NULL if the instruction set is not compiled in
+ *         or not supported by the running CPU.
+ */
+const struct ReductionKernels *getReductionKernels(enum KernelIsa isa) {
+    if (isa < 0 || isa >= KERNEL_ISA_COUNT || !cpuSupports(isa)) {
+        return NULL;
+    }
+    return &kernelTables[isa];
+}
+
+
+/**
+ * @brief Returns the fastest reduction kernels supported by the running CPU.
+ *
+ * The widest instruction set reported by CPU feature detection is chosen; the scalar
+ * kernels are used on CPUs (or architectures) without AVX2.
+ *
+ * @return Pointer to the selected kernel table (never NULL).
+ */
+const struct ReductionKernels *selectReductionKernels(void) {
+    for (int isa = KERNEL_ISA_COUNT - 1; isa > KERNEL_ISA_SCALAR; isa--) {
+        const struct ReductionKernels *kernels = getReductionKernels((enum KernelIsa)isa);
+        if (kernels != NULL) {
+            return kernels;
+        }
+    }
+    return &kernelTables[KERNEL_ISA_SCALAR];
+}
@@ -0,0 +1,48 @@
+#ifndef REDUCTIONKERNELS_H
+#define REDUCTIONKERNELS_H
+
+#include <math.h>
+
+// Instruction sets the reduction kernels are compiled for
+enum KernelIsa {
+    KERNEL_ISA_SCALAR,
+    KERNEL_ISA_AVX2,
+    KERNEL_ISA_AVX512,
+    KERNEL_ISA_COUNT
+};
+
+// Table of reduction kernels implemented for one instruction set
+struct ReductionKernels {
+    const char *name;
+    // Compensated sum of all values
+    double (*sum)(const double *dataArray, int numVals);
+    // Compensated sum of (x - mean)^2 over all values
+    double (*sumSquaredDeviations)(const double *dataArray, int numVals, double mean);
+    // Compensated sum of 1/x over all values; *numZeros receives the number of zero values
+    double (*sumReciprocals)(const double *dataArray, int numVals, int *numZeros);
+};
+
+/**
+ * @brief Adds one value to a Kahan accumulator.
+ *
+ * Once the sum is infinite or NaN the compensation is dropped, since inf - inf would turn it into
+ * NaN; the sum then behaves like a plain IEEE sum.
+ *
+ * @param sum Pointer to the running sum.
+ * @param comp Pointer to the running compensation (the low-order bits lost so far; the true sum is sum - comp).
+ * @param value Value to add.
+ */
+static inline void kahanAdd(double *sum, double *comp, double value) {
+    double y = value - *comp;
+    double t = *sum + y;
+    *comp = isfinite(t) ? (t - *sum) - y : 0.0;
+    *sum = t;
+}
+
+// Function to get the kernels for one instruction set (NULL if the CPU does not support it)
+const struct ReductionKernels *getReductionKernels(enum KernelIsa isa);
+
+// Function to get the fastest kernels supported by the running CPU
+const struct ReductionKernels *selectReductionKernels(void);
+
+#endif
@@ -0,0 +1,345 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+
+#include "resultsFormat.h"
+
+/*
+ * Machine-readable versions of printResults. Values are printed with the fewest digits (up to 17)
+ * that read back as the same double; undefined or non-finite values become null in JSON and empty
+ * cells in CSV. Only the selected statistics are written, together with the dataset size and the
+ * time of every stage of the run in seconds, so results and performance can be collected together.
+ */
+
+
+/**
+ * @brief Parses an output format name.
+ *
+ * @param name "text", "json" or "csv".
+ * @param format Pointer to the variable that receives the format.
+ *
+ * @return 0 on success, -1 if the name is unknown.
+ */
+int parseOutputFormat(const char *name, enum OutputFormat *format) {
+    if (strcmp(name, "text") == 0) {
+        *format = FORMAT_TEXT;
+    } else if (strcmp(name, "json") == 0) {
+        *format = FORMAT_JSON;
+    } else if (strcmp(name, "csv") == 0) {
+        *format = FORMAT_CSV;
+    } else {
+        return -1;
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Returns the name of an invalid value policy, as accepted by parseInvalidValuePolicy.
+ */
+static const char *policyName(enum InvalidValuePolicy policy) {
+    switch (policy) {
+        case POLICY_SKIP:
+            return "skip";
+        case POLICY_ERROR:
+            return "error";
+        default:
+            return "reject";
+    }
+}
+
+
+/**
+ * @brief Formats a finite number with the fewest significant digits that read back as the same value.
+ */
+static void formatNumber(char *buffer, size_t size, double value) {
+    for (int digits = 15; digits <= 17; digits++) {
+        snprintf(buffer, size, "%.*g", digits, value);
+        if (strtod(buffer, NULL) == value) {
+            return;
+        }
+    }
+}
+
+
+/**
+ * @brief Prints a number as JSON (null if it is not finite).
+ */
+static void printJsonNumber(double value) {
+    if (isfinite(value)) {
+        char buffer[32];
+        formatNumber(buffer, sizeof(buffer), value);
+        printf("%s", buffer);
+    } else {
+        printf("null");
+    }
+}
+
+
+/**
+ * @brief Prints the separator and the key of the next member of a JSON object.
+ */
+static void printJsonKey(int *first, const char *indent, const char *key) {
+    printf("%s\n%s\"%s\": ", *first ? "" : ",", indent, key);
+    *first = 0;
+}
+
+
+/**
+ * @brief Prints the results as one JSON object.
+ *
+ * Besides the selected statistics the object holds "numValues", "type" and "unusedCapacity", the
+ * requested percentiles as "p50", "p99.9", ... under "percentiles", the sketch under "approximateModes"
+ * and the histogram if they were computed, "timings" in seconds per stage, and "peakRssKilobytes" if
+ * it was measured.
+ *
+ * @param results Pointer to the results.
+ */
+void printResultsJson(const struct StatsResults *results) {
+    const struct AlternativeMeans *means = &results->means;
+    int first = 1;
+
+    printf("{");
+    printJsonKey(&first, "  ", "numValues");
+    printf("%d", results->numVals);
+    printJsonKey(&first, "  ", "type");
+    printf("\"%s\"", (results->dataType != NULL) ? results->dataType : "double");
+    printJsonKey(&first, "  ", "unusedCapacity");
+    printf("%d", results->capacity - results->numVals);
+
+    if (results->statistics & STAT_MEAN) {
+        printJsonKey(&first, "  ", "mean");
+        printJsonNumber(results->mean);
+    }
+    if (results->statistics & STAT_MEDIAN) {
+        printJsonKey(&first, "  ", "median");
+        printJsonNumber(results->median);
+    }
+    if (results->statistics & STAT_STDDEV) {
+        printJsonKey(&first, "  ", "stddev");
+        printJsonNumber(results->stddev);
+    }
+    if (results->statistics & STAT_GEOMETRIC) {
+        printJsonKey(&first, "  ", "geometricMean");
+        printJsonNumber(means->geometricDefined ? means->geometricMean : NAN);
+    }
+    if (results->statistics & STAT_HARMONIC) {
+        printJsonKey(&first, "  ", "harmonicMean");
+        printJsonNumber(means->harmonicDefined ? means->harmonicMean : NAN);
+    }
+    if (results->statistics & (STAT_GEOMETRIC | STAT_HARMONIC)) {
+        printJsonKey(&first, "  ", "invalidValues");
+        printf("{\"nonPositive\": %d, \"zero\": %d, \"nan\": %d, \"policy\": \"%s\"}", means->numNonPositive,
+               means->numZeros, means->numNaN, policyName(means->policy));
+    }
+
+    if (results->numQuantiles > 0) {
+        printJsonKey(&first, "  ", "percentiles");
+        printf("{");
+        for (int i = 0; i < results->numQuantiles; i++) {
+            printf("%s\"p%g\": ", (i == 0) ? "" : ", ", results->probabilities[i] * 100.0);
+            printJsonNumber(results->quantiles[i]);
+        }
+        printf("}");
+    }
+
+    if (results->heavyHitters != NULL) {
+        const struct HeavyHitters *sketch = results->heavyHitters;
+        struct HeavyHitter *top = (struct HeavyHitter *)malloc(sizeof(struct HeavyHitter) * sketch->capacity);
+        if (top == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+        int size = topHeavyHitters(sketch, top);
+        printJsonKey(&first, "  ", "approximateModes");
+        printf("{\"counters\": %d, \"binWidth\": ", sketch->capacity);
+        printJsonNumber(sketch->binWidth);
+        printf(", \"values\": [");
+        for (int i = 0; i < size; i++) {
+            printf("%s{\"value\": ", (i == 0) ? "" : ", ");
+            printJsonNumber(top[i].value);
+            printf(", \"count\": %d, \"error\": %d}", top[i].count, top[i].error);
+        }
+        printf("]}");
+        free(top);
+    } else if (results->statistics & STAT_MODE) {
+        printJsonKey(&first, "  ", "modes");
+        printf("[");
+        for (int i = 0; i < results->numModes; i++) {
+            printf("%s", (i == 0) ? "" : ", ");
+            printJsonNumber(results->modes[i]);
+        }
+        printf("]");
+    }
+
+    if (results->histogram.numBins > 0) {
+        const struct Histogram *histogram = &results->histogram;
+        printJsonKey(&first, "  ", "histogram");
+        printf("{\"min\": ");
+        printJsonNumber(histogram->min);
+        printf(", \"max\": ");
+        printJsonNumber(histogram->max);
+        printf(", \"binWidth\": ");
+        printJsonNumber(histogram->binWidth);
+        printf(", \"counts\": [");
+        for (int i = 0; i < histogram->numBins; i++) {
+            printf("%s%d", (i == 0) ? "" : ", ", histogram->counts[i]);
+        }
+        printf("], \"nonFinite\": %d}", histogram->numNonFinite);
+    }
+
+    const struct StageTimings *timings = &results->timings;
+    printJsonKey(&first, "  ", "timings");
+    printf("{\"parse\": %.9f, \"moments\": %.9f, \"means\": %.9f, \"sort\": %.9f, \"median\": %.9f, "
+           "\"mode\": %.9f, \"histogram\": %.9f, \"compute\": %.9f}",
+           timings->parse, timings->moments, timings->means, timings->sort, timings->median, timings->mode,
+           timings->histogram, timings->compute);
+
+    if (results->peakRssKilobytes >= 0) {
+        printJsonKey(&first, "  ", "peakRssKilobytes");
+        printf("%ld", results->peakRssKilobytes);
+    }
+    printf("\n}\n");
+}
+
+
+/**
+ * @brief Prints a CSV cell with a number (empty if it is not finite).
+ */
+static void printCsvNumber(double value) {
+    printf(",");
+    if (isfinite(value)) {
+        char buffer[32];
+        formatNumber(buffer, sizeof(buffer), value);
+        printf("%s", buffer);
+    }
+}
+
+
+/**
+ * @brief Prints the results as a CSV header line and one row.
+ *
+ * The columns are num_values, type, the selected statistics, one column per percentile (p50, ...),
+ * the counts of invalid values if a geometric or harmonic mean was selected, the mode(s) separated by
+ * semicolons (or value:count:error triples of the sketch), the stage times in seconds and the peak
+ * RSS if it was measured. The histogram is only part of the JSON output.
+ *
+ * @param results Pointer to the results.
+ */
+void printResultsCsv(const struct StatsResults *results) {
+    const struct AlternativeMeans *means = &results->means;
+    unsigned int statistics = results->statistics;
+    int hasModes = results->heavyHitters != NULL || (statistics & STAT_MODE);
+    int hasInvalid = (statistics & (STAT_GEOMETRIC | STAT_HARMONIC)) != 0;
+
+    // Header
+    printf("num_values,type");
+    if (statistics & STAT_MEAN) {
+        printf(",mean");
+    }
+    if (statistics & STAT_MEDIAN) {
+        printf(",median");
+    }
+    if (statistics & STAT_STDDEV) {
+        printf(",stddev");
+    }
+    if (statistics & STAT_GEOMETRIC) {
+        printf(",geometric_mean");
+    }
+    if (statistics & STAT_HARMONIC) {
+        printf(",harmonic_mean");
+    }
+    for (int i = 0; i < results->numQuantiles; i++) {
+        printf(",p%g", results->probabilities[i] * 100.0);
+    }
+    if (hasInvalid) {
+        printf(",non_positive,zeros,nan");
+    }
+    if (hasModes) {
+        printf(",%s", (results->heavyHitters != NULL) ? "approximate_modes" : "modes");
+    }
+    printf(",parse_s,moments_s,means_s,sort_s,median_s,mode_s,histogram_s,compute_s");
+    if (results->peakRssKilobytes >= 0) {
+        printf(",peak_rss_kb");
+    }
+    printf("\n");
+
+    // Row
+    printf("%d,%s", results->numVals, (results->dataType != NULL) ? results->dataType : "double");
+    if (statistics & STAT_MEAN) {
+        printCsvNumber(results->mean);
+    }
+    if (statistics & STAT_MEDIAN) {
+        printCsvNumber(results->median);
+    }
+    if (statistics & STAT_STDDEV) {
+        printCsvNumber(results->stddev);
+    }
+    if (statistics & STAT_GEOMETRIC) {
+        printCsvNumber(means->geometricDefined ? means->geometricMean : NAN);
+    }
+    if (statistics & STAT_HARMONIC) {
+        printCsvNumber(means->harmonicDefined ? means->harmonicMean : NAN);
+    }
+    for (int i = 0; i < results->numQuantiles; i++) {
+        printCsvNumber(results->quantiles[i]);
+    }
+    if (hasInvalid) {
+        printf(",%d,%d,%d", means->numNonPositive, means->numZeros, means->numNaN);
+    }
+    if (results->heavyHitters != NULL) {
+        const struct HeavyHitters *sketch = results->heavyHitters;
+        struct HeavyHitter *top = (struct HeavyHitter *)malloc(sizeof(struct HeavyHitter) * sketch->capacity);
+        if (top == NULL) {
+            perror("Error allocating memory");
+            exit(EXIT_FAILURE);
+        }
+        int size = topHeavyHitters(sketch, top);
+        printf(",");
+        for (int i = 0; i < size; i++) {
+            char buffer[32];
+            formatNumber(buffer, sizeof(buffer), top[i].value);
+            printf("%s%s:%d:%d", (i == 0) ? "" : ";", buffer, top[i].count, top[i].error);
+        }
+        free(top);
+    } else if (hasModes) {
+        printf(",");
+        for (int i = 0; i < results->numModes; i++) {
+            char buffer[32];
+            formatNumber(buffer, sizeof(buffer), results->modes[i]);
+            printf("%s%s", (i == 0) ? "" : ";", buffer);
+        }
+    }
+    const struct StageTimings *timings = &results->timings;
+    printf(",%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f,%.9f", timings->parse, timings->moments, timings->means,
+           timings->sort, timings->median, timings->mode, timings->histogram, timings->compute);
+    if (results->peakRssKilobytes >= 0) {
+        printf(",%ld", results->peakRssKilobytes);
+    }
+    printf("\n");
+}
+
+
+/**
+ * @brief Prints the results in the given format.
+ *
+ * @param results Pointer to the results.
+ * @param format Output format.
+ */
+void printResultsInFormat(const struct StatsResults *results, enum OutputFormat format) {
+    switch (format) {
+        case FORMAT_JSON:
+            printResultsJson(results);
+            break;
+        case FORMAT_CSV:
+            printResultsCsv(results);
+            break;
+        default:
+            printResults(results);
+            if (results->peakRssKilobytes >= 0) {
+                printf("Peak RSS: %ld KB\n", results->peakRssKilobytes);
+            }
+            break;
+    }
+}
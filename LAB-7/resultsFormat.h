@@ -0,0 +1,25 @@
+#ifndef RESULTSFORMAT_H
+#define RESULTSFORMAT_H
+
+#include "statsFunctions.h"
+
+// How the results of a run are written to standard output
+enum OutputFormat {
+    FORMAT_TEXT,    // Human-readable block (printResults)
+    FORMAT_JSON,    // One JSON object
+    FORMAT_CSV      // A header line and one row
+};
+
+// Function to parse a format name ("text", "json" or "csv"), returns -1 if unknown
+int parseOutputFormat(const char *name, enum OutputFormat *format);
+
+// Function to print the results as one JSON object
+void printResultsJson(const struct StatsResults *results);
+
+// Function to print the results as a CSV header line and one row
+void printResultsCsv(const struct StatsResults *results);
+
+// Function to print the results in the given format
+void printResultsInFormat(const struct StatsResults *results, enum OutputFormat format);
+
+#endif
@@ -0,0 +1,360 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "rollingStats.h"
+
+/*
+ * Rolling statistics keep the last window values of a stream in a ring buffer and update every
+ * statistic when a value arrives or is evicted:
+ *  - mean and variance with Welford's update and its inverse, in O(1); the running sums are
+ *    recomputed from the ring once per window evictions so rounding errors cannot accumulate,
+ *    which keeps the cost O(1) amortized;
+ *  - median with two heaps of ring slots (a max-heap of the lower half and a min-heap of the upper
+ *    half), each slot knowing its position; a new value takes over the slot of the evicted one and
+ *    usually only needs one sift in its heap, so an update costs O(log window);
+ *  - mode with a frequency table and a count of counts, so the largest frequency is known in O(1).
+ * NaN samples are not added to the window; they are only counted.
+ */
+
+
+/**
+ * @brief Allocates an array and exits with an error message on failure.
+ */
+static void *allocateOrExit(size_t size) {
+    void *memory = malloc(size);
+    if (memory == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    return memory;
+}
+
+
+/**
+ * @brief Initializes rolling statistics over the last window values of a stream.
+ *
+ * @param stats Pointer to the rolling statistics to initialize.
+ * @param window Number of values in the window (must be positive).
+ */
+void initRollingStats(struct RollingStats *stats, int window) {
+    stats->window = window;
+    stats->ring = (double *)allocateOrExit(sizeof(double) * window);
+    stats->head = 0;
+    stats->count = 0;
+    stats->numNaN = 0;
+    stats->numEvictions = 0;
+    stats->mean = 0.0;
+    stats->m2 = 0.0;
+    stats->low.slots = (int *)allocateOrExit(sizeof(int) * window);
+    stats->low.size = 0;
+    stats->high.slots = (int *)allocateOrExit(sizeof(int) * window);
+    stats->high.size = 0;
+    stats->heapPosition = (int *)allocateOrExit(sizeof(int) * window);
+    stats->inLowHeap = (char *)allocateOrExit(window);
+    initFrequencyTable(&stats->frequencies, window);
+    stats->countOfCounts = (int *)calloc(window + 1, sizeof(int));
+    if (stats->countOfCounts == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    stats->maxCount = 0;
+}
+
+
+/**
+ * @brief Returns whether slot a belongs above slot b in a heap.
+ *
+ * The low heap is a max-heap and the high heap a min-heap.
+ */
+static int heapBefore(const struct RollingStats *stats, int isLow, int a, int b) {
+    return isLow ? stats->ring[a] > stats->ring[b] : stats->ring[a] < stats->ring[b];
+}
+
+
+/**
+ * @brief Stores a slot at an index of a heap and records its position.
+ */
+static void heapPlace(struct RollingStats *stats, struct SlotHeap *heap, int index, int slot) {
+    heap->slots[index] = slot;
+    stats->heapPosition[slot] = index;
+}
+
+
+/**
+ * @brief Moves the slot at an index of a heap up or down until the heap order holds.
+ */
+static void heapFix(struct RollingStats *stats, struct SlotHeap *heap, int isLow, int index) {
+    int slot = heap->slots[index];
+
+    // Sift up
+    while (index > 0) {
+        int parent = (index - 1) / 2;
+        if (!heapBefore(stats, isLow, slot, heap->slots[parent])) {
+            break;
+        }
+        heapPlace(stats, heap, index, heap->slots[parent]);
+        index = parent;
+    }
+
+    // Sift down
+    while (1) {
+        int child = 2 * index + 1;
+        if (child >= heap->size) {
+            break;
+        }
+        if (child + 1 < heap->size && heapBefore(stats, isLow, heap->slots[child + 1], heap->slots[child])) {
+            child++;
+        }
+        if (!heapBefore(stats, isLow, heap->slots[child], slot)) {
+            break;
+        }
+        heapPlace(stats, heap, index, heap->slots[child]);
+        index = child;
+    }
+    heapPlace(stats, heap, index, slot);
+}
+
+
+/**
+ * @brief Inserts a slot into a heap.
+ */
+static void heapPush(struct RollingStats *stats, int isLow, int slot) {
+    struct SlotHeap *heap = isLow ? &stats->low : &stats->high;
+    stats->inLowHeap[slot] = (char)isLow;
+    heapPlace(stats, heap, heap->size++, slot);
+    heapFix(stats, heap, isLow, heap->size - 1);
+}
+
+
+/**
+ * @brief Removes the slot at an index of a heap.
+ *
+ * @return The removed slot.
+ */
+static int heapRemoveAt(struct RollingStats *stats, int isLow, int index) {
+    struct SlotHeap *heap = isLow ? &stats->low : &stats->high;
+    int slot = heap->slots[index];
+    heap->size--;
+    if (index < heap->size) {
+        heapPlace(stats, heap, index, heap->slots[heap->size]);
+        heapFix(stats, heap, isLow, index);
+    }
+    return slot;
+}
+
+
+/**
+ * @brief Restores the size balance of the heaps: the low heap holds half the values, rounded up.
+ */
+static void rebalanceHeaps(struct RollingStats *stats) {
+    if (stats->low.size > stats->high.size + 1) {
+        heapPush(stats, 0, heapRemoveAt(stats, 1, 0));
+    } else if (stats->high.size > stats->low.size) {
+        heapPush(stats, 1, heapRemoveAt(stats, 0, 0));
+    }
+}
+
+
+/**
+ * @brief Recomputes the mean and the sum of squared deviations of the window from the ring buffer.
+ */
+static void recomputeMoments(struct RollingStats *stats) {
+    double sum = 0.0;
+    for (int i = 0; i < stats->count; i++) {
+        sum += stats->ring[(stats->head + i) % stats->window];
+    }
+    stats->mean = sum / stats->count;
+    double m2 = 0.0;
+    for (int i = 0; i < stats->count; i++) {
+        double deviation = stats->ring[(stats->head + i) % stats->window] - stats->mean;
+        m2 += deviation * deviation;
+    }
+    stats->m2 = m2;
+    stats->numEvictions = 0;
+}
+
+
+/**
+ * @brief Removes the oldest value from the window.
+ */
+static void evictOldest(struct RollingStats *stats) {
+    int slot = stats->head;
+    double value = stats->ring[slot];
+
+    // Inverse Welford update
+    if (stats->count == 1) {
+        stats->mean = 0.0;
+        stats->m2 = 0.0;
+    } else {
+        double oldMean = stats->mean;
+        stats->mean = (stats->count * oldMean - value) / (stats->count - 1);
+        stats->m2 -= (value - oldMean) * (value - stats->mean);
+    }
+
+    int count = removeFromFrequencyTable(&stats->frequencies, value, 1);
+    stats->countOfCounts[count + 1]--;
+    if (count > 0) {
+        stats->countOfCounts[count]++;
+    }
+    if (stats->countOfCounts[stats->maxCount] == 0) {
+        stats->maxCount--;
+    }
+
+    stats->head = (stats->head + 1) % stats->window;
+    stats->count--;
+    stats->numEvictions++;
+}
+
+
+/**
+ * @brief Adds a value to the window.
+ *
+ * When the window is full the oldest value is evicted first. Both steps take O(log window) time for
+ * the median heaps and O(1) (amortized) for everything else. NaN values are counted and ignored.
+ *
+ * @param stats Pointer to the rolling statistics.
+ * @param value New value of the stream.
+ */
+void addRollingValue(struct RollingStats *stats, double value) {
+    if (isnan(value)) {
+        stats->numNaN++;
+        return;
+    }
+    // When the window is full the new value takes over the slot of the evicted one
+    int replacing = stats->count == stats->window;
+    if (replacing) {
+        evictOldest(stats);
+    }
+
+    int slot = (stats->head + stats->count) % stats->window;
+    stats->ring[slot] = value;
+    stats->count++;
+
+    // Welford update
+    double delta = value - stats->mean;
+    stats->mean += delta / stats->count;
+    stats->m2 += delta * (value - stats->mean);
+    if (stats->numEvictions >= stats->window) {
+        recomputeMoments(stats);
+    }
+
+    if (replacing) {
+        int isLow = stats->inLowHeap[slot];
+        int staysInHeap = isLow ? (stats->high.size == 0 || value <= stats->ring[stats->high.slots[0]])
+                                : value >= stats->ring[stats->low.slots[0]];
+        if (staysInHeap) {
+            // The halves keep their sizes, so one sift restores the heap order
+            heapFix(stats, isLow ? &stats->low : &stats->high, isLow, stats->heapPosition[slot]);
+        } else {
+            heapRemoveAt(stats, isLow, stats->heapPosition[slot]);
+            heapPush(stats, !isLow, slot);
+            rebalanceHeaps(stats);
+        }
+    } else {
+        // The value joins the lower half if it is not above the current median candidate
+        int toLow = stats->low.size == 0 || value <= stats->ring[stats->low.slots[0]];
+        heapPush(stats, toLow, slot);
+        rebalanceHeaps(stats);
+    }
+
+    int count = addToFrequencyTable(&stats->frequencies, value, 1);
+    stats->countOfCounts[count]++;
+    if (count > 1) {
+        stats->countOfCounts[count - 1]--;
+    }
+    if (count > stats->maxCount) {
+        stats->maxCount = count;
+    }
+}
+
+
+/**
+ * @brief Returns the mean of the window (0 if it is empty).
+ *
+ * @param stats Pointer to the rolling statistics.
+ */
+double rollingMean(const struct RollingStats *stats) {
+    return stats->mean;
+}
+
+
+/**
+ * @brief Returns the population standard deviation of the window, as calculateStandardDeviation does.
+ *
+ * @param stats Pointer to the rolling statistics.
+ */
+double rollingStandardDeviation(const struct RollingStats *stats) {
+    if (stats->count == 0 || stats->m2 <= 0.0) {
+        return 0.0; // Rounding can leave a tiny negative m2 for a constant window
+    }
+    return sqrt(stats->m2 / stats->count);
+}
+
+
+/**
+ * @brief Returns the median of the window (0 if it is empty).
+ *
+ * For an even number of values the two middle values are averaged, as calculateMedian does.
+ *
+ * @param stats Pointer to the rolling statistics.
+ */
+double rollingMedian(const struct RollingStats *stats) {
+    if (stats->count == 0) {
+        return 0.0;
+    }
+    double lower = stats->ring[stats->low.slots[0]];
+    if (stats->low.size > stats->high.size) {
+        return lower;
+    }
+    double upper = stats->ring[stats->high.slots[0]];
+    return 0.5 * lower + 0.5 * upper;
+}
+
+
+/**
+ * @brief Returns how often the most frequent value of the window occurs.
+ *
+ * @param stats Pointer to the rolling statistics.
+ */
+int rollingModeFrequency(const struct RollingStats *stats) {
+    return stats->maxCount;
+}
+
+
+/**
+ * @brief Calculates the mode(s) of the window.
+ *
+ * If every distinct value occurs equally often there is no mode; this is decided in O(1) from the
+ * count of counts. Otherwise the frequency table is scanned for the values with the largest count.
+ *
+ * @param stats Pointer to the rolling statistics.
+ * @param numModes Pointer to an integer variable to store the number of modes found.
+ *
+ * @return Pointer to the dynamically allocated array of modes (ascending) if mode(s) exist, NULL otherwise.
+ */
+double *rollingModes(const struct RollingStats *stats, int *numModes) {
+    if (stats->maxCount == 0 || stats->countOfCounts[stats->maxCount] == stats->frequencies.size) {
+        *numModes = 0;
+        return NULL;
+    }
+    return modesFromFrequencyTables(&stats->frequencies, 1, numModes);
+}
+
+
+/**
+ * @brief Releases the memory held by rolling statistics.
+ *
+ * @param stats Pointer to the rolling statistics.
+ */
+void freeRollingStats(struct RollingStats *stats) {
+    free(stats->ring);
+    free(stats->low.slots);
+    free(stats->high.slots);
+    free(stats->heapPosition);
+    free(stats->inLowHeap);
+    freeFrequencyTable(&stats->frequencies);
+    free(stats->countOfCounts);
+    stats->ring = NULL;
+    stats->count = 0;
+}
@@ -0,0 +1,55 @@
+#ifndef ROLLINGSTATS_H
+#define ROLLINGSTATS_H
+
+#include "frequencyTable.h"
+
+// Binary heap of ring buffer slots, ordered by the values stored in the slots
+struct SlotHeap {
+    int *slots;
+    int size;
+};
+
+// Statistics over the last window values of a stream, updated incrementally
+struct RollingStats {
+    int window;             // Maximum number of values in the window
+    double *ring;           // Ring buffer holding the values of the window
+    int head;               // Slot of the oldest value
+    int count;              // Number of values currently in the window
+    int numNaN;             // Number of NaN samples that were ignored
+    int numEvictions;       // Evictions since the mean and m2 were last recomputed from the ring
+    double mean;            // Mean of the window
+    double m2;              // Sum of squared deviations from the mean
+    struct SlotHeap low;    // Max-heap holding the lower half of the window
+    struct SlotHeap high;   // Min-heap holding the upper half of the window
+    int *heapPosition;      // Index of each slot in its heap
+    char *inLowHeap;        // Whether each slot is in the low heap
+    struct FrequencyTable frequencies; // Number of occurrences of each value in the window
+    int *countOfCounts;     // countOfCounts[c] is the number of distinct values occurring c times
+    int maxCount;           // Largest count of any value in the window
+};
+
+// Function to initialize rolling statistics over the last window values
+void initRollingStats(struct RollingStats *stats, int window);
+
+// Function to add a value to the window, evicting the oldest value when the window is full
+void addRollingValue(struct RollingStats *stats, double value);
+
+// Function to get the mean of the window
+double rollingMean(const struct RollingStats *stats);
+
+// Function to get the (population) standard deviation of the window
+double rollingStandardDeviation(const struct RollingStats *stats);
+
+// Function to get the median of the window
+double rollingMedian(const struct RollingStats *stats);
+
+// Function to get how often the most frequent value of the window occurs
+int rollingModeFrequency(const struct RollingStats *stats);
+
+// Function to calculate the mode(s) of the window, with the same rules as calculateMode
+double *rollingModes(const struct RollingStats *stats, int *numModes);
+
+// Function to release the memory held by rolling statistics
+void freeRollingStats(struct RollingStats *stats);
+
+#endif
@@ -1,39 +1,94 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <math.h>
+#include <string.h>
 #include <stdbool.h>
 
 #include "statsFunctions.h"
+#include "reductionKernels.h"
+
+
+/**
+ * @brief Prints one line for the geometric or harmonic mean.
+ *
+ * The value is followed by the number of invalid values that were skipped, or replaced by the reason
+ * the mean is undefined. Nothing extra is printed when all values were valid.
+ *
+ * @param label Label printed before the value.
+ * @param defined Whether the mean is defined.
+ * @param value Value of the mean.
+ * @param numInvalid Number of values the mean is undefined for (apart from NaN).
+ * @param invalidName Description of those values ("non-positive" or "zero").
+ * @param numNaN Number of NaN values.
+ * @param policy Policy the mean was computed with.
+ */
+static void printAlternativeMean(const char *label, int defined, double value, int numInvalid,
+                                 const char *invalidName, int numNaN, enum InvalidValuePolicy policy) {
+    printf("%s", label);
+    if (defined) {
+        printf("%.3f", value);
+        if (numInvalid + numNaN > 0 && policy == POLICY_SKIP) {
+            printf(" (skipped %d %s, %d NaN)", numInvalid, invalidName, numNaN);
+        }
+    } else if (numInvalid + numNaN > 0) {
+        printf("undefined (%d %s, %d NaN)", numInvalid, invalidName, numNaN);
+    } else {
+        printf("undefined (no values)");
+    }
+    printf("\n");
+}
 
 
 /**
  * @brief Prints the results of statistical analysis.
  *
  * This function prints various statistical results computed from the dataset, including the number of values,
- * mean, median, standard deviation, mode(s), geometric mean, harmonic mean, and unused array capacity.
+ * mean, median, standard deviation, geometric mean, harmonic mean, the requested percentiles, mode(s), unused
+ * array capacity and, if one was built, the histogram.
  * It formats the output neatly for readability.
  *
- * @param numVals Number of values in the dataset.
- * @param capacity Capacity of the array used to store the dataset.
- * @param mean Arithmetic mean of the dataset.
- * @param median Median of the dataset.
- * @param stddev Standard deviation of the dataset.
- * @param modes Pointer to an array containing the mode(s) of the dataset.
- * @param numModes Number of modes found in the dataset.
- * @param geometricMean Geometric mean of the dataset.
- * @param harmonicMean Harmonic mean of the dataset.
+ * @param results Pointer to the results of the run.
  */
-void printResults(int numVals, int capacity, double mean, double median, double stddev, double *modes, int numModes, double geometricMean, double harmonicMean) {
+void printResults(const struct StatsResults *results) {
+    const struct AlternativeMeans *means = &results->means;
+    const double *modes = results->modes;
+    int numModes = results->numModes;
+
     printf("Results:\n");
     printf("--------\n");
-    printf("Num values:            %d\n", numVals);
-    printf("      mean:        %.3f\n", mean);
-    printf("    median:        %.3f\n", median);
-    printf("    stddev:        %.3f\n", stddev);
-    printf("  geometric mean:  %.3f\n", geometricMean);
-    printf("  harmonic mean:   %.3f\n", harmonicMean);
-
-   if (modes == NULL || numModes == 0) {
+    printf("Num values:            %d\n", results->numVals);
+    if (results->dataType != NULL) {
+        printf("      type:        %s\n", results->dataType);
+    }
+    if (results->statistics & STAT_MEAN) {
+        printf("      mean:        %.3f\n", results->mean);
+    }
+    if (results->statistics & STAT_MEDIAN) {
+        printf("    median:        %.3f\n", results->median);
+    }
+    if (results->statistics & STAT_STDDEV) {
+        printf("    stddev:        %.3f\n", results->stddev);
+    }
+    if (results->statistics & STAT_GEOMETRIC) {
+        printAlternativeMean("  geometric mean:  ", means->geometricDefined, means->geometricMean,
+                             means->numNonPositive, "non-positive", means->numNaN, means->policy);
+    }
+    if (results->statistics & STAT_HARMONIC) {
+        printAlternativeMean("  harmonic mean:   ", means->harmonicDefined, means->harmonicMean,
+                             means->numZeros, "zero", means->numNaN, means->policy);
+    }
+
+    for (int i = 0; i < results->numQuantiles; i++) {
+        char label[32];
+        snprintf(label, sizeof(label), "p%g", results->probabilities[i] * 100.0);
+        printf("%10s:        %.3f\n", label, results->quantiles[i]);
+    }
+
+   if (results->heavyHitters != NULL) {
+    printHeavyHitters(results->heavyHitters);
+    } else if (!(results->statistics & STAT_MODE)) {
+    // The mode was not selected
+    } else if (modes == NULL || numModes == 0) {
     printf(" mode: No Mode Found\n");
     } else {
     printf(" mode(s):");
@@ -57,7 +112,11 @@ void printResults(int numVals, int capacity, double mean, double median, double
 
     printf("\n");
 }
-    printf("Unused array capacity: %d\n", capacity - numVals);
+    printf("Unused array capacity: %d\n", results->capacity - results->numVals);
+
+    if (results->histogram.numBins > 0) {
+        printHistogram(&results->histogram);
+    }
 }
 
 
@@ -68,7 +127,8 @@ void printResults(int numVals, int capacity, double mean, double median, double
  * This function calculates the standard deviation, which measures the amount of variation or dispersion
  * in a set of values. It first computes the squared differences between each value and the mean, sums
  * up these squared differences, and then divides the sum by the number of values to obtain the variance.
- * Finally, it takes the square root of the variance to get the standard deviation.
+ * Finally, it takes the square root of the variance to get the standard deviation. The sum is computed by
+ * the fastest reduction kernel the CPU supports (see reductionKernels.c).
  *
  * @param data Pointer to the array of doubleing-point values.
  * @param numVals Number of values in the array.
@@ -77,11 +137,8 @@ void printResults(int numVals, int capacity, double mean, double median, double
  * @return The standard deviation of the data.
  */
 double calculateStandardDeviation(const double *data, int numVals, double mean) {
-    double sum = 0.0; // Initialize sum variable to hold the total sum of squared differences
     // Calculate the sum of squared differences between each value and the mean
-    for (int i = 0; i < numVals; i++) {
-        sum += (data[i] - mean) * (data[i] - mean);
-    }
+    double sum = selectReductionKernels()->sumSquaredDeviations(data, numVals, mean);
     // Calculate the variance by dividing the sum of squared differences by the number of values
     double variance = sum / numVals;
     // Return the square root of the variance to get the standard deviation
@@ -94,38 +151,22 @@ double calculateStandardDeviation(const double *data, int numVals, double mean)
 /**
  * @brief Computes the median of the data.
  *
- * This function calculates the median, which is the middle value of a sorted array of doubleing-point values.
- * It first sorts the data array in ascending order using a bubble sort algorithm. Then, it determines the median
- * based on whether the number of values is even or odd. If the number of values is even, it averages the two middle
- * values. If the number of values is odd, it returns the middle value directly.
+ * This function calculates the median, which is the middle value of a sorted array of floating-point values.
+ * Instead of sorting the whole array, it selects the middle value(s) with the multi-selection of the quantile
+ * engine (see calculateQuantiles), in expected linear time. If the number of values is even, it averages the two
+ * middle values. If the number of values is odd, it returns the middle value directly.
+ * The data array is reordered in place.
  *
- * @param data Pointer to the array of doubleing-point values.
+ * @param data Pointer to the array of floating-point values.
  * @param numVals Number of values in the array.
  *
  * @return The median of the data.
  */
 double calculateMedian(double *data, int numVals) {
-    // Sort the data array using a bubble sort algorithm
-    for (int i = 0; i < numVals - 1; i++) {
-        for (int j = 0; j < numVals - i - 1; j++) {
-            if (data[j] > data[j + 1]) {
-                // Swap elements if they are out of order
-                double temp = data[j];
-                data[j] = data[j + 1];
-                data[j + 1] = temp;
-            }
-        }
-    }
-
-    if (numVals % 2 == 0) {
-        // If the number of values is even, average the two middle values
-        int middle1 = numVals / 2 - 1;
-        int middle2 = numVals / 2;
-        return (data[middle1] + data[middle2]) / 2.0;
-    } else {
-        // If the number of values is odd, return the middle value
-        return data[numVals / 2];
-    }
+    double probability = 0.5;
+    double median;
+    calculateQuantiles(data, numVals, &probability, 1, &median);
+    return median;
 }
 
 
@@ -157,17 +198,26 @@ bool allValuesUnique(const double *data, int numVals) {
     return true;
 }
 
+/**
+ * @brief Compares two doubles for qsort in ascending order.
+ */
+static int compareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
 /**
  * @brief Computes the mode(s) of the data.
  *
  * This function calculates the mode(s), which is the value(s) that occur most frequently in the dataset.
- * It iterates through the sorted array of doubleing-point values to find the mode(s). If all values in the dataset
+ * It iterates through the array of doubleing-point values to find the mode(s). If all values in the dataset
  * are unique or if the dataset is empty, it returns NULL and sets the number of modes to 0. Otherwise, it determines
  * the mode(s) by finding the longest streak of consecutive equal values. If multiple values have the same maximum
- * streak, they are all considered modes. The function returns an array containing the mode(s), along with the number
- * of modes found.
+ * streak, they are all considered modes. The function returns an array containing the mode(s) in ascending order,
+ * along with the number of modes found.
  *
- * @param data Pointer to the sorted array of doubleing-point values.
+ * @param data Pointer to the array of doubleing-point values.
  * @param numVals Number of values in the array.
  * @param numModes Pointer to an integer variable to store the number of modes found.
  *
@@ -253,6 +303,9 @@ double* calculateMode(const double* data, int numVals, int* numModes) {
         }
     }
 
+    // Report the modes in ascending order
+    qsort(modes, modeIndex, sizeof(double), compareDoubles);
+
     // Store the number of modes
     *numModes = modeIndex;
 
@@ -261,47 +314,298 @@ double* calculateMode(const double* data, int numVals, int* numModes) {
 }
 
 
+/**
+ * @brief Computes the mode(s) of data sorted in ascending order.
+ *
+ * Equal values are adjacent in sorted data, so every distinct value is one run and the frequencies
+ * are found in a single linear scan instead of comparing every pair of values. The same rules as
+ * calculateMode apply, including for NaN values, which equal nothing and so have a frequency of 0.
+ *
+ * @param data Pointer to the sorted array of floating-point values (NaNs may be at either end).
+ * @param numVals Number of values in the array.
+ * @param numModes Pointer to an integer variable to store the number of modes found.
+ *
+ * @return Pointer to the array containing the mode(s) in ascending order if mode(s) exist, NULL otherwise.
+ */
+double *calculateModeSorted(const double *data, int numVals, int *numModes) {
+    // Find the largest run length, and whether all runs (and NaNs, with frequency 0) are equally long
+    int maxCount = 0;
+    int numRuns = 0;
+    int numNaN = 0;
+    bool sameFrequency = true;
+    for (int i = 0; i < numVals;) {
+        if (isnan(data[i])) {
+            numNaN++;
+            i++;
+            continue;
+        }
+        int end = i + 1;
+        while (end < numVals && data[end] == data[i]) {
+            end++;
+        }
+        int count = end - i;
+        if (numRuns > 0 && count != maxCount) {
+            sameFrequency = false;
+        }
+        maxCount = (count > maxCount) ? count : maxCount;
+        numRuns++;
+        i = end;
+    }
+    if (numNaN > 0 && numRuns > 0) {
+        sameFrequency = false;
+    }
+
+    if (numRuns == 0 || sameFrequency) {
+        *numModes = 0;
+        return NULL;
+    }
+
+    // Collect the values of the longest runs
+    double *modes = (double *)malloc(sizeof(double) * numRuns);
+    if (modes == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    int modeIndex = 0;
+    for (int i = 0; i < numVals;) {
+        if (isnan(data[i])) {
+            i++;
+            continue;
+        }
+        int end = i + 1;
+        while (end < numVals && data[end] == data[i]) {
+            end++;
+        }
+        if (end - i == maxCount) {
+            modes[modeIndex++] = data[i];
+        }
+        i = end;
+    }
+
+    *numModes = modeIndex;
+    return modes;
+}
+
+
 
 
 /**
- * @brief Computes the geometric mean of the data.
+ * @brief Accumulates the harmonic mean terms of a block without the reduction kernels.
  *
- * This function calculates the geometric mean, which is the nth root of the product of all values
- * in the dataset, where n is the number of values. It first checks if the dataset is empty, in which
- * case the geometric mean is undefined and returns 0. It then calculates the product of all positive
- * values in the dataset and checks if any value is non-positive, in which case the geometric mean is
- * undefined and returns 0. Finally, it computes the nth root of the product to obtain the geometric mean.
+ * This is the fallback for blocks whose plain sum of reciprocals is not finite: NaN values are left out
+ * and counted, and reciprocals of values smaller in magnitude than RECIPROCAL_TINY (which may overflow)
+ * are accumulated scaled by RECIPROCAL_TINY in a separate sum.
  *
- * @param data Pointer to the array of doubleing-point values.
+ * @return The number of NaN values in the block.
+ */
+static int accumulateReciprocalsCarefully(const double *data, int numVals, struct MeanTerms *terms) {
+    int numNonZero = 0, numNaN = 0;
+    for (int i = 0; i < numVals; i++) {
+        double value = data[i];
+        int isNaN = (value != value);
+        int isNonZero = (value != 0.0) & !isNaN;
+        int isTiny = isNonZero & (fabs(value) < RECIPROCAL_TINY);
+        numNaN += isNaN;
+        numNonZero += isNonZero;
+        // Tiny values are scaled up before taking the reciprocal, so it stays finite
+        double reciprocal = isNonZero ? 1.0 / (isTiny ? value / RECIPROCAL_TINY : value) : 0.0;
+        kahanAdd(isTiny ? &terms->tinyReciprocalSum : &terms->reciprocalSum,
+                 isTiny ? &terms->tinyReciprocalComp : &terms->reciprocalComp, reciprocal);
+    }
+    terms->numNonZero += numNonZero;
+    terms->numZeros += numVals - numNonZero - numNaN;
+    return numNaN;
+}
+
+
+/**
+ * @brief Accumulates the terms of the geometric and/or harmonic mean of a block of data.
+ *
+ * The sum of reciprocals runs in the sumReciprocals reduction kernel (independent compensated lanes,
+ * vectorized where the CPU allows) and is merged into the running compensated sum. A NaN value, or a
+ * reciprocal sum that overflows because of values close to zero, makes the kernel's result non-finite;
+ * only then is the block summed again value by value, with NaNs left out and tiny values scaled.
+ * The log-sum is a plain compensated loop over log(x) of the positive values, and is skipped unless the
+ * geometric mean is selected. The terms are added to the existing contents of terms, so blocks of data
+ * can be accumulated one after another; initialize terms to all zeros before the first block. Only the
+ * counts of the selected means are updated (numNaN always is).
+ *
+ * @param data Pointer to the array of floating-point values.
  * @param numVals Number of values in the array.
+ * @param statistics STAT_GEOMETRIC and/or STAT_HARMONIC: the means whose terms are wanted.
+ * @param terms Pointer to the terms to add to.
+ */
+void accumulateMeanTerms(const double *data, int numVals, unsigned int statistics, struct MeanTerms *terms) {
+    int numNaN = 0;
+
+    if (statistics & STAT_HARMONIC) {
+        int numZeros;
+        double sum = selectReductionKernels()->sumReciprocals(data, numVals, &numZeros);
+        if (isfinite(sum)) {
+            // A NaN would have made the sum NaN, so every non-zero value contributed
+            kahanAdd(&terms->reciprocalSum, &terms->reciprocalComp, sum);
+            terms->numZeros += numZeros;
+            terms->numNonZero += numVals - numZeros;
+        } else {
+            numNaN = accumulateReciprocalsCarefully(data, numVals, terms);
+        }
+    }
+
+    if (statistics & STAT_GEOMETRIC) {
+        double logSum = terms->logSum, logComp = terms->logComp;
+        int numPositive = 0;
+        numNaN = 0;
+        for (int i = 0; i < numVals; i++) {
+            double value = data[i];
+            int isPositive = (value > 0.0);
+            numNaN += (value != value);
+            numPositive += isPositive;
+            kahanAdd(&logSum, &logComp, log(isPositive ? value : 1.0));
+        }
+        terms->logSum = logSum;
+        terms->logComp = logComp;
+        terms->numPositive += numPositive;
+        terms->numNonPositive += numVals - numPositive - numNaN;
+    }
+
+    terms->numNaN += numNaN;
+}
+
+
+/**
+ * @brief Merges the mean terms of another block of data.
  *
- * @return The geometric mean of the data.
+ * @param into Pointer to the terms that receive the merged values.
+ * @param from Pointer to the terms of the other block.
  */
-double calculateGeometricMean(const double *data, int numVals) {
-    // Check if the dataset is empty
-    if (numVals == 0) {
-        return 0; // Geometric mean is undefined for an empty set
+void mergeMeanTerms(struct MeanTerms *into, const struct MeanTerms *from) {
+    kahanAdd(&into->logSum, &into->logComp, from->logSum);
+    kahanAdd(&into->logSum, &into->logComp, -from->logComp);
+    kahanAdd(&into->reciprocalSum, &into->reciprocalComp, from->reciprocalSum);
+    kahanAdd(&into->reciprocalSum, &into->reciprocalComp, -from->reciprocalComp);
+    kahanAdd(&into->tinyReciprocalSum, &into->tinyReciprocalComp, from->tinyReciprocalSum);
+    kahanAdd(&into->tinyReciprocalSum, &into->tinyReciprocalComp, -from->tinyReciprocalComp);
+    into->numPositive += from->numPositive;
+    into->numNonZero += from->numNonZero;
+    into->numNonPositive += from->numNonPositive;
+    into->numZeros += from->numZeros;
+    into->numNaN += from->numNaN;
+}
+
+
+/**
+ * @brief Computes the geometric and harmonic means from accumulated terms.
+ *
+ * The geometric mean is exp(logSum / count) and the harmonic mean is count / reciprocalSum, where count
+ * is the number of values each mean is defined for. The policy decides what happens if invalid values
+ * were seen: POLICY_REJECT marks the affected mean as undefined, POLICY_SKIP computes it over the valid
+ * values only, and POLICY_ERROR fails. The counts of invalid values are always reported in means.
+ * If the scaled sum of tiny reciprocals is non-zero, the harmonic mean is computed in the scaled domain
+ * so that neither the reciprocal sum nor the result overflows.
+ *
+ * @param terms Pointer to the accumulated terms.
+ * @param policy How values the means are undefined for are treated.
+ * @param means Pointer to the structure that receives the means and counts.
+ *
+ * @return 0 on success, -1 if the policy is POLICY_ERROR and invalid values were seen.
+ */
+int finalizeAlternativeMeans(const struct MeanTerms *terms, enum InvalidValuePolicy policy,
+                             struct AlternativeMeans *means) {
+    means->policy = policy;
+    means->numNonPositive = terms->numNonPositive;
+    means->numZeros = terms->numZeros;
+    means->numNaN = terms->numNaN;
+    means->geometricMean = 0;
+    means->harmonicMean = 0;
+
+    int geometricInvalid = terms->numNonPositive + terms->numNaN;
+    int harmonicInvalid = terms->numZeros + terms->numNaN;
+    if (policy == POLICY_ERROR && (geometricInvalid > 0 || harmonicInvalid > 0)) {
+        means->geometricDefined = 0;
+        means->harmonicDefined = 0;
+        return -1;
     }
 
-    // Calculate the sum of logarithms of positive values
-    double logSum = 0.0;
-    int numPositiveVals = 0;
+    means->geometricDefined = terms->numPositive > 0 && (policy == POLICY_SKIP || geometricInvalid == 0);
+    means->harmonicDefined = terms->numNonZero > 0 && (policy == POLICY_SKIP || harmonicInvalid == 0);
 
-    for (int i = 0; i < numVals; i++) {
-        // Check if any value is non-positive
-        if (data[i] <= 0) {
-            // Geometric mean is undefined for non-positive values
-            return 0;
+    if (means->geometricDefined) {
+        means->geometricMean = exp((terms->logSum - terms->logComp) / terms->numPositive);
+    }
+    if (means->harmonicDefined) {
+        double reciprocalSum = terms->reciprocalSum - terms->reciprocalComp;
+        double tinySum = terms->tinyReciprocalSum - terms->tinyReciprocalComp;
+        if (tinySum == 0.0) {
+            means->harmonicMean = terms->numNonZero / reciprocalSum;
+        } else {
+            // count / (reciprocalSum + tinySum / RECIPROCAL_TINY), evaluated with both sides scaled
+            means->harmonicMean = (terms->numNonZero * RECIPROCAL_TINY) / (reciprocalSum * RECIPROCAL_TINY + tinySum);
         }
+    }
+    return 0;
+}
+
+
+/**
+ * @brief Computes the geometric and harmonic means of the data in one pass.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ * @param policy How values the means are undefined for are treated.
+ * @param means Pointer to the structure that receives the means and the counts of invalid values.
+ *
+ * @return 0 on success, -1 if the policy is POLICY_ERROR and invalid values were seen.
+ */
+int calculateAlternativeMeans(const double *data, int numVals, enum InvalidValuePolicy policy,
+                              struct AlternativeMeans *means) {
+    struct MeanTerms terms = {0};
+    accumulateMeanTerms(data, numVals, STAT_GEOMETRIC | STAT_HARMONIC, &terms);
+    return finalizeAlternativeMeans(&terms, policy, means);
+}
+
 
-        logSum += log(data[i]);
-        numPositiveVals++;
+/**
+ * @brief Parses the name of an invalid value policy.
+ *
+ * @param name Policy name: "reject", "skip" or "error".
+ * @param policy Pointer to the variable that receives the policy.
+ *
+ * @return 0 if the name is known, -1 otherwise.
+ */
+int parseInvalidValuePolicy(const char *name, enum InvalidValuePolicy *policy) {
+    if (strcmp(name, "reject") == 0) {
+        *policy = POLICY_REJECT;
+    } else if (strcmp(name, "skip") == 0) {
+        *policy = POLICY_SKIP;
+    } else if (strcmp(name, "error") == 0) {
+        *policy = POLICY_ERROR;
+    } else {
+        return -1;
     }
+    return 0;
+}
 
-    // Calculate the geometric mean using the sum of logarithms
-    double geometricMean = exp(logSum / numPositiveVals);
 
-    return geometricMean;
+/**
+ * @brief Computes the geometric mean of the data.
+ *
+ * This function calculates the geometric mean, which is the nth root of the product of all values
+ * in the dataset, where n is the number of values. It is computed in log space, without the
+ * reciprocal pass of the harmonic mean (calculateAlternativeMeans computes both in one call). If
+ * the dataset is empty or any value is non-positive, the geometric mean is undefined and 0 is
+ * returned.
+ *
+ * @param data Pointer to the array of floating-point values.
+ * @param numVals Number of values in the array.
+ *
+ * @return The geometric mean of the data.
+ */
+double calculateGeometricMean(const double *data, int numVals) {
+    struct MeanTerms terms = {0};
+    struct AlternativeMeans means;
+    accumulateMeanTerms(data, numVals, STAT_GEOMETRIC, &terms);
+    finalizeAlternativeMeans(&terms, POLICY_REJECT, &means);
+    return means.geometricMean;
 }
 
 
@@ -309,36 +613,21 @@ double calculateGeometricMean(const double *data, int numVals) {
  * @brief Computes the harmonic mean of the data.
  *
  * This function calculates the harmonic mean, which is the reciprocal of the arithmetic mean of
- * the reciprocals of the values in the dataset. It first checks if the dataset is empty, in which
- * case the harmonic mean is undefined and returns 0. It then calculates the sum of reciprocals of
- * all non-zero values in the dataset and checks if any value is zero, in which case the harmonic mean
- * is undefined and returns 0. Finally, it divides the number of values by the sum of reciprocals to
- * obtain the harmonic mean.
+ * the reciprocals of the values in the dataset, without the log pass of the geometric mean
+ * (calculateAlternativeMeans computes both in one call). If the dataset is
+ * empty or any value is zero, the harmonic mean is undefined and 0 is returned.
  *
- * @param data Pointer to the array of doubleing-point values.
+ * @param data Pointer to the array of floating-point values.
  * @param numVals Number of values in the array.
  *
  * @return The harmonic mean of the data.
  */
 double calculateHarmonicMean(const double *data, int numVals) {
-    // Check if the dataset is empty
-    if (numVals == 0) {
-        return 0;  // Harmonic mean is undefined for an empty set
-    }
-
-    // Calculate the sum of reciprocals of non-zero values
-    double reciprocal_sum = 0.0;
-    for (int i = 0; i < numVals; i++) {
-        // Check if any value is zero
-        if (data[i] == 0) {
-            // Harmonic mean is undefined if any value is zero
-            return 0;
-        }
-        reciprocal_sum += 1.0 / data[i];
-    }
-
-    // Calculate the harmonic mean
-    return numVals / reciprocal_sum;
+    struct MeanTerms terms = {0};
+    struct AlternativeMeans means;
+    accumulateMeanTerms(data, numVals, STAT_HARMONIC, &terms);
+    finalizeAlternativeMeans(&terms, POLICY_REJECT, &means);
+    return means.harmonicMean;
 }
 
 
@@ -346,8 +635,8 @@ double calculateHarmonicMean(const double *data, int numVals) {
  * @brief Computes the mean of the data.
  *
  * This function calculates the arithmetic mean (average) of the provided array of doubleing-point values.
- * It iterates through the array, sums up all the values, and divides the total sum by the number of values
- * to obtain the mean.
+ * It sums up all the values with the fastest reduction kernel the CPU supports, and divides the total sum
+ * by the number of values to obtain the mean.
  *
  * @param data Pointer to the array of doubleing-point values.
  * @param numVals Number of values in the array.
@@ -355,10 +644,7 @@ double calculateHarmonicMean(const double *data, int numVals) {
  * @return The mean of the data.
  */
 double calculateMean(const double *data, int numVals) {
-    double sum = 0.0; // Initialize sum variable to hold the total sum of values
-    for (int i = 0; i < numVals; i++) {
-        sum += data[i]; // Add each value to the sum
-    }
+    double sum = selectReductionKernels()->sum(data, numVals); // Compensated sum of all values
     return sum / numVals; // Return the mean by dividing the sum by the number of values
 }
 
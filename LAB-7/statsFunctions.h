@@ -1,6 +1,90 @@
 #ifndef STATSFUNCTION_H
 #define STATSFUNCTION_H
 
+#include "quantiles.h"
+#include "heavyHitters.h"
+
+// How the geometric and harmonic means treat values they are undefined for
+enum InvalidValuePolicy {
+    POLICY_REJECT,  // Report the mean as undefined if any value is invalid
+    POLICY_SKIP,    // Leave invalid values out of the mean
+    POLICY_ERROR    // Treat any invalid value as a fatal input error
+};
+
+// Statistics that can be selected for a run (bit flags)
+enum Statistic {
+    STAT_MEAN = 1 << 0,
+    STAT_STDDEV = 1 << 1,
+    STAT_MEDIAN = 1 << 2,
+    STAT_MODE = 1 << 3,
+    STAT_GEOMETRIC = 1 << 4,
+    STAT_HARMONIC = 1 << 5,
+    STAT_ALL = (1 << 6) - 1
+};
+
+// Values with a magnitude below this have their reciprocals accumulated in scaled form (1/x would overflow)
+#define RECIPROCAL_TINY 0x1p-512
+
+// Running terms of the geometric and harmonic means; terms of disjoint blocks can be merged
+struct MeanTerms {
+    double logSum;              // Compensated sum of log(x) over the positive values
+    double logComp;             // Compensation term of logSum
+    double reciprocalSum;       // Compensated sum of 1/x over the non-zero values with |x| >= RECIPROCAL_TINY
+    double reciprocalComp;      // Compensation term of reciprocalSum
+    double tinyReciprocalSum;   // Sum of RECIPROCAL_TINY/x over the values with 0 < |x| < RECIPROCAL_TINY
+    double tinyReciprocalComp;  // Compensation term of tinyReciprocalSum
+    int numPositive;            // Values the geometric mean is defined for
+    int numNonZero;             // Values the harmonic mean is defined for
+    int numNonPositive;         // Values <= 0 (invalid for the geometric mean)
+    int numZeros;               // Values == 0 (invalid for the harmonic mean)
+    int numNaN;                 // NaN values (invalid for both means)
+};
+
+// Geometric and harmonic means together with the number of invalid values they encountered
+struct AlternativeMeans {
+    double geometricMean;
+    double harmonicMean;
+    int geometricDefined;       // 0 if the geometric mean is undefined (no valid values, or rejected)
+    int harmonicDefined;        // 0 if the harmonic mean is undefined (no valid values, or rejected)
+    int numNonPositive;
+    int numZeros;
+    int numNaN;
+    enum InvalidValuePolicy policy;
+};
+
+// Wall-clock seconds spent in each stage of a run (0 for stages that did not run)
+struct StageTimings {
+    double parse;       // Reading and parsing the input
+    double moments;     // Mean and standard deviation
+    double means;       // Geometric and harmonic mean
+    double sort;        // Sort shared by the mode and the order statistics
+    double median;      // Median and percentiles
+    double mode;        // Mode(s), exact or estimated
+    double histogram;
+    double compute;     // All statistics (the only stage the parallel and typed engines report)
+};
+
+// All results of a run, as printed by printResults
+struct StatsResults {
+    unsigned int statistics;        // STAT_* flags of the statistics to print
+    int numVals;
+    int capacity;
+    double mean;
+    double median;
+    double stddev;
+    double *modes;                  // NULL if no mode
+    int numModes;
+    struct AlternativeMeans means;
+    const double *probabilities;    // Requested quantile probabilities (NULL if none)
+    double *quantiles;              // One quantile per requested probability
+    int numQuantiles;
+    struct Histogram histogram;     // numBins is 0 if no histogram was requested
+    const char *dataType;           // Storage type of a typed dataset (NULL for plain doubles)
+    const struct HeavyHitters *heavyHitters; // Replaces the exact modes if not NULL
+    struct StageTimings timings;
+    long peakRssKilobytes;          // Peak resident set size, -1 if not reported
+};
+
 // Function to calculate the mean of a dataset
 double calculateMean(const double *dataArray, int numVals);
 
@@ -13,13 +97,33 @@ double calculateStandardDeviation(const double *dataArray, int numVals, double m
 // Function to calculate the mode(s) of a dataset
 double *calculateMode(const double *dataArray, int numVals, int *numModes);
 
+// Function to calculate the mode(s) of a dataset sorted in ascending order
+double *calculateModeSorted(const double *dataArray, int numVals, int *numModes);
+
 // Function to calculate the geometric mean of a dataset
 double calculateGeometricMean(const double *dataArray, int numVals);
 
 // Function to calculate the harmonic mean of a dataset
 double calculateHarmonicMean(const double *dataArray, int numVals);
 
+// Function to accumulate the terms of the selected means (STAT_GEOMETRIC and/or STAT_HARMONIC) of a dataset
+void accumulateMeanTerms(const double *dataArray, int numVals, unsigned int statistics, struct MeanTerms *terms);
+
+// Function to merge the mean terms of another block of data
+void mergeMeanTerms(struct MeanTerms *into, const struct MeanTerms *from);
+
+// Function to compute the geometric and harmonic means from accumulated terms (returns -1 on a policy error)
+int finalizeAlternativeMeans(const struct MeanTerms *terms, enum InvalidValuePolicy policy,
+                             struct AlternativeMeans *means);
+
+// Function to calculate the geometric and harmonic means of a dataset in one pass (returns -1 on a policy error)
+int calculateAlternativeMeans(const double *dataArray, int numVals, enum InvalidValuePolicy policy,
+                              struct AlternativeMeans *means);
+
+// Function to parse a policy name ("reject", "skip" or "error"), returns -1 if unknown
+int parseInvalidValuePolicy(const char *name, enum InvalidValuePolicy *policy);
+
 // Function to print out the results of statistical calculations
-void printResults(int numVals, int capacity, double mean, double median, double stddev, double *modes, int numModes, double geometricMean, double harmonicMean);
+void printResults(const struct StatsResults *results);
 
 #endif
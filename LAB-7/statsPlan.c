@@ -0,0 +1,200 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "statsPlan.h"
+#include "readFile.h"
+#include "profiler.h"
+
+/*
+ * The planner turns a selection of statistics into the passes over the data that produce them, so a
+ * run pays only for what it reports:
+ *  - the standard deviation reuses the mean pass instead of summing the values again;
+ *  - the geometric and harmonic means share one call, which only runs the log pass for the geometric
+ *    mean and sums the reciprocals with the reduction kernels;
+ *  - the median and the percentiles are found by one multi-selection, unless the modes are selected
+ *    too, in which case one radix sort serves all of them: modes are the longest runs of equal values
+ *    of the sorted data, and every quantile is read directly from it.
+ */
+
+// Names accepted by parseStatisticList, in the order of the STAT_* flags
+static const char *const STATISTIC_NAMES[] = {"mean", "stddev", "median", "mode", "geometric", "harmonic"};
+#define NUM_STATISTICS ((int)(sizeof(STATISTIC_NAMES) / sizeof(STATISTIC_NAMES[0])))
+
+
+/**
+ * @brief Parses a comma-separated list of statistic names.
+ *
+ * The names are mean, stddev, median, mode, geometric, harmonic and all.
+ *
+ * @param list List such as "mean,stddev".
+ * @param statistics Pointer to the variable that receives the STAT_* flags.
+ *
+ * @return 0 on success, -1 if the list is empty or a name is unknown.
+ */
+int parseStatisticList(const char *list, unsigned int *statistics) {
+    unsigned int selected = 0;
+    const char *cursor = list;
+    while (1) {
+        size_t length = strcspn(cursor, ",");
+        if (length == 3 && strncmp(cursor, "all", 3) == 0) {
+            selected |= STAT_ALL;
+        } else {
+            int found = 0;
+            for (int i = 0; i < NUM_STATISTICS; i++) {
+                if (strlen(STATISTIC_NAMES[i]) == length && strncmp(cursor, STATISTIC_NAMES[i], length) == 0) {
+                    selected |= 1u << i;
+                    found = 1;
+                }
+            }
+            if (!found) {
+                return -1;
+            }
+        }
+        if (cursor[length] == '\0') {
+            break;
+        }
+        cursor += length + 1;
+    }
+    *statistics = selected;
+    return 0;
+}
+
+
+/**
+ * @brief Plans the passes over the data for a selection of statistics.
+ *
+ * @param statistics STAT_* flags of the selected statistics.
+ * @param numPercentiles Number of requested percentiles (computed in addition to the selection).
+ * @param exactModes 0 if the modes are estimated elsewhere (e.g. by a heavy-hitters sketch).
+ * @param plan Pointer to the plan to fill in.
+ */
+void planStatistics(unsigned int statistics, int numPercentiles, int exactModes, struct StatsPlan *plan) {
+    plan->statistics = statistics;
+    plan->numPercentiles = numPercentiles;
+    plan->meanPass = (statistics & (STAT_MEAN | STAT_STDDEV)) != 0;
+    plan->deviationPass = (statistics & STAT_STDDEV) != 0;
+    plan->meanTermsPass = (statistics & (STAT_GEOMETRIC | STAT_HARMONIC)) != 0;
+    if (exactModes && (statistics & STAT_MODE)) {
+        plan->orderPass = ORDER_SORT;
+    } else if ((statistics & STAT_MEDIAN) || numPercentiles > 0) {
+        plan->orderPass = ORDER_SELECT;
+    } else {
+        plan->orderPass = ORDER_NONE;
+    }
+}
+
+
+/**
+ * @brief Prints the passes of a plan, one per line.
+ *
+ * @param plan Pointer to the plan.
+ * @param stream Stream to print to.
+ */
+void printStatsPlan(const struct StatsPlan *plan, FILE *stream) {
+    fprintf(stream, "Plan:\n");
+    if (plan->meanPass) {
+        fprintf(stream, "  sum pass                  -> mean\n");
+    }
+    if (plan->deviationPass) {
+        fprintf(stream, "  squared deviation pass    -> stddev (reuses the mean)\n");
+    }
+    if (plan->meanTermsPass) {
+        if (plan->statistics & STAT_GEOMETRIC) {
+            fprintf(stream, "  log pass                  -> geometric mean\n");
+        }
+        if (plan->statistics & STAT_HARMONIC) {
+            fprintf(stream, "  reciprocal pass (kernel)  -> harmonic mean\n");
+        }
+    }
+    if (plan->orderPass == ORDER_SORT) {
+        fprintf(stream, "  radix sort + run scan     -> mode(s)%s%s\n",
+                (plan->statistics & STAT_MEDIAN) ? ", median" : "",
+                (plan->numPercentiles > 0) ? ", percentiles" : "");
+    } else if (plan->orderPass == ORDER_SELECT) {
+        fprintf(stream, "  multi-selection           -> %s%s\n",
+                (plan->statistics & STAT_MEDIAN) ? "median" : "percentiles",
+                ((plan->statistics & STAT_MEDIAN) && plan->numPercentiles > 0) ? ", percentiles" : "");
+    }
+}
+
+
+/**
+ * @brief Runs a plan over a dataset.
+ *
+ * results->probabilities and results->quantiles must hold room for plan->numPercentiles quantiles
+ * followed by the median (probability 0.5), as main sets them up. Only the fields of the selected
+ * statistics are written, and the time of every pass is stored in results->timings. Under
+ * POLICY_ERROR, only values invalid for a selected mean are an error.
+ *
+ * @param plan Pointer to the plan.
+ * @param data Pointer to the array of floating-point values (reordered or sorted in place).
+ * @param numVals Number of values in the array (must be positive).
+ * @param policy How values the geometric and harmonic means are undefined for are treated.
+ * @param results Pointer to the results to fill in.
+ *
+ * @return 0 on success, -1 if the policy is POLICY_ERROR and invalid values were seen.
+ */
+int executeStatsPlan(const struct StatsPlan *plan, double *data, int numVals, enum InvalidValuePolicy policy,
+                     struct StatsResults *results) {
+    int status = 0;
+    results->statistics = plan->statistics;
+
+    struct StageTimings *timings = &results->timings;
+
+    // Passes that do not depend on the order of the values come first, since the order pass reorders them
+    double start = monotonicSeconds();
+    profileBegin("mean/stddev");
+    if (plan->meanPass) {
+        results->mean = calculateMean(data, numVals);
+    }
+    if (plan->deviationPass) {
+        results->stddev = calculateStandardDeviation(data, numVals, results->mean);
+    }
+    profileEnd();
+    timings->moments = monotonicSeconds() - start;
+
+    start = monotonicSeconds();
+    profileBegin("geometric/harmonic");
+    if (plan->meanTermsPass) {
+        struct MeanTerms terms = {0};
+        // Only the selected means are accumulated, so values only invalid for the other one are not
+        // counted against the policy
+        accumulateMeanTerms(data, numVals, plan->statistics & (STAT_GEOMETRIC | STAT_HARMONIC), &terms);
+        status = finalizeAlternativeMeans(&terms, policy, &results->means);
+    }
+    profileEnd();
+    timings->means = monotonicSeconds() - start;
+
+    // The median is one more quantile after the requested percentiles
+    int numOrderStatistics = plan->numPercentiles + ((plan->statistics & STAT_MEDIAN) ? 1 : 0);
+    if (plan->orderPass == ORDER_SORT) {
+        start = monotonicSeconds();
+        profileBegin("sort");
+        sortValues(data, numVals);
+        profileEnd();
+        timings->sort = monotonicSeconds() - start;
+
+        start = monotonicSeconds();
+        profileBegin("mode");
+        results->modes = calculateModeSorted(data, numVals, &results->numModes);
+        profileEnd();
+        timings->mode = monotonicSeconds() - start;
+
+        start = monotonicSeconds();
+        profileBegin("median/percentiles");
+        quantilesOfSortedData(data, numVals, results->probabilities, numOrderStatistics, results->quantiles);
+        profileEnd();
+        timings->median = monotonicSeconds() - start;
+    } else if (plan->orderPass == ORDER_SELECT) {
+        start = monotonicSeconds();
+        profileBegin("median/percentiles");
+        calculateQuantiles(data, numVals, results->probabilities, numOrderStatistics, results->quantiles);
+        profileEnd();
+        timings->median = monotonicSeconds() - start;
+    }
+    if (plan->statistics & STAT_MEDIAN) {
+        results->median = results->quantiles[plan->numPercentiles];
+    }
+    return status;
+}
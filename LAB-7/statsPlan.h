@@ -0,0 +1,38 @@
+#ifndef STATSPLAN_H
+#define STATSPLAN_H
+
+#include <stdio.h>
+
+#include "statsFunctions.h"
+
+// How the order statistics (median, percentiles, modes) are found
+enum OrderPass {
+    ORDER_NONE,     // No order statistic is needed
+    ORDER_SELECT,   // Median and percentiles by one multi-selection, in expected linear time
+    ORDER_SORT      // One radix sort shared by the modes, the median and the percentiles
+};
+
+// Passes over the data needed for a selection of statistics
+struct StatsPlan {
+    unsigned int statistics;    // Selected STAT_* flags
+    int numPercentiles;         // Number of requested percentiles
+    int meanPass;               // Sum of the values (needed by the mean and the standard deviation)
+    int deviationPass;          // Squared deviations from the mean
+    int meanTermsPass;          // Logarithms and reciprocals of the geometric and harmonic means
+    enum OrderPass orderPass;
+};
+
+// Function to parse a comma-separated list of statistic names into STAT_* flags, returns -1 if a name is unknown
+int parseStatisticList(const char *list, unsigned int *statistics);
+
+// Function to plan the passes for the selected statistics and percentiles
+void planStatistics(unsigned int statistics, int numPercentiles, int exactModes, struct StatsPlan *plan);
+
+// Function to print the passes of a plan to a stream
+void printStatsPlan(const struct StatsPlan *plan, FILE *stream);
+
+// Function to run a plan over a dataset (reordered in place) and store the results; returns -1 on a policy error
+int executeStatsPlan(const struct StatsPlan *plan, double *dataArray, int numVals, enum InvalidValuePolicy policy,
+                     struct StatsResults *results);
+
+#endif
@@ -0,0 +1,37 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include "readFile.h"
+#include "binaryData.h"
+
+/**
+ * @brief Converts a text data file into a binary data file.
+ *
+ * This program reads the floating-point values of a text file (the input format of basicstats) and
+ * writes them to a binary data file: a small header followed by packed little-endian doubles (see
+ * binaryData.h). basicstats recognizes binary data files and memory-maps them instead of parsing
+ * them, so repeated runs over the same large dataset skip the text parsing entirely.
+ *
+ * @param argc Number of command-line arguments.
+ * @param argv Array of command-line argument strings.
+ * @return 0 upon successful conversion, 1 otherwise.
+ */
+int main(int argc, char *argv[]) {
+    // Check if the correct number of arguments are provided
+    if (argc != 3) {
+        printf("Usage: %s <input_text_file> <output_binary_file>\n", argv[0]);
+        return 1;
+    }
+
+    int numVals, cap;
+    double *data = readDataFromFile(argv[1], &numVals, &cap);
+
+    if (writeBinaryDataFile(argv[2], data, numVals) != 0) {
+        perror("Error writing binary data file");
+        releaseData(data);
+        return 1;
+    }
+
+    printf("Wrote %d values to %s\n", numVals, argv[2]);
+    releaseData(data);
+    return 0;
+}
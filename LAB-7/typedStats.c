@@ -0,0 +1,538 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <math.h>
+
+#include "typedStats.h"
+#include "reductionKernels.h"
+#include "frequencyTable.h"
+
+/*
+ * Statistics for datasets that were parsed as integers (int32 or int64) or narrowed to float32.
+ * Sums of integers are exact. Everything that needs doubles (standard deviation, geometric and
+ * harmonic means, floating-point sums) converts the data block by block into a small buffer that
+ * stays in L1 cache and runs the regular double kernels on it, so float32 data only streams half
+ * as many bytes from memory as double data. Integer data with a small range gets its median,
+ * quantiles and modes from a counting sort; other data uses radix selection on order-preserving
+ * keys, which never reorders the data.
+ */
+
+// Number of values converted to double at a time
+#define CONVERT_BLOCK_SIZE 2048
+
+// Number of bits of the key resolved by each pass of the radix selection
+#define SELECT_DIGIT_BITS 16
+#define SELECT_BUCKETS (1 << SELECT_DIGIT_BITS)
+
+
+/**
+ * @brief Converts values [begin, begin + count) of a typed dataset to doubles.
+ */
+static void convertBlock(const struct TypedData *data, int begin, int count, double *out) {
+    switch (data->type) {
+        case DATA_FLOAT32: {
+            const float *values = (const float *)data->values + begin;
+            for (int i = 0; i < count; i++) {
+                out[i] = values[i];
+            }
+            break;
+        }
+        case DATA_INT32: {
+            const int32_t *values = (const int32_t *)data->values + begin;
+            for (int i = 0; i < count; i++) {
+                out[i] = values[i];
+            }
+            break;
+        }
+        case DATA_INT64: {
+            const int64_t *values = (const int64_t *)data->values + begin;
+            for (int i = 0; i < count; i++) {
+                out[i] = (double)values[i];
+            }
+            break;
+        }
+        default:
+            memcpy(out, (const double *)data->values + begin, sizeof(double) * count);
+            break;
+    }
+}
+
+
+/**
+ * @brief Computes the mean of a typed dataset.
+ *
+ * Integer sums are exact: int32 values are summed in 64 bits (which cannot overflow for fewer than
+ * 2^32 values), int64 values in 128 bits where the compiler supports it. Float32 values are summed
+ * block by block with the compensated double kernels.
+ */
+static double typedMean(const struct TypedData *data) {
+    int numVals = data->numVals;
+    switch (data->type) {
+        case DATA_INT32: {
+            const int32_t *values = (const int32_t *)data->values;
+            int64_t sum = 0;
+            for (int i = 0; i < numVals; i++) {
+                sum += values[i];
+            }
+            return (double)sum / numVals;
+        }
+        case DATA_INT64: {
+            const int64_t *values = (const int64_t *)data->values;
+#ifdef __SIZEOF_INT128__
+            __int128 sum = 0;
+            for (int i = 0; i < numVals; i++) {
+                sum += values[i];
+            }
+            // Split the exact sum into quotient and remainder so the division loses nothing before rounding
+            __int128 quotient = sum / numVals;
+            __int128 remainder = sum % numVals;
+            return (double)quotient + (double)remainder / numVals;
+#else
+            long double sum = 0;
+            for (int i = 0; i < numVals; i++) {
+                sum += values[i];
+            }
+            return (double)(sum / numVals);
+#endif
+        }
+        default: {
+            const struct ReductionKernels *kernels = selectReductionKernels();
+            double block[CONVERT_BLOCK_SIZE];
+            double sum = 0.0, comp = 0.0;
+            for (int begin = 0; begin < numVals; begin += CONVERT_BLOCK_SIZE) {
+                int count = (numVals - begin < CONVERT_BLOCK_SIZE) ? numVals - begin : CONVERT_BLOCK_SIZE;
+                convertBlock(data, begin, count, block);
+                kahanAdd(&sum, &comp, kernels->sum(block, count));
+            }
+            return (sum - comp) / numVals;
+        }
+    }
+}
+
+
+/**
+ * @brief Computes the sum of squared deviations and/or the terms of the selected means in one pass.
+ *
+ * Each block is converted to doubles once and the selected reductions run on the cached block.
+ *
+ * @param deviations Whether to sum the squared deviations from mean (0 is returned otherwise).
+ * @param meanStatistics STAT_GEOMETRIC and/or STAT_HARMONIC, or 0.
+ */
+static double typedSquaredDeviationsAndMeanTerms(const struct TypedData *data, double mean, int deviations,
+                                                 unsigned int meanStatistics, struct MeanTerms *terms) {
+    const struct ReductionKernels *kernels = selectReductionKernels();
+    double block[CONVERT_BLOCK_SIZE];
+    double sum = 0.0, comp = 0.0;
+    for (int begin = 0; begin < data->numVals; begin += CONVERT_BLOCK_SIZE) {
+        int count = (data->numVals - begin < CONVERT_BLOCK_SIZE) ? data->numVals - begin : CONVERT_BLOCK_SIZE;
+        convertBlock(data, begin, count, block);
+        if (deviations) {
+            kahanAdd(&sum, &comp, kernels->sumSquaredDeviations(block, count, mean));
+        }
+        if (meanStatistics != 0) {
+            accumulateMeanTerms(block, count, meanStatistics, terms);
+        }
+    }
+    return sum - comp;
+}
+
+
+/**
+ * @brief Finds the minimum and maximum of integer data.
+ */
+static void integerRange(const struct TypedData *data, int64_t *min, int64_t *max) {
+    int64_t lo = INT64_MAX, hi = INT64_MIN;
+    if (data->type == DATA_INT32) {
+        const int32_t *values = (const int32_t *)data->values;
+        for (int i = 0; i < data->numVals; i++) {
+            lo = (values[i] < lo) ? values[i] : lo;
+            hi = (values[i] > hi) ? values[i] : hi;
+        }
+    } else {
+        const int64_t *values = (const int64_t *)data->values;
+        for (int i = 0; i < data->numVals; i++) {
+            lo = (values[i] < lo) ? values[i] : lo;
+            hi = (values[i] > hi) ? values[i] : hi;
+        }
+    }
+    *min = lo;
+    *max = hi;
+}
+
+
+/**
+ * @brief Counts how often every integer in [min, min + range) occurs.
+ *
+ * @return Dynamically allocated array of range counts.
+ */
+static int *countingSortCounts(const struct TypedData *data, int64_t min, int range) {
+    int *counts = (int *)calloc(range, sizeof(int));
+    if (counts == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    if (data->type == DATA_INT32) {
+        const int32_t *values = (const int32_t *)data->values;
+        for (int i = 0; i < data->numVals; i++) {
+            counts[values[i] - min]++;
+        }
+    } else {
+        const int64_t *values = (const int64_t *)data->values;
+        for (int i = 0; i < data->numVals; i++) {
+            counts[values[i] - min]++;
+        }
+    }
+    return counts;
+}
+
+
+/**
+ * @brief Finds the values at several ranks from counting sort counts, in one scan.
+ *
+ * @param counts Counts of the integers min, min + 1, ...
+ * @param range Number of counts.
+ * @param min Smallest integer.
+ * @param ranks Requested ranks, sorted ascending.
+ * @param numRanks Number of requested ranks.
+ * @param values Array that receives the value at each rank.
+ */
+static void countingSortRanks(const int *counts, int range, int64_t min, const int *ranks, int numRanks, double *values) {
+    long long seen = 0;
+    int next = 0;
+    for (int slot = 0; slot < range && next < numRanks; slot++) {
+        seen += counts[slot];
+        while (next < numRanks && ranks[next] < seen) {
+            values[next++] = (double)(min + slot);
+        }
+    }
+}
+
+
+/**
+ * @brief Computes the modes from counting sort counts, with the same rules as calculateMode.
+ */
+static double *countingSortModes(const int *counts, int range, int64_t min, int *numModes) {
+    int maxCount = 0, minCount = 0;
+    for (int slot = 0; slot < range; slot++) {
+        if (counts[slot] == 0) {
+            continue;
+        }
+        maxCount = (counts[slot] > maxCount) ? counts[slot] : maxCount;
+        minCount = (minCount == 0 || counts[slot] < minCount) ? counts[slot] : minCount;
+    }
+    // All values occur equally often
+    if (maxCount == minCount) {
+        *numModes = 0;
+        return NULL;
+    }
+
+    int numModesCount = 0;
+    for (int slot = 0; slot < range; slot++) {
+        numModesCount += (counts[slot] == maxCount);
+    }
+    double *modes = (double *)malloc(sizeof(double) * numModesCount);
+    if (modes == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    int modeIndex = 0;
+    for (int slot = 0; slot < range; slot++) {
+        if (counts[slot] == maxCount) {
+            modes[modeIndex++] = (double)(min + slot);
+        }
+    }
+    *numModes = numModesCount;
+    return modes;
+}
+
+
+/**
+ * @brief Maps a float to an unsigned key with the same ordering.
+ */
+static inline uint64_t floatKey(float value) {
+    uint32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    return (bits & 0x80000000u) ? (uint32_t)~bits : (bits | 0x80000000u);
+}
+
+/**
+ * @brief Maps an int32 to an unsigned key with the same ordering.
+ */
+static inline uint64_t int32Key(int32_t value) {
+    return (uint32_t)value ^ 0x80000000u;
+}
+
+/**
+ * @brief Maps an int64 to an unsigned key with the same ordering.
+ */
+static inline uint64_t int64Key(int64_t value) {
+    return (uint64_t)value ^ 0x8000000000000000ULL;
+}
+
+// Defines a function that counts the next key digit of the values matching the resolved key prefix
+#define DEFINE_KEY_HISTOGRAM(name, type, keyFunction)                                               \
+    static void name(const type *values, int numVals, uint64_t prefix, uint64_t prefixMask,          \
+                     int shift, unsigned int *histogram) {                                           \
+        for (int i = 0; i < numVals; i++) {                                                          \
+            uint64_t key = keyFunction(values[i]);                                                   \
+            if ((key & prefixMask) == prefix) {                                                      \
+                histogram[(key >> shift) & (SELECT_BUCKETS - 1)]++;                                  \
+            }                                                                                        \
+        }                                                                                            \
+    }
+
+DEFINE_KEY_HISTOGRAM(floatKeyHistogram, float, floatKey)
+DEFINE_KEY_HISTOGRAM(int32KeyHistogram, int32_t, int32Key)
+DEFINE_KEY_HISTOGRAM(int64KeyHistogram, int64_t, int64Key)
+
+
+/**
+ * @brief Finds the value of a given rank with most-significant-digit radix selection.
+ *
+ * Same algorithm as parallelSelect, on the keys of the typed values: two histogram passes resolve a
+ * 32-bit key, four resolve a 64-bit key. The data is not modified.
+ *
+ * @param data Pointer to the float32, int32 or int64 dataset.
+ * @param rank 0-based rank of the requested value.
+ * @param histogram Scratch array of SELECT_BUCKETS counts.
+ *
+ * @return The value at the rank, as a double.
+ */
+static double typedSelect(const struct TypedData *data, int rank, unsigned int *histogram) {
+    int keyBits = (data->type == DATA_INT64) ? 64 : 32;
+    uint64_t prefix = 0, prefixMask = 0;
+
+    for (int shift = keyBits - SELECT_DIGIT_BITS; shift >= 0; shift -= SELECT_DIGIT_BITS) {
+        memset(histogram, 0, sizeof(unsigned int) * SELECT_BUCKETS);
+        switch (data->type) {
+            case DATA_FLOAT32:
+                floatKeyHistogram((const float *)data->values, data->numVals, prefix, prefixMask, shift, histogram);
+                break;
+            case DATA_INT32:
+                int32KeyHistogram((const int32_t *)data->values, data->numVals, prefix, prefixMask, shift, histogram);
+                break;
+            default:
+                int64KeyHistogram((const int64_t *)data->values, data->numVals, prefix, prefixMask, shift, histogram);
+                break;
+        }
+
+        uint64_t digit = 0;
+        while (digit < SELECT_BUCKETS - 1 && (unsigned int)rank >= histogram[digit]) {
+            rank -= histogram[digit];
+            digit++;
+        }
+        prefix |= digit << shift;
+        prefixMask |= (uint64_t)(SELECT_BUCKETS - 1) << shift;
+    }
+
+    // Map the key back to the value
+    if (data->type == DATA_FLOAT32) {
+        uint32_t key = (uint32_t)prefix;
+        uint32_t bits = (key & 0x80000000u) ? (key & 0x7fffffffu) : ~key;
+        float value;
+        memcpy(&value, &bits, sizeof(value));
+        return value;
+    }
+    if (data->type == DATA_INT32) {
+        return (int32_t)((uint32_t)prefix ^ 0x80000000u);
+    }
+    return (double)(int64_t)(prefix ^ 0x8000000000000000ULL);
+}
+
+
+/**
+ * @brief Compares two ints for qsort in ascending order.
+ */
+static int compareInts(const void *a, const void *b) {
+    int x = *(const int *)a;
+    int y = *(const int *)b;
+    return (x > y) - (x < y);
+}
+
+
+/**
+ * @brief Computes the modes of a float32 or wide-range integer dataset with a frequency table.
+ *
+ * The values are counted as doubles, which is exact for float32, int32 and int64 values up to 2^53.
+ */
+static double *hashedModes(const struct TypedData *data, int *numModes) {
+    struct FrequencyTable table;
+    double block[CONVERT_BLOCK_SIZE];
+    initFrequencyTable(&table, 1024);
+    for (int begin = 0; begin < data->numVals; begin += CONVERT_BLOCK_SIZE) {
+        int count = (data->numVals - begin < CONVERT_BLOCK_SIZE) ? data->numVals - begin : CONVERT_BLOCK_SIZE;
+        convertBlock(data, begin, count, block);
+        for (int i = 0; i < count; i++) {
+            addToFrequencyTable(&table, block[i], 1);
+        }
+    }
+    double *modes = modesFromFrequencyTables(&table, 1, numModes);
+    freeFrequencyTable(&table);
+    return modes;
+}
+
+
+/**
+ * @brief Prints the passes calculateTypedStatistics makes for a plan, one per line.
+ *
+ * @param plan Pointer to the plan.
+ * @param data Pointer to the dataset.
+ * @param stream Stream to print to.
+ */
+void printTypedStatsPlan(const struct StatsPlan *plan, const struct TypedData *data, FILE *stream) {
+    int isInteger = data->type == DATA_INT32 || data->type == DATA_INT64;
+    unsigned int meanStatistics = plan->statistics & (STAT_GEOMETRIC | STAT_HARMONIC);
+    fprintf(stream, "Plan (%s kernels):\n", dataTypeName(data->type));
+    if (plan->meanPass) {
+        fprintf(stream, "  %-25s -> mean\n", isInteger ? "exact integer sum pass" : "sum pass");
+    }
+    if (plan->deviationPass || meanStatistics != 0) {
+        fprintf(stream, "  %-25s -> %s%s%s%s%s\n", "converted block pass", plan->deviationPass ? "stddev" : "",
+                (plan->deviationPass && meanStatistics != 0) ? ", " : "",
+                (meanStatistics & STAT_GEOMETRIC) ? "geometric mean" : "",
+                (meanStatistics == (STAT_GEOMETRIC | STAT_HARMONIC)) ? ", " : "",
+                (meanStatistics & STAT_HARMONIC) ? "harmonic mean" : "");
+    }
+    int numOrderStatistics = plan->numPercentiles + ((plan->statistics & STAT_MEDIAN) ? 1 : 0);
+    if (numOrderStatistics > 0 || (plan->statistics & STAT_MODE)) {
+        fprintf(stream, "  %-25s -> %s%s%s\n", isInteger ? "counting sort or radix" : "radix selection",
+                (plan->statistics & STAT_MEDIAN) ? "median" : ((plan->numPercentiles > 0) ? "percentiles" : ""),
+                ((plan->statistics & STAT_MEDIAN) && plan->numPercentiles > 0) ? ", percentiles" : "",
+                (plan->statistics & STAT_MODE) ? ((numOrderStatistics > 0) ? ", mode(s)" : "mode(s)") : "");
+    }
+}
+
+
+/**
+ * @brief Calculates the statistics of a plan on a float32, int32 or int64 dataset.
+ *
+ * The mean uses exact integer sums for integer data. The standard deviation and the geometric and
+ * harmonic means share one pass over the data. For integer data with a range of at most
+ * COUNTING_SORT_MAX_RANGE (and not much larger than the number of values), a counting sort answers
+ * the median, every requested quantile and the modes from one array of counts; otherwise the ranks
+ * are found by radix selection and the modes with a frequency table. Passes the plan does not need
+ * are skipped, as in executeStatsPlan. The data is never modified.
+ *
+ * @param data Pointer to the dataset (numVals must be positive).
+ * @param plan Pointer to the plan of the selected statistics and percentiles.
+ * @param policy How values the geometric and harmonic means are undefined for are treated.
+ * @param probabilities Requested quantile probabilities in [0, 1], plan->numPercentiles of them.
+ * @param results Pointer to the results; the fields of the selected statistics are filled in.
+ *
+ * @return 0 on success, -1 if the policy is POLICY_ERROR and invalid values were seen.
+ */
+int calculateTypedStatistics(const struct TypedData *data, const struct StatsPlan *plan, enum InvalidValuePolicy policy,
+                             const double *probabilities, struct StatsResults *results) {
+    int numVals = data->numVals;
+    int numProbabilities = plan->numPercentiles;
+    int status = 0;
+    results->statistics = plan->statistics;
+
+    if (plan->meanPass) {
+        results->mean = typedMean(data);
+    }
+    unsigned int meanStatistics = plan->statistics & (STAT_GEOMETRIC | STAT_HARMONIC);
+    if (plan->deviationPass || meanStatistics != 0) {
+        struct MeanTerms terms = {0};
+        double m2 = typedSquaredDeviationsAndMeanTerms(data, results->mean, plan->deviationPass, meanStatistics, &terms);
+        results->stddev = sqrt(m2 / numVals);
+        if (meanStatistics != 0) {
+            status = finalizeAlternativeMeans(&terms, policy, &results->means);
+        }
+    }
+
+    int wantMedian = (plan->statistics & STAT_MEDIAN) != 0;
+    int wantModes = (plan->statistics & STAT_MODE) != 0;
+    // Ranks needed for the requested quantiles and the median (last): lower and upper rank of each
+    int numQuantiles = numProbabilities + wantMedian;
+    if (numQuantiles == 0 && !wantModes) {
+        return status;
+    }
+    int numRanks = 2 * numQuantiles;
+    // One spare element each, so the arrays are never empty when only the modes are wanted
+    double *positions = (double *)malloc(sizeof(double) * (numQuantiles + 1));
+    int *ranks = (int *)malloc(sizeof(int) * (numRanks + 1));
+    int *sortedRanks = (int *)malloc(sizeof(int) * (numRanks + 1));
+    double *rankValues = (double *)malloc(sizeof(double) * (numRanks + 1));
+    if (positions == NULL || ranks == NULL || sortedRanks == NULL || rankValues == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    for (int q = 0; q < numQuantiles; q++) {
+        positions[q] = (numVals - 1) * ((q < numProbabilities) ? probabilities[q] : 0.5);
+        int lower = (int)floor(positions[q]);
+        ranks[2 * q] = lower;
+        ranks[2 * q + 1] = (lower + 1 < numVals) ? lower + 1 : lower;
+    }
+    memcpy(sortedRanks, ranks, sizeof(int) * numRanks);
+    qsort(sortedRanks, numRanks, sizeof(int), compareInts);
+
+    int64_t min = 0, max = 0;
+    int useCountingSort = 0;
+    if (data->type == DATA_INT32 || data->type == DATA_INT64) {
+        integerRange(data, &min, &max);
+        // Compare as unsigned so that a range wider than int64 does not overflow
+        uint64_t range = (uint64_t)max - (uint64_t)min + 1;
+        useCountingSort = range <= COUNTING_SORT_MAX_RANGE && range <= 4 * (uint64_t)numVals + 65536;
+    }
+
+    double *sortedValues = (double *)malloc(sizeof(double) * (numRanks + 1));
+    if (sortedValues == NULL) {
+        perror("Error allocating memory");
+        exit(EXIT_FAILURE);
+    }
+    if (useCountingSort) {
+        int range = (int)(max - min + 1);
+        int *counts = countingSortCounts(data, min, range);
+        countingSortRanks(counts, range, min, sortedRanks, numRanks, sortedValues);
+        if (wantModes) {
+            results->modes = countingSortModes(counts, range, min, &results->numModes);
+        }
+        free(counts);
+    } else {
+        if (numRanks > 0) {
+            unsigned int *histogram = (unsigned int *)malloc(sizeof(unsigned int) * SELECT_BUCKETS);
+            if (histogram == NULL) {
+                perror("Error allocating memory");
+                exit(EXIT_FAILURE);
+            }
+            for (int r = 0; r < numRanks; r++) {
+                // Equal ranks are selected once
+                sortedValues[r] = (r > 0 && sortedRanks[r] == sortedRanks[r - 1]) ? sortedValues[r - 1]
+                                                                                    : typedSelect(data, sortedRanks[r], histogram);
+            }
+            free(histogram);
+        }
+        if (wantModes) {
+            results->modes = hashedModes(data, &results->numModes);
+        }
+    }
+
+    // Look up the value of every rank and interpolate, as calculateQuantiles does
+    for (int r = 0; r < numRanks; r++) {
+        int index = 0;
+        while (sortedRanks[index] != ranks[r]) {
+            index++;
+        }
+        rankValues[r] = sortedValues[index];
+    }
+    for (int q = 0; q < numQuantiles; q++) {
+        double fraction = positions[q] - floor(positions[q]);
+        double lower = rankValues[2 * q];
+        double upper = rankValues[2 * q + 1];
+        double quantile = (fraction == 0.0) ? lower : (1.0 - fraction) * lower + fraction * upper;
+        if (q < numProbabilities) {
+            results->quantiles[q] = quantile;
+        } else {
+            results->median = quantile;
+        }
+    }
+
+    free(positions);
+    free(ranks);
+    free(sortedRanks);
+    free(rankValues);
+    free(sortedValues);
+    return status;
+}
@@ -0,0 +1,20 @@
+#ifndef TYPEDSTATS_H
+#define TYPEDSTATS_H
+
+#include <stdio.h>
+
+#include "readFile.h"
+#include "statsFunctions.h"
+#include "statsPlan.h"
+
+// Integer data whose range (max - min + 1) is at most this uses counting sort for the median, quantiles and modes
+#define COUNTING_SORT_MAX_RANGE (1 << 24)
+
+// Function to calculate the planned statistics of a float32, int32 or int64 dataset with kernels specialized for its type
+int calculateTypedStatistics(const struct TypedData *data, const struct StatsPlan *plan, enum InvalidValuePolicy policy,
+                             const double *probabilities, struct StatsResults *results);
+
+// Function to print the passes calculateTypedStatistics makes for a plan to a stream
+void printTypedStatsPlan(const struct StatsPlan *plan, const struct TypedData *data, FILE *stream);
+
+#endif